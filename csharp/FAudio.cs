@@ -1297,6 +1297,26 @@ public static class FAudio
 		public int backgroundMusic;
 	}
 
+	/* See "extensions/StreamStatsEXT.txt" for more details. */
+	[StructLayout(LayoutKind.Sequential)]
+	public struct FACTWaveStreamStatsEXT
+	{
+		public uint packetsRead;
+		public uint packetsReused;
+		public uint packetsSubmitted;
+		public uint packetsStarved;
+		public uint starvedMS;
+	}
+
+	/* See "extensions/TranscodeEXT.txt" for more details. */
+	[StructLayout(LayoutKind.Sequential)]
+	public struct FACTTranscodePolicyEXT
+	{
+		public uint target; /* FACT_TRANSCODE_*_EXT */
+		public uint maxDecodedSize;
+		public ushort category;
+	}
+
 	[StructLayout(LayoutKind.Sequential)]
 	public unsafe struct FACTCueProperties
 	{
@@ -1488,6 +1508,9 @@ public static class FAudio
 	public const ushort FACTVARIABLEINDEX_INVALID =	0xFFFF;
 	public const ushort FACTCATEGORY_INVALID =	0xFFFF;
 
+	public const uint FACT_TRANSCODE_PCM16_EXT =	0;
+	public const uint FACT_TRANSCODE_FLOAT_EXT =	1;
+
 	public const uint FACT_ENGINE_LOOKAHEAD_DEFAULT = 250;
 
 	public const byte FACTNOTIFICATIONTYPE_CUEPREPARED =				1;
@@ -1508,6 +1531,7 @@ public static class FAudio
 	public const byte FACTNOTIFICATIONTYPE_WAVEDESTROYED =				16;
 	public const byte FACTNOTIFICATIONTYPE_WAVEBANKPREPARED =			17;
 	public const byte FACTNOTIFICATIONTYPE_WAVEBANKSTREAMING_INVALIDCONTENT =	18;
+	public const byte FACTNOTIFICATIONTYPE_SOUNDBANKPREPARED_EXT =			19;
 
 	public const byte FACT_FLAG_NOTIFICATION_PERSIST = 0x01;
 
@@ -1530,6 +1554,24 @@ public static class FAudio
 		out IntPtr ppEngine /* FACTAudioEngine** */
 	);
 
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTURingGetFileIOCallbacksEXT(
+		out FACTFileIOCallbacks pCallbacks
+	);
+
+	/* Returns the handle to use as FACTStreamingParameters.file */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	private static extern unsafe IntPtr FACTURingOpenEXT(byte* path);
+	public static unsafe IntPtr FACTURingOpenEXT(string path)
+	{
+		int utf8BufSize = Utf8Size(path);
+		byte* utf8Buf = stackalloc byte[utf8BufSize];
+		return FACTURingOpenEXT(Utf8Encode(path, utf8Buf, utf8BufSize));
+	}
+
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern void FACTURingCloseEXT(IntPtr pFile);
+
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	public static extern uint FACTAudioEngine_AddRef(
 		IntPtr pEngine /* FACTAudioEngine* */
@@ -1587,6 +1629,20 @@ public static class FAudio
 		out IntPtr ppSoundBank /* FACTSoundBank** */
 	);
 
+	/* See "extensions/AsyncLoadEXT.txt" for more details.
+	 * ppSoundBank is written after this returns, so it has to point to
+	 * unmanaged memory, not a managed out parameter.
+	 */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_CreateSoundBankAsyncEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		IntPtr pvBuffer,
+		uint dwSize,
+		uint dwFlags,
+		uint dwAllocAttributes,
+		IntPtr ppSoundBank /* FACTSoundBank** */
+	);
+
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	public static extern uint FACTAudioEngine_CreateInMemoryWaveBank(
 		IntPtr pEngine, /* FACTAudioEngine* */
@@ -1597,6 +1653,45 @@ public static class FAudio
 		out IntPtr ppWaveBank /* FACTWaveBank** */
 	);
 
+	/* See "extensions/AsyncLoadEXT.txt" for more details.
+	 * ppWaveBank has to point to unmanaged memory, like ppSoundBank above.
+	 */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_CreateInMemoryWaveBankAsyncEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		IntPtr pvBuffer,
+		uint dwSize,
+		uint dwFlags,
+		uint dwAllocAttributes,
+		IntPtr ppWaveBank /* FACTWaveBank** */
+	);
+
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	private static extern unsafe uint FACTAudioEngine_CreateMappedWaveBankEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		byte* szPath,
+		uint dwFlags,
+		uint dwAllocAttributes,
+		out IntPtr ppWaveBank /* FACTWaveBank** */
+	);
+	public static unsafe uint FACTAudioEngine_CreateMappedWaveBankEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		string szPath,
+		uint dwFlags,
+		uint dwAllocAttributes,
+		out IntPtr ppWaveBank /* FACTWaveBank** */
+	) {
+		int utf8BufSize = Utf8Size(szPath);
+		byte* utf8Buf = stackalloc byte[utf8BufSize];
+		return FACTAudioEngine_CreateMappedWaveBankEXT(
+			pEngine,
+			Utf8Encode(szPath, utf8Buf, utf8BufSize),
+			dwFlags,
+			dwAllocAttributes,
+			out ppWaveBank
+		);
+	}
+
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	public static extern uint FACTAudioEngine_CreateStreamingWaveBank(
 		IntPtr pEngine, /* FACTAudioEngine* */
@@ -1604,6 +1699,43 @@ public static class FAudio
 		out IntPtr ppWaveBank /* FACTWaveBank** */
 	);
 
+	/* See "extensions/AsyncLoadEXT.txt" for more details.
+	 * ppWaveBank has to point to unmanaged memory, like ppSoundBank above.
+	 */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_CreateStreamingWaveBankAsyncEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		ref FACTStreamingParameters pParms,
+		IntPtr ppWaveBank /* FACTWaveBank** */
+	);
+
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_CreateCachedWaveBankEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		ref FACTStreamingParameters pParms,
+		out IntPtr ppWaveBank /* FACTWaveBank** */
+	);
+
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_SetWaveCacheBudgetEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		uint dwBudget
+	);
+
+	/* See "extensions/TranscodeEXT.txt" for more details. */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_SetTranscodePolicyEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		ref FACTTranscodePolicyEXT pPolicy
+	);
+
+	/* See "extensions/TranscodeEXT.txt" for more details. */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTAudioEngine_GetTranscodedSizeEXT(
+		IntPtr pEngine, /* FACTAudioEngine* */
+		out uint pdwBytes
+	);
+
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	private static extern unsafe uint FACTAudioEngine_PrepareWave(
 		IntPtr pEngine, /* FACTAudioEngine* */
@@ -1905,6 +2037,20 @@ public static class FAudio
 		uint dwFlags
 	);
 
+	/* See "extensions/CachedWaveBankEXT.txt" for more details. */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTWaveBank_PrefetchEXT(
+		IntPtr pWaveBank, /* FACTWaveBank* */
+		ushort nWaveIndex
+	);
+
+	/* See "extensions/TranscodeEXT.txt" for more details. */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTWaveBank_TranscodeEXT(
+		IntPtr pWaveBank, /* FACTWaveBank* */
+		ushort nWaveIndex
+	);
+
 	/* Wave Interface */
 
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
@@ -1961,6 +2107,13 @@ public static class FAudio
 		out FACTWaveInstanceProperties pProperties
 	);
 
+	/* See "extensions/StreamStatsEXT.txt" for more details. */
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern uint FACTWave_GetStreamStatsEXT(
+		IntPtr pWave, /* FACTWave* */
+		out FACTWaveStreamStatsEXT pStats
+	);
+
 	/* Cue Interface */
 
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
@@ -2370,6 +2523,15 @@ public static class FAudio
 		return XNA_PlaySong(Utf8Encode(name, utf8Buf, utf8BufSize));
 	}
 
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	private static extern unsafe uint XNA_QueueSongEXT(byte* name);
+	public static unsafe uint XNA_QueueSongEXT(string name)
+	{
+		int utf8BufSize = Utf8Size(name);
+		byte* utf8Buf = stackalloc byte[utf8BufSize];
+		return XNA_QueueSongEXT(Utf8Encode(name, utf8Buf, utf8BufSize));
+	}
+
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	public static extern void XNA_PauseSong();
 
@@ -2379,6 +2541,15 @@ public static class FAudio
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	public static extern void XNA_StopSong();
 
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern void XNA_SetSongPositionEXT(float seconds);
+
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern float XNA_GetSongPositionEXT();
+
+	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
+	public static extern void XNA_SetSongDecodeAheadEXT(uint milliseconds);
+
 	[DllImport(nativeLibName, CallingConvention = CallingConvention.Cdecl)]
 	public static extern void XNA_SetSongVolume(float volume);
 
@@ -242,6 +242,24 @@ typedef struct FACTWaveInstanceProperties
 	int32_t backgroundMusic;
 } FACTWaveInstanceProperties;
 
+/* See "extensions/StreamStatsEXT.txt" for more details. */
+typedef struct FACTWaveStreamStatsEXT
+{
+	uint32_t packetsRead;
+	uint32_t packetsReused;
+	uint32_t packetsSubmitted;
+	uint32_t packetsStarved;
+	uint32_t starvedMS;
+} FACTWaveStreamStatsEXT;
+
+/* See "extensions/TranscodeEXT.txt" for more details. */
+typedef struct FACTTranscodePolicyEXT
+{
+	uint32_t target; /* FACT_TRANSCODE_*_EXT */
+	uint32_t maxDecodedSize;
+	uint16_t category;
+} FACTTranscodePolicyEXT;
+
 typedef struct FACTCueProperties
 {
 	char friendlyName[0xFF];
@@ -412,6 +430,9 @@ static const uint16_t FACTINDEX_INVALID =		0xFFFF;
 static const uint16_t FACTVARIABLEINDEX_INVALID =	0xFFFF;
 static const uint16_t FACTCATEGORY_INVALID =		0xFFFF;
 
+static const uint32_t FACT_TRANSCODE_PCM16_EXT =	0;
+static const uint32_t FACT_TRANSCODE_FLOAT_EXT =	1;
+
 static const uint8_t FACTNOTIFICATIONTYPE_CUEPREPARED =				1;
 static const uint8_t FACTNOTIFICATIONTYPE_CUEPLAY =				2;
 static const uint8_t FACTNOTIFICATIONTYPE_CUESTOP =				3;
@@ -430,6 +451,7 @@ static const uint8_t FACTNOTIFICATIONTYPE_WAVELOOPED =				15;
 static const uint8_t FACTNOTIFICATIONTYPE_WAVEDESTROYED =			16;
 static const uint8_t FACTNOTIFICATIONTYPE_WAVEBANKPREPARED =			17;
 static const uint8_t FACTNOTIFICATIONTYPE_WAVEBANKSTREAMING_INVALIDCONTENT =	18;
+static const uint8_t FACTNOTIFICATIONTYPE_SOUNDBANKPREPARED_EXT =		19;
 
 static const uint8_t FACT_FLAG_NOTIFICATION_PERSIST = 0x01;
 
@@ -485,6 +507,15 @@ FACTAPI uint32_t FACTCreateEngineWithCustomAllocatorEXT(
 	FAudioReallocFunc customRealloc
 );
 
+/* See "extensions/URingIOEXT.txt" for more details. */
+FACTAPI uint32_t FACTURingGetFileIOCallbacksEXT(
+	FACTFileIOCallbacks *pCallbacks
+);
+
+FACTAPI void* FACTURingOpenEXT(const char *path);
+
+FACTAPI void FACTURingCloseEXT(void *pFile);
+
 FACTAPI uint32_t FACTAudioEngine_AddRef(FACTAudioEngine *pEngine);
 
 FACTAPI uint32_t FACTAudioEngine_Release(FACTAudioEngine *pEngine);
@@ -525,6 +556,16 @@ FACTAPI uint32_t FACTAudioEngine_CreateSoundBank(
 	FACTSoundBank **ppSoundBank
 );
 
+/* See "extensions/AsyncLoadEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_CreateSoundBankAsyncEXT(
+	FACTAudioEngine *pEngine,
+	const void *pvBuffer,
+	uint32_t dwSize,
+	uint32_t dwFlags,
+	uint32_t dwAllocAttributes,
+	FACTSoundBank **ppSoundBank
+);
+
 FACTAPI uint32_t FACTAudioEngine_CreateInMemoryWaveBank(
 	FACTAudioEngine *pEngine,
 	const void *pvBuffer,
@@ -534,12 +575,63 @@ FACTAPI uint32_t FACTAudioEngine_CreateInMemoryWaveBank(
 	FACTWaveBank **ppWaveBank
 );
 
+/* See "extensions/AsyncLoadEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_CreateInMemoryWaveBankAsyncEXT(
+	FACTAudioEngine *pEngine,
+	const void *pvBuffer,
+	uint32_t dwSize,
+	uint32_t dwFlags,
+	uint32_t dwAllocAttributes,
+	FACTWaveBank **ppWaveBank
+);
+
+/* See "extensions/MappedWaveBankEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_CreateMappedWaveBankEXT(
+	FACTAudioEngine *pEngine,
+	const char *szPath,
+	uint32_t dwFlags,
+	uint32_t dwAllocAttributes,
+	FACTWaveBank **ppWaveBank
+);
+
 FACTAPI uint32_t FACTAudioEngine_CreateStreamingWaveBank(
 	FACTAudioEngine *pEngine,
 	const FACTStreamingParameters *pParms,
 	FACTWaveBank **ppWaveBank
 );
 
+/* See "extensions/AsyncLoadEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_CreateStreamingWaveBankAsyncEXT(
+	FACTAudioEngine *pEngine,
+	const FACTStreamingParameters *pParms,
+	FACTWaveBank **ppWaveBank
+);
+
+/* See "extensions/CachedWaveBankEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_CreateCachedWaveBankEXT(
+	FACTAudioEngine *pEngine,
+	const FACTStreamingParameters *pParms,
+	FACTWaveBank **ppWaveBank
+);
+
+/* See "extensions/CachedWaveBankEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_SetWaveCacheBudgetEXT(
+	FACTAudioEngine *pEngine,
+	uint32_t dwBudget
+);
+
+/* See "extensions/TranscodeEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_SetTranscodePolicyEXT(
+	FACTAudioEngine *pEngine,
+	const FACTTranscodePolicyEXT *pPolicy
+);
+
+/* See "extensions/TranscodeEXT.txt" for more details. */
+FACTAPI uint32_t FACTAudioEngine_GetTranscodedSizeEXT(
+	FACTAudioEngine *pEngine,
+	uint32_t *pdwBytes
+);
+
 FACTAPI uint32_t FACTAudioEngine_PrepareWave(
 	FACTAudioEngine *pEngine,
 	uint32_t dwFlags,
@@ -735,6 +827,18 @@ FACTAPI uint32_t FACTWaveBank_Stop(
 	uint32_t dwFlags
 );
 
+/* See "extensions/CachedWaveBankEXT.txt" for more details. */
+FACTAPI uint32_t FACTWaveBank_PrefetchEXT(
+	FACTWaveBank *pWaveBank,
+	uint16_t nWaveIndex
+);
+
+/* See "extensions/TranscodeEXT.txt" for more details. */
+FACTAPI uint32_t FACTWaveBank_TranscodeEXT(
+	FACTWaveBank *pWaveBank,
+	uint16_t nWaveIndex
+);
+
 /* Wave Interface */
 
 FACTAPI uint32_t FACTWave_Destroy(FACTWave *pWave);
@@ -763,6 +867,12 @@ FACTAPI uint32_t FACTWave_GetProperties(
 	FACTWaveInstanceProperties *pProperties
 );
 
+/* See "extensions/StreamStatsEXT.txt" for more details. */
+FACTAPI uint32_t FACTWave_GetStreamStatsEXT(
+	FACTWave *pWave,
+	FACTWaveStreamStatsEXT *pStats
+);
+
 /* Cue Interface */
 
 FACTAPI uint32_t FACTCue_Destroy(FACTCue *pCue);
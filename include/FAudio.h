@@ -381,6 +381,7 @@ typedef struct FAudioXMA2WaveFormatEx
 #define FAUDIO_SEND_USEFILTER		0x0080
 #define FAUDIO_VOICE_NOSAMPLESPLAYED	0x0100
 #define FAUDIO_1024_QUANTUM		0x8000
+#define FAUDIO_VOICE_DECODEAHEAD_EXT	0x00100000
 
 #define FAUDIO_DEFAULT_FILTER_TYPE	FAudioLowPassFilter
 #define FAUDIO_DEFAULT_FILTER_FREQUENCY	FAUDIO_MAX_FILTER_FREQUENCY
@@ -487,6 +488,9 @@ typedef struct FAudioXMA2WaveFormatEx
 #define FAUDIO_FORMAT_XMAUDIO2		0x0166
 #define FAUDIO_FORMAT_EXTENSIBLE	0xFFFE
 
+#define FAUDIO_FORMAT_VORBIS_EXT	0x674F
+#define FAUDIO_FORMAT_QOA_EXT		0x6F71
+
 extern FAudioGUID DATAFORMAT_SUBTYPE_PCM;
 extern FAudioGUID DATAFORMAT_SUBTYPE_IEEE_FLOAT;
 
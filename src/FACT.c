@@ -27,6 +27,26 @@
 #include "FAudioFX.h"
 #include "FACT_internal.h"
 
+/* Set/GetVariable don't take apiLock, so the values go through the platform
+ * atomics. The update thread reads them after it takes the changed flag,
+ * which the setters raise after the value is stored.
+ */
+
+static void store_variable(float *dst, float value)
+{
+	uint32_t bits;
+	FAudio_memcpy(&bits, &value, sizeof(bits));
+	FAudio_PlatformAtomicSet((uint32_t*) dst, bits);
+}
+
+static float load_variable(float *src)
+{
+	uint32_t bits = FAudio_PlatformAtomicGet((uint32_t*) src);
+	float value;
+	FAudio_memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
 /* AudioEngine implementation */
 
 static void remove_single_notification(FACTAudioEngine *engine, size_t index)
@@ -81,18 +101,18 @@ static void send_wave_notification(FACTAudioEngine *engine, uint8_t type, const
 	}
 }
 
-static void send_soundbank_notification(FACTAudioEngine *engine, FACTSoundBank *soundbank)
+static void send_soundbank_notification(FACTAudioEngine *engine, uint8_t type, FACTSoundBank *soundbank)
 {
 	FACTNotification notification;
 
-	notification.type = FACTNOTIFICATIONTYPE_SOUNDBANKDESTROYED;
+	notification.type = type;
 	notification.soundBank.pSoundBank = soundbank;
 
 	for (ptrdiff_t i = engine->notification_count - 1; i >= 0; --i)
 	{
 		FACTNotificationDescription *desc = &engine->notifications[i];
 
-		if (desc->type == FACTNOTIFICATIONTYPE_SOUNDBANKDESTROYED && (!desc->pSoundBank || desc->pSoundBank == soundbank))
+		if (desc->type == type && (!desc->pSoundBank || desc->pSoundBank == soundbank))
 		{
 			notification.pvContext = desc->pvContext;
 			if (!(desc->flags & FACT_FLAG_NOTIFICATION_PERSIST))
@@ -287,6 +307,8 @@ uint32_t FACTAudioEngine_Initialize(
 		pEngine->categories[0].volume = 1.0f;
 		pEngine->categories[0].visibility = 1;
 		pEngine->categories[0].instanceCount = 0;
+		pEngine->categories[0].instanceHead = NULL;
+		pEngine->categories[0].instanceTail = NULL;
 		pEngine->categories[0].currentVolume = 1.0f;
 
 		pEngine->categoryNames[1] = pEngine->pMalloc(8);
@@ -299,6 +321,8 @@ uint32_t FACTAudioEngine_Initialize(
 		pEngine->categories[1].volume = 1.0f;
 		pEngine->categories[1].visibility = 1;
 		pEngine->categories[1].instanceCount = 0;
+		pEngine->categories[1].instanceHead = NULL;
+		pEngine->categories[1].instanceTail = NULL;
 		pEngine->categories[1].currentVolume = 1.0f;
 
 		pEngine->categoryNames[2] = pEngine->pMalloc(6);
@@ -311,6 +335,8 @@ uint32_t FACTAudioEngine_Initialize(
 		pEngine->categories[2].volume = 1.0f;
 		pEngine->categories[2].visibility = 1;
 		pEngine->categories[2].instanceCount = 0;
+		pEngine->categories[2].instanceHead = NULL;
+		pEngine->categories[2].instanceTail = NULL;
 		pEngine->categories[2].currentVolume = 1.0f;
 
 		pEngine->variables = NULL;
@@ -330,10 +356,18 @@ uint32_t FACTAudioEngine_Initialize(
 		}
 	}
 
+	FACT_INTERNAL_BuildEngineLookups(pEngine);
+
 	pEngine->notifications = NULL;
 	pEngine->notification_count = 0;
 	pEngine->notifications_capacity = 0;
 
+	pEngine->cacheBudget = FACT_WAVE_CACHE_DEFAULT_BUDGET;
+	pEngine->transcodePolicy.target = FACT_TRANSCODE_PCM16_EXT;
+	pEngine->transcodePolicy.maxDecodedSize = 0;
+	pEngine->transcodePolicy.category = FACTCATEGORY_INVALID;
+	pEngine->transcodedSize = 0;
+
 	/* Assign the callbacks */
 	pEngine->notificationCallback = pParams->fnNotificationCallback;
 	pEngine->pReadFile = pParams->fileIOCallbacks.readFileCallback;
@@ -416,7 +450,20 @@ uint32_t FACTAudioEngine_Initialize(
 		FAPOBase_Release((FAPOBase*) reverbDesc.pEffect);
 	}
 
+	/* Anything that depends on global variables needs a first update */
+	pEngine->globalVariableVersion = 1;
+	pEngine->dspVariableVersion = 0;
+
 	pEngine->initialized = true;
+	pEngine->apiSignal = FAudio_PlatformCreateSemaphore(0);
+
+	/* Cue timing runs off the mixer, see FACT_INTERNAL_GetTime */
+	pEngine->clockCallback.callback.OnCriticalError = NULL;
+	pEngine->clockCallback.callback.OnProcessingPassEnd = NULL;
+	pEngine->clockCallback.callback.OnProcessingPassStart = FACT_INTERNAL_OnProcessingPassStart;
+	pEngine->clockCallback.engine = pEngine;
+	pEngine->clockWall = FAudio_timems();
+	FAudio_RegisterForCallbacks(pEngine->audio, &pEngine->clockCallback.callback);
 	pEngine->apiThread = FAudio_PlatformCreateThread(
 		FACT_INTERNAL_APIThread,
 		"FACT Thread",
@@ -429,6 +476,9 @@ uint32_t FACTAudioEngine_Initialize(
 
 static void send_queued_wavebank_notifications(FACTAudioEngine *engine)
 {
+	for (size_t i = 0; i < engine->prepared_soundbank_count; ++i)
+		send_soundbank_notification(engine, FACTNOTIFICATIONTYPE_SOUNDBANKPREPARED_EXT, engine->prepared_soundbanks[i]);
+	engine->prepared_soundbank_count = 0;
 	for (size_t i = 0; i < engine->prepared_wavebank_count; ++i)
 		send_wavebank_notification(engine, FACTNOTIFICATIONTYPE_WAVEBANKPREPARED, engine->prepared_wavebanks[i]);
 	engine->prepared_wavebank_count = 0;
@@ -444,17 +494,32 @@ uint32_t FACTAudioEngine_ShutDown(FACTAudioEngine *pEngine)
 
 	/* Close thread, then lock ASAP */
 	pEngine->initialized = false;
+	if (pEngine->apiSignal != NULL)
+	{
+		FAudio_PlatformSignalSemaphore(pEngine->apiSignal);
+	}
 	FAudio_PlatformWaitThread(pEngine->apiThread, NULL);
+
+	/* Let a load that's in progress finish, it needs the apiLock */
+	FACT_INTERNAL_LoadQuit(pEngine);
 	FAudio_PlatformLockMutex(pEngine->apiLock);
 
 	/* Stop the platform stream before freeing stuff! */
 	if (pEngine->audio != NULL)
 	{
+		if (pEngine->clockCallback.engine != NULL)
+		{
+			FAudio_UnregisterForCallbacks(
+				pEngine->audio,
+				&pEngine->clockCallback.callback
+			);
+		}
 		FAudio_StopEngine(pEngine->audio);
 	}
 
 	send_queued_wavebank_notifications(pEngine);
 	pEngine->pFree(pEngine->prepared_wavebanks);
+	pEngine->pFree(pEngine->prepared_soundbanks);
 
 	/* This method destroys all existing cues, sound banks, and wave banks.
 	 * It blocks until all cues are destroyed.
@@ -468,6 +533,25 @@ uint32_t FACTAudioEngine_ShutDown(FACTAudioEngine *pEngine)
 		FACTSoundBank_Destroy((FACTSoundBank*) pEngine->sbList->entry);
 	}
 
+	/* No more WaveBanks, so no more transcode batches either */
+	if (pEngine->transcodeLock != NULL)
+	{
+		FAudio_PlatformDestroyMutex(pEngine->transcodeLock);
+		FAudio_PlatformDestroyMutex(pEngine->transcodeDecodeLock);
+	}
+
+	/* No more streaming Waves, the stream thread can go */
+	FACT_INTERNAL_StreamQuit(pEngine);
+
+	/* Every Wave is gone, so are the idle voices they left behind */
+	FACT_INTERNAL_DestroyVoicePools(pEngine);
+
+	/* Destroying Cues above still wakes the API thread, so this goes last */
+	if (pEngine->apiSignal != NULL)
+	{
+		FAudio_PlatformDestroySemaphore(pEngine->apiSignal);
+	}
+
 	pEngine->pFree(pEngine->notifications);
 	pEngine->notification_count = 0;
 	pEngine->notifications_capacity = 0;
@@ -479,6 +563,7 @@ uint32_t FACTAudioEngine_ShutDown(FACTAudioEngine *pEngine)
 	}
 	pEngine->pFree(pEngine->categoryNames);
 	pEngine->pFree(pEngine->categories);
+	pEngine->pFree(pEngine->categoryLookup.slots);
 
 	/* Variable data */
 	for (i = 0; i < pEngine->variableCount; i += 1)
@@ -487,6 +572,8 @@ uint32_t FACTAudioEngine_ShutDown(FACTAudioEngine *pEngine)
 	}
 	pEngine->pFree(pEngine->variableNames);
 	pEngine->pFree(pEngine->variables);
+	pEngine->pFree(pEngine->globalVariableLookup.slots);
+	pEngine->pFree(pEngine->cueVariableLookup.slots);
 	pEngine->pFree(pEngine->globalVariableValues);
 
 	/* RPC data */
@@ -594,10 +681,41 @@ uint32_t FACTAudioEngine_CreateSoundBank(
 		dwSize,
 		ppSoundBank
 	);
+	if (retval == 0)
+	{
+		FACT_INTERNAL_AddSoundBank(*ppSoundBank);
+		FACT_INTERNAL_QueueSoundBankPrepared(pEngine, *ppSoundBank);
+
+		/* Last, since this drops the apiLock while it decodes */
+		FACT_INTERNAL_TranscodeSoundBank(*ppSoundBank);
+	}
 	FAudio_PlatformUnlockMutex(pEngine->apiLock);
 	return retval;
 }
 
+uint32_t FACTAudioEngine_CreateSoundBankAsyncEXT(
+	FACTAudioEngine *pEngine,
+	const void *pvBuffer,
+	uint32_t dwSize,
+	uint32_t dwFlags,
+	uint32_t dwAllocAttributes,
+	FACTSoundBank **ppSoundBank
+) {
+	FACTLoadRequest *request;
+
+	request = (FACTLoadRequest*) pEngine->pMalloc(sizeof(FACTLoadRequest));
+	FAudio_zero(request, sizeof(FACTLoadRequest));
+	request->ppSoundBank = ppSoundBank;
+	request->buffer = pvBuffer;
+	request->size = dwSize;
+	*ppSoundBank = NULL;
+
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	FACT_INTERNAL_LoadAdd(pEngine, request);
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return FAUDIO_OK;
+}
+
 uint32_t FACTAudioEngine_CreateInMemoryWaveBank(
 	FACTAudioEngine *pEngine,
 	const void *pvBuffer,
@@ -616,15 +734,87 @@ uint32_t FACTAudioEngine_CreateInMemoryWaveBank(
 		FACT_INTERNAL_DefaultReadFile,
 		FACT_INTERNAL_DefaultGetOverlappedResult,
 		false,
+		false,
+		&pEngine->transcodePolicy,
+		ppWaveBank
+	);
+	if (retval == 0)
+	{
+		FACT_INTERNAL_AddWaveBank(*ppWaveBank);
+	}
+	FACT_INTERNAL_QueueWaveBankPrepared(pEngine, *ppWaveBank);
+	if (retval == 0)
+	{
+		/* Last, since this drops the apiLock while it decodes */
+		FACT_INTERNAL_TranscodeWaveBank(*ppWaveBank);
+	}
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return retval;
+}
+
+uint32_t FACTAudioEngine_CreateInMemoryWaveBankAsyncEXT(
+	FACTAudioEngine *pEngine,
+	const void *pvBuffer,
+	uint32_t dwSize,
+	uint32_t dwFlags,
+	uint32_t dwAllocAttributes,
+	FACTWaveBank **ppWaveBank
+) {
+	FACTLoadRequest *request;
+
+	request = (FACTLoadRequest*) pEngine->pMalloc(sizeof(FACTLoadRequest));
+	FAudio_zero(request, sizeof(FACTLoadRequest));
+	request->ppWaveBank = ppWaveBank;
+	request->io = FAudio_memopen((void*) pvBuffer, dwSize);
+	request->isStreaming = false;
+	*ppWaveBank = NULL;
+
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	FACT_INTERNAL_LoadAdd(pEngine, request);
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return FAUDIO_OK;
+}
+
+uint32_t FACTAudioEngine_CreateMappedWaveBankEXT(
+	FACTAudioEngine *pEngine,
+	const char *szPath,
+	uint32_t dwFlags,
+	uint32_t dwAllocAttributes,
+	FACTWaveBank **ppWaveBank
+) {
+	uint32_t retval;
+	FAudioIOStream *io;
+
+	io = FAudio_PlatformMapFile(szPath);
+	if (io == NULL)
+	{
+		return FAUDIO_E_FAIL;
+	}
+
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	retval = FACT_INTERNAL_ParseWaveBank(
+		pEngine,
+		io,
+		0,
+		0,
+		FACT_INTERNAL_DefaultReadFile,
+		FACT_INTERNAL_DefaultGetOverlappedResult,
+		false,
+		false,
+		&pEngine->transcodePolicy,
 		ppWaveBank
 	);
-	if (pEngine->prepared_wavebank_count == pEngine->prepared_wavebanks_capacity)
+	if (retval != 0)
 	{
-		pEngine->prepared_wavebanks_capacity = FAudio_max(pEngine->prepared_wavebanks_capacity * 2, 8);
-		pEngine->prepared_wavebanks = pEngine->pRealloc(pEngine->prepared_wavebanks,
-			pEngine->prepared_wavebanks_capacity * sizeof(FACTWaveBank *));
+		FAudio_PlatformUnlockMutex(pEngine->apiLock);
+		FAudio_close(io);
+		return retval;
 	}
-	pEngine->prepared_wavebanks[pEngine->prepared_wavebank_count++] = *ppWaveBank;
+	FACT_INTERNAL_AddWaveBank(*ppWaveBank);
+	FACT_INTERNAL_QueueWaveBankPrepared(pEngine, *ppWaveBank);
+
+	/* Last, since this drops the apiLock while it decodes */
+	FACT_INTERNAL_TranscodeWaveBank(*ppWaveBank);
 	FAudio_PlatformUnlockMutex(pEngine->apiLock);
 	return retval;
 }
@@ -655,19 +845,127 @@ uint32_t FACTAudioEngine_CreateStreamingWaveBank(
 		pEngine->pReadFile,
 		pEngine->pGetOverlappedResult,
 		true,
+		false,
+		&pEngine->transcodePolicy,
 		ppWaveBank
 	);
-	if (pEngine->prepared_wavebank_count == pEngine->prepared_wavebanks_capacity)
+	if (retval == 0)
 	{
-		pEngine->prepared_wavebanks_capacity = FAudio_max(pEngine->prepared_wavebanks_capacity * 2, 8);
-		pEngine->prepared_wavebanks = pEngine->pRealloc(pEngine->prepared_wavebanks,
-			pEngine->prepared_wavebanks_capacity * sizeof(FACTWaveBank *));
+		FACT_INTERNAL_AddWaveBank(*ppWaveBank);
 	}
-	pEngine->prepared_wavebanks[pEngine->prepared_wavebank_count++] = *ppWaveBank;
+	FACT_INTERNAL_QueueWaveBankPrepared(pEngine, *ppWaveBank);
 	FAudio_PlatformUnlockMutex(pEngine->apiLock);
 	return retval;
 }
 
+uint32_t FACTAudioEngine_CreateStreamingWaveBankAsyncEXT(
+	FACTAudioEngine *pEngine,
+	const FACTStreamingParameters *pParms,
+	FACTWaveBank **ppWaveBank
+) {
+	FACTLoadRequest *request;
+
+	request = (FACTLoadRequest*) pEngine->pMalloc(sizeof(FACTLoadRequest));
+	FAudio_zero(request, sizeof(FACTLoadRequest));
+	request->ppWaveBank = ppWaveBank;
+	request->io = pParms->file;
+	request->offset = pParms->offset;
+	request->isStreaming = true;
+	*ppWaveBank = NULL;
+
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	if (	pEngine->pReadFile == FACT_INTERNAL_DefaultReadFile &&
+		pEngine->pGetOverlappedResult == FACT_INTERNAL_DefaultGetOverlappedResult	)
+	{
+		/* Our I/O doesn't care about packets, set to 0 as an optimization */
+		request->packetSize = 0;
+	}
+	else
+	{
+		request->packetSize = pParms->packetSize * 2048;
+	}
+	FACT_INTERNAL_LoadAdd(pEngine, request);
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return FAUDIO_OK;
+}
+
+uint32_t FACTAudioEngine_CreateCachedWaveBankEXT(
+	FACTAudioEngine *pEngine,
+	const FACTStreamingParameters *pParms,
+	FACTWaveBank **ppWaveBank
+) {
+	uint32_t retval, packetSize;
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	if (	pEngine->pReadFile == FACT_INTERNAL_DefaultReadFile &&
+		pEngine->pGetOverlappedResult == FACT_INTERNAL_DefaultGetOverlappedResult	)
+	{
+		/* Our I/O doesn't care about packets, set to 0 as an optimization */
+		packetSize = 0;
+	}
+	else
+	{
+		packetSize = pParms->packetSize * 2048;
+	}
+	retval = FACT_INTERNAL_ParseWaveBank(
+		pEngine,
+		pParms->file,
+		pParms->offset,
+		packetSize,
+		pEngine->pReadFile,
+		pEngine->pGetOverlappedResult,
+		false,
+		true,
+		&pEngine->transcodePolicy,
+		ppWaveBank
+	);
+	if (retval != 0)
+	{
+		FAudio_PlatformUnlockMutex(pEngine->apiLock);
+		return retval;
+	}
+	FACT_INTERNAL_AddWaveBank(*ppWaveBank);
+	FACT_INTERNAL_QueueWaveBankPrepared(pEngine, *ppWaveBank);
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return retval;
+}
+
+uint32_t FACTAudioEngine_SetWaveCacheBudgetEXT(
+	FACTAudioEngine *pEngine,
+	uint32_t dwBudget
+) {
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	pEngine->cacheBudget = dwBudget;
+	FACT_INTERNAL_CacheTrim(pEngine, dwBudget);
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return FAUDIO_OK;
+}
+
+uint32_t FACTAudioEngine_SetTranscodePolicyEXT(
+	FACTAudioEngine *pEngine,
+	const FACTTranscodePolicyEXT *pPolicy
+) {
+	if (	pPolicy == NULL ||
+		(	pPolicy->target != FACT_TRANSCODE_PCM16_EXT &&
+			pPolicy->target != FACT_TRANSCODE_FLOAT_EXT	)	)
+	{
+		return FAUDIO_E_INVALID_ARG;
+	}
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	pEngine->transcodePolicy = *pPolicy;
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return FAUDIO_OK;
+}
+
+uint32_t FACTAudioEngine_GetTranscodedSizeEXT(
+	FACTAudioEngine *pEngine,
+	uint32_t *pdwBytes
+) {
+	FAudio_PlatformLockMutex(pEngine->apiLock);
+	*pdwBytes = pEngine->transcodedSize;
+	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	return FAUDIO_OK;
+}
+
 uint32_t FACTAudioEngine_PrepareWave(
 	FACTAudioEngine *pEngine,
 	uint32_t dwFlags,
@@ -722,7 +1020,7 @@ uint32_t FACTAudioEngine_RegisterNotification(FACTAudioEngine *engine, const FAC
 	if (!engine->notificationCallback)
 		return FACTENGINE_E_NONOTIFICATIONCALLBACK;
 
-	if (desc->type == 0 || desc->type > FACTNOTIFICATIONTYPE_WAVEBANKSTREAMING_INVALIDCONTENT)
+	if (desc->type == 0 || desc->type > FACTNOTIFICATIONTYPE_SOUNDBANKPREPARED_EXT)
 		return FAUDIO_E_INVALID_ARG;
 
 	FAudio_PlatformLockMutex(engine->apiLock);
@@ -777,44 +1075,8 @@ uint16_t FACTAudioEngine_GetCategory(
 	FACTAudioEngine *pEngine,
 	const char *szFriendlyName
 ) {
-	uint16_t i;
-	FAudio_PlatformLockMutex(pEngine->apiLock);
-	for (i = 0; i < pEngine->categoryCount; i += 1)
-	{
-		if (FAudio_strcmp(szFriendlyName, pEngine->categoryNames[i]) == 0)
-		{
-			FAudio_PlatformUnlockMutex(pEngine->apiLock);
-			return i;
-		}
-	}
-	FAudio_PlatformUnlockMutex(pEngine->apiLock);
-	return FACTCATEGORY_INVALID;
-}
-
-static bool FACT_INTERNAL_IsInCategory(
-	FACTAudioEngine *engine,
-	uint16_t target,
-	uint16_t category
-) {
-	FACTAudioCategory *cat;
-
-	/* Same category, no need to go on a crazy hunt */
-	if (category == target)
-	{
-		return true;
-	}
-
-	/* Right, on with the crazy hunt */
-	cat = &engine->categories[category];
-	while (cat->parentCategory != -1)
-	{
-		if (cat->parentCategory == target)
-		{
-			return true;
-		}
-		cat = &engine->categories[cat->parentCategory];
-	}
-	return false;
+	/* The name tables never change after parsing, no lock needed */
+	return FACT_INTERNAL_FindName(&pEngine->categoryLookup, szFriendlyName);
 }
 
 uint32_t FACTAudioEngine_Stop(
@@ -887,6 +1149,7 @@ uint32_t FACTAudioEngine_SetVolume(
 			);
 		}
 	}
+	FAudio_PlatformSignalSemaphore(pEngine->apiSignal);
 	FAudio_PlatformUnlockMutex(pEngine->apiLock);
 	return FAUDIO_OK;
 }
@@ -927,15 +1190,10 @@ uint16_t FACTAudioEngine_GetGlobalVariableIndex(
 	FACTAudioEngine *pEngine,
 	const char *szFriendlyName
 ) {
-	uint16_t i;
-	for (i = 0; i < pEngine->variableCount; i += 1)
-	{
-		if (!FAudio_strcmp(szFriendlyName, pEngine->variableNames[i]) &&
-			!(pEngine->variables[i].accessibility & ACCESSIBILITY_CUE) &&
-			(pEngine->variables[i].accessibility & ACCESSIBILITY_PUBLIC))
-			return i;
-	}
-	return FACTVARIABLEINDEX_INVALID;
+	return FACT_INTERNAL_FindName(
+		&pEngine->globalVariableLookup,
+		szFriendlyName
+	);
 }
 
 uint32_t FACTAudioEngine_SetGlobalVariable(
@@ -952,13 +1210,19 @@ uint32_t FACTAudioEngine_SetGlobalVariable(
 			|| (var->accessibility & ACCESSIBILITY_READONLY))
 		return FACTENGINE_E_INVALIDVARIABLEINDEX;
 
-	FAudio_PlatformLockMutex(pEngine->apiLock);
-	pEngine->globalVariableValues[nIndex] = FAudio_clamp(
-		nValue,
-		var->minValue,
-		var->maxValue
+	/* No apiLock here, the update thread folds this into
+	 * globalVariableVersion on its next pass
+	 */
+	store_variable(
+		&pEngine->globalVariableValues[nIndex],
+		FAudio_clamp(
+			nValue,
+			var->minValue,
+			var->maxValue
+		)
 	);
-	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	FAudio_PlatformAtomicSet(&pEngine->globalVariablesChanged, 1);
+	FAudio_PlatformSignalSemaphore(pEngine->apiSignal);
 	return FAUDIO_OK;
 }
 
@@ -975,9 +1239,7 @@ uint32_t FACTAudioEngine_GetGlobalVariable(
 	if (!(var->accessibility & ACCESSIBILITY_PUBLIC) || (var->accessibility & ACCESSIBILITY_CUE))
 		return FACTENGINE_E_INVALIDVARIABLEINDEX;
 
-	FAudio_PlatformLockMutex(pEngine->apiLock);
-	*pnValue = pEngine->globalVariableValues[nIndex];
-	FAudio_PlatformUnlockMutex(pEngine->apiLock);
+	*pnValue = load_variable(&pEngine->globalVariableValues[nIndex]);
 	return FAUDIO_OK;
 }
 
@@ -987,26 +1249,13 @@ uint16_t FACTSoundBank_GetCueIndex(
 	FACTSoundBank *pSoundBank,
 	const char *szFriendlyName
 ) {
-	uint16_t i;
 	if (pSoundBank == NULL)
 	{
 		return FACTINDEX_INVALID;
 	}
 
-	FAudio_PlatformLockMutex(pSoundBank->parentEngine->apiLock);
-	if (pSoundBank->cueNames != NULL)
-	for (i = 0; i < pSoundBank->cueCount; i += 1)
-	{
-		if (FAudio_strcmp(szFriendlyName, pSoundBank->cueNames[i]) == 0)
-		{
-			FAudio_PlatformUnlockMutex(
-				pSoundBank->parentEngine->apiLock
-			);
-			return i;
-		}
-	}
-	FAudio_PlatformUnlockMutex(pSoundBank->parentEngine->apiLock);
-	return FACTINDEX_INVALID;
+	/* The name tables never change after parsing, no lock needed */
+	return FACT_INTERNAL_FindName(&pSoundBank->cueLookup, szFriendlyName);
 }
 
 uint32_t FACTSoundBank_GetNumCues(
@@ -1177,7 +1426,18 @@ uint32_t FACTSoundBank_Prepare(
 	}
 
 	if (!interactive)
-		create_sound(*ppCue);
+	{
+		/* Preparing Waves needs their WaveBank, so wait for the load */
+		if (FACT_INTERNAL_CueWaitsForLoad(*ppCue))
+		{
+			(*ppCue)->loadQueued = true;
+			(*ppCue)->state = FACT_STATE_PREPARING;
+		}
+		else
+		{
+			create_sound(*ppCue);
+		}
+	}
 
 	FAudio_PlatformUnlockMutex(pSoundBank->parentEngine->apiLock);
 	return FAUDIO_OK;
@@ -1310,7 +1570,6 @@ uint32_t FACTSoundBank_Stop(
 
 uint32_t FACTSoundBank_Destroy(FACTSoundBank *pSoundBank)
 {
-	uint16_t i, j, k;
 	FAudioMutex mutex;
 
 	if (pSoundBank == NULL)
@@ -1334,88 +1593,9 @@ uint32_t FACTSoundBank_Destroy(FACTSoundBank *pSoundBank)
 		pSoundBank->parentEngine->pFree
 	);
 
-	/* SoundBank Name */
-	pSoundBank->parentEngine->pFree(pSoundBank->name);
-
-	/* Cue data */
-	pSoundBank->parentEngine->pFree(pSoundBank->cues);
-
-	/* WaveBank Name data */
-	for (i = 0; i < pSoundBank->wavebankCount; i += 1)
-	{
-		pSoundBank->parentEngine->pFree(pSoundBank->wavebankNames[i]);
-	}
-	pSoundBank->parentEngine->pFree(pSoundBank->wavebankNames);
-
-	/* Sound data */
-	for (i = 0; i < pSoundBank->soundCount; i += 1)
-	{
-		for (j = 0; j < pSoundBank->sounds[i].trackCount; j += 1)
-		{
-			for (k = 0; k < pSoundBank->sounds[i].tracks[j].eventCount; k += 1)
-			{
-				#define MATCH(t) \
-					pSoundBank->sounds[i].tracks[j].events[k].type == t
-				if (	MATCH(FACTEVENT_PLAYWAVE) ||
-					MATCH(FACTEVENT_PLAYWAVETRACKVARIATION) ||
-					MATCH(FACTEVENT_PLAYWAVEEFFECTVARIATION) ||
-					MATCH(FACTEVENT_PLAYWAVETRACKEFFECTVARIATION)	)
-				{
-					if (pSoundBank->sounds[i].tracks[j].events[k].wave.isComplex)
-					{
-						pSoundBank->parentEngine->pFree(
-							pSoundBank->sounds[i].tracks[j].events[k].wave.complex.wave_indices
-						);
-						pSoundBank->parentEngine->pFree(
-							pSoundBank->sounds[i].tracks[j].events[k].wave.complex.wavebanks
-						);
-						pSoundBank->parentEngine->pFree(
-							pSoundBank->sounds[i].tracks[j].events[k].wave.complex.weights
-						);
-					}
-				}
-				#undef MATCH
-			}
-			pSoundBank->parentEngine->pFree((void *)pSoundBank->sounds[i].tracks[j].events);
-		}
-		pSoundBank->parentEngine->pFree((void *)pSoundBank->sounds[i].tracks);
-		pSoundBank->parentEngine->pFree((void *)pSoundBank->sounds[i].rpc_codes.codes);
-		pSoundBank->parentEngine->pFree(pSoundBank->sounds[i].dspCodes);
-	}
-	pSoundBank->parentEngine->pFree((void *)pSoundBank->sounds);
-	pSoundBank->parentEngine->pFree(pSoundBank->soundCodes);
-
-	/* Variation data */
-	for (i = 0; i < pSoundBank->variationCount; i += 1)
-	{
-		pSoundBank->parentEngine->pFree(
-			pSoundBank->variations[i].entries
-		);
-	}
-	pSoundBank->parentEngine->pFree(pSoundBank->variations);
-
-	/* Transition data */
-	for (i = 0; i < pSoundBank->transitionCount; i += 1)
-	{
-		pSoundBank->parentEngine->pFree(
-			pSoundBank->transitions[i].entries
-		);
-	}
-	pSoundBank->parentEngine->pFree(pSoundBank->transitions);
-	pSoundBank->parentEngine->pFree(pSoundBank->transitionCodes);
-
-	/* Cue Name data */
-	if (pSoundBank->cueNames != NULL)
-	{
-		for (i = 0; i < pSoundBank->cueCount; i += 1)
-		{
-			pSoundBank->parentEngine->pFree(pSoundBank->cueNames[i]);
-		}
-		pSoundBank->parentEngine->pFree(pSoundBank->cueNames);
-	}
-
-	send_soundbank_notification(pSoundBank->parentEngine, pSoundBank);
+	send_soundbank_notification(pSoundBank->parentEngine, FACTNOTIFICATIONTYPE_SOUNDBANKDESTROYED, pSoundBank);
 
+	/* Everything else was parsed into the same allocation */
 	mutex = pSoundBank->parentEngine->apiLock;
 	pSoundBank->parentEngine->pFree(pSoundBank);
 	FAudio_PlatformUnlockMutex(mutex);
@@ -1490,6 +1670,9 @@ uint32_t FACTWaveBank_Destroy(FACTWaveBank *pWaveBank)
 		pWaveBank->parentEngine->pFree
 	);
 
+	/* Waits for a transcode batch that's decoding from this WaveBank */
+	FACT_INTERNAL_FreeTranscoded(pWaveBank);
+
 	/* Free everything, finally. */
 	pWaveBank->parentEngine->pFree(pWaveBank->name);
 	pWaveBank->parentEngine->pFree(pWaveBank->entries);
@@ -1508,7 +1691,12 @@ uint32_t FACTWaveBank_Destroy(FACTWaveBank *pWaveBank)
 		pWaveBank->parentEngine->pFree(pWaveBank->seekTables);
 	}
 
-	if (!pWaveBank->streaming)
+	if (pWaveBank->cache != NULL)
+	{
+		/* The file belongs to the application, same as streaming */
+		FACT_INTERNAL_CacheFreeBank(pWaveBank);
+	}
+	else if (!pWaveBank->streaming)
 	{
 		FAudio_close(pWaveBank->io);
 	}
@@ -1523,6 +1711,7 @@ uint32_t FACTWaveBank_Destroy(FACTWaveBank *pWaveBank)
 	if (pWaveBank->waveBankNames != NULL)
 	{
 		pWaveBank->parentEngine->pFree(pWaveBank->waveBankNames);
+		pWaveBank->parentEngine->pFree(pWaveBank->waveLookup.slots);
 	}
 
 	mutex = pWaveBank->parentEngine->apiLock;
@@ -1580,26 +1769,13 @@ uint16_t FACTWaveBank_GetWaveIndex(
 	FACTWaveBank *pWaveBank,
 	const char *szFriendlyName
 ) {
-	uint16_t i;
-	char *curName;
-	if (pWaveBank == NULL || pWaveBank->waveBankNames == NULL)
+	if (pWaveBank == NULL)
 	{
 		return FACTINDEX_INVALID;
 	}
 
-	FAudio_PlatformLockMutex(pWaveBank->parentEngine->apiLock);
-	curName = pWaveBank->waveBankNames;
-	for (i = 0; i < pWaveBank->entryCount; i += 1, curName += 64)
-	{
-		if (FAudio_strncmp(szFriendlyName, curName, 64) == 0)
-		{
-			FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
-			return i;
-		}
-	}
-	FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
-
-	return FACTINDEX_INVALID;
+	/* The name tables never change after parsing, no lock needed */
+	return FACT_INTERNAL_FindName(&pWaveBank->waveLookup, szFriendlyName);
 }
 
 uint32_t FACTWaveBank_GetWaveProperties(
@@ -1660,18 +1836,15 @@ uint32_t FACTWaveBank_GetWaveProperties(
 	return FAUDIO_OK;
 }
 
-uint32_t FACTWaveBank_Prepare(
+uint32_t FACT_INTERNAL_PrepareWave(
 	FACTWaveBank *pWaveBank,
 	uint16_t nWaveIndex,
 	uint32_t dwFlags,
 	uint32_t dwPlayOffset,
 	uint8_t nLoopCount,
+	bool reverb,
 	FACTWave **ppWave
 ) {
-	FAudioBuffer buffer;
-	FAudioBufferWMA bufferWMA;
-	FAudioVoiceSends sends;
-	FAudioSendDescriptor send;
 	union
 	{
 		FAudioWaveFormatEx pcm;
@@ -1680,6 +1853,7 @@ uint32_t FACTWaveBank_Prepare(
 	} format;
 	FACTWaveBankEntry *entry;
 	FACTSeekTable *seek;
+	uint32_t packetStride, i;
 	if (pWaveBank == NULL)
 	{
 		*ppWave = NULL;
@@ -1704,6 +1878,7 @@ uint32_t FACTWaveBank_Prepare(
 	(*ppWave)->volume = 1.0f;
 	(*ppWave)->pitch = 0;
 	(*ppWave)->loopCount = nLoopCount;
+	(*ppWave)->cachePending = false;
 
 	if (dwPlayOffset)
 		FAudio_Log("Unhandled play offset.\n");
@@ -1720,10 +1895,6 @@ uint32_t FACTWaveBank_Prepare(
 #endif
 
 	/* Create the voice */
-	send.Flags = 0;
-	send.pOutputVoice = pWaveBank->parentEngine->master;
-	sends.SendCount = 1;
-	sends.pSends = &send;
 	format.pcm.nChannels = entry->Format.nChannels;
 	format.pcm.nSamplesPerSec = entry->Format.nSamplesPerSec;
 	if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM)
@@ -1785,6 +1956,25 @@ uint32_t FACTWaveBank_Prepare(
 		format.xma2.bEncoderVersion = 4;
 		format.xma2.wBlockCount = seek->entryCount;
 	}
+	else if (	entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_ADPCM &&
+			pWaveBank->transcoded != NULL &&
+			pWaveBank->transcoded[nWaveIndex].data != NULL	)
+	{
+		/* Decoded at load time, see FACT_INTERNAL_TranscodeEntry */
+		if (pWaveBank->transcoded[nWaveIndex].isFloat)
+		{
+			format.pcm.wFormatTag = FAUDIO_FORMAT_IEEE_FLOAT;
+			format.pcm.wBitsPerSample = 32;
+		}
+		else
+		{
+			format.pcm.wFormatTag = FAUDIO_FORMAT_PCM;
+			format.pcm.wBitsPerSample = 16;
+		}
+		format.pcm.nBlockAlign = format.pcm.nChannels * format.pcm.wBitsPerSample / 8;
+		format.pcm.nAvgBytesPerSec = format.pcm.nBlockAlign * format.pcm.nSamplesPerSec;
+		format.pcm.cbSize = 0;
+	}
 	else if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_ADPCM)
 	{
 		format.pcm.wFormatTag = FAUDIO_FORMAT_MSADPCM;
@@ -1820,16 +2010,7 @@ uint32_t FACTWaveBank_Prepare(
 	(*ppWave)->callback.callback.OnVoiceProcessingPassStart = NULL;
 	(*ppWave)->callback.wave = *ppWave;
 	(*ppWave)->srcChannels = format.pcm.nChannels;
-	FAudio_CreateSourceVoice(
-		pWaveBank->parentEngine->audio,
-		&(*ppWave)->voice,
-		&format.pcm,
-		FAUDIO_VOICE_USEFILTER, /* FIXME: Can this be optional? */
-		4.0f,
-		(FAudioVoiceCallback*) &(*ppWave)->callback,
-		&sends,
-		NULL
-	);
+	FACT_INTERNAL_CreateWaveVoice(*ppWave, &format.pcm, reverb);
 	if (pWaveBank->streaming)
 	{
 		/* Init stream cache info */
@@ -1857,58 +2038,66 @@ uint32_t FACTWaveBank_Prepare(
 			FAudio_assert(entry->LoopRegion.dwStartSample == 0);
 			FAudio_assert(entry->LoopRegion.dwTotalSamples == 0 || entry->LoopRegion.dwTotalSamples == entry->Duration);
 		}
+		(*ppWave)->streamOffset = entry->PlayRegion.dwOffset;
+
+		/* Only read ahead if the wave doesn't fit in one packet */
+		(*ppWave)->streamPacketCount = (
+			((*ppWave)->streamSize < entry->PlayRegion.dwLength) ?
+				FACT_STREAM_PACKETS :
+				1
+		);
+		(*ppWave)->streamRead = 0;
+		(*ppWave)->streamSubmit = 0;
+		(*ppWave)->streamPlay = 0;
+		(*ppWave)->streamQueued = 0;
+		(*ppWave)->streamReading = 0;
+		(*ppWave)->streamStarved = 0;
+		(*ppWave)->streamPlayStart = FAudio_timems();
+		FAudio_zero(
+			&(*ppWave)->streamStats,
+			sizeof((*ppWave)->streamStats)
+		);
+		packetStride = (uint32_t) FACT_STREAM_ALIGN_UP(
+			(*ppWave)->streamSize + (pWaveBank->packetSize * 2)
+		);
 		(*ppWave)->streamCache = (uint8_t*) pWaveBank->parentEngine->pMalloc(
-			(*ppWave)->streamSize
+			(packetStride * (*ppWave)->streamPacketCount) +
+			FACT_STREAM_ALIGN
 		);
-		(*ppWave)->streamOffset = entry->PlayRegion.dwOffset;
+		FAudio_zero(
+			(*ppWave)->streamPackets,
+			sizeof((*ppWave)->streamPackets)
+		);
+		for (i = 0; i < (*ppWave)->streamPacketCount; i += 1)
+		{
+			(*ppWave)->streamPackets[i].data = (uint8_t*) (
+				FACT_STREAM_ALIGN_UP((size_t) (*ppWave)->streamCache) +
+				(packetStride * i)
+			);
+			(*ppWave)->streamPackets[i].offset = 0xFFFFFFFF;
+		}
+		(*ppWave)->streamLock = FAudio_PlatformCreateMutex();
 
-		/* Read and submit first buffer from the WaveBank */
-		FACT_INTERNAL_OnBufferEnd(&(*ppWave)->callback.callback, NULL);
+		/* Reads and submits the first buffer from the WaveBank */
+		FACT_INTERNAL_StreamAddWave(*ppWave);
 	}
 	else
 	{
 		(*ppWave)->streamCache = NULL;
 
-		buffer.Flags = FAUDIO_END_OF_STREAM;
-		buffer.AudioBytes = entry->PlayRegion.dwLength;
-		buffer.pAudioData = FAudio_memptr(
-			pWaveBank->io,
-			entry->PlayRegion.dwOffset
-		);
-		buffer.PlayBegin = 0;
-		buffer.PlayLength = entry->Duration;
-		if (nLoopCount == 0)
-		{
-			buffer.LoopBegin = 0;
-			buffer.LoopLength = 0;
-			buffer.LoopCount = 0;
-		}
-		else
-		{
-			buffer.LoopBegin = entry->LoopRegion.dwStartSample;
-			buffer.LoopLength = entry->LoopRegion.dwTotalSamples;
-			buffer.LoopCount = nLoopCount;
-		}
-		buffer.pContext = NULL;
-		if (format.pcm.wFormatTag == FAUDIO_FORMAT_WMAUDIO2)
+		/* Preparing the Wave is what loads a cached entry. If it isn't
+		 * resident, the stream thread reads it and the buffer goes in
+		 * once it's there, see FACT_INTERNAL_CachePublish.
+		 */
+		if (	pWaveBank->cache != NULL &&
+			FACT_INTERNAL_CacheAcquire(pWaveBank, nWaveIndex) == NULL	)
 		{
-			bufferWMA.pDecodedPacketCumulativeBytes =
-				pWaveBank->seekTables[nWaveIndex].entries;
-			bufferWMA.PacketCount =
-				pWaveBank->seekTables[nWaveIndex].entryCount;
-			FAudioSourceVoice_SubmitSourceBuffer(
-				(*ppWave)->voice,
-				&buffer,
-				&bufferWMA
-			);
+			(*ppWave)->state = FACT_STATE_PREPARING;
+			(*ppWave)->cachePending = true;
 		}
 		else
 		{
-			FAudioSourceVoice_SubmitSourceBuffer(
-				(*ppWave)->voice,
-				&buffer,
-				NULL
-			);
+			FACT_INTERNAL_SubmitWave(*ppWave);
 		}
 	}
 
@@ -1924,6 +2113,25 @@ uint32_t FACTWaveBank_Prepare(
 	return FAUDIO_OK;
 }
 
+uint32_t FACTWaveBank_Prepare(
+	FACTWaveBank *pWaveBank,
+	uint16_t nWaveIndex,
+	uint32_t dwFlags,
+	uint32_t dwPlayOffset,
+	uint8_t nLoopCount,
+	FACTWave **ppWave
+) {
+	return FACT_INTERNAL_PrepareWave(
+		pWaveBank,
+		nWaveIndex,
+		dwFlags,
+		dwPlayOffset,
+		nLoopCount,
+		false,
+		ppWave
+	);
+}
+
 uint32_t FACTWaveBank_Play(
 	FACTWaveBank *pWaveBank,
 	uint16_t nWaveIndex,
@@ -1977,6 +2185,58 @@ uint32_t FACTWaveBank_Stop(
 	return FAUDIO_OK;
 }
 
+uint32_t FACTWaveBank_PrefetchEXT(
+	FACTWaveBank *pWaveBank,
+	uint16_t nWaveIndex
+) {
+	if (pWaveBank == NULL)
+	{
+		return 1;
+	}
+	FAudio_PlatformLockMutex(pWaveBank->parentEngine->apiLock);
+	if (pWaveBank->cache == NULL || nWaveIndex >= pWaveBank->entryCount)
+	{
+		FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
+		return FAUDIO_E_INVALID_CALL;
+	}
+	FACT_INTERNAL_CachePrefetch(pWaveBank, nWaveIndex);
+	FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
+	return FAUDIO_OK;
+}
+
+uint32_t FACTWaveBank_TranscodeEXT(
+	FACTWaveBank *pWaveBank,
+	uint16_t nWaveIndex
+) {
+	FACTTranscodedEntry decoded;
+	bool isFloat;
+	if (pWaveBank == NULL)
+	{
+		return 1;
+	}
+	FAudio_PlatformLockMutex(pWaveBank->parentEngine->apiLock);
+	if (	nWaveIndex < pWaveBank->entryCount &&
+		pWaveBank->transcoded != NULL &&
+		pWaveBank->transcoded[nWaveIndex].data != NULL	)
+	{
+		FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
+		return FAUDIO_OK;
+	}
+	isFloat = (pWaveBank->parentEngine->transcodePolicy.target == FACT_TRANSCODE_FLOAT_EXT);
+	FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
+
+	/* Decode without the apiLock, only the result needs it */
+	FACT_INTERNAL_TranscodeDecode(pWaveBank, nWaveIndex, isFloat, &decoded);
+	if (decoded.data == NULL)
+	{
+		return FAUDIO_E_INVALID_CALL;
+	}
+	FAudio_PlatformLockMutex(pWaveBank->parentEngine->apiLock);
+	FACT_INTERNAL_TranscodePublish(pWaveBank, nWaveIndex, &decoded);
+	FAudio_PlatformUnlockMutex(pWaveBank->parentEngine->apiLock);
+	return FAUDIO_OK;
+}
+
 /* Wave implementation */
 
 uint32_t FACTWave_Destroy(FACTWave *pWave)
@@ -2001,9 +2261,20 @@ uint32_t FACTWave_Destroy(FACTWave *pWave)
 		pWave->parentBank->parentEngine->pFree
 	);
 
-	FAudioVoice_DestroyVoice(pWave->voice);
 	if (pWave->streamCache != NULL)
 	{
+		FACT_INTERNAL_StreamRemoveWave(pWave);
+	}
+
+	FACT_INTERNAL_DestroyWaveVoice(pWave);
+	if (pWave->parentBank->cache != NULL)
+	{
+		/* The voice is done with the data, it can be evicted now */
+		FACT_INTERNAL_CacheRelease(pWave->parentBank, pWave->index);
+	}
+	if (pWave->streamCache != NULL)
+	{
+		FAudio_PlatformDestroyMutex(pWave->streamLock);
 		pWave->parentBank->parentEngine->pFree(pWave->streamCache);
 	}
 	notification.pWave = pWave;
@@ -2031,8 +2302,11 @@ uint32_t FACTWave_Play(FACTWave *pWave)
 
 	if (!(pWave->state & FACT_STATE_PAUSED))
 	{
+		/* A Wave whose cached entry is still being read starts
+		 * playing as soon as it's loaded
+		 */
 		pWave->state |= FACT_STATE_PLAYING;
-		pWave->state &= ~FACT_STATE_PREPARED;
+		pWave->state &= ~(FACT_STATE_PREPARED | FACT_STATE_PREPARING);
 		FAudioSourceVoice_Start(pWave->voice, 0, 0);
 	}
 
@@ -2050,19 +2324,32 @@ uint32_t FACTWave_Stop(FACTWave *pWave, uint32_t dwFlags)
 	}
 	FAudio_PlatformLockMutex(pWave->parentBank->parentEngine->apiLock);
 
-	/* There are two ways that a Wave might be stopped immediately:
+	/* There are three ways that a Wave might be stopped immediately:
 	 * 1. The program explicitly asks for it
 	 * 2. The Wave is paused and therefore we can't do fade/release effects
+	 * 3. The Wave's cached entry isn't loaded, there's nothing to play out
 	 */
 	if (	dwFlags & FACT_FLAG_STOP_IMMEDIATE ||
-		pWave->state & FACT_STATE_PAUSED	)
+		pWave->state & FACT_STATE_PAUSED ||
+		pWave->cachePending	)
 	{
+		/* The stream thread submits under the streamLock, so nothing
+		 * gets queued behind the flush
+		 */
+		if (pWave->streamCache != NULL)
+		{
+			FAudio_PlatformLockMutex(pWave->streamLock);
+		}
 		pWave->state |= FACT_STATE_STOPPED;
 		pWave->state &= ~(
 			FACT_STATE_PLAYING |
 			FACT_STATE_STOPPING |
 			FACT_STATE_PAUSED
 		);
+		if (pWave->streamCache != NULL)
+		{
+			FAudio_PlatformUnlockMutex(pWave->streamLock);
+		}
 		FAudioSourceVoice_Stop(pWave->voice, 0, 0);
 		FAudioSourceVoice_FlushSourceBuffers(pWave->voice);
 	}
@@ -2277,6 +2564,27 @@ uint32_t FACTWave_GetProperties(
 	return FAUDIO_OK;
 }
 
+uint32_t FACTWave_GetStreamStatsEXT(
+	FACTWave *pWave,
+	FACTWaveStreamStatsEXT *pStats
+) {
+	if (pWave == NULL || pStats == NULL)
+	{
+		return FAUDIO_E_INVALID_CALL;
+	}
+	if (pWave->streamCache == NULL)
+	{
+		/* In-memory Waves don't stream */
+		FAudio_zero(pStats, sizeof(FACTWaveStreamStatsEXT));
+		return FACTENGINE_E_INVALIDUSAGE;
+	}
+
+	FAudio_PlatformLockMutex(pWave->streamLock);
+	*pStats = pWave->streamStats;
+	FAudio_PlatformUnlockMutex(pWave->streamLock);
+	return FAUDIO_OK;
+}
+
 /* Cue implementation */
 
 uint32_t FACTCue_Destroy(FACTCue *pCue)
@@ -2293,6 +2601,14 @@ uint32_t FACTCue_Destroy(FACTCue *pCue)
 	/* Stop before we start deleting everything */
 	FACTCue_Stop(pCue, FACT_FLAG_STOP_IMMEDIATE);
 
+	/* A Simple Wave that ended on its own is already stopped */
+	if (pCue->simpleWave != NULL)
+	{
+		FACTWave_Destroy(pCue->simpleWave);
+		pCue->simpleWave = NULL;
+	}
+	FACT_INTERNAL_RemoveInstance(pCue);
+
 	/* Remove this Cue from the SoundBank list */
 	cue = pCue->parentBank->cueList;
 	prev = cue;
@@ -2314,6 +2630,7 @@ uint32_t FACTCue_Destroy(FACTCue *pCue)
 		cue = cue->next;
 	}
 	FAudio_assert(cue != NULL && "Could not find Cue reference!");
+	FACT_INTERNAL_UnscheduleCue(pCue);
 
 	pCue->parentBank->parentEngine->pFree(pCue->variableValues);
 	FACT_INTERNAL_SendCueNotification(pCue, FACTNOTIFICATIONTYPE_CUEDESTROYED);
@@ -2339,6 +2656,15 @@ uint32_t FACTCue_Play(FACTCue *pCue)
 		return FACTENGINE_E_INVALIDUSAGE;
 	}
 
+	/* A WaveBank this needs is still loading, the load thread plays it */
+	if (pCue->loadQueued || FACT_INTERNAL_CueWaitsForLoad(pCue))
+	{
+		pCue->loadQueued = true;
+		pCue->loadPlay = true;
+		FAudio_PlatformUnlockMutex(pCue->parentBank->parentEngine->apiLock);
+		return FAUDIO_OK;
+	}
+
 	if (!play_sound(pCue))
 	{
 		FAudio_PlatformUnlockMutex(
@@ -2352,7 +2678,7 @@ uint32_t FACTCue_Play(FACTCue *pCue)
 
 	FACT_INTERNAL_SendCueNotification(pCue, FACTNOTIFICATIONTYPE_CUEPLAY);
 
-	pCue->start = FAudio_timems();
+	pCue->start = FACT_INTERNAL_GetTime(pCue->parentBank->parentEngine);
 
 	/* If it's a simple wave, just play it! */
 	if (pCue->simpleWave != NULL)
@@ -2369,6 +2695,8 @@ uint32_t FACTCue_Play(FACTCue *pCue)
 		FACTWave_Play(pCue->simpleWave);
 	}
 
+	FACT_INTERNAL_ScheduleCue(pCue);
+
 	FAudio_PlatformUnlockMutex(pCue->parentBank->parentEngine->apiLock);
 	return FAUDIO_OK;
 }
@@ -2415,8 +2743,11 @@ uint32_t FACTCue_Stop(FACTCue *pCue, uint32_t dwFlags)
 	{
 		pCue->start = 0;
 		pCue->elapsed = 0;
+		pCue->loadQueued = false;
+		pCue->loadPlay = false;
 		pCue->state |= FACT_STATE_STOPPED;
 		pCue->state &= ~(
+			FACT_STATE_PREPARING |
 			FACT_STATE_PLAYING |
 			FACT_STATE_STOPPING |
 			FACT_STATE_PAUSED
@@ -2427,7 +2758,7 @@ uint32_t FACTCue_Stop(FACTCue *pCue, uint32_t dwFlags)
 			FACTWave_Destroy(pCue->simpleWave);
 			pCue->simpleWave = NULL;
 
-			pCue->data->instanceCount -= 1;
+			FACT_INTERNAL_RemoveInstance(pCue);
 		}
 		else if (pCue->playingSound != NULL)
 		{
@@ -2457,6 +2788,9 @@ uint32_t FACTCue_Stop(FACTCue *pCue, uint32_t dwFlags)
 		}
 	}
 
+	/* Managed Cues get cleaned up by the API thread */
+	FACT_INTERNAL_ScheduleCue(pCue);
+
 	FACT_INTERNAL_SendCueNotification(pCue, FACTNOTIFICATIONTYPE_CUESTOP);
 
 	FAudio_PlatformUnlockMutex(pCue->parentBank->parentEngine->apiLock);
@@ -2470,9 +2804,8 @@ uint32_t FACTCue_GetState(FACTCue *pCue, uint32_t *pdwState)
 		*pdwState = 0;
 		return 1;
 	}
-	FAudio_PlatformLockMutex(pCue->parentBank->parentEngine->apiLock);
+	/* A single read, no need to wait out an update pass */
 	*pdwState = pCue->state;
-	FAudio_PlatformUnlockMutex(pCue->parentBank->parentEngine->apiLock);
 	return FAUDIO_OK;
 }
 
@@ -2540,20 +2873,14 @@ uint16_t FACTCue_GetVariableIndex(
 	FACTCue *pCue,
 	const char *szFriendlyName
 ) {
-	FACTAudioEngine *engine = pCue->parentBank->parentEngine;
-
 	if (pCue == NULL)
 	{
 		return FACTVARIABLEINDEX_INVALID;
 	}
-	for (uint16_t i = 0; i < engine->variableCount; ++i)
-	{
-		if (!FAudio_strcmp(szFriendlyName, engine->variableNames[i]) &&
-			(engine->variables[i].accessibility & ACCESSIBILITY_CUE) &&
-			(engine->variables[i].accessibility & ACCESSIBILITY_PUBLIC))
-			return i;
-	}
-	return FACTVARIABLEINDEX_INVALID;
+	return FACT_INTERNAL_FindName(
+		&pCue->parentBank->parentEngine->cueVariableLookup,
+		szFriendlyName
+	);
 }
 
 uint32_t FACTCue_SetVariable(
@@ -2574,15 +2901,20 @@ uint32_t FACTCue_SetVariable(
 			|| (var->accessibility & ACCESSIBILITY_READONLY))
 		return FACTENGINE_E_INVALIDVARIABLEINDEX;
 
-	FAudio_PlatformLockMutex(pCue->parentBank->parentEngine->apiLock);
-
-	pCue->variableValues[nIndex] = FAudio_clamp(
-		nValue,
-		var->minValue,
-		var->maxValue
+	/* No apiLock here, the update thread folds this into
+	 * variableVersion the next time it updates the Cue. Cues that
+	 * are playing are already in the run list, so a wakeup is enough.
+	 */
+	store_variable(
+		&pCue->variableValues[nIndex],
+		FAudio_clamp(
+			nValue,
+			var->minValue,
+			var->maxValue
+		)
 	);
-
-	FAudio_PlatformUnlockMutex(pCue->parentBank->parentEngine->apiLock);
+	FAudio_PlatformAtomicSet(&pCue->variablesChanged, 1);
+	FAudio_PlatformSignalSemaphore(pCue->parentBank->parentEngine->apiSignal);
 	return FAUDIO_OK;
 }
 
@@ -2604,18 +2936,14 @@ uint32_t FACTCue_GetVariable(
 	if (!(var->accessibility & ACCESSIBILITY_PUBLIC) || !(var->accessibility & ACCESSIBILITY_CUE))
 		return FACTENGINE_E_INVALIDVARIABLEINDEX;
 
-	FAudio_PlatformLockMutex(pCue->parentBank->parentEngine->apiLock);
-
 	if (nIndex == 0) /* NumCueInstances */
 	{
 		*nValue = pCue->parentBank->cues[pCue->index].instanceCount;
 	}
 	else
 	{
-		*nValue = pCue->variableValues[nIndex];
+		*nValue = load_variable(&pCue->variableValues[nIndex]);
 	}
-
-	FAudio_PlatformUnlockMutex(pCue->parentBank->parentEngine->apiLock);
 	return FAUDIO_OK;
 }
 
@@ -2639,7 +2967,10 @@ uint32_t FACTCue_Pause(FACTCue *pCue, int32_t fPause)
 	}
 
 	/* Store elapsed time */
-	pCue->elapsed += FAudio_timems() - pCue->start;
+	pCue->elapsed += (
+		FACT_INTERNAL_GetTime(pCue->parentBank->parentEngine) -
+		pCue->start
+	);
 
 	/* All we do is set the flag, not much to see here */
 	if (fPause)
@@ -2649,6 +2980,7 @@ uint32_t FACTCue_Pause(FACTCue *pCue, int32_t fPause)
 	else
 	{
 		pCue->state &= ~FACT_STATE_PAUSED;
+		FACT_INTERNAL_ScheduleCue(pCue);
 	}
 
 	/* Pause the Waves */
@@ -177,9 +177,7 @@ static inline void FACT_INTERNAL_ReadFile(
 void FACT_INTERNAL_GetNextWave(FACTCue *cue, const FACTSound *sound, const FACTTrack *track,
 	FACTTrackInstance *trackInst, const FACTEvent *evt, FACTEventInstance *evtInst)
 {
-	FAudioSendDescriptor reverbDesc[2];
 	bool has_variation = false;
-	FAudioVoiceSends reverbSends;
 	const char *wbName;
 	FACTWaveBank *wb = NULL;
 	LinkedList *list;
@@ -275,21 +273,16 @@ void FACT_INTERNAL_GetNextWave(FACTCue *cue, const FACTSound *sound, const FACTT
 		/* For infinite loops with no variation, let Wave do the work */
 		loopCount = 255;
 	}
-	FACTWaveBank_Prepare(wb, wave_index, evt->wave.flags, 0, loopCount, &trackInst->upcomingWave.wave);
+	FACT_INTERNAL_PrepareWave(
+		wb,
+		wave_index,
+		evt->wave.flags,
+		0,
+		loopCount,
+		sound->dspCodeCount > 0, /* Never more than 1...? */
+		&trackInst->upcomingWave.wave
+	);
 	trackInst->upcomingWave.wave->parentCue = cue;
-	if (sound->dspCodeCount > 0) /* Never more than 1...? */
-	{
-		reverbDesc[0].Flags = 0;
-		reverbDesc[0].pOutputVoice = cue->parentBank->parentEngine->master;
-		reverbDesc[1].Flags = 0;
-		reverbDesc[1].pOutputVoice = cue->parentBank->parentEngine->reverbVoice;
-		reverbSends.SendCount = 2;
-		reverbSends.pSends = reverbDesc;
-		FAudioVoice_SetOutputVoices(
-			trackInst->upcomingWave.wave->voice,
-			&reverbSends
-		);
-	}
 
 	/* 3D Audio */
 	if (cue->active3D)
@@ -527,11 +520,10 @@ static bool get_active_variation_index(FACTCue *cue, uint16_t *index)
 /* Returns false if the behaviour is FAIL. */
 static bool handle_instance_limit(FACTCue *cue, FACTAudioCategory *category)
 {
-	const FACTAudioEngine *engine = cue->parentBank->parentEngine;
 	float quietest_volume = FACTVOLUME_MAX;
 	enum max_instance_behavior behaviour;
 	uint8_t lowest_priority = UINT8_MAX;
-	FACTCue *replaced = NULL;
+	FACTCue *cursor, *replaced = NULL;
 
 	if (category)
 		behaviour = category->maxInstanceBehavior;
@@ -544,14 +536,16 @@ static bool handle_instance_limit(FACTCue *cue, FACTAudioCategory *category)
 		return false;
 	}
 
-	for (FACTCue *cursor = cue->parentBank->cueList; cursor; cursor = cursor->next)
+	/* Only the counted instances are candidates, oldest first */
+	if (category)
+		cursor = category->instanceHead;
+	else
+		cursor = cue->data->instanceHead;
+	for (; cursor; cursor = category ? cursor->categoryInstanceNext : cursor->dataInstanceNext)
 	{
 		if (cursor == cue || !cursor->playingSound || (cursor->state & (FACT_STATE_STOPPING | FACT_STATE_STOPPED)))
 			continue;
 
-		if (category && category != &engine->categories[cursor->playingSound->sound->category])
-			continue;
-
 		/* FIXME: How does QUEUE differ from REPLACE_OLDEST? */
 		if (behaviour == MAX_INSTANCE_BEHAVIOR_QUEUE
 			|| behaviour == MAX_INSTANCE_BEHAVIOR_REPLACE_OLDEST)
@@ -677,6 +671,9 @@ void create_sound(FACTCue *cue)
 		newSound->rpcData.rpcReverbSend = 0.0f;
 		newSound->rpcData.rpcFilterQFactor = FAUDIO_DEFAULT_FILTER_ONEOVERQ;
 		newSound->rpcData.rpcFilterFreq = FAUDIO_DEFAULT_FILTER_FREQUENCY;
+		newSound->rpcDepends = RPC_DEPENDS_DIRTY;
+		newSound->rpcCueVersion = 0;
+		newSound->rpcGlobalVersion = 0;
 		newSound->variation_index = variation_index;
 		newSound->state = SOUND_STATE_STOPPED;
 		newSound->tracks = (FACTTrackInstance*) cue->parentBank->parentEngine->pMalloc(
@@ -798,17 +795,12 @@ void create_sound(FACTCue *cue)
 					newSound->sound->tracks[i].rpc_codes.codes[j]
 				);
 				if (	rpc->parameter == RPC_PARAMETER_VOLUME &&
-					(cue->parentBank->parentEngine->variables[rpc->variable].accessibility & ACCESSIBILITY_CUE))
+					rpc->source == RPC_SOURCE_RELEASETIME	)
 				{
-					if (FAudio_strcmp(
-						newSound->parentCue->parentBank->parentEngine->variableNames[rpc->variable],
-						"ReleaseTime"
-					) == 0) {
-						lastX = rpc->points[rpc->pointCount - 1].x;
-						if (lastX > cue->maxRpcReleaseTime)
-						{
-							cue->maxRpcReleaseTime = (uint32_t) lastX /* bleh */;
-						}
+					lastX = rpc->points[rpc->pointCount - 1].x;
+					if (lastX > cue->maxRpcReleaseTime)
+					{
+						cue->maxRpcReleaseTime = (uint32_t) lastX /* bleh */;
 					}
 				}
 			}
@@ -818,11 +810,114 @@ void create_sound(FACTCue *cue)
 	}
 }
 
+static void add_instance(FACTCue *cue, FACTAudioCategory *category)
+{
+	cue->isInstance = true;
+
+	cue->dataInstanceNext = NULL;
+	cue->dataInstancePrev = cue->data->instanceTail;
+	if (cue->data->instanceTail != NULL)
+	{
+		cue->data->instanceTail->dataInstanceNext = cue;
+	}
+	else
+	{
+		cue->data->instanceHead = cue;
+	}
+	cue->data->instanceTail = cue;
+	++cue->data->instanceCount;
+
+	cue->instanceCategory = category;
+	if (category != NULL)
+	{
+		cue->categoryInstanceNext = NULL;
+		cue->categoryInstancePrev = category->instanceTail;
+		if (category->instanceTail != NULL)
+		{
+			category->instanceTail->categoryInstanceNext = cue;
+		}
+		else
+		{
+			category->instanceHead = cue;
+		}
+		category->instanceTail = cue;
+		++category->instanceCount;
+	}
+}
+
+void FACT_INTERNAL_RemoveInstance(FACTCue *cue)
+{
+	FACTAudioCategory *category = cue->instanceCategory;
+
+	if (!cue->isInstance)
+	{
+		return;
+	}
+	cue->isInstance = false;
+
+	if (cue->dataInstancePrev != NULL)
+	{
+		cue->dataInstancePrev->dataInstanceNext = cue->dataInstanceNext;
+	}
+	else
+	{
+		cue->data->instanceHead = cue->dataInstanceNext;
+	}
+	if (cue->dataInstanceNext != NULL)
+	{
+		cue->dataInstanceNext->dataInstancePrev = cue->dataInstancePrev;
+	}
+	else
+	{
+		cue->data->instanceTail = cue->dataInstancePrev;
+	}
+	cue->dataInstanceNext = NULL;
+	cue->dataInstancePrev = NULL;
+	cue->data->instanceCount -= 1;
+
+	if (category != NULL)
+	{
+		if (cue->categoryInstancePrev != NULL)
+		{
+			cue->categoryInstancePrev->categoryInstanceNext = cue->categoryInstanceNext;
+		}
+		else
+		{
+			category->instanceHead = cue->categoryInstanceNext;
+		}
+		if (cue->categoryInstanceNext != NULL)
+		{
+			cue->categoryInstanceNext->categoryInstancePrev = cue->categoryInstancePrev;
+		}
+		else
+		{
+			category->instanceTail = cue->categoryInstancePrev;
+		}
+		cue->categoryInstanceNext = NULL;
+		cue->categoryInstancePrev = NULL;
+		category->instanceCount -= 1;
+		cue->instanceCategory = NULL;
+	}
+}
+
 bool play_sound(FACTCue *cue)
 {
 	FACTSoundInstance *sound;
+	FACTAudioCategory *category = NULL;
 	uint16_t fade_in_ms = 0;
 
+	/* Simple Waves have no Sound, only the Cue limit applies. */
+	if (cue->simpleWave != NULL)
+	{
+		if (cue->data->instanceCount >= cue->data->instanceLimit)
+		{
+			if (!handle_instance_limit(cue, NULL))
+				return false;
+		}
+		add_instance(cue, NULL);
+		return true;
+	}
+
 	/* Interactive cues might not currently have a sound. */
 	if (!cue->playingSound)
 		return true;
@@ -837,22 +932,20 @@ bool play_sound(FACTCue *cue)
 
 	if (sound->sound->category != FACTCATEGORY_INVALID)
 	{
-		FACTAudioCategory *category = &cue->parentBank->parentEngine->categories[sound->sound->category];
+		category = &cue->parentBank->parentEngine->categories[sound->sound->category];
 		if (category->instanceCount >= category->instanceLimit)
 		{
 			if (!handle_instance_limit(cue, category))
 				return false;
 			fade_in_ms = category->fadeInMS;
 		}
-
-		++category->instanceCount;
 	}
-	++cue->data->instanceCount;
+	add_instance(cue, category);
 
 	if (fade_in_ms)
 	{
 		sound->fadeTarget = fade_in_ms;
-		sound->fadeStart = FAudio_timems();
+		sound->fadeStart = FACT_INTERNAL_GetTime(cue->parentBank->parentEngine);
 		sound->state = SOUND_STATE_FADE_IN;
 	}
 	else
@@ -888,18 +981,12 @@ void FACT_INTERNAL_DestroySound(FACTSoundInstance *sound)
 	}
 	sound->parentCue->parentBank->parentEngine->pFree(sound->tracks);
 
-	if (sound->sound->category != FACTCATEGORY_INVALID)
-	{
-		sound->parentCue->parentBank->parentEngine->categories[
-			sound->sound->category
-		].instanceCount -= 1;
-	}
+	FACT_INTERNAL_RemoveInstance(sound->parentCue);
 
 	/* TODO: if (sound->parentCue->playingSounds == NULL) */
 	{
 		sound->parentCue->state |= FACT_STATE_STOPPED;
 		sound->parentCue->state &= ~(FACT_STATE_PLAYING | FACT_STATE_PAUSED | FACT_STATE_STOPPING);
-		sound->parentCue->data->instanceCount -= 1;
 
 		FACT_INTERNAL_SendCueNotification(sound->parentCue, FACTNOTIFICATIONTYPE_CUESTOP);
 	}
@@ -922,10 +1009,13 @@ void FACT_INTERNAL_BeginFadeOut(FACTSoundInstance *sound, uint16_t fadeOutMS)
 #endif
 
 	sound->state = SOUND_STATE_FADE_OUT;
-	sound->fadeStart = FAudio_timems();
+	sound->fadeStart = FACT_INTERNAL_GetTime(
+		sound->parentCue->parentBank->parentEngine
+	);
 	sound->fadeTarget = fadeOutMS;
 
 	sound->parentCue->state |= FACT_STATE_STOPPING;
+	FACT_INTERNAL_ScheduleCue(sound->parentCue);
 }
 
 void FACT_INTERNAL_BeginReleaseRPC(FACTSoundInstance *sound, uint16_t releaseMS)
@@ -938,10 +1028,16 @@ void FACT_INTERNAL_BeginReleaseRPC(FACTSoundInstance *sound, uint16_t releaseMS)
 	}
 
 	sound->state = SOUND_STATE_RELEASE_RPC;
-	sound->fadeStart = FAudio_timems();
+	sound->fadeStart = FACT_INTERNAL_GetTime(
+		sound->parentCue->parentBank->parentEngine
+	);
 	sound->fadeTarget = releaseMS;
 
+	/* ReleaseTime RPCs start counting now */
+	sound->rpcDepends |= RPC_DEPENDS_DIRTY;
+
 	sound->parentCue->state |= FACT_STATE_STOPPING;
+	FACT_INTERNAL_ScheduleCue(sound->parentCue);
 }
 
 static float FACT_INTERNAL_CalculateRPC(
@@ -949,7 +1045,8 @@ static float FACT_INTERNAL_CalculateRPC(
 	float var
 ) {
 	float result;
-	uint8_t i;
+	float maxY, deltaXNormalized;
+	uint8_t lo, hi, mid;
 
 	/* Min/Max */
 	if (var <= rpc->points[0].x)
@@ -963,51 +1060,61 @@ static float FACT_INTERNAL_CalculateRPC(
 		return rpc->points[rpc->pointCount - 1].y;
 	}
 
-	/* Something between points */
-	result = 0.0f;
-	for (i = 0; i < rpc->pointCount - 1; i += 1)
+	/* Something between points, find the first segment that ends at or
+	 * after var. Steps (points sharing an x) resolve to the lower side.
+	 */
+	lo = 0;
+	hi = rpc->pointCount - 1;
+	while (hi - lo > 1)
 	{
-		/* y = b */
-		result = rpc->points[i].y;
-		if (var >= rpc->points[i].x && var <= rpc->points[i + 1].x)
+		mid = (lo + hi) / 2;
+		if (var > rpc->points[mid].x)
 		{
-			const float maxX = rpc->points[i + 1].x - rpc->points[i].x;
-			const float maxY = rpc->points[i + 1].y - rpc->points[i].y;
-			const float deltaX = (var - rpc->points[i].x);
-			const float deltaXNormalized = deltaX / maxX;
-
-			switch (rpc->points[i].type)
-			{
-				case RPC_POINT_TYPE_LINEAR:
-					result += maxY * deltaXNormalized;
-					break;
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
 
-				case RPC_POINT_TYPE_FAST:
-					result += maxY * (1.0f - FAudio_powf(1.0f - FAudio_powf(deltaXNormalized, 1.0f / 1.5f), 1.5f));
-					break;
+	/* y = b */
+	result = rpc->points[lo].y;
+	maxY = rpc->points[hi].y - rpc->points[lo].y;
+	deltaXNormalized = (
+		(var - rpc->points[lo].x) /
+		(rpc->points[hi].x - rpc->points[lo].x)
+	);
 
-				case RPC_POINT_TYPE_SLOW:
-					result += maxY * (1.0f - FAudio_powf(1.0f - FAudio_powf(deltaXNormalized, 1.5f), 1.0f / 1.5f));
-					break;
+	switch (rpc->points[lo].type)
+	{
+		case RPC_POINT_TYPE_LINEAR:
+			result += maxY * deltaXNormalized;
+			break;
 
-				case RPC_POINT_TYPE_SINCOS:
-					if (maxY > 0.0f)
-						result += maxY * (1.0f - FAudio_powf(1.0f - FAudio_sqrtf(deltaXNormalized), 2.0f));
-					else
-						result += maxY * (1.0f - FAudio_sqrtf(1.0f - FAudio_powf(deltaXNormalized, 2.0f)));
-					break;
+		case RPC_POINT_TYPE_FAST:
+			result += maxY * (1.0f - FAudio_powf(1.0f - FAudio_powf(deltaXNormalized, 1.0f / 1.5f), 1.5f));
+			break;
 
-				default:
-					FAudio_assert(0 && "Unrecognized curve type!");
-			}
+		case RPC_POINT_TYPE_SLOW:
+			result += maxY * (1.0f - FAudio_powf(1.0f - FAudio_powf(deltaXNormalized, 1.5f), 1.0f / 1.5f));
+			break;
 
+		case RPC_POINT_TYPE_SINCOS:
+			if (maxY > 0.0f)
+				result += maxY * (1.0f - FAudio_powf(1.0f - FAudio_sqrtf(deltaXNormalized), 2.0f));
+			else
+				result += maxY * (1.0f - FAudio_sqrtf(1.0f - FAudio_powf(deltaXNormalized, 2.0f)));
 			break;
-		}
+
+		default:
+			FAudio_assert(0 && "Unrecognized curve type!");
 	}
 	return result;
 }
 
-static void FACT_INTERNAL_UpdateRPCs(
+/* Returns the RPC_DEPENDS_* flags for what the results were computed from */
+static uint8_t FACT_INTERNAL_UpdateRPCs(
 	FACTCue *cue,
 	const struct rpc_codes *rpc_codes,
 	FACTInstanceRPCData *data,
@@ -1017,6 +1124,7 @@ static void FACT_INTERNAL_UpdateRPCs(
 	FACTRPC *rpc;
 	float rpcResult;
 	float variableValue;
+	uint8_t depends = 0;
 	FACTAudioEngine *engine = cue->parentBank->parentEngine;
 
 	if (rpc_codes->count > 0)
@@ -1031,44 +1139,39 @@ static void FACT_INTERNAL_UpdateRPCs(
 				engine,
 				rpc_codes->codes[i]
 			);
-			if (engine->variables[rpc->variable].accessibility & ACCESSIBILITY_CUE)
+			switch (rpc->source)
 			{
-				if (FAudio_strcmp(
-					engine->variableNames[rpc->variable],
-					"AttackTime"
-				) == 0) {
+				case RPC_SOURCE_ATTACKTIME:
 					variableValue = (float) elapsedTrack;
-				}
-				else if (FAudio_strcmp(
-					engine->variableNames[rpc->variable],
-					"ReleaseTime"
-				) == 0) {
+					depends |= RPC_DEPENDS_TIME;
+					break;
+
+				case RPC_SOURCE_RELEASETIME:
 					if (cue->playingSound->state == SOUND_STATE_RELEASE_RPC)
 					{
 						variableValue = (float) (timestamp - cue->playingSound->fadeStart);
+						depends |= RPC_DEPENDS_TIME;
 					}
 					else
 					{
 						variableValue = 0.0f;
 					}
-				}
-				else
-				{
+					break;
+
+				case RPC_SOURCE_CUE:
 					variableValue = cue->variableValues[rpc->variable];
-				}
+					depends |= RPC_DEPENDS_CUE;
+					break;
 
-				rpcResult = FACT_INTERNAL_CalculateRPC(
-					rpc,
-					variableValue
-				);
-			}
-			else
-			{
-				rpcResult = FACT_INTERNAL_CalculateRPC(
-					rpc,
-					engine->globalVariableValues[rpc->variable]
-				);
+				default:
+					variableValue = engine->globalVariableValues[rpc->variable];
+					depends |= RPC_DEPENDS_GLOBAL;
+					break;
 			}
+			rpcResult = FACT_INTERNAL_CalculateRPC(
+				rpc,
+				variableValue
+			);
 			if (rpc->parameter == RPC_PARAMETER_VOLUME)
 			{
 				data->rpcVolume += rpcResult;
@@ -1100,6 +1203,7 @@ static void FACT_INTERNAL_UpdateRPCs(
 			}
 		}
 	}
+	return depends;
 }
 
 /* Engine Update Function */
@@ -1109,6 +1213,20 @@ static void FACT_INTERNAL_UpdateEngine(FACTAudioEngine *engine)
 	FAudioFXReverbParameters rvbPar;
 	uint16_t i, j, par;
 	float rpcResult;
+
+	/* SetGlobalVariable doesn't take apiLock, pick up its writes here */
+	if (FAudio_PlatformAtomicExchange(&engine->globalVariablesChanged, 0))
+	{
+		engine->globalVariableVersion += 1;
+	}
+
+	/* DSP parameters only come from global variables */
+	if (engine->dspVariableVersion == engine->globalVariableVersion)
+	{
+		return;
+	}
+	engine->dspVariableVersion = engine->globalVariableVersion;
+
 	for (i = 0; i < engine->rpcCount; i += 1)
 	{
 		if (engine->rpcs[i].parameter >= RPC_PARAMETER_COUNT)
@@ -1395,14 +1513,33 @@ static void FACT_INTERNAL_ActivateEvent(FACTSoundInstance *sound, const FACTTrac
 	evtInst->finished = true;
 }
 
-static bool FACT_INTERNAL_UpdateSound(FACTSoundInstance *sound, uint32_t timestamp)
-{
+/* Fades, ramps and time-based RPCs are continuous, so while any of those are
+ * running the Sound still gets updated at this interval.
+ * FIXME: 10ms is based on the XAudio2 update time...?
+ */
+#define FACT_UPDATE_INTERVAL 10
+#define FACT_UPDATE_NEVER 0xFFFFFFFF
+
+/* Number of Cues the API thread updates before letting go of apiLock */
+#define FACT_UPDATE_BATCH 32
+
+/* delay is lowered to the number of milliseconds until this Sound next needs
+ * an update, not counting Wave completion (which wakes the thread itself).
+ */
+static bool FACT_INTERNAL_UpdateSound(
+	FACTSoundInstance *sound,
+	uint32_t timestamp,
+	uint32_t *delay
+) {
 	uint8_t i, j;
 	uint32_t waveState;
 	uint32_t elapsedCue;
 	FACTEventInstance *evtInst;
 	FAudioFilterParameters filterParams;
+	FACTCue *cue = sound->parentCue;
+	FACTAudioEngine *engine = cue->parentBank->parentEngine;
 	bool finished = true;
+	uint8_t depends;
 
 	if (sound->state == SOUND_STATE_STOPPED)
 		return false;
@@ -1452,33 +1589,51 @@ static bool FACT_INTERNAL_UpdateSound(FACTSoundInstance *sound, uint32_t timesta
 	{
 		fadeVolume = 1.0f;
 	}
+	if (sound->state != SOUND_STATE_PLAYING)
+	{
+		*delay = FAudio_min(*delay, FACT_UPDATE_INTERVAL);
+	}
 
 	/* To get the time on a single Cue, subtract from the global time
 	 * the latest start time minus the total time elapsed (minus pause time)
 	 */
 	elapsedCue = timestamp - (sound->parentCue->start - sound->parentCue->elapsed);
 
-	/* RPC updates */
-	sound->rpcData.rpcFilterFreq = -1.0f;
-	sound->rpcData.rpcFilterQFactor = -1.0f;
-	FACT_INTERNAL_UpdateRPCs(
-		sound->parentCue,
-		&sound->sound->rpc_codes,
-		&sound->rpcData,
-		timestamp,
-		elapsedCue - sound->tracks[0].events[0].timestamp
-	);
-	for (i = 0; i < sound->sound->trackCount; i += 1)
+	/* RPC updates, if anything they're based on has changed */
+	if (	(sound->rpcDepends & (RPC_DEPENDS_TIME | RPC_DEPENDS_DIRTY)) ||
+		(	(sound->rpcDepends & RPC_DEPENDS_CUE) &&
+			sound->rpcCueVersion != cue->variableVersion	) ||
+		(	(sound->rpcDepends & RPC_DEPENDS_GLOBAL) &&
+			sound->rpcGlobalVersion != engine->globalVariableVersion	)	)
 	{
-		sound->tracks[i].rpcData.rpcFilterFreq = sound->rpcData.rpcFilterFreq;
-		sound->tracks[i].rpcData.rpcFilterQFactor = sound->rpcData.rpcFilterQFactor;
-		FACT_INTERNAL_UpdateRPCs(
-			sound->parentCue,
-			&sound->sound->tracks[i].rpc_codes,
-			&sound->tracks[i].rpcData,
+		sound->rpcCueVersion = cue->variableVersion;
+		sound->rpcGlobalVersion = engine->globalVariableVersion;
+		sound->rpcData.rpcFilterFreq = -1.0f;
+		sound->rpcData.rpcFilterQFactor = -1.0f;
+		depends = FACT_INTERNAL_UpdateRPCs(
+			cue,
+			&sound->sound->rpc_codes,
+			&sound->rpcData,
 			timestamp,
-			elapsedCue - sound->sound->tracks[i].events[0].timestamp
+			elapsedCue - sound->tracks[0].events[0].timestamp
 		);
+		for (i = 0; i < sound->sound->trackCount; i += 1)
+		{
+			sound->tracks[i].rpcData.rpcFilterFreq = sound->rpcData.rpcFilterFreq;
+			sound->tracks[i].rpcData.rpcFilterQFactor = sound->rpcData.rpcFilterQFactor;
+			depends |= FACT_INTERNAL_UpdateRPCs(
+				cue,
+				&sound->sound->tracks[i].rpc_codes,
+				&sound->tracks[i].rpcData,
+				timestamp,
+				elapsedCue - sound->sound->tracks[i].events[0].timestamp
+			);
+		}
+		sound->rpcDepends = depends;
+	}
+	if (sound->rpcDepends & RPC_DEPENDS_TIME)
+	{
+		*delay = FAudio_min(*delay, FACT_UPDATE_INTERVAL);
 	}
 
 	/* Go through each event for each track */
@@ -1504,6 +1659,22 @@ static bool FACT_INTERNAL_UpdateSound(FACTSoundInstance *sound, uint32_t timesta
 						evtInst,
 						elapsedCue
 					);
+
+					/* Ramps stay due, and events that
+					 * fired may have stopped Waves on
+					 * tracks we've already updated
+					 */
+					*delay = FAudio_min(
+						*delay,
+						FACT_UPDATE_INTERVAL
+					);
+				}
+				else
+				{
+					*delay = FAudio_min(
+						*delay,
+						evtInst->timestamp - elapsedCue
+					);
 				}
 			}
 		}
@@ -1531,6 +1702,8 @@ static bool FACT_INTERNAL_UpdateSound(FACTSoundInstance *sound, uint32_t timesta
 			sound->tracks[i].upcomingWave.wave = NULL;
 			if (sound->tracks[i].activeWave.wave == NULL)
 			{
+				/* Nothing will wake us for this, check right away */
+				*delay = 0;
 				continue;
 			}
 			FACTWave_Play(sound->tracks[i].activeWave.wave);
@@ -1600,6 +1773,12 @@ static void FACT_INTERNAL_UpdateCue(FACTCue *cue)
 	float next;
 	FACTSoundInstance *sound;
 
+	/* SetVariable doesn't take apiLock, pick up its writes here */
+	if (FAudio_PlatformAtomicExchange(&cue->variablesChanged, 0))
+	{
+		cue->variableVersion += 1;
+	}
+
 	/* Interactive sound selection */
 	if (!(cue->data->flags & CUE_FLAG_SINGLE_SOUND) && cue->variation && cue->variation->type == VARIATION_TABLE_TYPE_INTERACTIVE)
 	{
@@ -1650,12 +1829,7 @@ static void FACT_INTERNAL_UpdateCue(FACTCue *cue)
 				}
 				cue->parentBank->parentEngine->pFree(sound->tracks);
 
-				if (sound->sound->category != FACTCATEGORY_INVALID)
-				{
-					sound->parentCue->parentBank->parentEngine->categories[
-						sound->sound->category
-					].instanceCount -= 1;
-				}
+				FACT_INTERNAL_RemoveInstance(cue);
 			}
 
 			/* TODO: Reset cue times? Transition tables...?
@@ -1676,12 +1850,144 @@ static void FACT_INTERNAL_UpdateCue(FACTCue *cue)
 
 /* FACT Thread */
 
+/* If the mixer hasn't run a pass for this long (device lost, engine stopped,
+ * or just not started yet), the clock runs off FAudio_timems() instead.
+ */
+#define FACT_CLOCK_STALE 50
+
+static uint32_t FACT_INTERNAL_ReadClock(
+	FACTAudioEngine *engine,
+	uint32_t *sincePass
+) {
+	uint32_t wall, time;
+
+	/* The mixer publishes both values, make sure they're from one pass */
+	do
+	{
+		wall = FAudio_PlatformAtomicGet(&engine->clockWall);
+		time = FAudio_PlatformAtomicGet(&engine->clockTime);
+	} while (wall != FAudio_PlatformAtomicGet(&engine->clockWall));
+
+	*sincePass = FAudio_timems() - wall;
+	return time;
+}
+
+/* Event timing follows the mixer rather than the wall clock, so that Waves
+ * and ramps line up with what's actually being rendered. The time is the
+ * mixer position (in milliseconds) at the start of the next processing
+ * pass, which is the earliest point anything the API thread does can be
+ * heard, so events land on the quantum they're due in.
+ */
+uint32_t FACT_INTERNAL_GetTime(FACTAudioEngine *engine)
+{
+	uint32_t sincePass;
+	uint32_t time = FACT_INTERNAL_ReadClock(engine, &sincePass);
+
+	/* No mixer to follow, keep counting from the last pass */
+	if (sincePass > FACT_CLOCK_STALE)
+	{
+		time += sincePass;
+	}
+	return time;
+}
+
+void FAUDIOCALL FACT_INTERNAL_OnProcessingPassStart(FAudioEngineCallback *callback)
+{
+	FACTAudioEngine *engine = ((FACTEngineCallback*) callback)->engine;
+	FAudio *audio = engine->audio;
+	uint32_t sincePass, last, time;
+
+	last = FACT_INTERNAL_ReadClock(engine, &sincePass);
+
+	/* Count this pass, it's already too late to change it */
+	engine->clockSamples += audio->updateSize;
+	time = engine->clockBase + (uint32_t) (
+		engine->clockSamples * 1000 /
+		audio->master->master.inputSampleRate
+	);
+
+	/* GetTime has been running off the wall clock, pick up from where it
+	 * got to so that the time never goes backwards
+	 */
+	if (	sincePass > FACT_CLOCK_STALE &&
+		(int32_t) (last + sincePass - time) > 0	)
+	{
+		engine->clockBase += last + sincePass - time;
+		time = last + sincePass;
+	}
+	FAudio_PlatformAtomicSet(&engine->clockTime, time);
+	FAudio_PlatformAtomicSet(&engine->clockWall, FAudio_timems());
+
+	/* Wake the API thread once the next Cue is due */
+	if (	FAudio_PlatformAtomicGet(&engine->clockArmed) &&
+		(int32_t) (FAudio_PlatformAtomicGet(&engine->clockDue) - time) <= 0 &&
+		FAudio_PlatformAtomicExchange(&engine->clockArmed, 0)	)
+	{
+		FAudio_PlatformAtomicSet(&engine->clockFired, 1);
+		FAudio_PlatformSignalSemaphore(engine->apiSignal);
+	}
+}
+
+void FACT_INTERNAL_ScheduleCue(FACTCue *cue)
+{
+	FACTAudioEngine *engine = cue->parentBank->parentEngine;
+
+	/* Caller holds apiLock */
+	if (!cue->scheduled)
+	{
+		cue->activePrev = NULL;
+		cue->activeNext = engine->activeCues;
+		if (engine->activeCues != NULL)
+		{
+			engine->activeCues->activePrev = cue;
+		}
+		engine->activeCues = cue;
+		cue->scheduled = true;
+	}
+	cue->due = FACT_INTERNAL_GetTime(engine);
+	cue->timed = true;
+	FAudio_PlatformSignalSemaphore(engine->apiSignal);
+}
+
+void FACT_INTERNAL_UnscheduleCue(FACTCue *cue)
+{
+	FACTAudioEngine *engine = cue->parentBank->parentEngine;
+
+	/* Caller holds apiLock */
+	if (!cue->scheduled)
+	{
+		return;
+	}
+	if (cue->activePrev != NULL)
+	{
+		cue->activePrev->activeNext = cue->activeNext;
+	}
+	else
+	{
+		engine->activeCues = cue->activeNext;
+	}
+	if (cue->activeNext != NULL)
+	{
+		cue->activeNext->activePrev = cue->activePrev;
+	}
+	if (engine->updateNext == cue)
+	{
+		/* The update thread was going to this Cue next */
+		engine->updateNext = cue->activeNext;
+	}
+	cue->activeNext = NULL;
+	cue->activePrev = NULL;
+	cue->scheduled = false;
+	cue->timed = false;
+}
+
 int32_t FACT_INTERNAL_APIThread(void* enginePtr)
 {
 	FACTAudioEngine *engine = (FACTAudioEngine*) enginePtr;
-	LinkedList *sbList;
-	FACTCue *cue, *cBackup;
-	uint32_t timestamp, updateTime;
+	FACTCue *cue;
+	uint32_t timestamp, delay, nextDue, batch, sincePass;
+	int32_t timeout, wakeups;
+	bool signaled = true, waiting;
 
 	/* Needs to match the audio thread priority, or else the scheduler will
 	 * let this thread sit around with a lock while the audio thread spins
@@ -1698,81 +2004,190 @@ threadstart:
 	 * so all the various actions will go together even if it takes
 	 * an extra millisecond to get through the whole Cue list.
 	 */
-	timestamp = FAudio_timems();
+	timestamp = FACT_INTERNAL_GetTime(engine);
 
 	FACT_INTERNAL_UpdateEngine(engine);
 
-	sbList = engine->sbList;
-	while (sbList != NULL)
+	/* Waves waiting on a cached entry get it before the Cues are run */
+	FACT_INTERNAL_CachePublish(engine);
+
+	/* Only Cues that are playing or stopping are in the run list. A timer
+	 * wakeup only updates the Cues that are due, but anything else that
+	 * wakes us (API calls, Waves ending) updates all of them, since we
+	 * can't tell which Cue it was for.
+	 */
+	waiting = false;
+	nextDue = 0;
+	batch = 0;
+	cue = engine->activeCues;
+	while (cue != NULL)
 	{
-		cue = ((FACTSoundBank*) sbList->entry)->cueList;
-		while (cue != NULL)
-		{
-			FACT_INTERNAL_UpdateCue(cue);
+		/* Anything that unschedules a Cue (including the Cue
+		 * itself being destroyed below) keeps this pointing at
+		 * the next live Cue, see FACT_INTERNAL_UnscheduleCue
+		 */
+		engine->updateNext = cue->activeNext;
 
-			if (cue->state & FACT_STATE_PAUSED)
+		if (!signaled && (!cue->timed || (int32_t) (cue->due - timestamp) > 0))
+		{
+			if (cue->timed && (!waiting || (int32_t) (cue->due - nextDue) < 0))
 			{
-				/* Funky edge case where we need to keep updating even when paused */
-				if (!(cue->state & FACT_STATE_STOPPING))
-				{
-					cue = cue->next;
-					continue;
-				}
+				nextDue = cue->due;
+				waiting = true;
 			}
+			cue = engine->updateNext;
+			continue;
+		}
+
+		FACT_INTERNAL_UpdateCue(cue);
+
+		delay = FACT_UPDATE_NEVER;
 
+		/* Funky edge case where we need to keep updating even when paused */
+		if (	!(cue->state & FACT_STATE_PAUSED) ||
+			(cue->state & FACT_STATE_STOPPING)	)
+		{
 			if (cue->playingSound != NULL)
 			{
-				if (FACT_INTERNAL_UpdateSound(cue->playingSound, timestamp))
+				if (FACT_INTERNAL_UpdateSound(cue->playingSound, timestamp, &delay))
 				{
 					FACT_INTERNAL_DestroySound(cue->playingSound);
 				}
 			}
+		}
 
-			/* Destroy if it's done and not user-handled. */
-			if (cue->managed && (cue->state & FACT_STATE_STOPPED))
+		/* Destroy if it's done and not user-handled. */
+		if (cue->managed && (cue->state & FACT_STATE_STOPPED))
+		{
+			FACTCue_Destroy(cue);
+		}
+		else if (	!(cue->state & (FACT_STATE_PLAYING | FACT_STATE_STOPPING)) ||
+				(	(cue->state & FACT_STATE_PAUSED) &&
+					!(cue->state & FACT_STATE_STOPPING)	)	)
+		{
+			/* Simple Waves stop on the audio thread, so the
+			 * instance is released here instead
+			 */
+			if (cue->state & FACT_STATE_STOPPED)
 			{
-				cBackup = cue->next;
-				FACTCue_Destroy(cue);
-				cue = cBackup;
+				FACT_INTERNAL_RemoveInstance(cue);
 			}
-			else
+
+			/* Play, Pause and Stop will put it back */
+			FACT_INTERNAL_UnscheduleCue(cue);
+		}
+		else
+		{
+			/* Simple Waves and idle Sounds wait for a wakeup */
+			cue->timed = (delay != FACT_UPDATE_NEVER);
+			if (cue->timed)
 			{
-				cue = cue->next;
+				cue->due = timestamp + delay;
+				if (!waiting || (int32_t) (cue->due - nextDue) < 0)
+				{
+					nextDue = cue->due;
+					waiting = true;
+				}
 			}
 		}
-		sbList = sbList->next;
+
+		/* Don't hold apiLock for the whole list, so that API
+		 * calls made while a lot of Cues are playing still get
+		 * in quickly. Cues scheduled in the meantime go to the
+		 * front of the list and signal us, so they are picked
+		 * up on the next pass.
+		 */
+		batch += 1;
+		if (batch == FACT_UPDATE_BATCH && engine->updateNext != NULL)
+		{
+			batch = 0;
+			FAudio_PlatformUnlockMutex(engine->apiLock);
+
+			/* Mutexes aren't fair, without giving up the rest
+			 * of our time slice we'd usually take the lock back
+			 * before a waiting thread even wakes up
+			 */
+			FAudio_sleep(0);
+
+			FAudio_PlatformLockMutex(engine->apiLock);
+		}
+
+		cue = engine->updateNext;
 	}
+	engine->updateNext = NULL;
 
 	FAudio_PlatformUnlockMutex(engine->apiLock);
 
 	if (engine->initialized)
 	{
-		/* FIXME: 10ms is based on the XAudio2 update time...? */
-		updateTime = FAudio_timems() - timestamp;
-		if (updateTime < 10)
+		/* Sleep until the mixer reaches the next Cue that's due, or
+		 * until something else wakes us
+		 */
+		timeout = -1;
+		if (waiting)
 		{
-			FAudio_sleep(10 - updateTime);
-		}
-		goto threadstart;
-	}
+			timestamp = FACT_INTERNAL_ReadClock(engine, &sincePass);
+			if (sincePass > FACT_CLOCK_STALE)
+			{
+				timestamp += sincePass;
+			}
+			timeout = (int32_t) (nextDue - timestamp);
+			if (timeout <= 0)
+			{
+				timeout = 0;
+			}
+			else
+			{
+				FAudio_PlatformAtomicSet(&engine->clockDue, nextDue);
+				FAudio_PlatformAtomicSet(&engine->clockArmed, 1);
+
+				/* While the mixer is running its clock wakes us,
+				 * the timeout is only there in case it stops
+				 */
+				if (sincePass <= FACT_CLOCK_STALE)
+				{
+					timeout += FACT_CLOCK_STALE;
+				}
+			}
+		}
+		wakeups = 0;
+		if (FAudio_PlatformWaitSemaphore(engine->apiSignal, timeout))
+		{
+			/* One update covers every wakeup that's queued up */
+			wakeups = 1;
+			while (FAudio_PlatformWaitSemaphore(engine->apiSignal, 0))
+			{
+				wakeups += 1;
+			}
+		}
+		FAudio_PlatformAtomicSet(&engine->clockArmed, 0);
+
+		/* If the mixer clock was the only thing that woke us, this is
+		 * a timer wakeup and only the Cues that are due get updated.
+		 * A clock signal that comes in late just causes an extra pass.
+		 */
+		if (FAudio_PlatformAtomicExchange(&engine->clockFired, 0))
+		{
+			wakeups -= 1;
+		}
+		signaled = (wakeups > 0);
+		goto threadstart;
+	}
 
 	return 0;
 }
 
-/* FAudio callbacks */
+/* Stream thread */
 
-void FACT_INTERNAL_OnBufferEnd(FAudioVoiceCallback *callback, void* pContext)
+static uint32_t FACT_INTERNAL_StreamEnd(FACTWave *wave)
 {
-	FAudioBuffer buffer;
-	FAudioBufferWMA bufferWMA;
-	FACTWaveCallback *c = (FACTWaveCallback*) callback;
 	FACTWaveBankEntry *entry;
-	uint32_t end, left, length;
+	uint32_t length;
 
-	entry = &c->wave->parentBank->entries[c->wave->index];
+	entry = &wave->parentBank->entries[wave->index];
 
-	/* Calculate total bytes left in this wave iteration */
-	if (c->wave->loopCount > 0 && entry->LoopRegion.dwTotalSamples > 0)
+	/* Calculate total bytes in this wave iteration */
+	if (wave->loopCount > 0 && entry->LoopRegion.dwTotalSamples > 0)
 	{
 		length = entry->LoopRegion.dwStartSample + entry->LoopRegion.dwTotalSamples;
 		if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM)
@@ -1793,167 +2208,2484 @@ void FACT_INTERNAL_OnBufferEnd(FAudioVoiceCallback *callback, void* pContext)
 				((entry->Format.wBlockAlign + 22) * entry->Format.nChannels)
 			);
 		}
-		else
+		else
+		{
+			length = entry->PlayRegion.dwLength;
+		}
+	}
+	else
+	{
+		length = entry->PlayRegion.dwLength;
+	}
+	return entry->PlayRegion.dwOffset + length;
+}
+
+/* Assigns the next region of the stream to the packet at streamRead.
+ * Returns 0 if there is nothing left to read (EOS or stopped), otherwise the
+ * packet is either PENDING and needs to be read, or READY if it already held
+ * that region. Call with streamLock held!
+ */
+static uint8_t FACT_INTERNAL_StreamSchedule(FACTWave *wave)
+{
+	FACTWaveBankEntry *entry;
+	FACTStreamPacket *packet;
+	uint32_t end, offset, length;
+
+	entry = &wave->parentBank->entries[wave->index];
+	packet = &wave->streamPackets[wave->streamRead];
+	end = FACT_INTERNAL_StreamEnd(wave);
+
+	/* Don't bother if we're EOS or the Wave has stopped */
+	if (	(wave->streamOffset >= end) ||
+		(wave->state & FACT_STATE_STOPPED)	)
+	{
+		return 0;
+	}
+
+	offset = wave->streamOffset;
+	length = FAudio_min(wave->streamSize, end - offset);
+	wave->streamOffset += length;
+
+	/* Last buffer in the stream? */
+	packet->flags = 0;
+	if (wave->streamOffset >= end)
+	{
+		/* Loop if applicable */
+		if (wave->loopCount > 0)
+		{
+			if (wave->loopCount != 255)
+			{
+				wave->loopCount -= 1;
+			}
+			wave->streamOffset = entry->PlayRegion.dwOffset;
+
+			/* Loop start */
+			if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM)
+			{
+				wave->streamOffset += (
+					entry->LoopRegion.dwStartSample *
+					entry->Format.nChannels *
+					(1 << entry->Format.wBitsPerSample)
+				);
+			}
+			else if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_ADPCM)
+			{
+				wave->streamOffset += (
+					entry->LoopRegion.dwStartSample /
+					/* wSamplesPerBlock */
+					((entry->Format.wBlockAlign + 16) * 2) *
+					/* nBlockAlign */
+					((entry->Format.wBlockAlign + 22) * entry->Format.nChannels)
+				);
+			}
+		}
+		else
+		{
+			packet->flags = FAUDIO_END_OF_STREAM;
+		}
+	}
+
+	wave->streamRead = (wave->streamRead + 1) % wave->streamPacketCount;
+
+	/* Short looping waves land on the same region over and over */
+	if (packet->offset == offset && packet->length == length)
+	{
+		packet->state = FACT_STREAMPACKET_READY;
+		wave->streamStats.packetsReused += 1;
+	}
+	else
+	{
+		packet->offset = offset;
+		packet->length = length;
+		packet->state = FACT_STREAMPACKET_PENDING;
+		wave->streamStats.packetsRead += 1;
+	}
+	return 1;
+}
+
+/* Gives every free packet its region. Call with streamLock held! */
+static void FACT_INTERNAL_StreamScheduleAll(FACTWave *wave)
+{
+	while (	wave->streamPackets[wave->streamRead].state == FACT_STREAMPACKET_EMPTY &&
+		FACT_INTERNAL_StreamSchedule(wave)	);
+}
+
+/* Queues every ready packet on the voice, in stream order. Packets may finish
+ * reading in any order, so this stops at the first one that isn't ready.
+ * Call with streamLock held!
+ */
+static void FACT_INTERNAL_StreamSubmit(FACTWave *wave)
+{
+	FAudioBuffer buffer;
+	FAudioBufferWMA bufferWMA;
+	FACTStreamPacket *packet;
+
+	/* Don't bother if the Wave has stopped */
+	if (wave->state & FACT_STATE_STOPPED)
+	{
+		return;
+	}
+
+	packet = &wave->streamPackets[wave->streamSubmit];
+	while (packet->state == FACT_STREAMPACKET_READY)
+	{
+		if (wave->streamStarved)
+		{
+			wave->streamStats.starvedMS += (
+				FAudio_timems() - wave->streamStarveStart
+			);
+			wave->streamStarved = 0;
+		}
+		wave->streamStats.packetsSubmitted += 1;
+		packet->state = FACT_STREAMPACKET_QUEUED;
+		if (wave->streamQueued == 0)
+		{
+			/* The voice was dry, it plays this one right away */
+			wave->streamPlayStart = FAudio_timems();
+		}
+		wave->streamQueued += 1;
+		wave->streamSubmit = (wave->streamSubmit + 1) % wave->streamPacketCount;
+
+		/* Assign buffer memory */
+		buffer.pAudioData = packet->data + packet->skip;
+		buffer.AudioBytes = packet->length;
+		buffer.Flags = packet->flags;
+
+		/* Unused properties */
+		buffer.PlayBegin = 0;
+		buffer.PlayLength = 0;
+		buffer.LoopBegin = 0;
+		buffer.LoopLength = 0;
+		buffer.LoopCount = 0;
+		buffer.pContext = NULL;
+
+		/* Submit, finally. */
+		if (wave->parentBank->entries[wave->index].Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_WMA)
+		{
+			bufferWMA.pDecodedPacketCumulativeBytes =
+				wave->parentBank->seekTables[wave->index].entries;
+			bufferWMA.PacketCount =
+				wave->parentBank->seekTables[wave->index].entryCount;
+			FAudioSourceVoice_SubmitSourceBuffer(
+				wave->voice,
+				&buffer,
+				&bufferWMA
+			);
+		}
+		else
+		{
+			FAudioSourceVoice_SubmitSourceBuffer(
+				wave->voice,
+				&buffer,
+				NULL
+			);
+		}
+
+		packet = &wave->streamPackets[wave->streamSubmit];
+	}
+}
+
+/* Works out the sector-aligned region to read for a packet. When the read goes
+ * straight into the packet, the padding in front is skipped on submit.
+ */
+static void FACT_INTERNAL_StreamAlign(
+	FACTWave *wave,
+	FACTStreamPacket *packet,
+	uint32_t *offset,
+	uint32_t *length
+) {
+	FACTWaveBank *wb = wave->parentBank;
+	uint32_t lenPacket;
+
+	/* We have to read data in multiples of the sector size, or else
+	 * Win32 ReadFile returns ERROR_INVALID_PARAMETER
+	 */
+	*offset = wb->file_offset + packet->offset;
+	*length = packet->length;
+	packet->skip = 0;
+	if (wb->packetSize > 0)
+	{
+		packet->skip = *offset % wb->packetSize;
+		*offset -= packet->skip;
+		*length += packet->skip;
+		lenPacket = *length % wb->packetSize;
+		if (lenPacket > 0)
+		{
+			*length += (wb->packetSize - lenPacket);
+		}
+	}
+}
+
+static void FACT_INTERNAL_StreamIssue(
+	FACTAudioEngine *engine,
+	FACTStreamRead *read
+) {
+	read->ovlp.Internal = NULL;
+	read->ovlp.InternalHigh = NULL;
+	read->ovlp.Offset = read->offset;
+	read->ovlp.OffsetHigh = 0; /* I sure hope so... */
+	read->ovlp.hEvent = NULL;
+	engine->pReadFile(
+		read->io,
+		read->data,
+		read->length,
+		NULL,
+		&read->ovlp
+	);
+}
+
+static void FACT_INTERNAL_StreamComplete(
+	FACTAudioEngine *engine,
+	FACTStreamRead *read
+) {
+	uint32_t result;
+
+	/* bWait blocks until the read has landed, same as Win32 */
+	engine->pGetOverlappedResult(read->io, &read->ovlp, &result, 1);
+}
+static int FACT_INTERNAL_StreamCompareOffset(const void *a, const void *b)
+{
+	const FACTStreamRequest *ra = (const FACTStreamRequest*) a;
+	const FACTStreamRequest *rb = (const FACTStreamRequest*) b;
+	if (ra->io != rb->io)
+	{
+		return ((size_t) ra->io < (size_t) rb->io) ? -1 : 1;
+	}
+	if (ra->offset != rb->offset)
+	{
+		return (ra->offset < rb->offset) ? -1 : 1;
+	}
+	return 0;
+}
+
+/* Deadlines are FAudio_timems() values, which wrap */
+#define FACT_STREAM_BEFORE(a, b) ((int32_t) ((a) - (b)) < 0)
+
+static int FACT_INTERNAL_StreamCompareDeadline(const void *a, const void *b)
+{
+	const FACTStreamRead *ra = (const FACTStreamRead*) a;
+	const FACTStreamRead *rb = (const FACTStreamRead*) b;
+	if (ra->deadline != rb->deadline)
+	{
+		return FACT_STREAM_BEFORE(ra->deadline, rb->deadline) ? -1 : 1;
+	}
+
+	/* Same deadline, keep going up the file */
+	if (ra->first != rb->first)
+	{
+		return (ra->first < rb->first) ? -1 : 1;
+	}
+	return 0;
+}
+
+/* How long the voice takes to play a packet, in milliseconds */
+static uint32_t FACT_INTERNAL_StreamPacketMS(
+	FACTWave *wave,
+	FACTStreamPacket *packet,
+	double rate
+) {
+	FACTWaveBankEntry *entry = &wave->parentBank->entries[wave->index];
+	uint32_t samples;
+
+	if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM)
+	{
+		samples = packet->length / (
+			entry->Format.nChannels *
+			(1 << entry->Format.wBitsPerSample)
+		);
+	}
+	else if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_ADPCM)
+	{
+		samples = packet->length /
+			/* nBlockAlign */
+			((entry->Format.wBlockAlign + 22) * entry->Format.nChannels) *
+			/* wSamplesPerBlock */
+			((entry->Format.wBlockAlign + 16) * 2);
+	}
+	else
+	{
+		/* These always fit in one packet */
+		samples = entry->Duration;
+	}
+	return (uint32_t) (samples * 1000.0 / rate);
+}
+
+/* Gives the free packets of every streaming Wave their regions, then claims
+ * every packet that needs a read. Returns the request count.
+ * Call with the engine streamLock held!
+ */
+static uint32_t FACT_INTERNAL_StreamGather(FACTAudioEngine *engine)
+{
+	FACTWave *wave;
+	FACTStreamPacket *packet;
+	FACTStreamRequest *request;
+	LinkedList *list;
+	uint32_t count = 0, due;
+	double rate;
+	uint8_t j;
+
+	list = engine->streamWaves;
+	while (list != NULL)
+	{
+		wave = (FACTWave*) list->entry;
+		FAudio_PlatformLockMutex(wave->streamLock);
+		FACT_INTERNAL_StreamScheduleAll(wave);
+
+		/* A loop may have found some of them still in memory */
+		FACT_INTERNAL_StreamSubmit(wave);
+
+		/* Walk the packets in the order the voice plays them, adding up
+		 * how long it takes to get to each one. Pitch changes how fast
+		 * the voice goes through them.
+		 */
+		rate = (
+			wave->parentBank->entries[wave->index].Format.nSamplesPerSec *
+			FAudio_pow(2.0, wave->pitch / 1200.0)
+		);
+		due = wave->streamPlayStart;
+		for (j = 0; j < wave->streamPacketCount; j += 1)
+		{
+			packet = &wave->streamPackets[
+				(wave->streamPlay + j) % wave->streamPacketCount
+			];
+			if (packet->state == FACT_STREAMPACKET_EMPTY)
+			{
+				break;
+			}
+			if (packet->state != FACT_STREAMPACKET_PENDING)
+			{
+				due += FACT_INTERNAL_StreamPacketMS(wave, packet, rate);
+				continue;
+			}
+			if (count == engine->streamRequestCapacity)
+			{
+				engine->streamRequestCapacity += FACT_STREAM_PACKETS * 4;
+				engine->streamRequests = (FACTStreamRequest*) engine->pRealloc(
+					engine->streamRequests,
+					sizeof(FACTStreamRequest) * engine->streamRequestCapacity
+				);
+				engine->streamReads = (FACTStreamRead*) engine->pRealloc(
+					engine->streamReads,
+					sizeof(FACTStreamRead) * engine->streamRequestCapacity
+				);
+			}
+			request = &engine->streamRequests[count++];
+			request->wave = wave;
+			request->packet = packet;
+			request->io = wave->parentBank->io;
+			FACT_INTERNAL_StreamAlign(
+				wave,
+				packet,
+				&request->offset,
+				&request->length
+			);
+			packet->state = FACT_STREAMPACKET_READING;
+			wave->streamReading += 1;
+			request->deadline = due;
+			due += FACT_INTERNAL_StreamPacketMS(wave, packet, rate);
+		}
+		FAudio_PlatformUnlockMutex(wave->streamLock);
+		list = list->next;
+	}
+	return count;
+}
+
+/* Sorts the requests by file offset and merges neighbors into single reads,
+ * then orders the reads by their most urgent packet. Returns the read count.
+ */
+static uint32_t FACT_INTERNAL_StreamCoalesce(
+	FACTAudioEngine *engine,
+	uint32_t requestCount
+) {
+	FACTStreamRequest *request;
+	FACTStreamRead *read = NULL;
+	uint32_t i, end, scratchLen, readCount = 0;
+
+	FAudio_qsort(
+		engine->streamRequests,
+		requestCount,
+		sizeof(FACTStreamRequest),
+		FACT_INTERNAL_StreamCompareOffset
+	);
+
+	scratchLen = 0;
+	for (i = 0; i < requestCount; i += 1)
+	{
+		request = &engine->streamRequests[i];
+		end = request->offset + request->length;
+		if (	read != NULL &&
+			read->io == request->io &&
+			request->offset <= read->offset + read->length &&
+			end - read->offset <= FACT_STREAM_COALESCE_MAX	)
+		{
+			read->length = FAudio_max(read->length, end - read->offset);
+			if (FACT_STREAM_BEFORE(request->deadline, read->deadline))
+			{
+				read->deadline = request->deadline;
+			}
+			read->count += 1;
+			continue;
+		}
+		if (read != NULL && read->count > 1)
+		{
+			scratchLen += FACT_STREAM_ALIGN_UP(read->length);
+		}
+		read = &engine->streamReads[readCount++];
+		read->io = request->io;
+		read->offset = request->offset;
+		read->length = request->length;
+		read->first = i;
+		read->count = 1;
+		read->deadline = request->deadline;
+	}
+	if (read != NULL && read->count > 1)
+	{
+		scratchLen += FACT_STREAM_ALIGN_UP(read->length);
+	}
+
+	/* Single packets are read in place, merged ones share a scratch
+	 * buffer that gets copied out once the read lands
+	 */
+	if (scratchLen > engine->streamScratchLen)
+	{
+		engine->streamScratchLen = scratchLen;
+		engine->streamScratch = (uint8_t*) engine->pRealloc(
+			engine->streamScratch,
+			scratchLen + FACT_STREAM_ALIGN
+		);
+	}
+	scratchLen = (uint32_t) (
+		FACT_STREAM_ALIGN_UP((size_t) engine->streamScratch) -
+		(size_t) engine->streamScratch
+	);
+	for (i = 0; i < readCount; i += 1)
+	{
+		read = &engine->streamReads[i];
+		if (read->count > 1)
+		{
+			read->data = engine->streamScratch + scratchLen;
+			scratchLen += FACT_STREAM_ALIGN_UP(read->length);
+		}
+		else
+		{
+			read->data = engine->streamRequests[read->first].packet->data;
+		}
+	}
+
+	FAudio_qsort(
+		engine->streamReads,
+		readCount,
+		sizeof(FACTStreamRead),
+		FACT_INTERNAL_StreamCompareDeadline
+	);
+	return readCount;
+}
+
+static void FACT_INTERNAL_StreamFinish(
+	FACTAudioEngine *engine,
+	FACTStreamRead *read
+) {
+	FACTStreamRequest *request;
+	FACTWave *wave;
+	uint32_t i;
+
+	for (i = read->first; i < read->first + read->count; i += 1)
+	{
+		request = &engine->streamRequests[i];
+		wave = request->wave;
+		if (read->count > 1)
+		{
+			FAudio_memcpy(
+				request->packet->data,
+				read->data + (
+					wave->parentBank->file_offset +
+					request->packet->offset -
+					read->offset
+				),
+				request->packet->length
+			);
+			request->packet->skip = 0;
+		}
+		FAudio_PlatformLockMutex(wave->streamLock);
+		request->packet->state = FACT_STREAMPACKET_READY;
+		wave->streamReading -= 1;
+		FACT_INTERNAL_StreamSubmit(wave);
+		FAudio_PlatformUnlockMutex(wave->streamLock);
+	}
+}
+
+static int32_t FAUDIOCALL FACT_INTERNAL_StreamThread(void *enginePtr)
+{
+	FACTAudioEngine *engine = (FACTAudioEngine*) enginePtr;
+	uint32_t i, count;
+
+	/* Same as the mixer, or a packet can miss its deadline */
+	FAudio_PlatformThreadPriority(FAUDIO_THREAD_PRIORITY_HIGH);
+
+	while (engine->streamRunning)
+	{
+		FAudio_PlatformLockMutex(engine->streamLock);
+
+		/* Claim every free packet first, so all the reads can be
+		 * in flight at the same time, most urgent first
+		 */
+		count = FACT_INTERNAL_StreamGather(engine);
+		count = FACT_INTERNAL_StreamCoalesce(engine, count);
+
+		/* Waves can be added and removed while the reads are out,
+		 * except that removing one with a read in flight waits for
+		 * streamIOLock (see StreamRemoveWave)
+		 */
+		FAudio_PlatformLockMutex(engine->streamIOLock);
+		FAudio_PlatformUnlockMutex(engine->streamLock);
+
+		for (i = 0; i < count; i += 1)
+		{
+			FACT_INTERNAL_StreamIssue(engine, &engine->streamReads[i]);
+		}
+		for (i = 0; i < count; i += 1)
+		{
+			FACT_INTERNAL_StreamComplete(engine, &engine->streamReads[i]);
+			FACT_INTERNAL_StreamFinish(engine, &engine->streamReads[i]);
+		}
+
+		FAudio_PlatformUnlockMutex(engine->streamIOLock);
+
+		/* Cached WaveBank entries are read one at a time in between
+		 * the packets, a big entry can't hold up streaming for long
+		 */
+		FAudio_PlatformLockMutex(engine->streamLock);
+		if (FACT_INTERNAL_CacheRead(engine))
+		{
+			continue;
+		}
+
+		/* OnBufferEnd wakes us whenever a packet frees up, the timeout
+		 * is just for when nothing is playing.
+		 */
+		FAudio_PlatformWaitSemaphore(engine->streamSignal, 100);
+	}
+	return 0;
+}
+
+/* Called with the apiLock held, same as StreamQuit */
+void FACT_INTERNAL_StreamStart(FACTAudioEngine *engine)
+{
+	if (!engine->streamRunning)
+	{
+		engine->streamLock = FAudio_PlatformCreateMutex();
+		engine->streamIOLock = FAudio_PlatformCreateMutex();
+		engine->streamSignal = FAudio_PlatformCreateSemaphore(0);
+		engine->streamRunning = 1;
+		engine->streamThread = FAudio_PlatformCreateThread(
+			FACT_INTERNAL_StreamThread,
+			"FACT Stream Thread",
+			engine
+		);
+	}
+}
+
+void FACT_INTERNAL_StreamAddWave(FACTWave *wave)
+{
+	FACTAudioEngine *engine = wave->parentBank->parentEngine;
+	FACTStreamPacket *packet;
+	FACTStreamRead read;
+
+	FACT_INTERNAL_StreamStart(engine);
+
+	/* The first packet is read here, so that the voice has something to
+	 * play as soon as the Wave starts. Nothing else knows about the Wave
+	 * yet, so this doesn't need the streamLock.
+	 */
+	packet = &wave->streamPackets[wave->streamRead];
+	if (	FACT_INTERNAL_StreamSchedule(wave) &&
+		packet->state == FACT_STREAMPACKET_PENDING	)
+	{
+		read.io = wave->parentBank->io;
+		read.data = packet->data;
+		FACT_INTERNAL_StreamAlign(
+			wave,
+			packet,
+			&read.offset,
+			&read.length
+		);
+		FACT_INTERNAL_StreamIssue(engine, &read);
+		FACT_INTERNAL_StreamComplete(engine, &read);
+		packet->state = FACT_STREAMPACKET_READY;
+	}
+	FACT_INTERNAL_StreamSubmit(wave);
+
+	LinkedList_AddEntry(
+		&engine->streamWaves,
+		wave,
+		engine->streamLock,
+		engine->pMalloc
+	);
+	FAudio_PlatformSignalSemaphore(engine->streamSignal);
+}
+
+void FACT_INTERNAL_StreamRemoveWave(FACTWave *wave)
+{
+	FACTAudioEngine *engine = wave->parentBank->parentEngine;
+	uint8_t reading;
+
+	LinkedList_RemoveEntry(
+		&engine->streamWaves,
+		wave,
+		engine->streamLock,
+		engine->pFree
+	);
+
+	/* The stream thread no longer sees this Wave, but it may still have
+	 * reads going into its packets. Those finish before it lets go of
+	 * streamIOLock.
+	 */
+	FAudio_PlatformLockMutex(wave->streamLock);
+	reading = wave->streamReading;
+	FAudio_PlatformUnlockMutex(wave->streamLock);
+	if (reading > 0)
+	{
+		FAudio_PlatformLockMutex(engine->streamIOLock);
+		FAudio_PlatformUnlockMutex(engine->streamIOLock);
+	}
+}
+
+void FACT_INTERNAL_StreamQuit(FACTAudioEngine *engine)
+{
+	FACTCacheLoad *load;
+
+	if (!engine->streamRunning)
+	{
+		return;
+	}
+
+	engine->streamRunning = 0;
+	FAudio_PlatformSignalSemaphore(engine->streamSignal);
+	FAudio_PlatformWaitThread(engine->streamThread, NULL);
+	FAudio_PlatformDestroySemaphore(engine->streamSignal);
+	FAudio_PlatformDestroyMutex(engine->streamLock);
+	FAudio_PlatformDestroyMutex(engine->streamIOLock);
+	engine->pFree(engine->streamRequests);
+	engine->pFree(engine->streamReads);
+	engine->pFree(engine->streamScratch);
+	while (engine->cacheLoads != NULL)
+	{
+		/* Every WaveBank is gone, nothing was left reading */
+		load = engine->cacheLoads;
+		engine->cacheLoads = load->next;
+		if (load->data != NULL)
+		{
+			engine->pFree(load->data);
+		}
+		engine->pFree(load);
+	}
+	engine->streamThread = NULL;
+	engine->streamSignal = NULL;
+	engine->streamLock = NULL;
+	engine->streamIOLock = NULL;
+	engine->streamRequests = NULL;
+	engine->streamReads = NULL;
+	engine->streamRequestCapacity = 0;
+	engine->streamScratch = NULL;
+	engine->streamScratchLen = 0;
+}
+
+/* Load thread */
+
+static bool FACT_INTERNAL_HasWaveBank(FACTSoundBank *sb, uint8_t wbIndex)
+{
+	LinkedList *list;
+
+	if (wbIndex >= sb->wavebankCount)
+	{
+		return true;
+	}
+	list = sb->parentEngine->wbList;
+	while (list != NULL)
+	{
+		if (FAudio_strcmp(
+			sb->wavebankNames[wbIndex],
+			((FACTWaveBank*) list->entry)->name
+		) == 0) {
+			return true;
+		}
+		list = list->next;
+	}
+	return false;
+}
+
+static bool FACT_INTERNAL_SoundWaitsForLoad(
+	FACTSoundBank *sb,
+	const FACTSound *sound
+) {
+	const FACTEvent *evt;
+	uint16_t k, w;
+	uint8_t j;
+
+	for (j = 0; j < sound->trackCount; j += 1)
+	{
+		for (k = 0; k < sound->tracks[j].eventCount; k += 1)
+		{
+			evt = &sound->tracks[j].events[k];
+			if (	evt->type != FACTEVENT_PLAYWAVE &&
+				evt->type != FACTEVENT_PLAYWAVETRACKVARIATION &&
+				evt->type != FACTEVENT_PLAYWAVEEFFECTVARIATION &&
+				evt->type != FACTEVENT_PLAYWAVETRACKEFFECTVARIATION	)
+			{
+				continue;
+			}
+			if (!evt->wave.isComplex)
+			{
+				if (!FACT_INTERNAL_HasWaveBank(sb, evt->wave.simple.wavebank))
+				{
+					return true;
+				}
+			}
+			else
+			{
+				for (w = 0; w < evt->wave.complex.wave_count; w += 1)
+				{
+					if (!FACT_INTERNAL_HasWaveBank(sb, evt->wave.complex.wavebanks[w]))
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+/* True if the Cue could play a WaveBank that isn't in yet while something is
+ * still loading. We can't tell which bank a load is until it's parsed, so any
+ * pending load counts. Called with the apiLock held.
+ */
+bool FACT_INTERNAL_CueWaitsForLoad(FACTCue *cue)
+{
+	FACTSoundBank *sb = cue->parentBank;
+	const FACTVariation *entry;
+	uint16_t i, j;
+
+	if (sb->parentEngine->loadPending == 0)
+	{
+		return false;
+	}
+
+	if (cue->data->flags & CUE_FLAG_SINGLE_SOUND)
+	{
+		return FACT_INTERNAL_SoundWaitsForLoad(sb, cue->sound);
+	}
+	if (cue->variation == NULL)
+	{
+		return false;
+	}
+	for (i = 0; i < cue->variation->entryCount; i += 1)
+	{
+		entry = &cue->variation->entries[i];
+		if (!cue->variation->isComplex)
+		{
+			if (!FACT_INTERNAL_HasWaveBank(sb, entry->simple.wavebank))
+			{
+				return true;
+			}
+			continue;
+		}
+		for (j = 0; j < sb->soundCount; j += 1)
+		{
+			if (entry->soundCode == sb->soundCodes[j])
+			{
+				if (FACT_INTERNAL_SoundWaitsForLoad(sb, &sb->sounds[j]))
+				{
+					return true;
+				}
+				break;
+			}
+		}
+	}
+	return false;
+}
+
+/* Prepares and plays the Cues that were waiting on a load, once they can */
+static void FACT_INTERNAL_LoadResumeCues(FACTAudioEngine *engine)
+{
+	LinkedList *list;
+	FACTCue *cue;
+
+	list = engine->sbList;
+	while (list != NULL)
+	{
+		cue = ((FACTSoundBank*) list->entry)->cueList;
+		while (cue != NULL)
+		{
+			if (cue->loadQueued && !FACT_INTERNAL_CueWaitsForLoad(cue))
+			{
+				cue->loadQueued = false;
+				if (cue->state & FACT_STATE_PREPARING)
+				{
+					/* Prepare skipped this, see FACTSoundBank_Prepare */
+					cue->state = FACT_STATE_PREPARED;
+					create_sound(cue);
+				}
+				if (cue->loadPlay)
+				{
+					cue->loadPlay = false;
+					FACTCue_Play(cue);
+				}
+			}
+			cue = cue->next;
+		}
+		list = list->next;
+	}
+}
+
+static void FACT_INTERNAL_LoadFinish(
+	FACTAudioEngine *engine,
+	FACTLoadRequest *request
+) {
+	FACTSoundBank *sb;
+	FACTWaveBank *wb;
+	uint32_t retval;
+
+	/* Parse without the apiLock, that's the slow part. This includes the
+	 * transcode size threshold, with the policy from when the load was queued.
+	 */
+	if (request->ppSoundBank != NULL)
+	{
+		retval = FACT_INTERNAL_ParseSoundBank(
+			engine,
+			request->buffer,
+			request->size,
+			&sb
+		);
+	}
+	else if (request->isStreaming)
+	{
+		retval = FACT_INTERNAL_ParseWaveBank(
+			engine,
+			request->io,
+			request->offset,
+			request->packetSize,
+			engine->pReadFile,
+			engine->pGetOverlappedResult,
+			true,
+			false,
+			&request->policy,
+			&wb
+		);
+	}
+	else
+	{
+		retval = FACT_INTERNAL_ParseWaveBank(
+			engine,
+			request->io,
+			0,
+			0,
+			FACT_INTERNAL_DefaultReadFile,
+			FACT_INTERNAL_DefaultGetOverlappedResult,
+			false,
+			false,
+			&request->policy,
+			&wb
+		);
+	}
+
+	/* A failed load still gets a notification, with a NULL bank */
+	FAudio_PlatformLockMutex(engine->apiLock);
+	if (request->ppSoundBank != NULL)
+	{
+		if (retval == 0)
+		{
+			FACT_INTERNAL_AddSoundBank(sb);
+			*request->ppSoundBank = sb;
+		}
+		else
+		{
+			sb = NULL;
+		}
+		FACT_INTERNAL_QueueSoundBankPrepared(engine, sb);
+	}
+	else
+	{
+		if (retval == 0)
+		{
+			FACT_INTERNAL_AddWaveBank(wb);
+			*request->ppWaveBank = wb;
+		}
+		else
+		{
+			if (!request->isStreaming)
+			{
+				FAudio_close(request->io);
+			}
+			wb = NULL;
+		}
+		FACT_INTERNAL_QueueWaveBankPrepared(engine, wb);
+	}
+	engine->loadPending -= 1;
+	FACT_INTERNAL_LoadResumeCues(engine);
+
+	/* Last, since this drops the apiLock while it decodes */
+	if (retval == 0)
+	{
+		if (request->ppSoundBank != NULL)
+		{
+			FACT_INTERNAL_TranscodeSoundBank(sb);
+		}
+		else
+		{
+			FACT_INTERNAL_TranscodeWaveBank(wb);
+		}
+	}
+	FAudio_PlatformUnlockMutex(engine->apiLock);
+}
+
+static int32_t FAUDIOCALL FACT_INTERNAL_LoadThread(void *enginePtr)
+{
+	FACTAudioEngine *engine = (FACTAudioEngine*) enginePtr;
+	FACTLoadRequest *request;
+
+	while (engine->loadRunning)
+	{
+		FAudio_PlatformLockMutex(engine->loadLock);
+		request = engine->loadHead;
+		if (request != NULL)
+		{
+			engine->loadHead = request->next;
+			if (engine->loadHead == NULL)
+			{
+				engine->loadTail = NULL;
+			}
+		}
+		FAudio_PlatformUnlockMutex(engine->loadLock);
+
+		if (request == NULL)
+		{
+			FAudio_PlatformWaitSemaphore(engine->loadSignal, -1);
+			continue;
+		}
+		FACT_INTERNAL_LoadFinish(engine, request);
+		engine->pFree(request);
+	}
+	return 0;
+}
+
+void FACT_INTERNAL_LoadAdd(
+	FACTAudioEngine *engine,
+	FACTLoadRequest *request
+) {
+	/* Called with the apiLock held, like StreamAddWave */
+	if (!engine->loadRunning)
+	{
+		engine->loadLock = FAudio_PlatformCreateMutex();
+		engine->loadSignal = FAudio_PlatformCreateSemaphore(0);
+		engine->loadRunning = 1;
+		engine->loadThread = FAudio_PlatformCreateThread(
+			FACT_INTERNAL_LoadThread,
+			"FACT Load Thread",
+			engine
+		);
+	}
+	engine->loadPending += 1;
+
+	/* The load thread parses without the apiLock, so it gets its own copy */
+	request->policy = engine->transcodePolicy;
+	request->next = NULL;
+	FAudio_PlatformLockMutex(engine->loadLock);
+	if (engine->loadTail != NULL)
+	{
+		engine->loadTail->next = request;
+	}
+	else
+	{
+		engine->loadHead = request;
+	}
+	engine->loadTail = request;
+	FAudio_PlatformUnlockMutex(engine->loadLock);
+	FAudio_PlatformSignalSemaphore(engine->loadSignal);
+}
+
+void FACT_INTERNAL_LoadQuit(FACTAudioEngine *engine)
+{
+	FACTLoadRequest *request;
+
+	/* Must not hold the apiLock, a load in progress needs it to finish */
+	if (!engine->loadRunning)
+	{
+		return;
+	}
+
+	/* Loads that haven't started are dropped */
+	FAudio_PlatformLockMutex(engine->loadLock);
+	engine->loadRunning = 0;
+	while (engine->loadHead != NULL)
+	{
+		request = engine->loadHead;
+		engine->loadHead = request->next;
+		if (request->ppWaveBank != NULL && !request->isStreaming)
+		{
+			FAudio_close(request->io);
+		}
+		engine->pFree(request);
+	}
+	engine->loadTail = NULL;
+	FAudio_PlatformUnlockMutex(engine->loadLock);
+
+	FAudio_PlatformSignalSemaphore(engine->loadSignal);
+	FAudio_PlatformWaitThread(engine->loadThread, NULL);
+	FAudio_PlatformDestroySemaphore(engine->loadSignal);
+	FAudio_PlatformDestroyMutex(engine->loadLock);
+	engine->loadThread = NULL;
+	engine->loadSignal = NULL;
+	engine->loadLock = NULL;
+	engine->loadPending = 0;
+}
+
+/* FAudio callbacks */
+
+void FACT_INTERNAL_OnBufferEnd(FAudioVoiceCallback *callback, void* pContext)
+{
+	FACTWaveCallback *c = (FACTWaveCallback*) callback;
+	FACTWave *wave = c->wave;
+	FACTStreamPacket *packet;
+
+	/* This is the mixer thread, so nothing here reads or waits. The
+	 * stream thread queues packets on the voice as soon as they land.
+	 */
+	FAudio_PlatformLockMutex(wave->streamLock);
+
+	/* The packet we just finished playing can be refilled */
+	packet = &wave->streamPackets[wave->streamPlay];
+	if (packet->state == FACT_STREAMPACKET_QUEUED)
+	{
+		packet->state = FACT_STREAMPACKET_EMPTY;
+		wave->streamPlay = (wave->streamPlay + 1) % wave->streamPacketCount;
+		wave->streamPlayStart = FAudio_timems();
+		wave->streamQueued -= 1;
+	}
+
+	/* Don't bother if the Wave has stopped */
+	if (wave->state & FACT_STATE_STOPPED)
+	{
+		FAudio_PlatformUnlockMutex(wave->streamLock);
+		return;
+	}
+
+	/* Working out the next region is cheap, and a short loop may find it
+	 * still in memory, in which case it goes right back on the voice
+	 */
+	FACT_INTERNAL_StreamScheduleAll(wave);
+	FACT_INTERNAL_StreamSubmit(wave);
+
+	/* Out of packets with more to come, the voice plays silence until
+	 * the stream thread catches up
+	 */
+	packet = &wave->streamPackets[wave->streamSubmit];
+	if (	wave->streamQueued == 0 &&
+		!wave->streamStarved &&
+		(	packet->state == FACT_STREAMPACKET_PENDING ||
+			packet->state == FACT_STREAMPACKET_READING	)	)
+	{
+		wave->streamStats.packetsStarved += 1;
+		wave->streamStarveStart = FAudio_timems();
+		wave->streamStarved = 1;
+	}
+	FAudio_PlatformUnlockMutex(wave->streamLock);
+
+	/* Read ahead into whatever we just freed up */
+	FAudio_PlatformSignalSemaphore(wave->parentBank->parentEngine->streamSignal);
+}
+
+void FACT_INTERNAL_OnStreamEnd(FAudioVoiceCallback *callback)
+{
+	FACTWaveCallback *c = (FACTWaveCallback*) callback;
+
+	c->wave->state = FACT_STATE_STOPPED;
+
+	if (	c->wave->parentCue != NULL &&
+		c->wave->parentCue->simpleWave == c->wave	)
+	{
+		c->wave->parentCue->state |= FACT_STATE_STOPPED;
+		c->wave->parentCue->state &= ~(
+			FACT_STATE_PLAYING |
+			FACT_STATE_STOPPING
+		);
+	}
+
+	/* The Cue needs to move on to its next Wave, or clean up. We're on the
+	 * audio thread here, so don't touch the run list, just wake it up.
+	 */
+	if (c->wave->parentCue != NULL)
+	{
+		FAudio_PlatformSignalSemaphore(
+			c->wave->parentBank->parentEngine->apiSignal
+		);
+	}
+}
+
+/* FAudioIOStream functions */
+
+int32_t FACTCALL FACT_INTERNAL_DefaultReadFile(
+	void *hFile,
+	void *buffer,
+	uint32_t nNumberOfBytesToRead,
+	uint32_t *lpNumberOfBytesRead, /* Not referenced! */
+	FACTOverlapped *lpOverlapped
+) {
+	FAudioIOStream *io = (FAudioIOStream*) hFile;
+	lpOverlapped->Internal = (void*) 0x00000103; /* STATUS_PENDING */
+	FAudio_PlatformLockMutex((FAudioMutex) io->lock);
+	io->seek(io->data, (size_t) lpOverlapped->Pointer, FAUDIO_SEEK_SET);
+	lpOverlapped->InternalHigh = (void*) (size_t) (io->read(
+		io->data,
+		buffer,
+		nNumberOfBytesToRead,
+		1
+	) * nNumberOfBytesToRead);
+	FAudio_PlatformUnlockMutex((FAudioMutex) io->lock);
+	lpOverlapped->Internal = 0; /* STATUS_SUCCESS */
+	return 1;
+}
+
+int32_t FACTCALL FACT_INTERNAL_DefaultGetOverlappedResult(
+	void *hFile,
+	FACTOverlapped *lpOverlapped,
+	uint32_t *lpNumberOfBytesTransferred,
+	int32_t bWait
+) {
+	*lpNumberOfBytesTransferred = (uint32_t) (size_t) lpOverlapped->InternalHigh;
+	return 1;
+}
+
+/* Voice pooling */
+
+void FACT_INTERNAL_CreateWaveVoice(
+	FACTWave *wave,
+	const FAudioWaveFormatEx *format,
+	bool reverb
+) {
+	FACTAudioEngine *engine = wave->parentBank->parentEngine;
+	FAudioSendDescriptor send[2];
+	FAudioVoiceSends sends;
+	FACTVoicePool *pool;
+
+	send[0].Flags = 0;
+	send[0].pOutputVoice = engine->master;
+	send[1].Flags = 0;
+	send[1].pOutputVoice = engine->reverbVoice;
+	sends.SendCount = (reverb && engine->reverbVoice != NULL) ? 2 : 1;
+	sends.pSends = send;
+
+	/* XMA and WMA voices carry decoder state, so only PCM, float and ADPCM
+	 * get recycled. Those are fully described by the format header.
+	 */
+	wave->voicePool = NULL;
+	if (	format->wFormatTag == FAUDIO_FORMAT_PCM ||
+		format->wFormatTag == FAUDIO_FORMAT_IEEE_FLOAT ||
+		format->wFormatTag == FAUDIO_FORMAT_MSADPCM	)
+	{
+		for (pool = engine->voicePools; pool != NULL; pool = pool->next)
+		{
+			if (	pool->formatTag == format->wFormatTag &&
+				pool->channels == format->nChannels &&
+				pool->sampleRate == format->nSamplesPerSec &&
+				pool->blockAlign == format->nBlockAlign &&
+				pool->bitsPerSample == format->wBitsPerSample &&
+				pool->reverb == (sends.SendCount == 2)	)
+			{
+				break;
+			}
+		}
+		if (pool == NULL)
+		{
+			pool = (FACTVoicePool*) engine->pMalloc(sizeof(FACTVoicePool));
+			pool->formatTag = format->wFormatTag;
+			pool->channels = format->nChannels;
+			pool->sampleRate = format->nSamplesPerSec;
+			pool->blockAlign = format->nBlockAlign;
+			pool->bitsPerSample = format->wBitsPerSample;
+			pool->reverb = (sends.SendCount == 2);
+			pool->voiceCount = 0;
+			pool->next = engine->voicePools;
+			engine->voicePools = pool;
+		}
+		wave->voicePool = pool;
+
+		if (pool->voiceCount > 0)
+		{
+			pool->voiceCount -= 1;
+			wave->voice = pool->voices[pool->voiceCount];
+			FAudio_INTERNAL_ResetSourceVoice(
+				wave->voice,
+				(FAudioVoiceCallback*) &wave->callback
+			);
+			return;
+		}
+	}
+
+	FAudio_CreateSourceVoice(
+		engine->audio,
+		&wave->voice,
+		format,
+		FAUDIO_VOICE_USEFILTER, /* FIXME: Can this be optional? */
+		4.0f,
+		(FAudioVoiceCallback*) &wave->callback,
+		&sends,
+		NULL
+	);
+}
+
+void FACT_INTERNAL_DestroyWaveVoice(FACTWave *wave)
+{
+	FACTAudioEngine *engine = wave->parentBank->parentEngine;
+	FACTVoicePool *pool = wave->voicePool;
+	FAudioVoiceSends *sends = &wave->voice->sends;
+
+	/* Only keep voices that still match their pool's sends */
+	if (	pool != NULL &&
+		pool->voiceCount < FACT_VOICE_POOL_SIZE &&
+		sends->SendCount == (pool->reverb ? 2 : 1) &&
+		sends->pSends[0].pOutputVoice == engine->master &&
+		(!pool->reverb || sends->pSends[1].pOutputVoice == engine->reverbVoice)	)
+	{
+		/* The Wave is about to be freed, cut the callback now */
+		FAudio_INTERNAL_ResetSourceVoice(wave->voice, NULL);
+		pool->voices[pool->voiceCount] = wave->voice;
+		pool->voiceCount += 1;
+	}
+	else
+	{
+		FAudioVoice_DestroyVoice(wave->voice);
+	}
+	wave->voice = NULL;
+}
+
+void FACT_INTERNAL_DestroyVoicePools(FACTAudioEngine *engine)
+{
+	FACTVoicePool *pool, *next;
+	uint8_t i;
+
+	pool = engine->voicePools;
+	while (pool != NULL)
+	{
+		next = pool->next;
+		for (i = 0; i < pool->voiceCount; i += 1)
+		{
+			FAudioVoice_DestroyVoice(pool->voices[i]);
+		}
+		engine->pFree(pool);
+		pool = next;
+	}
+	engine->voicePools = NULL;
+}
+
+/* Wave cache */
+
+static inline void FACT_INTERNAL_CacheUnlink(
+	FACTAudioEngine *engine,
+	FACTCacheEntry *entry
+) {
+	if (entry->lruPrev != NULL)
+	{
+		entry->lruPrev->lruNext = entry->lruNext;
+	}
+	else
+	{
+		engine->cacheOldest = entry->lruNext;
+	}
+	if (entry->lruNext != NULL)
+	{
+		entry->lruNext->lruPrev = entry->lruPrev;
+	}
+	else
+	{
+		engine->cacheNewest = entry->lruPrev;
+	}
+	entry->lruPrev = NULL;
+	entry->lruNext = NULL;
+}
+
+static inline void FACT_INTERNAL_CacheEvict(
+	FACTAudioEngine *engine,
+	FACTCacheEntry *entry
+) {
+	FACT_INTERNAL_CacheUnlink(engine, entry);
+	engine->pFree(entry->data);
+	entry->data = NULL;
+	engine->cacheSize -= entry->size;
+}
+
+/* Evicts idle entries, oldest first, until the cache fits in the budget */
+void FACT_INTERNAL_CacheTrim(FACTAudioEngine *engine, uint32_t budget)
+{
+	while (engine->cacheSize > budget && engine->cacheOldest != NULL)
+	{
+		FACT_INTERNAL_CacheEvict(engine, engine->cacheOldest);
+	}
+}
+
+/* Idle entries go to the newest end of the LRU list */
+static void FACT_INTERNAL_CacheIdle(
+	FACTAudioEngine *engine,
+	FACTCacheEntry *entry
+) {
+	entry->lruPrev = engine->cacheNewest;
+	entry->lruNext = NULL;
+	if (engine->cacheNewest != NULL)
+	{
+		engine->cacheNewest->lruNext = entry;
+	}
+	else
+	{
+		engine->cacheOldest = entry;
+	}
+	engine->cacheNewest = entry;
+
+	/* Anything that went over budget while playing goes now */
+	FACT_INTERNAL_CacheTrim(engine, engine->cacheBudget);
+}
+
+/* Queues a read of an entry that isn't resident. Its size counts against
+ * the budget from now on, so room is made for it right away.
+ * Caller holds apiLock.
+ */
+static void FACT_INTERNAL_CacheLoad(FACTWaveBank *wb, uint16_t index)
+{
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTCacheEntry *entry = &wb->cache[index];
+	FACTCacheLoad *load, *tail;
+
+	/* Make room first. If everything resident is playing, the cache
+	 * goes over budget until some of it is released.
+	 */
+	entry->size = wb->entries[index].PlayRegion.dwLength;
+	if (entry->size < engine->cacheBudget)
+	{
+		FACT_INTERNAL_CacheTrim(engine, engine->cacheBudget - entry->size);
+	}
+	else
+	{
+		FACT_INTERNAL_CacheTrim(engine, 0);
+	}
+	engine->cacheSize += entry->size;
+	entry->loading = true;
+
+	load = (FACTCacheLoad*) engine->pMalloc(sizeof(FACTCacheLoad));
+	load->bank = wb;
+	load->index = index;
+	load->state = FACT_CACHELOAD_QUEUED;
+	load->data = NULL;
+	load->next = NULL;
+
+	FACT_INTERNAL_StreamStart(engine);
+	FAudio_PlatformLockMutex(engine->streamLock);
+	if (engine->cacheLoads == NULL)
+	{
+		engine->cacheLoads = load;
+	}
+	else
+	{
+		tail = engine->cacheLoads;
+		while (tail->next != NULL)
+		{
+			tail = tail->next;
+		}
+		tail->next = load;
+	}
+	FAudio_PlatformUnlockMutex(engine->streamLock);
+	FAudio_PlatformSignalSemaphore(engine->streamSignal);
+}
+
+/* Returns the entry's wave data, or NULL if it is still being read, in which
+ * case the Wave is given the data by FACT_INTERNAL_CachePublish. Either way
+ * the entry stays resident until every Acquire is matched by a Release,
+ * after which it can be evicted. Caller holds apiLock.
+ */
+uint8_t* FACT_INTERNAL_CacheAcquire(FACTWaveBank *wb, uint16_t index)
+{
+	FACTCacheEntry *entry = &wb->cache[index];
+
+	if (entry->data != NULL && entry->refs == 0)
+	{
+		FACT_INTERNAL_CacheUnlink(wb->parentEngine, entry);
+	}
+	else if (entry->data == NULL && !entry->loading)
+	{
+		FACT_INTERNAL_CacheLoad(wb, index);
+	}
+	entry->refs += 1;
+	return entry->data;
+}
+
+void FACT_INTERNAL_CacheRelease(FACTWaveBank *wb, uint16_t index)
+{
+	FACTCacheEntry *entry = &wb->cache[index];
+
+	FAudio_assert(entry->refs > 0);
+	entry->refs -= 1;
+
+	/* A read that's still going goes idle when it's published */
+	if (entry->refs == 0 && entry->data != NULL)
+	{
+		FACT_INTERNAL_CacheIdle(wb->parentEngine, entry);
+	}
+}
+
+/* Starts reading an entry without a Wave to play it. An entry that is
+ * already resident and idle becomes the most recently used one instead.
+ * Caller holds apiLock.
+ */
+void FACT_INTERNAL_CachePrefetch(FACTWaveBank *wb, uint16_t index)
+{
+	FACTCacheEntry *entry = &wb->cache[index];
+
+	if (entry->data == NULL)
+	{
+		if (!entry->loading)
+		{
+			FACT_INTERNAL_CacheLoad(wb, index);
+		}
+	}
+	else if (entry->refs == 0)
+	{
+		FACT_INTERNAL_CacheUnlink(wb->parentEngine, entry);
+		FACT_INTERNAL_CacheIdle(wb->parentEngine, entry);
+	}
+}
+
+/* Reads the first queued entry, if there is one. Called by the stream thread
+ * with the streamLock held, which it gives up for the read itself. Returns
+ * whether anything was read.
+ */
+bool FACT_INTERNAL_CacheRead(FACTAudioEngine *engine)
+{
+	FACTCacheLoad *load;
+	FACTWaveBank *wb;
+	FACTWaveBankEntry *waveEntry;
+
+	load = engine->cacheLoads;
+	while (load != NULL && load->state != FACT_CACHELOAD_QUEUED)
+	{
+		load = load->next;
+	}
+	if (load == NULL)
+	{
+		FAudio_PlatformUnlockMutex(engine->streamLock);
+		return false;
+	}
+	load->state = FACT_CACHELOAD_READING;
+	wb = load->bank;
+	waveEntry = &wb->entries[load->index];
+
+	/* Same as the packet reads, a WaveBank that gets destroyed in the
+	 * meantime waits for streamIOLock before it lets go of the file
+	 */
+	FAudio_PlatformLockMutex(engine->streamIOLock);
+	FAudio_PlatformUnlockMutex(engine->streamLock);
+
+	load->data = (uint8_t*) engine->pMalloc(waveEntry->PlayRegion.dwLength);
+	FACT_INTERNAL_ReadFile(
+		engine->pReadFile,
+		engine->pGetOverlappedResult,
+		wb->io,
+		wb->file_offset + waveEntry->PlayRegion.dwOffset,
+		wb->packetSize,
+		&wb->packetBuffer,
+		&wb->packetBufferLen,
+		engine->pRealloc,
+		load->data,
+		waveEntry->PlayRegion.dwLength
+	);
+
+	/* Same as in-memory WaveBanks, big-endian PCM is swapped at load */
+	if (	wb->bigEndian &&
+		waveEntry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM &&
+		waveEntry->Format.wBitsPerSample == 1	)
+	{
+		FAudio_INTERNAL_SwapBE16(
+			(uint16_t*) load->data,
+			waveEntry->PlayRegion.dwLength / 2
+		);
+	}
+
+	FAudio_PlatformLockMutex(engine->streamLock);
+	load->state = FACT_CACHELOAD_DONE;
+	FAudio_PlatformUnlockMutex(engine->streamLock);
+	FAudio_PlatformUnlockMutex(engine->streamIOLock);
+
+	/* The API thread makes it resident, it has the apiLock */
+	FAudio_PlatformSignalSemaphore(engine->apiSignal);
+	return true;
+}
+
+/* Makes every finished read resident and hands it to the Waves that were
+ * prepared while it was being read. Caller holds apiLock.
+ */
+void FACT_INTERNAL_CachePublish(FACTAudioEngine *engine)
+{
+	FACTCacheLoad *load, *done = NULL, **prev;
+	FACTCacheEntry *entry;
+	FACTWaveBank *wb;
+	FACTWave *wave;
+	LinkedList *list;
+	uint8_t *data;
+	uint16_t index;
+
+	if (!engine->streamRunning)
+	{
+		return;
+	}
+
+	FAudio_PlatformLockMutex(engine->streamLock);
+	prev = &engine->cacheLoads;
+	while (*prev != NULL)
+	{
+		load = *prev;
+		if (load->state == FACT_CACHELOAD_DONE)
+		{
+			*prev = load->next;
+			load->next = done;
+			done = load;
+		}
+		else
+		{
+			prev = &load->next;
+		}
+	}
+	FAudio_PlatformUnlockMutex(engine->streamLock);
+
+	while (done != NULL)
+	{
+		load = done;
+		done = done->next;
+		wb = load->bank;
+		index = load->index;
+		data = load->data;
+		engine->pFree(load);
+
+		if (wb == NULL)
+		{
+			/* The WaveBank went away while this was read */
+			engine->pFree(data);
+			continue;
+		}
+
+		entry = &wb->cache[index];
+		entry->data = data;
+		entry->loading = false;
+
+		list = wb->waveList;
+		while (list != NULL)
+		{
+			wave = (FACTWave*) list->entry;
+			if (wave->cachePending && wave->index == index)
+			{
+				wave->cachePending = false;
+				if (wave->state & FACT_STATE_PREPARING)
+				{
+					wave->state = FACT_STATE_PREPARED;
+				}
+				if (!(wave->state & FACT_STATE_STOPPED))
+				{
+					FACT_INTERNAL_SubmitWave(wave);
+				}
+			}
+			list = list->next;
+		}
+
+		/* Prefetched, or every Wave went away while it was read */
+		if (entry->refs == 0)
+		{
+			FACT_INTERNAL_CacheIdle(engine, entry);
+		}
+	}
+}
+
+/* Frees every resident entry of a WaveBank that no Wave is using anymore,
+ * and drops any reads that are still queued for it
+ */
+void FACT_INTERNAL_CacheFreeBank(FACTWaveBank *wb)
+{
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTCacheLoad *load, **prev;
+	bool reading = false;
+	uint32_t i;
+
+	if (engine->streamRunning)
+	{
+		FAudio_PlatformLockMutex(engine->streamLock);
+		prev = &engine->cacheLoads;
+		while (*prev != NULL)
+		{
+			load = *prev;
+			if (load->bank != wb)
+			{
+				prev = &load->next;
+			}
+			else if (load->state == FACT_CACHELOAD_READING)
+			{
+				/* The stream thread still has it, it gets
+				 * freed by CachePublish
+				 */
+				load->bank = NULL;
+				reading = true;
+				prev = &load->next;
+			}
+			else
+			{
+				*prev = load->next;
+				if (load->data != NULL)
+				{
+					engine->pFree(load->data);
+				}
+				engine->pFree(load);
+			}
+		}
+		FAudio_PlatformUnlockMutex(engine->streamLock);
+
+		/* The read has to be done with the file before it's closed */
+		if (reading)
+		{
+			FAudio_PlatformLockMutex(engine->streamIOLock);
+			FAudio_PlatformUnlockMutex(engine->streamIOLock);
+		}
+	}
+
+	for (i = 0; i < wb->entryCount; i += 1)
+	{
+		FAudio_assert(wb->cache[i].refs == 0);
+		if (wb->cache[i].data != NULL)
+		{
+			FACT_INTERNAL_CacheEvict(engine, &wb->cache[i]);
+		}
+		else if (wb->cache[i].loading)
+		{
+			engine->cacheSize -= wb->cache[i].size;
+		}
+	}
+	engine->pFree(wb->cache);
+	wb->cache = NULL;
+}
+
+/* Queues a whole entry on the voice of a Wave from a WaveBank that isn't
+ * streaming. Entries of cached WaveBanks have to be resident.
+ */
+void FACT_INTERNAL_SubmitWave(FACTWave *wave)
+{
+	FACTWaveBank *wb = wave->parentBank;
+	FACTWaveBankEntry *entry = &wb->entries[wave->index];
+	FACTTranscodedEntry *transcoded = NULL;
+	FAudioBuffer buffer;
+	FAudioBufferWMA bufferWMA;
+	uint32_t blockSamples;
+
+	if (wb->transcoded != NULL && wb->transcoded[wave->index].data != NULL)
+	{
+		transcoded = &wb->transcoded[wave->index];
+	}
+
+	buffer.Flags = FAUDIO_END_OF_STREAM;
+	buffer.AudioBytes = entry->PlayRegion.dwLength;
+	buffer.PlayLength = entry->Duration;
+	if (transcoded != NULL)
+	{
+		buffer.pAudioData = transcoded->data;
+		buffer.AudioBytes = transcoded->size;
+		buffer.PlayLength = transcoded->samples;
+	}
+	else if (wb->cache != NULL)
+	{
+		buffer.pAudioData = wb->cache[wave->index].data;
+	}
+	else
+	{
+		buffer.pAudioData = FAudio_memptr(
+			wb->io,
+			entry->PlayRegion.dwOffset
+		);
+	}
+	buffer.PlayBegin = 0;
+	if (wave->loopCount == 0)
+	{
+		buffer.LoopBegin = 0;
+		buffer.LoopLength = 0;
+		buffer.LoopCount = 0;
+	}
+	else
+	{
+		buffer.LoopBegin = entry->LoopRegion.dwStartSample;
+		buffer.LoopLength = entry->LoopRegion.dwTotalSamples;
+		buffer.LoopCount = wave->loopCount;
+		if (transcoded != NULL)
+		{
+			/* Match the block rounding of the MSADPCM voice */
+			blockSamples = ((entry->Format.wBlockAlign + 22) - 6) * 2;
+			buffer.LoopBegin -= buffer.LoopBegin % blockSamples;
+			buffer.LoopLength -= buffer.LoopLength % blockSamples;
+		}
+	}
+	buffer.pContext = NULL;
+	if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_WMA)
+	{
+		bufferWMA.pDecodedPacketCumulativeBytes =
+			wb->seekTables[wave->index].entries;
+		bufferWMA.PacketCount =
+			wb->seekTables[wave->index].entryCount;
+		FAudioSourceVoice_SubmitSourceBuffer(
+			wave->voice,
+			&buffer,
+			&bufferWMA
+		);
+	}
+	else
+	{
+		FAudioSourceVoice_SubmitSourceBuffer(
+			wave->voice,
+			&buffer,
+			NULL
+		);
+	}
+}
+
+/* Transcoding */
+
+bool FACT_INTERNAL_IsInCategory(
+	FACTAudioEngine *engine,
+	uint16_t target,
+	uint16_t category
+) {
+	FACTAudioCategory *cat;
+
+	/* Same category, no need to go on a crazy hunt */
+	if (category == target)
+	{
+		return true;
+	}
+
+	/* Right, on with the crazy hunt */
+	cat = &engine->categories[category];
+	while (cat->parentCategory != -1)
+	{
+		if (cat->parentCategory == target)
+		{
+			return true;
+		}
+		cat = &engine->categories[cat->parentCategory];
+	}
+	return false;
+}
+
+/* Largest MSADPCM block, in samples across all channels */
+#define FACT_ADPCM_BLOCK_MAX ((((255 + 22) - 6) * 2) * 2)
+
+/* Decodes one MSADPCM entry of an in-memory WaveBank to PCM16 or float, so
+ * Prepare can hand the voice PCM instead of making the mixer decode it every
+ * time it plays. This only reads the entry table and the WaveBank data, which
+ * never change once the WaveBank is parsed, so it doesn't need the apiLock.
+ * The copy is private until FACT_INTERNAL_TranscodePublish hands it over.
+ * out->data is NULL if the entry can't be transcoded.
+ */
+void FACT_INTERNAL_TranscodeDecode(
+	FACTWaveBank *wb,
+	uint16_t index,
+	bool isFloat,
+	FACTTranscodedEntry *out
+) {
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTWaveBankEntry *entry;
+	const uint8_t *src;
+	float block[FACT_ADPCM_BLOCK_MAX];
+	uint32_t channels, blockAlign, samplesPerBlock, blockCount;
+	uint32_t samples, done, copy, i;
+	uint64_t size;
+
+	FAudio_zero(out, sizeof(FACTTranscodedEntry));
+
+	/* Streaming and cached WaveBanks don't keep the data around */
+	if (	wb->streaming ||
+		wb->cache != NULL ||
+		index >= wb->entryCount	)
+	{
+		return;
+	}
+
+	entry = &wb->entries[index];
+	channels = entry->Format.nChannels;
+	if (	entry->Format.wFormatTag != FACT_WAVEBANKMINIFORMAT_TAG_ADPCM ||
+		channels == 0 ||
+		channels > 2	)
+	{
+		return;
+	}
+	blockAlign = (entry->Format.wBlockAlign + 22) * channels;
+	samplesPerBlock = ((blockAlign / channels) - 6) * 2;
+	blockCount = entry->PlayRegion.dwLength / blockAlign;
+	samples = (uint32_t) FAudio_min(
+		(uint64_t) entry->Duration,
+		(uint64_t) blockCount * samplesPerBlock
+	);
+
+	/* MSADPCM voices only play whole blocks, so the copy does the same */
+	samples -= samples % samplesPerBlock;
+	size = (uint64_t) samples * channels * (isFloat ? sizeof(float) : sizeof(int16_t));
+	if (samples == 0 || size > 0xFFFFFFFF)
+	{
+		return;
+	}
+
+	out->isFloat = isFloat;
+	out->samples = samples;
+	out->size = (uint32_t) size;
+	out->data = (uint8_t*) engine->pMalloc(out->size);
+
+	src = FAudio_memptr(
+		(FAudioIOStream*) wb->io,
+		entry->PlayRegion.dwOffset
+	);
+	for (done = 0; done < samples; done += copy, src += blockAlign)
+	{
+		copy = FAudio_min(samples - done, samplesPerBlock);
+		if (isFloat)
+		{
+			FAudio_INTERNAL_DecodeMSADPCMBlock(
+				src,
+				((float*) out->data) + (done * channels),
+				channels,
+				copy
+			);
+		}
+		else
+		{
+			/* The decoder only produces float, but it's just
+			 * int16 / 32768 so this gets the exact samples back
+			 */
+			FAudio_INTERNAL_DecodeMSADPCMBlock(
+				src,
+				block,
+				channels,
+				copy
+			);
+			for (i = 0; i < copy * channels; i += 1)
+			{
+				((int16_t*) out->data)[(done * channels) + i] =
+					(int16_t) (block[i] * 32768.0f);
+			}
+		}
+	}
+}
+
+/* Hands a copy from FACT_INTERNAL_TranscodeDecode to the WaveBank, with the
+ * apiLock held. If the entry was transcoded in the meantime, the copy is
+ * dropped instead.
+ */
+void FACT_INTERNAL_TranscodePublish(
+	FACTWaveBank *wb,
+	uint16_t index,
+	FACTTranscodedEntry *decoded
+) {
+	FACTAudioEngine *engine = wb->parentEngine;
+	size_t memsize;
+
+	if (decoded->data == NULL)
+	{
+		return;
+	}
+	if (wb->transcoded == NULL)
+	{
+		memsize = sizeof(FACTTranscodedEntry) * wb->entryCount;
+		wb->transcoded = (FACTTranscodedEntry*) engine->pMalloc(memsize);
+		FAudio_zero(wb->transcoded, memsize);
+	}
+	if (wb->transcoded[index].data != NULL)
+	{
+		engine->pFree(decoded->data);
+	}
+	else
+	{
+		wb->transcoded[index] = *decoded;
+		engine->transcodedSize += decoded->size;
+	}
+	decoded->data = NULL;
+}
+
+/* Adds an entry to a batch, with the apiLock held. Entries that are already
+ * transcoded or queued are skipped, so the category pass can find the same
+ * entry through any number of events.
+ */
+static void FACT_INTERNAL_TranscodeQueue(
+	FACTTranscodeBatch *batch,
+	FACTWaveBank *wb,
+	uint16_t index
+) {
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTTranscodeJob *job;
+	size_t memsize;
+
+	if (	index >= wb->entryCount ||
+		wb->entries[index].Format.wFormatTag != FACT_WAVEBANKMINIFORMAT_TAG_ADPCM	)
+	{
+		return;
+	}
+	if (wb->transcoded == NULL)
+	{
+		memsize = sizeof(FACTTranscodedEntry) * wb->entryCount;
+		wb->transcoded = (FACTTranscodedEntry*) engine->pMalloc(memsize);
+		FAudio_zero(wb->transcoded, memsize);
+	}
+	if (wb->transcoded[index].data != NULL || wb->transcoded[index].queued)
+	{
+		return;
+	}
+	wb->transcoded[index].queued = true;
+
+	job = (FACTTranscodeJob*) engine->pMalloc(sizeof(FACTTranscodeJob));
+	FAudio_zero(job, sizeof(FACTTranscodeJob));
+	job->wb = wb;
+	job->index = index;
+	job->next = batch->jobs;
+	batch->jobs = job;
+}
+
+/* Decodes a batch and publishes the copies. Called with the apiLock held, and
+ * returns with it held, but it's released while the entries decode. The
+ * transcodeLock is only held to pick up a job and to store its copy, so a
+ * WaveBank that's destroyed in the meantime waits for one entry at most, see
+ * FACT_INTERNAL_FreeTranscoded.
+ */
+static void FACT_INTERNAL_TranscodeRun(
+	FACTAudioEngine *engine,
+	FACTTranscodeBatch *batch
+) {
+	FACTTranscodeBatch **prev;
+	FACTTranscodeJob *job;
+	FACTTranscodedEntry decoded;
+	FACTWaveBank *wb;
+	bool isFloat;
+
+	if (batch->jobs == NULL)
+	{
+		return;
+	}
+	isFloat = (engine->transcodePolicy.target == FACT_TRANSCODE_FLOAT_EXT);
+
+	if (engine->transcodeLock == NULL)
+	{
+		engine->transcodeLock = FAudio_PlatformCreateMutex();
+		engine->transcodeDecodeLock = FAudio_PlatformCreateMutex();
+	}
+	FAudio_PlatformLockMutex(engine->transcodeLock);
+	batch->current = NULL;
+	batch->next = engine->transcodeBatches;
+	engine->transcodeBatches = batch;
+	FAudio_PlatformUnlockMutex(engine->transcodeLock);
+
+	/* The jobs only change under the transcodeLock from here on */
+	FAudio_PlatformUnlockMutex(engine->apiLock);
+	for (job = batch->jobs; job != NULL; job = job->next)
+	{
+		FAudio_PlatformLockMutex(engine->transcodeDecodeLock);
+		FAudio_PlatformLockMutex(engine->transcodeLock);
+		if (job->wb == NULL)
+		{
+			FAudio_PlatformUnlockMutex(engine->transcodeLock);
+			FAudio_PlatformUnlockMutex(engine->transcodeDecodeLock);
+			continue;
+		}
+		batch->current = job;
+		wb = job->wb;
+		FAudio_PlatformUnlockMutex(engine->transcodeLock);
+
+		FACT_INTERNAL_TranscodeDecode(
+			wb,
+			job->index,
+			isFloat,
+			&decoded
+		);
+
+		FAudio_PlatformLockMutex(engine->transcodeLock);
+		batch->current = NULL;
+		if (job->wb != NULL)
+		{
+			job->decoded = decoded;
+		}
+		else if (decoded.data != NULL)
+		{
+			engine->pFree(decoded.data);
+		}
+		FAudio_PlatformUnlockMutex(engine->transcodeLock);
+		FAudio_PlatformUnlockMutex(engine->transcodeDecodeLock);
+	}
+	FAudio_PlatformLockMutex(engine->apiLock);
+
+	FAudio_PlatformLockMutex(engine->transcodeLock);
+	prev = &engine->transcodeBatches;
+	while (*prev != batch)
+	{
+		prev = &(*prev)->next;
+	}
+	*prev = batch->next;
+	FAudio_PlatformUnlockMutex(engine->transcodeLock);
+
+	while (batch->jobs != NULL)
+	{
+		job = batch->jobs;
+		batch->jobs = job->next;
+		if (job->wb != NULL)
+		{
+			job->wb->transcoded[job->index].queued = false;
+			FACT_INTERNAL_TranscodePublish(
+				job->wb,
+				job->index,
+				&job->decoded
+			);
+		}
+		engine->pFree(job);
+	}
+}
+
+/* Queues whatever the policy's category plays from wb through sb */
+static void FACT_INTERNAL_TranscodeCategory(
+	FACTTranscodeBatch *batch,
+	FACTWaveBank *wb,
+	FACTSoundBank *sb
+) {
+	FACTAudioEngine *engine = wb->parentEngine;
+	uint16_t category = engine->transcodePolicy.category;
+	const FACTSound *sound;
+	const FACTEvent *evt;
+	uint16_t i, k, w;
+	uint8_t j, wbIndex;
+
+	if (category == FACTCATEGORY_INVALID || category >= engine->categoryCount)
+	{
+		return;
+	}
+
+	/* Which of the SoundBank's WaveBanks is this one? */
+	for (wbIndex = 0; wbIndex < sb->wavebankCount; wbIndex += 1)
+	{
+		if (FAudio_strcmp(sb->wavebankNames[wbIndex], wb->name) == 0)
+		{
+			break;
+		}
+	}
+	if (wbIndex == sb->wavebankCount)
+	{
+		return;
+	}
+
+	for (i = 0; i < sb->soundCount; i += 1)
+	{
+		sound = &sb->sounds[i];
+		if (	sound->category == FACTCATEGORY_INVALID ||
+			sound->category >= engine->categoryCount ||
+			!FACT_INTERNAL_IsInCategory(engine, category, sound->category)	)
+		{
+			continue;
+		}
+		for (j = 0; j < sound->trackCount; j += 1)
+		{
+			for (k = 0; k < sound->tracks[j].eventCount; k += 1)
+			{
+				evt = &sound->tracks[j].events[k];
+				if (	evt->type != FACTEVENT_PLAYWAVE &&
+					evt->type != FACTEVENT_PLAYWAVETRACKVARIATION &&
+					evt->type != FACTEVENT_PLAYWAVEEFFECTVARIATION &&
+					evt->type != FACTEVENT_PLAYWAVETRACKEFFECTVARIATION	)
+				{
+					continue;
+				}
+				if (!evt->wave.isComplex)
+				{
+					if (evt->wave.simple.wavebank == wbIndex)
+					{
+						FACT_INTERNAL_TranscodeQueue(
+							batch,
+							wb,
+							evt->wave.simple.wave_index
+						);
+					}
+				}
+				else
+				{
+					for (w = 0; w < evt->wave.complex.wave_count; w += 1)
+					{
+						if (evt->wave.complex.wavebanks[w] == wbIndex)
+						{
+							FACT_INTERNAL_TranscodeQueue(
+								batch,
+								wb,
+								evt->wave.complex.wave_indices[w]
+							);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/* Size threshold, by what the decoded copy would cost. The parser runs this
+ * before the WaveBank is added to the Engine, so the copies can go straight
+ * in without the apiLock. FACT_INTERNAL_AddWaveBank counts them.
+ */
+static void FACT_INTERNAL_TranscodeBySize(
+	FACTWaveBank *wb,
+	const FACTTranscodePolicyEXT *policy
+) {
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTWaveBankEntry *entry;
+	FACTTranscodedEntry decoded;
+	uint64_t decodedSize;
+	size_t memsize;
+	uint32_t i;
+
+	if (wb->streaming || wb->cache != NULL || policy->maxDecodedSize == 0)
+	{
+		return;
+	}
+	for (i = 0; i < wb->entryCount; i += 1)
+	{
+		entry = &wb->entries[i];
+		if (entry->Format.wFormatTag != FACT_WAVEBANKMINIFORMAT_TAG_ADPCM)
+		{
+			continue;
+		}
+		decodedSize = (uint64_t) entry->Duration * entry->Format.nChannels * (
+			(policy->target == FACT_TRANSCODE_FLOAT_EXT) ?
+				sizeof(float) :
+				sizeof(int16_t)
+		);
+		if (decodedSize > policy->maxDecodedSize)
+		{
+			continue;
+		}
+		FACT_INTERNAL_TranscodeDecode(
+			wb,
+			(uint16_t) i,
+			policy->target == FACT_TRANSCODE_FLOAT_EXT,
+			&decoded
+		);
+		if (decoded.data == NULL)
 		{
-			length = entry->PlayRegion.dwLength;
+			continue;
 		}
+		if (wb->transcoded == NULL)
+		{
+			memsize = sizeof(FACTTranscodedEntry) * wb->entryCount;
+			wb->transcoded = (FACTTranscodedEntry*) engine->pMalloc(memsize);
+			FAudio_zero(wb->transcoded, memsize);
+		}
+		wb->transcoded[i] = decoded;
 	}
-	else
-	{
-		length = entry->PlayRegion.dwLength;
-	}
-	end = entry->PlayRegion.dwOffset + length;
-	left = length - (c->wave->streamOffset - entry->PlayRegion.dwOffset);
+}
 
-	/* Don't bother if we're EOS or the Wave has stopped */
-	if (	(c->wave->streamOffset >= end) ||
-		(c->wave->state & FACT_STATE_STOPPED)	)
+/* Applies the category policy to a newly added in-memory WaveBank, through
+ * every SoundBank that's already loaded. This releases the apiLock while it
+ * decodes, so callers run it last, once the WaveBank is fully set up.
+ */
+void FACT_INTERNAL_TranscodeWaveBank(FACTWaveBank *wb)
+{
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTTranscodeBatch batch;
+	LinkedList *list;
+
+	if (wb->streaming || wb->cache != NULL)
 	{
 		return;
 	}
 
-	/* Assign buffer memory */
-	buffer.pAudioData = c->wave->streamCache;
-	buffer.AudioBytes = FAudio_min(
-		c->wave->streamSize,
-		left
-	);
+	batch.jobs = NULL;
+	if (engine->transcodePolicy.category != FACTCATEGORY_INVALID)
+	{
+		list = engine->sbList;
+		while (list != NULL)
+		{
+			FACT_INTERNAL_TranscodeCategory(
+				&batch,
+				wb,
+				(FACTSoundBank*) list->entry
+			);
+			list = list->next;
+		}
+	}
+	FACT_INTERNAL_TranscodeRun(engine, &batch);
+}
 
-	/* Read! */
-	FACT_INTERNAL_ReadFile(
-		c->wave->parentBank->parentEngine->pReadFile,
-		c->wave->parentBank->parentEngine->pGetOverlappedResult,
-		c->wave->parentBank->io,
-		c->wave->parentBank->file_offset + c->wave->streamOffset,
-		c->wave->parentBank->packetSize,
-		&c->wave->parentBank->packetBuffer,
-		&c->wave->parentBank->packetBufferLen,
-		c->wave->parentBank->parentEngine->pRealloc,
-		c->wave->streamCache,
-		buffer.AudioBytes
-	);
-	c->wave->streamOffset += buffer.AudioBytes;
+/* Applies the category policy to WaveBanks loaded before this SoundBank. Like
+ * FACT_INTERNAL_TranscodeWaveBank, this releases the apiLock while it decodes.
+ */
+void FACT_INTERNAL_TranscodeSoundBank(FACTSoundBank *sb)
+{
+	FACTTranscodeBatch batch;
+	LinkedList *list;
+	FACTWaveBank *wb;
 
-	/* Last buffer in the stream? */
-	buffer.Flags = 0;
-	if (c->wave->streamOffset >= end)
+	batch.jobs = NULL;
+	list = sb->parentEngine->wbList;
+	while (list != NULL)
 	{
-		/* Loop if applicable */
-		if (c->wave->loopCount > 0)
+		wb = (FACTWaveBank*) list->entry;
+		if (!wb->streaming && wb->cache == NULL)
 		{
-			if (c->wave->loopCount != 255)
-			{
-				c->wave->loopCount -= 1;
-			}
-			c->wave->streamOffset = entry->PlayRegion.dwOffset;
+			FACT_INTERNAL_TranscodeCategory(&batch, wb, sb);
+		}
+		list = list->next;
+	}
+	FACT_INTERNAL_TranscodeRun(sb->parentEngine, &batch);
+}
 
-			/* Loop start */
-			if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM)
+void FACT_INTERNAL_FreeTranscoded(FACTWaveBank *wb)
+{
+	FACTAudioEngine *engine = wb->parentEngine;
+	FACTTranscodeBatch *batch;
+	FACTTranscodeJob *job;
+	bool inFlight = false;
+	uint32_t i;
+
+	if (wb->transcoded == NULL)
+	{
+		return;
+	}
+
+	/* Cancel the jobs of any batch that's decoding... */
+	if (engine->transcodeLock != NULL)
+	{
+		FAudio_PlatformLockMutex(engine->transcodeLock);
+		for (batch = engine->transcodeBatches; batch != NULL; batch = batch->next)
+		{
+			if (batch->current != NULL && batch->current->wb == wb)
 			{
-				c->wave->streamOffset += (
-					entry->LoopRegion.dwStartSample *
-					entry->Format.nChannels *
-					(1 << entry->Format.wBitsPerSample)
-				);
+				inFlight = true;
 			}
-			else if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_ADPCM)
+			for (job = batch->jobs; job != NULL; job = job->next)
 			{
-				c->wave->streamOffset += (
-					entry->LoopRegion.dwStartSample /
-					/* wSamplesPerBlock */
-					((entry->Format.wBlockAlign + 16) * 2) *
-					/* nBlockAlign */
-					((entry->Format.wBlockAlign + 22) * entry->Format.nChannels)
-				);
+				if (job->wb == wb)
+				{
+					if (job->decoded.data != NULL)
+					{
+						engine->pFree(job->decoded.data);
+						job->decoded.data = NULL;
+					}
+					job->wb = NULL;
+				}
 			}
 		}
-		else
+		FAudio_PlatformUnlockMutex(engine->transcodeLock);
+
+		/* ... and wait for the entry it's reading from us, if any */
+		if (inFlight)
 		{
-			buffer.Flags = FAUDIO_END_OF_STREAM;
+			FAudio_PlatformLockMutex(engine->transcodeDecodeLock);
+			FAudio_PlatformUnlockMutex(engine->transcodeDecodeLock);
 		}
 	}
 
-	/* Unused properties */
-	buffer.PlayBegin = 0;
-	buffer.PlayLength = 0;
-	buffer.LoopBegin = 0;
-	buffer.LoopLength = 0;
-	buffer.LoopCount = 0;
-	buffer.pContext = NULL;
+	for (i = 0; i < wb->entryCount; i += 1)
+	{
+		if (wb->transcoded[i].data != NULL)
+		{
+			wb->parentEngine->transcodedSize -= wb->transcoded[i].size;
+			wb->parentEngine->pFree(wb->transcoded[i].data);
+		}
+	}
+	wb->parentEngine->pFree(wb->transcoded);
+	wb->transcoded = NULL;
+}
 
-	/* Submit, finally. */
-	if (entry->Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_WMA)
+/* Name lookup */
+
+#define FACT_NAME_BLOCK_LENGTH 64
+#define FACT_NAME_UNBOUNDED ((size_t) -1)
+
+static uint32_t FACT_INTERNAL_HashName(const char *name, size_t maxLength)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+	size_t i;
+	for (i = 0; i < maxLength && name[i] != '\0'; i += 1)
 	{
-		bufferWMA.pDecodedPacketCumulativeBytes =
-			c->wave->parentBank->seekTables[c->wave->index].entries;
-		bufferWMA.PacketCount =
-			c->wave->parentBank->seekTables[c->wave->index].entryCount;
-		FAudioSourceVoice_SubmitSourceBuffer(
-			c->wave->voice,
-			&buffer,
-			&bufferWMA
-		);
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619u;
 	}
-	else
+	return hash;
+}
+
+static inline const char* FACT_INTERNAL_GetName(
+	const FACTNameIndex *index,
+	uint16_t i
+) {
+	if (index->names != NULL)
 	{
-		FAudioSourceVoice_SubmitSourceBuffer(
-			c->wave->voice,
-			&buffer,
-			NULL
-		);
+		return index->names[i];
 	}
+	return index->nameBlock + (i * FACT_NAME_BLOCK_LENGTH);
 }
 
-void FACT_INTERNAL_OnStreamEnd(FAudioVoiceCallback *callback)
+uint32_t FACT_INTERNAL_NameIndexSize(uint32_t count)
 {
-	FACTWaveCallback *c = (FACTWaveCallback*) callback;
+	uint32_t size;
+	if (count == 0)
+	{
+		return 0;
+	}
 
-	c->wave->state = FACT_STATE_STOPPED;
+	/* Keep the table at most half full so probes stay short */
+	size = 2;
+	while (size < count * 2)
+	{
+		size <<= 1;
+	}
+	return size;
+}
 
-	if (	c->wave->parentCue != NULL &&
-		c->wave->parentCue->simpleWave == c->wave	)
+void FACT_INTERNAL_InitNameIndex(
+	FACTNameIndex *index,
+	uint16_t *slots,
+	uint32_t size,
+	char **names,
+	const char *nameBlock
+) {
+	uint32_t i;
+
+	index->slots = slots;
+	index->mask = (size > 0) ? (size - 1) : 0;
+	index->names = names;
+	index->nameBlock = nameBlock;
+	for (i = 0; i < size; i += 1)
 	{
-		c->wave->parentCue->state |= FACT_STATE_STOPPED;
-		c->wave->parentCue->state &= ~(
-			FACT_STATE_PLAYING |
-			FACT_STATE_STOPPING
-		);
-		c->wave->parentCue->data->instanceCount -= 1;
+		slots[i] = FACTINDEX_INVALID;
 	}
 }
 
-/* FAudioIOStream functions */
+void FACT_INTERNAL_AddName(FACTNameIndex *index, uint16_t i)
+{
+	uint32_t slot = FACT_INTERNAL_HashName(
+		FACT_INTERNAL_GetName(index, i),
+		(index->names != NULL) ? FACT_NAME_UNBOUNDED : FACT_NAME_BLOCK_LENGTH
+	);
 
-int32_t FACTCALL FACT_INTERNAL_DefaultReadFile(
-	void *hFile,
-	void *buffer,
-	uint32_t nNumberOfBytesToRead,
-	uint32_t *lpNumberOfBytesRead, /* Not referenced! */
-	FACTOverlapped *lpOverlapped
-) {
-	FAudioIOStream *io = (FAudioIOStream*) hFile;
-	lpOverlapped->Internal = (void*) 0x00000103; /* STATUS_PENDING */
-	FAudio_PlatformLockMutex((FAudioMutex) io->lock);
-	io->seek(io->data, (size_t) lpOverlapped->Pointer, FAUDIO_SEEK_SET);
-	lpOverlapped->InternalHigh = (void*) (size_t) (io->read(
-		io->data,
-		buffer,
-		nNumberOfBytesToRead,
-		1
-	) * nNumberOfBytesToRead);
-	FAudio_PlatformUnlockMutex((FAudioMutex) io->lock);
-	lpOverlapped->Internal = 0; /* STATUS_SUCCESS */
-	return 1;
+	/* Duplicate names keep their insertion order along the probe sequence,
+	 * so the lowest index still wins like it did with the linear search.
+	 */
+	slot &= index->mask;
+	while (index->slots[slot] != FACTINDEX_INVALID)
+	{
+		slot = (slot + 1) & index->mask;
+	}
+	index->slots[slot] = i;
 }
 
-int32_t FACTCALL FACT_INTERNAL_DefaultGetOverlappedResult(
-	void *hFile,
-	FACTOverlapped *lpOverlapped,
-	uint32_t *lpNumberOfBytesTransferred,
-	int32_t bWait
+uint16_t FACT_INTERNAL_FindName(
+	const FACTNameIndex *index,
+	const char *name
 ) {
-	*lpNumberOfBytesTransferred = (uint32_t) (size_t) lpOverlapped->InternalHigh;
-	return 1;
+	uint32_t slot;
+	uint16_t i;
+
+	if (index->slots == NULL || name == NULL)
+	{
+		return FACTINDEX_INVALID;
+	}
+
+	if (index->names != NULL)
+	{
+		slot = FACT_INTERNAL_HashName(name, FACT_NAME_UNBOUNDED) & index->mask;
+		while ((i = index->slots[slot]) != FACTINDEX_INVALID)
+		{
+			if (FAudio_strcmp(name, index->names[i]) == 0)
+			{
+				return i;
+			}
+			slot = (slot + 1) & index->mask;
+		}
+	}
+	else
+	{
+		slot = FACT_INTERNAL_HashName(
+			name,
+			FACT_NAME_BLOCK_LENGTH
+		) & index->mask;
+		while ((i = index->slots[slot]) != FACTINDEX_INVALID)
+		{
+			if (FAudio_strncmp(
+				name,
+				index->nameBlock + (i * FACT_NAME_BLOCK_LENGTH),
+				FACT_NAME_BLOCK_LENGTH
+			) == 0) {
+				return i;
+			}
+			slot = (slot + 1) & index->mask;
+		}
+	}
+	return FACTINDEX_INVALID;
+}
+
+void FACT_INTERNAL_BuildEngineLookups(FACTAudioEngine *engine)
+{
+	uint32_t size;
+	uint16_t i, globalCount = 0, cueCount = 0;
+
+	size = FACT_INTERNAL_NameIndexSize(engine->categoryCount);
+	FACT_INTERNAL_InitNameIndex(
+		&engine->categoryLookup,
+		(size > 0) ? (uint16_t*) engine->pMalloc(sizeof(uint16_t) * size) : NULL,
+		size,
+		engine->categoryNames,
+		NULL
+	);
+	for (i = 0; i < engine->categoryCount; i += 1)
+	{
+		FACT_INTERNAL_AddName(&engine->categoryLookup, i);
+	}
+
+	/* Global and Cue variables get separate tables, so each lookup only
+	 * sees the variables it is allowed to return.
+	 */
+	for (i = 0; i < engine->variableCount; i += 1)
+	{
+		if (engine->variables[i].accessibility & ACCESSIBILITY_PUBLIC)
+		{
+			if (engine->variables[i].accessibility & ACCESSIBILITY_CUE)
+			{
+				cueCount += 1;
+			}
+			else
+			{
+				globalCount += 1;
+			}
+		}
+	}
+
+	size = FACT_INTERNAL_NameIndexSize(globalCount);
+	FACT_INTERNAL_InitNameIndex(
+		&engine->globalVariableLookup,
+		(size > 0) ? (uint16_t*) engine->pMalloc(sizeof(uint16_t) * size) : NULL,
+		size,
+		engine->variableNames,
+		NULL
+	);
+	size = FACT_INTERNAL_NameIndexSize(cueCount);
+	FACT_INTERNAL_InitNameIndex(
+		&engine->cueVariableLookup,
+		(size > 0) ? (uint16_t*) engine->pMalloc(sizeof(uint16_t) * size) : NULL,
+		size,
+		engine->variableNames,
+		NULL
+	);
+	for (i = 0; i < engine->variableCount; i += 1)
+	{
+		if (engine->variables[i].accessibility & ACCESSIBILITY_PUBLIC)
+		{
+			if (engine->variables[i].accessibility & ACCESSIBILITY_CUE)
+			{
+				FACT_INTERNAL_AddName(&engine->cueVariableLookup, i);
+			}
+			else
+			{
+				FACT_INTERNAL_AddName(&engine->globalVariableLookup, i);
+			}
+		}
+	}
 }
 
 /* Parsing functions */
@@ -2000,6 +4732,29 @@ static inline float read_volbyte(const uint8_t **ptr)
 	return (float) ((3969.0 * FAudio_log10(read_u8(ptr) / 28240.0)) + 8715.0);
 }
 
+/* Resolve where an RPC's variable comes from once, rather than comparing
+ * variable names every time it's evaluated.
+ */
+static void FACT_INTERNAL_CompileRPC(FACTAudioEngine *engine, FACTRPC *rpc)
+{
+	if (!(engine->variables[rpc->variable].accessibility & ACCESSIBILITY_CUE))
+	{
+		rpc->source = RPC_SOURCE_GLOBAL;
+	}
+	else if (FAudio_strcmp(engine->variableNames[rpc->variable], "AttackTime") == 0)
+	{
+		rpc->source = RPC_SOURCE_ATTACKTIME;
+	}
+	else if (FAudio_strcmp(engine->variableNames[rpc->variable], "ReleaseTime") == 0)
+	{
+		rpc->source = RPC_SOURCE_RELEASETIME;
+	}
+	else
+	{
+		rpc->source = RPC_SOURCE_CUE;
+	}
+}
+
 uint32_t FACT_INTERNAL_ParseAudioEngine(
 	FACTAudioEngine *pEngine,
 	const FACTRuntimeParameters *pParams
@@ -2095,6 +4850,8 @@ uint32_t FACT_INTERNAL_ParseAudioEngine(
 		);
 		pEngine->categories[i].visibility = read_u8(&ptr);
 		pEngine->categories[i].instanceCount = 0;
+		pEngine->categories[i].instanceHead = NULL;
+		pEngine->categories[i].instanceTail = NULL;
 		pEngine->categories[i].currentVolume = 1.0f;
 	}
 
@@ -2236,6 +4993,12 @@ uint32_t FACT_INTERNAL_ParseAudioEngine(
 		FAudio_memcpy(pEngine->variableNames[i], ptr, memsize);
 	}
 
+	/* Now that the variables have names, the RPCs can be compiled */
+	for (i = 0; i < pEngine->rpcCount; i += 1)
+	{
+		FACT_INTERNAL_CompileRPC(pEngine, &pEngine->rpcs[i]);
+	}
+
 	/* Store this pointer in case we're asked to free it */
 	if (pParams->globalSettingsFlags & FACT_FLAG_MANAGEDATA)
 	{
@@ -2245,11 +5008,112 @@ uint32_t FACT_INTERNAL_ParseAudioEngine(
 	return FAUDIO_OK;
 }
 
-void FACT_INTERNAL_ParseTrackEvents(
+/* SoundBank data is parsed into a single allocation, which is sized with a
+ * first pass over the file. Every block in it is aligned to this.
+ */
+#define FACT_ARENA_ALIGN 8
+#define FACT_ARENA_ALIGN_UP(x) \
+	(((x) + (FACT_ARENA_ALIGN - 1)) & ~((size_t) (FACT_ARENA_ALIGN - 1)))
+
+typedef struct FACTArena
+{
+	uint8_t *next;
+	uint8_t *end;
+} FACTArena;
+
+/* The second pass trusts the same counts the first pass added up, but a bank
+ * whose offsets point into the middle of another block can make the two
+ * disagree. Running off the end of the arena fails the parse instead.
+ */
+static inline void* FACT_INTERNAL_ArenaAlloc(FACTArena *arena, size_t size)
+{
+	void *result = arena->next;
+	size = FACT_ARENA_ALIGN_UP(size);
+	if (size > (size_t) (arena->end - arena->next))
+	{
+		return NULL;
+	}
+	arena->next += size;
+	return result;
+}
+
+static size_t FACT_INTERNAL_TrackEventsSize(const uint8_t **ptr, bool se)
+{
+	uint8_t eventCount, settings, i;
+	uint16_t type, waveCount;
+	size_t memsize;
+
+	eventCount = read_u8(ptr);
+	memsize = FACT_ARENA_ALIGN_UP(sizeof(FACTEvent) * eventCount);
+	for (i = 0; i < eventCount; i += 1)
+	{
+		type = read_u32(ptr, se) & 0x001F;
+		*ptr += 3; /* Random offset, separator */
+
+		switch (type)
+		{
+			case FACTEVENT_STOP:
+				*ptr += 1;
+				break;
+
+			case FACTEVENT_PLAYWAVE:
+				*ptr += 9;
+				break;
+
+			case FACTEVENT_PLAYWAVEEFFECTVARIATION:
+				*ptr += 9 + 24;
+				break;
+
+			case FACTEVENT_PLAYWAVETRACKVARIATION:
+			case FACTEVENT_PLAYWAVETRACKEFFECTVARIATION:
+				*ptr += 6;
+				if (type == FACTEVENT_PLAYWAVETRACKEFFECTVARIATION)
+				{
+					*ptr += 24;
+				}
+				waveCount = read_u32(ptr, se) & 0xFFFF;
+				*ptr += 4 + (waveCount * 5);
+				memsize += (
+					FACT_ARENA_ALIGN_UP(sizeof(uint16_t) * waveCount) +
+					FACT_ARENA_ALIGN_UP(sizeof(uint8_t) * waveCount) * 2
+				);
+				break;
+
+			case FACTEVENT_PITCH:
+			case FACTEVENT_VOLUME:
+			case FACTEVENT_PITCHREPEATING:
+			case FACTEVENT_VOLUMEREPEATING:
+				/* Ramps and equations happen to be the same size */
+				settings = read_u8(ptr);
+				*ptr += 14;
+				if (	!(settings & EVENT_SETTINGS_RAMP) &&
+					(	type == FACTEVENT_PITCHREPEATING ||
+						type == FACTEVENT_VOLUMEREPEATING	)	)
+				{
+					*ptr += 4;
+				}
+				break;
+
+			case FACTEVENT_MARKER:
+				*ptr += 4;
+				break;
+
+			case FACTEVENT_MARKERREPEATING:
+				*ptr += 8;
+				break;
+
+			default:
+				FAudio_assert(0 && "Unknown event type!");
+		}
+	}
+	return memsize;
+}
+
+static uint32_t FACT_INTERNAL_ParseTrackEvents(
 	const uint8_t **ptr,
 	bool se,
 	FACTTrack *track,
-	FAudioMallocFunc pMalloc
+	FACTArena *arena
 ) {
 	FACTEvent *events;
 	uint32_t evtInfo;
@@ -2258,7 +5122,11 @@ void FACT_INTERNAL_ParseTrackEvents(
 	uint16_t j;
 
 	track->eventCount = read_u8(ptr);
-	events = pMalloc(sizeof(*events) * track->eventCount);
+	events = FACT_INTERNAL_ArenaAlloc(arena, sizeof(*events) * track->eventCount);
+	if (events == NULL)
+	{
+		return FACTENGINE_E_INVALIDDATA;
+	}
 	FAudio_zero(events, sizeof(*events) * track->eventCount);
 	track->events = events;
 	for (i = 0; i < track->eventCount; i += 1)
@@ -2310,9 +5178,15 @@ void FACT_INTERNAL_ParseTrackEvents(
 				FAudio_Log("Unexpected variation table type.\n");
 			event->wave.complex.has_variation = (evtInfo >> 16) & EVENT_WAVE_HAS_VARIATION;
 			*ptr += 4; /* Unknown values */
-			event->wave.complex.wave_indices = pMalloc(sizeof(uint16_t) * event->wave.complex.wave_count);
-			event->wave.complex.wavebanks = pMalloc(sizeof(uint8_t) * event->wave.complex.wave_count);
-			event->wave.complex.weights = pMalloc(sizeof(uint8_t) * event->wave.complex.wave_count);
+			event->wave.complex.wave_indices = FACT_INTERNAL_ArenaAlloc(arena, sizeof(uint16_t) * event->wave.complex.wave_count);
+			event->wave.complex.wavebanks = FACT_INTERNAL_ArenaAlloc(arena, sizeof(uint8_t) * event->wave.complex.wave_count);
+			event->wave.complex.weights = FACT_INTERNAL_ArenaAlloc(arena, sizeof(uint8_t) * event->wave.complex.wave_count);
+			if (	event->wave.complex.wave_indices == NULL ||
+				event->wave.complex.wavebanks == NULL ||
+				event->wave.complex.weights == NULL	)
+			{
+				return FACTENGINE_E_INVALIDDATA;
+			}
 			for (uint16_t j = 0; j < event->wave.complex.wave_count; ++j)
 			{
 				event->wave.complex.wave_indices[j] = read_u16(ptr, se);
@@ -2375,9 +5249,15 @@ void FACT_INTERNAL_ParseTrackEvents(
 				FAudio_Log("Unexpected variation table type.\n");
 			event->wave.complex.has_variation = (evtInfo >> 16) & EVENT_WAVE_HAS_VARIATION;
 			*ptr += 4; /* Unknown values */
-			event->wave.complex.wave_indices = pMalloc(sizeof(uint16_t) * event->wave.complex.wave_count);
-			event->wave.complex.wavebanks = pMalloc(sizeof(uint8_t) * event->wave.complex.wave_count);
-			event->wave.complex.weights = pMalloc(sizeof(uint8_t) * event->wave.complex.wave_count);
+			event->wave.complex.wave_indices = FACT_INTERNAL_ArenaAlloc(arena, sizeof(uint16_t) * event->wave.complex.wave_count);
+			event->wave.complex.wavebanks = FACT_INTERNAL_ArenaAlloc(arena, sizeof(uint8_t) * event->wave.complex.wave_count);
+			event->wave.complex.weights = FACT_INTERNAL_ArenaAlloc(arena, sizeof(uint8_t) * event->wave.complex.wave_count);
+			if (	event->wave.complex.wave_indices == NULL ||
+				event->wave.complex.wavebanks == NULL ||
+				event->wave.complex.weights == NULL	)
+			{
+				return FACTENGINE_E_INVALIDDATA;
+			}
 			for (j = 0; j < event->wave.complex.wave_count; j += 1)
 			{
 				event->wave.complex.wave_indices[j] = read_u16(ptr, se);
@@ -2436,17 +5316,23 @@ void FACT_INTERNAL_ParseTrackEvents(
 		}
 		#undef EVTTYPE
 	}
+	return FAUDIO_OK;
 }
 
-static void parse_rpc_codes(FACTAudioEngine *engine, struct rpc_codes *data, const uint8_t **ptr, bool se)
+static uint32_t parse_rpc_codes(FACTArena *arena, struct rpc_codes *data, const uint8_t **ptr, bool se)
 {
 	uint32_t *codes;
 
 	data->count = read_u8(ptr);
-	codes = engine->pMalloc(data->count * sizeof(*codes));
+	codes = FACT_INTERNAL_ArenaAlloc(arena, data->count * sizeof(*codes));
+	if (codes == NULL)
+	{
+		return FACTENGINE_E_INVALIDDATA;
+	}
 	data->codes = codes;
 	for (uint8_t i = 0; i < data->count; ++i)
 		codes[i] = read_u32(ptr, se);
+	return FAUDIO_OK;
 }
 
 uint32_t FACT_INTERNAL_ParseSoundBank(
@@ -2459,7 +5345,10 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	uint16_t	contentVersion,
 			cueSimpleCount,
 			cueComplexCount,
-			cueTotalAlign;
+			cueTotalAlign,
+			cueCount,
+			soundCount;
+	uint8_t wavebankCount;
 	int32_t	cueSimpleOffset,
 		cueComplexOffset,
 		cueNameOffset,
@@ -2473,9 +5362,13 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	uint16_t filterData;
 	FACTSound *sounds;
 	uint8_t platform;
-	size_t memsize;
-	uint16_t i, j, k, cur, tool;
-	const uint8_t *ptrBookmark;
+	size_t memsize, arenaSize;
+	FACTArena arena;
+	uint16_t *slots;
+	uint8_t flags, count, trackCount;
+	uint16_t i, j, k, cur, tool, entryCount, variationCount, transitionCount;
+	uint32_t code;
+	const uint8_t *ptrBookmark, *ptrEvents;
 
 	const uint8_t *ptr = pvBuffer;
 	const uint8_t *start = ptr;
@@ -2515,19 +5408,15 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 		return -4; /* TODO: WRONG PLATFORM */
 	}
 
-	sb = (FACTSoundBank*) pEngine->pMalloc(sizeof(FACTSoundBank));
-	sb->parentEngine = pEngine;
-	sb->cueList = NULL;
-
 	cueSimpleCount = read_u16(&ptr, se);
 	cueComplexCount = read_u16(&ptr, se);
 
 	ptr += 2; /* Unknown value */
 
 	cueTotalAlign = read_u16(&ptr, se); /* FIXME: Why? */
-	sb->cueCount = cueSimpleCount + cueComplexCount;
-	sb->wavebankCount = read_u8(&ptr);
-	sb->soundCount = read_u16(&ptr, se);
+	cueCount = cueSimpleCount + cueComplexCount;
+	wavebankCount = read_u8(&ptr);
+	soundCount = read_u16(&ptr, se);
 
 	/* Cue name length, unused */
 	ptr += 2;
@@ -2547,34 +5436,224 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	cueNameIndexOffset = read_s32(&ptr, se);
 	soundOffset = read_s32(&ptr, se);
 
+	/* Everything below lives in one allocation, so size it first. This
+	 * has to match the allocations made while parsing exactly!
+	 */
+	ptrBookmark = ptr;
+	arenaSize = FACT_ARENA_ALIGN_UP(sizeof(FACTSoundBank));
+	arenaSize += FACT_ARENA_ALIGN_UP(FAudio_strlen((char*) ptr) + 1);
+
+	arenaSize += FACT_ARENA_ALIGN_UP(sizeof(char*) * wavebankCount);
+	for (i = 0; i < wavebankCount; i += 1)
+	{
+		arenaSize += FACT_ARENA_ALIGN_UP(
+			FAudio_strlen((char*) start + wavebankNameOffset + (i * 64)) + 1
+		);
+	}
+
+	ptr = start + soundOffset;
+	arenaSize += FACT_ARENA_ALIGN_UP(sizeof(FACTSound) * soundCount);
+	arenaSize += FACT_ARENA_ALIGN_UP(sizeof(uint32_t) * soundCount);
+	for (i = 0; i < soundCount; i += 1)
+	{
+		flags = read_u8(&ptr);
+		ptr += 8; /* Category, volume, pitch, priority, length */
+		if (flags & SOUND_FLAG_COMPLEX)
+		{
+			trackCount = read_u8(&ptr);
+		}
+		else
+		{
+			trackCount = 1;
+			ptr += 3; /* Wave index, wavebank */
+			arenaSize += FACT_ARENA_ALIGN_UP(sizeof(FACTEvent));
+		}
+		arenaSize += FACT_ARENA_ALIGN_UP(sizeof(FACTTrack) * trackCount);
+
+		if (flags & SOUND_FLAG_RPC_MASK)
+		{
+			ptr += 2; /* RPC data length */
+			for (j = 0; j < trackCount + 1; j += 1)
+			{
+				/* The sound's codes, then each track's */
+				if (	(j == 0 && (flags & SOUND_FLAG_HAS_RPC)) ||
+					(j > 0 && (flags & SOUND_FLAG_HAS_TRACK_RPC))	)
+				{
+					count = read_u8(&ptr);
+					ptr += count * sizeof(uint32_t);
+					arenaSize += FACT_ARENA_ALIGN_UP(count * sizeof(uint32_t));
+				}
+			}
+		}
+
+		if (flags & SOUND_FLAG_HAS_DSP)
+		{
+			ptr += 2; /* DSP presets length */
+			count = read_u8(&ptr);
+			ptr += count * sizeof(uint32_t);
+			arenaSize += FACT_ARENA_ALIGN_UP(count * sizeof(uint32_t));
+		}
+
+		if (flags & SOUND_FLAG_COMPLEX)
+		{
+			/* The next sound starts after the last track's events */
+			ptrEvents = ptr;
+			for (j = 0; j < trackCount; j += 1)
+			{
+				ptr += 1; /* Volume */
+				code = read_u32(&ptr, se);
+				if (contentVersion != FACT_CONTENT_VERSION_3_0)
+				{
+					ptr += 4; /* Filter data, frequency */
+				}
+				ptrEvents = start + code;
+				arenaSize += FACT_INTERNAL_TrackEventsSize(&ptrEvents, se);
+			}
+			ptr = ptrEvents;
+		}
+	}
+
+	arenaSize += FACT_ARENA_ALIGN_UP(sizeof(FACTCueData) * cueCount);
+	variationCount = 0;
+	transitionCount = 0;
+	if (cueComplexCount > 0)
+	{
+		ptr = start + cueComplexOffset;
+		for (i = 0; i < cueComplexCount; i += 1)
+		{
+			flags = read_u8(&ptr);
+			ptr += 4; /* Sound code */
+			code = read_u32(&ptr, se);
+			ptr += 6; /* Instance limit, fades, max instance behavior */
+			if (!(flags & CUE_FLAG_SINGLE_SOUND))
+			{
+				variationCount += 1;
+			}
+			if (code != 0 && code != 0xFFFFFFFF)
+			{
+				transitionCount += 1;
+			}
+		}
+	}
+
+	if (variationCount > 0)
+	{
+		ptr = start + variationOffset;
+		arenaSize += FACT_ARENA_ALIGN_UP(
+			sizeof(FACTVariationTable) * variationCount
+		);
+	}
+	for (i = 0; i < variationCount; i += 1)
+	{
+		entryCountAndFlags = read_u32(&ptr, se);
+		entryCount = entryCountAndFlags & 0xFFFF;
+		ptr += 4; /* Unknown value, variable */
+		arenaSize += FACT_ARENA_ALIGN_UP(sizeof(FACTVariation) * entryCount);
+		switch ((entryCountAndFlags >> (16 + 3)) & 0x07)
+		{
+			case VARIATION_TABLE_TYPE_WAVE:
+				ptr += entryCount * 5;
+				break;
+			case VARIATION_TABLE_TYPE_SOUND:
+				ptr += entryCount * 6;
+				break;
+			case VARIATION_TABLE_TYPE_INTERACTIVE:
+				ptr += entryCount * 16;
+				break;
+			case VARIATION_TABLE_TYPE_COMPACT_WAVE:
+				ptr += entryCount * 3;
+				break;
+			default:
+				FAudio_assert(0 && "Unknown variation type!");
+		}
+	}
+
+	if (transitionCount > 0)
+	{
+		ptr = start + transitionOffset;
+		arenaSize += FACT_ARENA_ALIGN_UP(
+			sizeof(FACTTransitionTable) * transitionCount
+		);
+		arenaSize += FACT_ARENA_ALIGN_UP(sizeof(uint32_t) * transitionCount);
+	}
+	for (i = 0; i < transitionCount; i += 1)
+	{
+		code = read_u32(&ptr, se);
+		ptr += code * 26;
+		arenaSize += FACT_ARENA_ALIGN_UP(sizeof(FACTTransition) * code);
+	}
+
+	if (cueNameOffset != -1)
+	{
+		arenaSize += FACT_ARENA_ALIGN_UP(sizeof(char*) * cueCount);
+		arenaSize += FACT_ARENA_ALIGN_UP(
+			sizeof(uint16_t) * FACT_INTERNAL_NameIndexSize(cueCount)
+		);
+		for (i = 0; i < cueCount; i += 1)
+		{
+			const uint8_t *offset_ptr = start + cueNameIndexOffset + (i * 6);
+
+			ptr = start + read_u32(&offset_ptr, se);
+			arenaSize += FACT_ARENA_ALIGN_UP(FAudio_strlen((char*) ptr) + 1);
+		}
+	}
+
+	arena.next = (uint8_t*) pEngine->pMalloc(arenaSize);
+	arena.end = arena.next + arenaSize;
+	sb = (FACTSoundBank*) FACT_INTERNAL_ArenaAlloc(&arena, sizeof(FACTSoundBank));
+	sb->parentEngine = pEngine;
+	sb->cueList = NULL;
+	sb->cueCount = cueCount;
+	sb->wavebankCount = wavebankCount;
+	sb->soundCount = soundCount;
+	ptr = ptrBookmark;
+
 	/* SoundBank Name */
 	memsize = FAudio_strlen((char*) ptr) + 1; /* Dastardly! */
-	sb->name = (char*) pEngine->pMalloc(memsize);
+	sb->name = (char*) FACT_INTERNAL_ArenaAlloc(&arena, memsize);
+	if (sb->name == NULL)
+	{
+		goto arenafail;
+	}
 	FAudio_memcpy(sb->name, ptr, memsize);
 	ptr += 64;
 
 	/* WaveBank Name data */
 	ptr = start + wavebankNameOffset;
-	sb->wavebankNames = (char**) pEngine->pMalloc(
+	sb->wavebankNames = (char**) FACT_INTERNAL_ArenaAlloc(
+		&arena,
 		sizeof(char*) *
 		sb->wavebankCount
 	);
+	if (sb->wavebankNames == NULL)
+	{
+		goto arenafail;
+	}
 	for (i = 0; i < sb->wavebankCount; i += 1)
 	{
 		memsize = FAudio_strlen((char*) ptr) + 1;
-		sb->wavebankNames[i] = (char*) pEngine->pMalloc(memsize);
+		sb->wavebankNames[i] = (char*) FACT_INTERNAL_ArenaAlloc(&arena, memsize);
+		if (sb->wavebankNames[i] == NULL)
+		{
+			goto arenafail;
+		}
 		FAudio_memcpy(sb->wavebankNames[i], ptr, memsize);
 		ptr += 64;
 	}
 
 	/* Sound data */
 	ptr = start + soundOffset;
-	sounds = pEngine->pMalloc(sb->soundCount * sizeof(*sounds));
+	sounds = FACT_INTERNAL_ArenaAlloc(&arena, sb->soundCount * sizeof(*sounds));
 	sb->sounds = sounds;
-	sb->soundCodes = (uint32_t*) pEngine->pMalloc(
+	sb->soundCodes = (uint32_t*) FACT_INTERNAL_ArenaAlloc(
+		&arena,
 		sizeof(uint32_t) *
 		sb->soundCount
 	);
+	if (sounds == NULL || sb->soundCodes == NULL)
+	{
+		goto arenafail;
+	}
 	for (i = 0; i < sb->soundCount; i += 1)
 	{
 		FACTSound *sound = &sounds[i];
@@ -2593,7 +5672,11 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 		if (sound->flags & SOUND_FLAG_COMPLEX)
 		{
 			sound->trackCount = read_u8(&ptr);
-			tracks = pEngine->pMalloc(sound->trackCount * sizeof(*tracks));
+			tracks = FACT_INTERNAL_ArenaAlloc(&arena, sound->trackCount * sizeof(*tracks));
+			if (tracks == NULL)
+			{
+				goto arenafail;
+			}
 			FAudio_zero(tracks, sound->trackCount * sizeof(*tracks));
 			sound->tracks = tracks;
 		}
@@ -2601,14 +5684,22 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 		{
 			FACTEvent *event;
 
-			tracks = pEngine->pMalloc(sizeof(*tracks));
+			tracks = FACT_INTERNAL_ArenaAlloc(&arena, sizeof(*tracks));
+			if (tracks == NULL)
+			{
+				goto arenafail;
+			}
 			FAudio_zero(tracks, sizeof(*tracks));
 			sound->trackCount = 1;
 			sound->tracks = tracks;
 			tracks[0].filter = 0xFF;
 			tracks[0].eventCount = 1;
 
-			event = pEngine->pMalloc(sizeof(*event));
+			event = FACT_INTERNAL_ArenaAlloc(&arena, sizeof(*event));
+			if (event == NULL)
+			{
+				goto arenafail;
+			}
 			FAudio_zero(event, sizeof(*event));
 			event->type = FACTEVENT_PLAYWAVE;
 			event->wave.position = 0; /* FIXME */
@@ -2625,7 +5716,10 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 
 			if (sound->flags & SOUND_FLAG_HAS_RPC)
 			{
-				parse_rpc_codes(pEngine, &sound->rpc_codes, &ptr, se);
+				if (parse_rpc_codes(&arena, &sound->rpc_codes, &ptr, se) != FAUDIO_OK)
+				{
+					goto arenafail;
+				}
 			}
 			else
 			{
@@ -2635,7 +5729,12 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 			if (sound->flags & SOUND_FLAG_HAS_TRACK_RPC)
 			{
 				for (j = 0; j < sound->trackCount; j += 1)
-					parse_rpc_codes(pEngine, &tracks[j].rpc_codes, &ptr, se);
+				{
+					if (parse_rpc_codes(&arena, &tracks[j].rpc_codes, &ptr, se) != FAUDIO_OK)
+					{
+						goto arenafail;
+					}
+				}
 			}
 
 			/* FIXME: Does 0x08 mean something for RPCs...? */
@@ -2653,7 +5752,11 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 			ptr += 2;
 
 			sound->dspCodeCount = read_u8(&ptr);
-			sound->dspCodes = pEngine->pMalloc(sound->dspCodeCount * sizeof(uint32_t));
+			sound->dspCodes = FACT_INTERNAL_ArenaAlloc(&arena, sound->dspCodeCount * sizeof(uint32_t));
+			if (sound->dspCodes == NULL)
+			{
+				goto arenafail;
+			}
 			for (uint8_t j = 0; j < sound->dspCodeCount; ++j)
 			{
 				sound->dspCodes[j] = read_u32(&ptr, se);
@@ -2702,7 +5805,10 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 				FACTTrack *track = &tracks[j];
 
 				ptr = start + track->code;
-				FACT_INTERNAL_ParseTrackEvents(&ptr, se, track, pEngine->pMalloc);
+				if (FACT_INTERNAL_ParseTrackEvents(&ptr, se, track, &arena) != FAUDIO_OK)
+				{
+					goto arenafail;
+				}
 			}
 		}
 	}
@@ -2710,10 +5816,15 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	/* All Cue data */
 	sb->variationCount = 0;
 	sb->transitionCount = 0;
-	sb->cues = (FACTCueData*) pEngine->pMalloc(
+	sb->cues = (FACTCueData*) FACT_INTERNAL_ArenaAlloc(
+		&arena,
 		sizeof(FACTCueData) *
 		sb->cueCount
 	);
+	if (sb->cues == NULL)
+	{
+		goto arenafail;
+	}
 	cur = 0;
 
 	/* Simple Cue data */
@@ -2731,6 +5842,8 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 			sb->cues[cur].fadeOutMS = 0;
 			sb->cues[cur].maxInstanceBehavior = MAX_INSTANCE_BEHAVIOR_FAIL;
 			sb->cues[cur].instanceCount = 0;
+			sb->cues[cur].instanceHead = NULL;
+			sb->cues[cur].instanceTail = NULL;
 		}
 	}
 
@@ -2754,6 +5867,8 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 			sb->cues[cur].fadeOutMS = read_u16(&ptr, se);
 			sb->cues[cur].maxInstanceBehavior = read_u8(&ptr) >> 3;
 			sb->cues[cur].instanceCount = 0;
+			sb->cues[cur].instanceHead = NULL;
+			sb->cues[cur].instanceTail = NULL;
 
 			if (!(sb->cues[cur].flags & CUE_FLAG_SINGLE_SOUND))
 			{
@@ -2772,10 +5887,15 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	if (sb->variationCount > 0)
 	{
 		ptr = start + variationOffset;
-		sb->variations = (FACTVariationTable*) pEngine->pMalloc(
+		sb->variations = (FACTVariationTable*) FACT_INTERNAL_ArenaAlloc(
+			&arena,
 			sizeof(FACTVariationTable) *
 			sb->variationCount
 		);
+		if (sb->variations == NULL)
+		{
+			goto arenafail;
+		}
 	}
 	else
 	{
@@ -2792,7 +5912,11 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 		ptr += 2; /* Unknown value */
 		table->variable = read_s16(&ptr, se);
 		memsize = sizeof(FACTVariation) * table->entryCount;
-		table->entries = pEngine->pMalloc(memsize);
+		table->entries = FACT_INTERNAL_ArenaAlloc(&arena, memsize);
+		if (table->entries == NULL)
+		{
+			goto arenafail;
+		}
 		FAudio_zero(table->entries, memsize);
 
 		switch (table->type)
@@ -2849,14 +5973,20 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	if (sb->transitionCount > 0)
 	{
 		ptr = start + transitionOffset;
-		sb->transitions = (FACTTransitionTable*) pEngine->pMalloc(
+		sb->transitions = (FACTTransitionTable*) FACT_INTERNAL_ArenaAlloc(
+			&arena,
 			sizeof(FACTTransitionTable) *
 			sb->transitionCount
 		);
-		sb->transitionCodes = (uint32_t*) pEngine->pMalloc(
+		sb->transitionCodes = (uint32_t*) FACT_INTERNAL_ArenaAlloc(
+			&arena,
 			sizeof(uint32_t) *
 			sb->transitionCount
 		);
+		if (sb->transitions == NULL || sb->transitionCodes == NULL)
+		{
+			goto arenafail;
+		}
 	}
 	else
 	{
@@ -2868,9 +5998,14 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 		sb->transitionCodes[i] = (uint32_t) (ptr - start);
 		sb->transitions[i].entryCount = read_u32(&ptr, se);
 		memsize = sizeof(FACTTransition) * sb->transitions[i].entryCount;
-		sb->transitions[i].entries = (FACTTransition*) pEngine->pMalloc(
+		sb->transitions[i].entries = (FACTTransition*) FACT_INTERNAL_ArenaAlloc(
+			&arena,
 			memsize
 		);
+		if (sb->transitions[i].entries == NULL)
+		{
+			goto arenafail;
+		}
 		for (j = 0; j < sb->transitions[i].entryCount; j += 1)
 		{
 			sb->transitions[i].entries[j].soundCode = read_s32(&ptr, se);
@@ -2888,10 +6023,15 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 	if (cueNameOffset != -1)
 	{
 		ptr = start + cueNameOffset;
-		sb->cueNames = (char**) pEngine->pMalloc(
+		sb->cueNames = (char**) FACT_INTERNAL_ArenaAlloc(
+			&arena,
 			sizeof(char*) *
 			sb->cueCount
 		);
+		if (sb->cueNames == NULL)
+		{
+			goto arenafail;
+		}
 		for (i = 0; i < sb->cueCount; i += 1)
 		{
 			const uint8_t *offset_ptr = start + cueNameIndexOffset + (i * 6);
@@ -2906,25 +6046,75 @@ uint32_t FACT_INTERNAL_ParseSoundBank(
 #endif
 
 			memsize = FAudio_strlen((char*) ptr) + 1;
-			sb->cueNames[i] = (char*) pEngine->pMalloc(memsize);
+			sb->cueNames[i] = (char*) FACT_INTERNAL_ArenaAlloc(&arena, memsize);
+			if (sb->cueNames[i] == NULL)
+			{
+				goto arenafail;
+			}
 			FAudio_memcpy(sb->cueNames[i], ptr, memsize);
 		}
+
+		/* No cues means no table at all, FindName checks for NULL slots.
+		 * A zero-sized block would still be a pointer into the arena.
+		 */
+		memsize = FACT_INTERNAL_NameIndexSize(sb->cueCount);
+		if (memsize > 0)
+		{
+			slots = (uint16_t*) FACT_INTERNAL_ArenaAlloc(
+				&arena,
+				sizeof(uint16_t) * memsize
+			);
+			if (slots == NULL)
+			{
+				goto arenafail;
+			}
+		}
+		else
+		{
+			slots = NULL;
+		}
+		FACT_INTERNAL_InitNameIndex(
+			&sb->cueLookup,
+			slots,
+			memsize,
+			sb->cueNames,
+			NULL
+		);
+		for (i = 0; i < sb->cueCount; i += 1)
+		{
+			FACT_INTERNAL_AddName(&sb->cueLookup, i);
+		}
 	}
 	else
 	{
 		sb->cueNames = NULL;
+		FACT_INTERNAL_InitNameIndex(&sb->cueLookup, NULL, 0, NULL, NULL);
 	}
+	FAudio_assert(arena.next == arena.end);
+
+	*ppSoundBank = sb;
+	return FAUDIO_OK;
+
+arenafail:
+	/* sb is the start of the arena, nothing else was allocated */
+	pEngine->pFree(sb);
+	return FACTENGINE_E_INVALIDDATA;
+}
+
+/* Parsing doesn't touch the Engine, so the load thread can do it without the
+ * apiLock. Adding the bank is what makes it visible, that needs the lock.
+ */
+void FACT_INTERNAL_AddSoundBank(FACTSoundBank *sb)
+{
+	FACTAudioEngine *engine = sb->parentEngine;
 
 	/* Add to the Engine SoundBank list */
 	LinkedList_AddEntry(
-		&pEngine->sbList,
+		&engine->sbList,
 		sb,
-		pEngine->sbLock,
-		pEngine->pMalloc
+		engine->sbLock,
+		engine->pMalloc
 	);
-
-	*ppSoundBank = sb;
-	return FAUDIO_OK;
 }
 
 /* This parser is based on the unxwb project, written by Luigi Auriemma.
@@ -2944,20 +6134,25 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 	FACTReadFileCallback pRead,
 	FACTGetOverlappedResultCallback pOverlap,
 	bool isStreaming,
+	bool isCached,
+	const FACTTranscodePolicyEXT *pPolicy,
 	FACTWaveBank **ppWaveBank
 ) {
 	bool se; /* Swap Endian */
 	FACTWaveBank *wb;
 	size_t memsize;
-	uint32_t i, j;
+	uint32_t i;
 	FACTWaveBankHeader header;
 	FACTWaveBankData wbinfo;
 	uint32_t compactEntry;
 	int32_t seekTableOffset;
+	uint32_t seekTableBase;
+	uint32_t *seekTable;
 	uint32_t fileOffset;
 	uint8_t *packetBuffer = NULL;
 	uint32_t packetBufferLen = 0;
-	uint16_t *pcm;
+	uint8_t *segment;
+	uint32_t segmentLen;
 
 	#define SEEKSET(loc) \
 		fileOffset = offset + loc;
@@ -3052,7 +6247,7 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 	}
 	wb->streaming = (wbinfo.dwFlags & FACT_WAVEBANK_TYPE_STREAMING);
 
-	if (wb->streaming != isStreaming)
+	if (!isCached && wb->streaming != isStreaming)
 	{
 		/* Native forbids creating an in-memory wave bank when the flags
 		 * include STREAMING. It allows creating a streaming wave bank
@@ -3062,6 +6257,13 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 		return FACTENGINE_E_INVALIDUSAGE;
 	}
 
+	/* Cached WaveBanks can be either type, they always play from memory */
+	if (isCached)
+	{
+		wb->streaming = false;
+	}
+	wb->bigEndian = se;
+
 	wb->entryCount = wbinfo.dwEntryCount;
 	memsize = FAudio_strlen(wbinfo.szBankName) + 1;
 	wb->name = (char*) pEngine->pMalloc(memsize);
@@ -3073,13 +6275,20 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 	wb->entryRefs = (uint32_t*) pEngine->pMalloc(memsize);
 	FAudio_zero(wb->entryRefs, memsize);
 
-	/* WaveBank Entry Metadata */
+	/* WaveBank Entry Metadata, read in one go and decoded from memory */
 	SEEKSET(header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYMETADATA].dwOffset)
+	segmentLen = wbinfo.dwEntryCount * wbinfo.dwEntryMetaDataElementSize;
 	if (wbinfo.dwFlags & FACT_WAVEBANK_FLAGS_COMPACT)
 	{
-		for (i = 0; i < wbinfo.dwEntryCount - 1; i += 1)
+		segment = (uint8_t*) pEngine->pMalloc(segmentLen);
+		READ(segment, segmentLen)
+		for (i = 0; i < wbinfo.dwEntryCount; i += 1)
 		{
-			READ(&compactEntry, sizeof(compactEntry))
+			FAudio_memcpy(
+				&compactEntry,
+				segment + (i * wbinfo.dwEntryMetaDataElementSize),
+				sizeof(compactEntry)
+			);
 			if (se)
 			{
 				DOSWAP_32(compactEntry);
@@ -3088,72 +6297,77 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 				(compactEntry & ((1 << 21) - 1)) *
 				wbinfo.dwAlignment
 			);
-			wb->entries[i].PlayRegion.dwLength = (
-				(compactEntry >> 21) & ((1 << 11) - 1)
-			);
+		}
+		pEngine->pFree(segment);
 
-			/* TODO: Deviation table */
-			SEEKCUR(wbinfo.dwEntryMetaDataElementSize)
+		/* TODO: Deviation table */
+		for (i = 0; i < wbinfo.dwEntryCount; i += 1)
+		{
 			wb->entries[i].PlayRegion.dwLength = (
-				(compactEntry & ((1 << 21) - 1)) *
-				wbinfo.dwAlignment
+				(i < wbinfo.dwEntryCount - 1) ?
+					wb->entries[i + 1].PlayRegion.dwOffset :
+					header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYWAVEDATA].dwLength
 			) - wb->entries[i].PlayRegion.dwOffset;
-
+		}
+		for (i = 0; i < wbinfo.dwEntryCount; i += 1)
+		{
 			wb->entries[i].PlayRegion.dwOffset +=
 				header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYWAVEDATA].dwOffset;
 		}
+	}
+	else
+	{
+		if (wbinfo.dwEntryMetaDataElementSize == sizeof(FACTWaveBankEntry))
+		{
+			READ(wb->entries, segmentLen)
+		}
+		else
+		{
+			/* Older banks have shorter entries, pad them out */
+			segment = (uint8_t*) pEngine->pMalloc(segmentLen);
+			READ(segment, segmentLen)
+			for (i = 0; i < wbinfo.dwEntryCount; i += 1)
+			{
+				FAudio_memcpy(
+					&wb->entries[i],
+					segment + (i * wbinfo.dwEntryMetaDataElementSize),
+					FAudio_min(
+						wbinfo.dwEntryMetaDataElementSize,
+						sizeof(FACTWaveBankEntry)
+					)
+				);
+			}
+			pEngine->pFree(segment);
+		}
 
-		READ(&compactEntry, sizeof(compactEntry))
+		/* Every entry field is 32 bits wide, swap them all at once */
 		if (se)
 		{
-			DOSWAP_32(compactEntry);
+			FAudio_INTERNAL_SwapBE32(
+				(uint32_t*) wb->entries,
+				wbinfo.dwEntryCount * (sizeof(FACTWaveBankEntry) / sizeof(uint32_t))
+			);
 		}
-		wb->entries[i].PlayRegion.dwOffset = (
-			(compactEntry & ((1 << 21) - 1)) *
-			wbinfo.dwAlignment
-		);
-
-		/* TODO: Deviation table */
-		SEEKCUR(wbinfo.dwEntryMetaDataElementSize)
-		wb->entries[i].PlayRegion.dwLength = (
-			header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYWAVEDATA].dwLength -
-			wb->entries[i].PlayRegion.dwOffset
-		);
 
-		wb->entries[i].PlayRegion.dwOffset +=
-			header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYWAVEDATA].dwOffset;
-	}
-	else
-	{
 		for (i = 0; i < wbinfo.dwEntryCount; i += 1)
 		{
-			READ(&wb->entries[i], wbinfo.dwEntryMetaDataElementSize)
-			if (se)
-			{
-				DOSWAP_32(wb->entries[i].dwFlagsAndDuration);
-				DOSWAP_32(wb->entries[i].Format.dwValue);
-				DOSWAP_32(wb->entries[i].PlayRegion.dwOffset);
-				DOSWAP_32(wb->entries[i].PlayRegion.dwLength);
-				DOSWAP_32(wb->entries[i].LoopRegion.dwStartSample);
-				DOSWAP_32(wb->entries[i].LoopRegion.dwTotalSamples);
-			}
 			wb->entries[i].PlayRegion.dwOffset +=
 				header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYWAVEDATA].dwOffset;
 
 			/* If it's in-memory big-endian PCM, swap! */
 			if (	se &&
 				!wb->streaming &&
+				!isCached &&
 				wb->entries[i].Format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM &&
 				wb->entries[i].Format.wBitsPerSample == 1	)
 			{
-				pcm = (uint16_t*) FAudio_memptr(
-					(FAudioIOStream*) wb->io,
-					wb->entries[i].PlayRegion.dwOffset
+				FAudio_INTERNAL_SwapBE16(
+					(uint16_t*) FAudio_memptr(
+						(FAudioIOStream*) wb->io,
+						wb->entries[i].PlayRegion.dwOffset
+					),
+					wb->entries[i].PlayRegion.dwLength / 2
 				);
-				for (j = 0; j < wb->entries[i].PlayRegion.dwLength; j += 2, pcm += 1)
-				{
-					DOSWAP_16(*pcm);
-				}
 			}
 		}
 
@@ -3172,59 +6386,57 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 	if (	wbinfo.dwFlags & FACT_WAVEBANK_FLAGS_SEEKTABLES &&
 		header.Segments[FACT_WAVEBANK_SEGIDX_SEEKTABLES].dwLength > 0	)
 	{
-		/* The seek table data layout is an absolute disaster! */
+		/* The seek table data layout is an absolute disaster! It's an
+		 * offset per entry, followed by each table as a count and then
+		 * the entries, all 32 bits wide. Read the whole segment...
+		 */
+		SEEKSET(header.Segments[FACT_WAVEBANK_SEGIDX_SEEKTABLES].dwOffset)
+		segmentLen = header.Segments[FACT_WAVEBANK_SEGIDX_SEEKTABLES].dwLength;
+		segment = (uint8_t*) pEngine->pMalloc(segmentLen);
+		READ(segment, segmentLen)
+		if (se)
+		{
+			FAudio_INTERNAL_SwapBE32(
+				(uint32_t*) segment,
+				segmentLen / sizeof(uint32_t)
+			);
+		}
+
+		/* ... then carve the tables out of it */
 		wb->seekTables = (FACTSeekTable*) pEngine->pMalloc(
 			wbinfo.dwEntryCount * sizeof(FACTSeekTable)
 		);
+		seekTableBase = wbinfo.dwEntryCount * sizeof(uint32_t);
 		for (i = 0; i < wbinfo.dwEntryCount; i += 1)
 		{
-			/* Get the table offset... */
-			SEEKSET(
-				header.Segments[FACT_WAVEBANK_SEGIDX_SEEKTABLES].dwOffset +
-				i * sizeof(uint32_t)
-			)
-			READ(&seekTableOffset, sizeof(int32_t))
-			if (se)
-			{
-				DOSWAP_32(seekTableOffset);
-			}
+			wb->seekTables[i].entryCount = 0;
+			wb->seekTables[i].entries = NULL;
 
 			/* If the offset is -1, this wave needs no table */
-			if (seekTableOffset == -1)
+			seekTableOffset = ((int32_t*) segment)[i];
+			if (	seekTableOffset < 0 ||
+				seekTableBase + seekTableOffset + sizeof(uint32_t) > segmentLen	)
 			{
-				wb->seekTables[i].entryCount = 0;
-				wb->seekTables[i].entries = NULL;
 				continue;
 			}
 
-			/* Go to the table offset, after the offset table... */
-			SEEKSET(
-				header.Segments[FACT_WAVEBANK_SEGIDX_SEEKTABLES].dwOffset +
-				(wbinfo.dwEntryCount * sizeof(uint32_t)) +
-				seekTableOffset
-			)
-
-			/* Read the table, finally. */
-			READ(&wb->seekTables[i].entryCount, sizeof(uint32_t))
-			if (se)
+			seekTable = (uint32_t*) (segment + seekTableBase + seekTableOffset);
+			if (	seekTableBase + seekTableOffset + sizeof(uint32_t) +
+				(seekTable[0] * sizeof(uint32_t)) > segmentLen	)
 			{
-				DOSWAP_32(wb->seekTables[i].entryCount);
+				continue;
 			}
+			wb->seekTables[i].entryCount = seekTable[0];
 			wb->seekTables[i].entries = (uint32_t*) pEngine->pMalloc(
-				wb->seekTables[i].entryCount * sizeof(uint32_t)
+				seekTable[0] * sizeof(uint32_t)
 			);
-			READ(
+			FAudio_memcpy(
 				wb->seekTables[i].entries,
-				wb->seekTables[i].entryCount * sizeof(uint32_t)
-			)
-			if (se)
-			{
-				for (j = 0; j < wb->seekTables[i].entryCount; j += 1)
-				{
-					DOSWAP_32(wb->seekTables[i].entries[j]);
-				}
-			}
+				seekTable + 1,
+				seekTable[0] * sizeof(uint32_t)
+			);
 		}
+		pEngine->pFree(segment);
 	}
 	else
 	{
@@ -3237,19 +6449,41 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 		SEEKSET(header.Segments[FACT_WAVEBANK_SEGIDX_ENTRYNAMES].dwOffset)
 		wb->waveBankNames = (char*) pEngine->pMalloc(64 * wbinfo.dwEntryCount);
 		READ(wb->waveBankNames, 64 * wbinfo.dwEntryCount);
+
+		memsize = FACT_INTERNAL_NameIndexSize(wbinfo.dwEntryCount);
+		FACT_INTERNAL_InitNameIndex(
+			&wb->waveLookup,
+			(memsize > 0) ?
+				(uint16_t*) pEngine->pMalloc(sizeof(uint16_t) * memsize) :
+				NULL,
+			memsize,
+			NULL,
+			wb->waveBankNames
+		);
+		for (i = 0; i < wbinfo.dwEntryCount; i += 1)
+		{
+			FACT_INTERNAL_AddName(&wb->waveLookup, i);
+		}
 	}
 	else
 	{
 		wb->waveBankNames = NULL;
+		FACT_INTERNAL_InitNameIndex(&wb->waveLookup, NULL, 0, NULL, NULL);
 	}
 
-	/* Add to the Engine WaveBank list */
-	LinkedList_AddEntry(
-		&pEngine->wbList,
-		wb,
-		pEngine->wbLock,
-		pEngine->pMalloc
-	);
+	/* Cached WaveBanks read their entries when they're first used */
+	if (isCached)
+	{
+		memsize = sizeof(FACTCacheEntry) * wbinfo.dwEntryCount;
+		wb->cache = (FACTCacheEntry*) pEngine->pMalloc(memsize);
+		FAudio_zero(wb->cache, memsize);
+	}
+	else
+	{
+		wb->cache = NULL;
+	}
+	wb->transcoded = NULL;
+	FACT_INTERNAL_TranscodeBySize(wb, pPolicy);
 
 	/* Finally. */
 	wb->packetBuffer = packetBuffer;
@@ -3258,4 +6492,54 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 	return FAUDIO_OK;
 }
 
+void FACT_INTERNAL_AddWaveBank(FACTWaveBank *wb)
+{
+	FACTAudioEngine *engine = wb->parentEngine;
+	uint32_t i;
+
+	/* Add to the Engine WaveBank list */
+	LinkedList_AddEntry(
+		&engine->wbList,
+		wb,
+		engine->wbLock,
+		engine->pMalloc
+	);
+
+	/* The parser already did the transcode size threshold */
+	if (wb->transcoded != NULL)
+	{
+		for (i = 0; i < wb->entryCount; i += 1)
+		{
+			engine->transcodedSize += wb->transcoded[i].size;
+		}
+	}
+}
+
+void FACT_INTERNAL_QueueSoundBankPrepared(
+	FACTAudioEngine *engine,
+	FACTSoundBank *sb
+) {
+	/* Sent from DoWork, on the application's thread */
+	if (engine->prepared_soundbank_count == engine->prepared_soundbanks_capacity)
+	{
+		engine->prepared_soundbanks_capacity = FAudio_max(engine->prepared_soundbanks_capacity * 2, 8);
+		engine->prepared_soundbanks = engine->pRealloc(engine->prepared_soundbanks,
+			engine->prepared_soundbanks_capacity * sizeof(FACTSoundBank *));
+	}
+	engine->prepared_soundbanks[engine->prepared_soundbank_count++] = sb;
+}
+
+void FACT_INTERNAL_QueueWaveBankPrepared(
+	FACTAudioEngine *engine,
+	FACTWaveBank *wb
+) {
+	if (engine->prepared_wavebank_count == engine->prepared_wavebanks_capacity)
+	{
+		engine->prepared_wavebanks_capacity = FAudio_max(engine->prepared_wavebanks_capacity * 2, 8);
+		engine->prepared_wavebanks = engine->pRealloc(engine->prepared_wavebanks,
+			engine->prepared_wavebanks_capacity * sizeof(FACTWaveBank *));
+	}
+	engine->prepared_wavebanks[engine->prepared_wavebank_count++] = wb;
+}
+
 /* vim: set noexpandtab shiftwidth=8 tabstop=8: */
@@ -56,6 +56,10 @@ typedef struct FACTAudioCategory
 
 	uint8_t instanceCount;
 	float currentVolume;
+
+	/* Cues counted in instanceCount, oldest first */
+	FACTCue *instanceHead;
+	FACTCue *instanceTail;
 } FACTAudioCategory;
 
 typedef struct FACTVariable
@@ -81,6 +85,15 @@ typedef struct FACTRPCPoint
 	enum rpc_point_type type;
 } FACTRPCPoint;
 
+/* Where an RPC gets its variable's value from, resolved at load time */
+enum rpc_source
+{
+	RPC_SOURCE_GLOBAL,
+	RPC_SOURCE_CUE,
+	RPC_SOURCE_ATTACKTIME,
+	RPC_SOURCE_RELEASETIME
+};
+
 typedef enum FACTRPCParameter
 {
 	RPC_PARAMETER_VOLUME,
@@ -97,6 +110,7 @@ typedef struct FACTRPC
 	uint8_t pointCount;
 	uint16_t parameter;
 	FACTRPCPoint *points;
+	enum rpc_source source;
 } FACTRPC;
 
 typedef struct FACTDSPParameter
@@ -293,6 +307,10 @@ typedef struct FACTCueData
 	uint16_t fadeOutMS;
 	enum max_instance_behavior maxInstanceBehavior;
 	uint8_t instanceCount;
+
+	/* Cues counted in instanceCount, oldest first */
+	FACTCue *instanceHead;
+	FACTCue *instanceTail;
 } FACTCueData;
 
 typedef struct FACTVariation
@@ -430,6 +448,11 @@ typedef struct FACTTrackInstance
 	FACTEventInstance *waveEvtInst;
 } FACTTrackInstance;
 
+#define RPC_DEPENDS_TIME	0x01
+#define RPC_DEPENDS_CUE		0x02
+#define RPC_DEPENDS_GLOBAL	0x04
+#define RPC_DEPENDS_DIRTY	0x08
+
 typedef struct FACTSoundInstance
 {
 	/* Base Sound reference */
@@ -441,6 +464,13 @@ typedef struct FACTSoundInstance
 	/* RPC instance data */
 	FACTInstanceRPCData rpcData;
 
+	/* What the RPC results were computed from, and the variable versions
+	 * they were computed with. They're only redone when those change.
+	 */
+	uint8_t rpcDepends;
+	uint32_t rpcCueVersion;
+	uint32_t rpcGlobalVersion;
+
 	/* Fade data */
 	uint32_t fadeStart;
 	uint16_t fadeTarget;
@@ -468,8 +498,202 @@ typedef struct FACTWaveCallback
 	FACTWave *wave;
 } FACTWaveCallback;
 
+/* How many packets a streaming Wave can have in flight. Packets are queued on
+ * the voice as soon as they are read, so the voice can have all of them ahead.
+ */
+#define FACT_STREAM_PACKETS 3
+
+typedef enum FACTStreamPacketState
+{
+	FACT_STREAMPACKET_EMPTY,
+	FACT_STREAMPACKET_PENDING, /* Has a region, waiting for the stream thread */
+	FACT_STREAMPACKET_READING,
+	FACT_STREAMPACKET_READY,
+	FACT_STREAMPACKET_QUEUED
+} FACTStreamPacketState;
+
+typedef struct FACTStreamPacket
+{
+	/* Sized for the packet plus sector alignment on both ends */
+	uint8_t *data;
+
+	/* Region of the wavebank this packet holds, kept after playback so
+	 * a loop back to the same region can skip the read
+	 */
+	uint32_t offset;
+	uint32_t length;
+	uint32_t skip;
+	uint32_t flags;
+
+	FACTStreamPacketState state;
+} FACTStreamPacket;
+
+/* Reads of neighboring packets are merged up to this size */
+#define FACT_STREAM_COALESCE_MAX (1024 * 1024)
+
+/* Packet and scratch buffers start on page boundaries, so that file I/O
+ * callbacks can read into them directly (see FACTURingOpenEXT)
+ */
+#define FACT_STREAM_ALIGN 4096
+#define FACT_STREAM_ALIGN_UP(x) \
+	(((x) + (FACT_STREAM_ALIGN - 1)) & ~((size_t) (FACT_STREAM_ALIGN - 1)))
+
+typedef struct FACTStreamRequest
+{
+	FACTWave *wave;
+	FACTStreamPacket *packet;
+
+	/* Sector-aligned region in the file */
+	void *io;
+	uint32_t offset;
+	uint32_t length;
+
+	/* When the voice will need this packet, in FAudio_timems() time */
+	uint32_t deadline;
+} FACTStreamRequest;
+
+typedef struct FACTStreamRead
+{
+	void *io;
+	uint32_t offset;
+	uint32_t length;
+	uint8_t *data;
+
+	/* The requests this read serves, sorted by offset */
+	uint32_t first;
+	uint32_t count;
+	uint32_t deadline;
+
+	FACTOverlapped ovlp;
+} FACTStreamRead;
+
 /* Public XACT Types */
 
+/* Idle source voices kept for reuse, one pool per voice configuration */
+
+#define FACT_VOICE_POOL_SIZE 16
+
+typedef struct FACTVoicePool
+{
+	/* Key */
+	uint16_t formatTag;
+	uint16_t channels;
+	uint32_t sampleRate;
+	uint16_t blockAlign;
+	uint16_t bitsPerSample;
+	bool reverb;
+
+	FAudioSourceVoice *voices[FACT_VOICE_POOL_SIZE];
+	uint8_t voiceCount;
+	struct FACTVoicePool *next;
+} FACTVoicePool;
+
+/* Wave data for cached WaveBanks, one per entry. Resident entries that no
+ * Wave is using sit in the engine's LRU list until they are evicted.
+ */
+
+#define FACT_WAVE_CACHE_DEFAULT_BUDGET (16 * 1024 * 1024)
+
+typedef struct FACTCacheEntry
+{
+	uint8_t *data; /* NULL when not resident */
+	uint32_t size;
+	uint32_t refs;
+	bool loading; /* The stream thread is reading it */
+	struct FACTCacheEntry *lruPrev;
+	struct FACTCacheEntry *lruNext;
+} FACTCacheEntry;
+
+/* Entries are read by the stream thread and made resident by the API thread,
+ * so that neither the read nor the caller's Prepare waits on the other.
+ */
+
+#define FACT_CACHELOAD_QUEUED	0
+#define FACT_CACHELOAD_READING	1
+#define FACT_CACHELOAD_DONE	2
+
+typedef struct FACTCacheLoad
+{
+	FACTWaveBank *bank; /* NULL once the WaveBank is destroyed */
+	uint16_t index;
+	uint8_t state;
+	uint8_t *data;
+	struct FACTCacheLoad *next;
+} FACTCacheLoad;
+
+/* MSADPCM entries decoded once at load time, see FACTTranscodePolicyEXT */
+
+typedef struct FACTTranscodedEntry
+{
+	uint8_t *data; /* NULL if the entry plays from the WaveBank data */
+	uint32_t size;
+	uint32_t samples;
+	bool isFloat;
+	bool queued; /* In a FACTTranscodeBatch, under the apiLock */
+} FACTTranscodedEntry;
+
+/* Entries picked under the apiLock and decoded without it, see
+ * FACT_INTERNAL_TranscodeRun
+ */
+
+typedef struct FACTTranscodeJob
+{
+	FACTWaveBank *wb; /* NULL if the WaveBank was destroyed meanwhile */
+	uint16_t index;
+	FACTTranscodedEntry decoded;
+	struct FACTTranscodeJob *next;
+} FACTTranscodeJob;
+
+typedef struct FACTTranscodeBatch
+{
+	FACTTranscodeJob *jobs;
+	FACTTranscodeJob *current; /* The one decoding, if any */
+	struct FACTTranscodeBatch *next;
+} FACTTranscodeBatch;
+
+/* Bank created by the load thread, see FACT_INTERNAL_LoadAdd */
+
+typedef struct FACTLoadRequest
+{
+	struct FACTLoadRequest *next;
+
+	/* Exactly one is set, the new bank is written there once it's in */
+	FACTSoundBank **ppSoundBank;
+	FACTWaveBank **ppWaveBank;
+
+	/* SoundBank */
+	const void *buffer;
+	uint32_t size;
+
+	/* WaveBank */
+	void *io;
+	uint32_t offset;
+	uint32_t packetSize;
+	bool isStreaming;
+	FACTTranscodePolicyEXT policy; /* Copied when the load is queued */
+} FACTLoadRequest;
+
+/* Name lookup tables, built once when the names are parsed and read-only
+ * afterward. Names come from either an array of strings or a block of
+ * fixed-size 64-byte entries (WaveBank names).
+ */
+
+typedef struct FACTNameIndex
+{
+	uint16_t *slots;
+	uint32_t mask;
+	char **names;
+	const char *nameBlock;
+} FACTNameIndex;
+
+/* Engine callback for the mixer clock, the engine owns this */
+
+typedef struct FACTEngineCallback
+{
+	FAudioEngineCallback callback;
+	FACTAudioEngine *engine;
+} FACTEngineCallback;
+
 struct FACTAudioEngine
 {
 	uint32_t refcount;
@@ -493,24 +717,81 @@ struct FACTAudioEngine
 	FACTRPC *rpcs;
 	FACTDSPPreset *dspPresets;
 
+	FACTNameIndex categoryLookup;
+	FACTNameIndex globalVariableLookup;
+	FACTNameIndex cueVariableLookup;
+
 	/* Engine references */
 	LinkedList *sbList;
 	LinkedList *wbList;
 	FAudioMutex sbLock;
 	FAudioMutex wbLock;
 	float *globalVariableValues;
+	uint32_t globalVariablesChanged; /* Atomic, set without apiLock */
+	uint32_t globalVariableVersion;
+	uint32_t dspVariableVersion;
 
 	/* FAudio references */
 	FAudio *audio;
 	FAudioMasteringVoice *master;
 	FAudioSubmixVoice *reverbVoice;
 	FAudioWaveFormatExtensible output_format;
+	FACTVoicePool *voicePools;
+
+	/* Wave cache, shared by every cached WaveBank */
+	uint32_t cacheBudget;
+	uint32_t cacheSize;
+	FACTCacheEntry *cacheOldest;
+	FACTCacheEntry *cacheNewest;
+	FACTCacheLoad *cacheLoads; /* Protected by streamLock */
+
+	/* Load-time transcoding */
+	FACTTranscodePolicyEXT transcodePolicy;
+	uint32_t transcodedSize;
+	FACTTranscodeBatch *transcodeBatches; /* Under apiLock and transcodeLock */
+	FAudioMutex transcodeLock; /* Guards the jobs of transcodeBatches */
+	FAudioMutex transcodeDecodeLock; /* Held while a job decodes */
 
 	/* Engine thread */
 	FAudioThread apiThread;
 	FAudioMutex apiLock;
+	FAudioSemaphore apiSignal;
+	FACTCue *activeCues;
+	FACTCue *updateNext;
 	bool initialized;
 
+	/* Mixer clock, see FACT_INTERNAL_OnProcessingPassStart */
+	FACTEngineCallback clockCallback;
+	uint64_t clockSamples; /* Audio thread only */
+	uint32_t clockBase; /* Audio thread only */
+	uint32_t clockTime; /* Atomic */
+	uint32_t clockWall; /* Atomic, FAudio_timems() at clockTime */
+	uint32_t clockDue; /* Atomic */
+	uint32_t clockArmed; /* Atomic */
+	uint32_t clockFired; /* Atomic */
+
+	/* Stream thread */
+	LinkedList *streamWaves;
+	FAudioMutex streamLock;
+	FAudioMutex streamIOLock; /* Held while reads are in flight */
+	FAudioThread streamThread;
+	FAudioSemaphore streamSignal;
+	FACTStreamRequest *streamRequests;
+	FACTStreamRead *streamReads;
+	uint32_t streamRequestCapacity;
+	uint8_t *streamScratch;
+	uint32_t streamScratchLen;
+	uint8_t streamRunning;
+
+	/* Load thread */
+	FACTLoadRequest *loadHead;
+	FACTLoadRequest *loadTail;
+	FAudioMutex loadLock;
+	FAudioThread loadThread;
+	FAudioSemaphore loadSignal;
+	uint32_t loadPending; /* Queued or parsing, under the apiLock */
+	uint8_t loadRunning;
+
 	/* Allocator callbacks */
 	FAudioMallocFunc pMalloc;
 	FAudioFreeFunc pFree;
@@ -523,6 +804,8 @@ struct FACTAudioEngine
 	 * These are queued and processed in DoWork(). */
 	FACTWaveBank **prepared_wavebanks;
 	size_t prepared_wavebank_count, prepared_wavebanks_capacity;
+	FACTSoundBank **prepared_soundbanks;
+	size_t prepared_soundbank_count, prepared_soundbanks_capacity;
 
 	/* Settings handle */
 	void *settings;
@@ -544,6 +827,7 @@ struct FACTSoundBank
 	/* Strings, strings everywhere! */
 	char **wavebankNames;
 	char **cueNames;
+	FACTNameIndex cueLookup;
 
 	/* Actual SoundBank information */
 	char *name;
@@ -569,14 +853,22 @@ struct FACTWaveBank
 	uint32_t *entryRefs;
 	FACTSeekTable *seekTables;
 	char *waveBankNames;
+	FACTNameIndex waveLookup;
 
 	/* I/O information */
 	uint32_t file_offset;
 	uint32_t packetSize;
 	bool streaming;
+	bool bigEndian;
 	uint8_t *packetBuffer;
 	uint32_t packetBufferLen;
 	void* io;
+
+	/* Cached WaveBanks only, NULL otherwise */
+	FACTCacheEntry *cache;
+
+	/* NULL until an entry is transcoded */
+	FACTTranscodedEntry *transcoded;
 };
 
 struct FACTWave
@@ -594,15 +886,29 @@ struct FACTWave
 	float volume;
 	int16_t pitch;
 	uint8_t loopCount;
+	bool cachePending; /* Nothing submitted until the entry is loaded */
 
 	/* Stream data */
 	uint32_t streamSize;
-	uint32_t streamOffset;
+	uint32_t streamOffset; /* Next region to be read, not played! */
 	uint8_t *streamCache;
+	FAudioMutex streamLock;
+	FACTStreamPacket streamPackets[FACT_STREAM_PACKETS];
+	uint8_t streamPacketCount;
+	uint8_t streamRead; /* Next packet to get a region */
+	uint8_t streamSubmit; /* Next packet to queue on the voice */
+	uint8_t streamPlay; /* Packet the voice is playing */
+	uint8_t streamQueued;
+	uint8_t streamReading; /* Packets the stream thread has in flight */
+	uint8_t streamStarved;
+	uint32_t streamStarveStart;
+	uint32_t streamPlayStart; /* When the voice got to streamPlay */
+	FACTWaveStreamStatsEXT streamStats;
 
 	/* FAudio references */
 	uint16_t srcChannels;
 	FAudioSourceVoice *voice;
+	FACTVoicePool *voicePool;
 	FACTWaveCallback callback;
 };
 
@@ -629,10 +935,14 @@ struct FACTCue
 
 	/* Instance data */
 	float *variableValues;
+	uint32_t variablesChanged; /* Atomic, set without apiLock */
+	uint32_t variableVersion;
 	float interactive;
 
 	/* Playback */
 	uint32_t state;
+	bool loadQueued; /* Waits on a WaveBank that's still loading */
+	bool loadPlay; /* Play was called while queued */
 	FACTWave *simpleWave;
 	FACTSoundInstance *playingSound;
 	uint32_t maxRpcReleaseTime;
@@ -646,6 +956,21 @@ struct FACTCue
 	/* Timer */
 	uint32_t start;
 	uint32_t elapsed;
+
+	/* Instance limiting, set while this Cue counts as an instance */
+	bool isInstance;
+	FACTAudioCategory *instanceCategory;
+	FACTCue *dataInstanceNext;
+	FACTCue *dataInstancePrev;
+	FACTCue *categoryInstanceNext;
+	FACTCue *categoryInstancePrev;
+
+	/* Engine run list, only holds Cues that need updates */
+	FACTCue *activeNext;
+	FACTCue *activePrev;
+	bool scheduled;
+	bool timed;
+	uint32_t due;
 };
 
 /* Internal functions */
@@ -655,14 +980,88 @@ void FACT_INTERNAL_GetNextWave(FACTCue *cue, const FACTSound *sound, const FACTT
 void create_sound(FACTCue *cue);
 bool play_sound(FACTCue *cue);
 void FACT_INTERNAL_DestroySound(FACTSoundInstance *sound);
+void FACT_INTERNAL_RemoveInstance(FACTCue *cue);
 void FACT_INTERNAL_BeginFadeOut(FACTSoundInstance *sound, uint16_t fadeOutMS);
 void FACT_INTERNAL_BeginReleaseRPC(FACTSoundInstance *sound, uint16_t releaseMS);
 
 void FACT_INTERNAL_SendCueNotification(FACTCue *cue, uint8_t type);
 
+uint32_t FACT_INTERNAL_PrepareWave(
+	FACTWaveBank *pWaveBank,
+	uint16_t nWaveIndex,
+	uint32_t dwFlags,
+	uint32_t dwPlayOffset,
+	uint8_t nLoopCount,
+	bool reverb,
+	FACTWave **ppWave
+);
+
+/* Voice pooling */
+
+void FACT_INTERNAL_CreateWaveVoice(
+	FACTWave *wave,
+	const FAudioWaveFormatEx *format,
+	bool reverb
+);
+void FACT_INTERNAL_DestroyWaveVoice(FACTWave *wave);
+void FACT_INTERNAL_DestroyVoicePools(FACTAudioEngine *engine);
+
+/* Wave cache */
+
+uint8_t* FACT_INTERNAL_CacheAcquire(FACTWaveBank *wb, uint16_t index);
+void FACT_INTERNAL_CacheRelease(FACTWaveBank *wb, uint16_t index);
+void FACT_INTERNAL_CachePrefetch(FACTWaveBank *wb, uint16_t index);
+bool FACT_INTERNAL_CacheRead(FACTAudioEngine *engine);
+void FACT_INTERNAL_CachePublish(FACTAudioEngine *engine);
+void FACT_INTERNAL_CacheTrim(FACTAudioEngine *engine, uint32_t budget);
+void FACT_INTERNAL_CacheFreeBank(FACTWaveBank *wb);
+void FACT_INTERNAL_SubmitWave(FACTWave *wave);
+
+/* Transcoding */
+
+bool FACT_INTERNAL_IsInCategory(
+	FACTAudioEngine *engine,
+	uint16_t target,
+	uint16_t category
+);
+void FACT_INTERNAL_TranscodeDecode(
+	FACTWaveBank *wb,
+	uint16_t index,
+	bool isFloat,
+	FACTTranscodedEntry *out
+);
+void FACT_INTERNAL_TranscodePublish(
+	FACTWaveBank *wb,
+	uint16_t index,
+	FACTTranscodedEntry *decoded
+);
+void FACT_INTERNAL_TranscodeWaveBank(FACTWaveBank *wb);
+void FACT_INTERNAL_TranscodeSoundBank(FACTSoundBank *sb);
+void FACT_INTERNAL_FreeTranscoded(FACTWaveBank *wb);
+
 /* FACT Thread */
 
 int32_t FAUDIOCALL FACT_INTERNAL_APIThread(void* enginePtr);
+uint32_t FACT_INTERNAL_GetTime(FACTAudioEngine *engine);
+void FAUDIOCALL FACT_INTERNAL_OnProcessingPassStart(FAudioEngineCallback *callback);
+void FACT_INTERNAL_ScheduleCue(FACTCue *cue);
+void FACT_INTERNAL_UnscheduleCue(FACTCue *cue);
+
+/* Stream thread */
+
+void FACT_INTERNAL_StreamStart(FACTAudioEngine *engine);
+void FACT_INTERNAL_StreamAddWave(FACTWave *wave);
+void FACT_INTERNAL_StreamRemoveWave(FACTWave *wave);
+void FACT_INTERNAL_StreamQuit(FACTAudioEngine *engine);
+
+/* Load thread */
+
+void FACT_INTERNAL_LoadAdd(
+	FACTAudioEngine *engine,
+	FACTLoadRequest *request
+);
+void FACT_INTERNAL_LoadQuit(FACTAudioEngine *engine);
+bool FACT_INTERNAL_CueWaitsForLoad(FACTCue *cue);
 
 /* FAudio callbacks */
 
@@ -686,6 +1085,23 @@ int32_t FACTCALL FACT_INTERNAL_DefaultGetOverlappedResult(
 	int32_t bWait
 );
 
+/* Name lookup */
+
+uint32_t FACT_INTERNAL_NameIndexSize(uint32_t count);
+void FACT_INTERNAL_InitNameIndex(
+	FACTNameIndex *index,
+	uint16_t *slots,
+	uint32_t size,
+	char **names,
+	const char *nameBlock
+);
+void FACT_INTERNAL_AddName(FACTNameIndex *index, uint16_t i);
+uint16_t FACT_INTERNAL_FindName(
+	const FACTNameIndex *index,
+	const char *name
+);
+void FACT_INTERNAL_BuildEngineLookups(FACTAudioEngine *engine);
+
 /* Parsing functions */
 
 uint32_t FACT_INTERNAL_ParseAudioEngine(
@@ -706,7 +1122,19 @@ uint32_t FACT_INTERNAL_ParseWaveBank(
 	FACTReadFileCallback pRead,
 	FACTGetOverlappedResultCallback pOverlap,
 	bool isStreaming,
+	bool isCached,
+	const FACTTranscodePolicyEXT *pPolicy,
 	FACTWaveBank **ppWaveBank
 );
+void FACT_INTERNAL_AddSoundBank(FACTSoundBank *sb);
+void FACT_INTERNAL_AddWaveBank(FACTWaveBank *wb);
+void FACT_INTERNAL_QueueSoundBankPrepared(
+	FACTAudioEngine *engine,
+	FACTSoundBank *sb
+);
+void FACT_INTERNAL_QueueWaveBankPrepared(
+	FACTAudioEngine *engine,
+	FACTWaveBank *wb
+);
 
 /* vim: set noexpandtab shiftwidth=8 tabstop=8: */
@@ -0,0 +1,647 @@
+/* FAudio - XAudio Reimplementation for FNA
+ *
+ * Copyright (c) 2011-2024 Ethan Lee, Luigi Auriemma, and the MonoGame Team
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Ethan "flibitijibibo" Lee <flibitijibibo@flibitijibibo.com>
+ *
+ */
+
+/* FACT file I/O callbacks over Linux io_uring
+ *
+ * Streaming wavebanks are read through FACTFileIOCallbacks, which mirror Win32
+ * ReadFile/GetOverlappedResult on an OVERLAPPED handle. Here each file gets one
+ * ring: ReadFile queues the read and returns right away, and one thread per
+ * file reaps the completions and fills in the FACTOverlapped just like the
+ * Win32 kernel would. That's one thread per wavebank instead of one per stream.
+ *
+ * The data is read with O_DIRECT when the filesystem allows it, so that music
+ * and ambience streamed once don't push everything else out of the page cache.
+ * FACT keeps its packet buffers page-aligned for this (FACT_STREAM_ALIGN).
+ */
+
+#if defined(HAVE_IO_URING) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* O_DIRECT */
+#endif /* HAVE_IO_URING */
+
+#include "FACT_internal.h"
+
+#ifdef HAVE_IO_URING
+
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* Same values Win32 puts in OVERLAPPED.Internal */
+#define URING_STATUS_SUCCESS	((void*) 0x00000000)
+#define URING_STATUS_PENDING	((void*) 0x00000103)
+#define URING_STATUS_ERROR	((void*) 0xC0000185) /* STATUS_IO_DEVICE_ERROR */
+
+/* O_DIRECT wants the buffer, offset and length on block boundaries. statx
+ * tells us which (Linux 6.1 and up). Otherwise we assume 512, the smallest
+ * block size there is; if the device wants more, the kernel fails the read
+ * with EINVAL and we redo it through the page cache.
+ */
+#define URING_DIRECT_ALIGN 512
+
+/* Reads in flight per file. Past this, reads are done synchronously. */
+#define URING_ENTRIES 256
+
+typedef struct FACTURingSlot
+{
+	FACTOverlapped *ovlp;
+	void *buffer;
+	uint32_t length;
+	uint64_t offset;
+	int fd;
+} FACTURingSlot;
+
+typedef struct FACTURingFile
+{
+	int bufferedFd;
+	int directFd; /* -1 if the filesystem doesn't do O_DIRECT */
+	int ringFd; /* -1 if io_uring isn't available */
+
+	/* Alignment masks for O_DIRECT reads */
+	uint32_t directMemMask;
+	uint32_t directOffsetMask;
+
+	/* Submission queue */
+	uint8_t *sqRing;
+	size_t sqRingSize;
+	uint32_t *sqHead;
+	uint32_t *sqTail;
+	uint32_t *sqMask;
+	uint32_t *sqArray;
+	struct io_uring_sqe *sqes;
+	size_t sqesSize;
+
+	/* Completion queue, may share the SQ mapping */
+	uint8_t *cqRing;
+	size_t cqRingSize;
+	uint32_t *cqHead;
+	uint32_t *cqTail;
+	uint32_t *cqMask;
+	struct io_uring_cqe *cqes;
+
+	/* Reads in flight, user_data is the slot index + 1 */
+	FACTURingSlot slots[URING_ENTRIES];
+	uint32_t freeSlots[URING_ENTRIES];
+	uint32_t freeCount;
+
+	/* Bumped after every batch of completions, GetOverlappedResult
+	 * sleeps on it with a futex
+	 */
+	uint32_t completions;
+
+	FAudioMutex lock;
+	FAudioThread thread;
+	volatile uint8_t running;
+} FACTURingFile;
+
+static inline int FACT_URING_Setup(uint32_t entries, struct io_uring_params *p)
+{
+	return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int FACT_URING_Enter(
+	int fd,
+	uint32_t toSubmit,
+	uint32_t minComplete,
+	uint32_t flags
+) {
+	return (int) syscall(
+		__NR_io_uring_enter,
+		fd,
+		toSubmit,
+		minComplete,
+		flags,
+		NULL,
+		0
+	);
+}
+
+static void FACT_URING_Complete(FACTOverlapped *ovlp, int64_t result)
+{
+	ovlp->InternalHigh = (void*) (size_t) ((result < 0) ? 0 : result);
+	__atomic_store_n(
+		&ovlp->Internal,
+		(result < 0) ? URING_STATUS_ERROR : URING_STATUS_SUCCESS,
+		__ATOMIC_RELEASE
+	);
+}
+
+static int64_t FACT_URING_ReadSync(
+	int fd,
+	void *buffer,
+	uint32_t length,
+	uint64_t offset
+) {
+	ssize_t result;
+	do
+	{
+		result = pread(fd, buffer, length, (off_t) offset);
+	} while (result < 0 && errno == EINTR);
+	return result;
+}
+
+/* Queues one SQE and hands it to the kernel. Returns 0 or a negative errno, in
+ * which case the SQE has been taken back out of the ring.
+ * Call with the file lock held!
+ */
+static int FACT_URING_Submit(
+	FACTURingFile *file,
+	uint8_t opcode,
+	int fd,
+	void *buffer,
+	uint32_t length,
+	uint64_t offset,
+	uint64_t userData
+) {
+	struct io_uring_sqe *sqe;
+	uint32_t tail, index;
+	int result;
+
+	tail = *file->sqTail;
+	index = tail & *file->sqMask;
+	sqe = &file->sqes[index];
+	FAudio_zero(sqe, sizeof(struct io_uring_sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->addr = (uint64_t) (size_t) buffer;
+	sqe->len = length;
+	sqe->user_data = userData;
+	file->sqArray[index] = index;
+	__atomic_store_n(file->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+	do
+	{
+		result = FACT_URING_Enter(file->ringFd, 1, 0, 0);
+	} while (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+
+	if (result < 1)
+	{
+		/* The kernel didn't take it. It's still in the ring, so pull it
+		 * back out, or the next submit would send it along anyway.
+		 */
+		result = (result < 0) ? -errno : -EIO;
+		if (__atomic_load_n(file->sqHead, __ATOMIC_ACQUIRE) == tail)
+		{
+			__atomic_store_n(file->sqTail, tail, __ATOMIC_RELEASE);
+		}
+		return result;
+	}
+	return 0;
+}
+
+static int32_t FAUDIOCALL FACT_URING_Thread(void *data)
+{
+	FACTURingFile *file = (FACTURingFile*) data;
+	struct io_uring_cqe *cqe;
+	FACTURingSlot *slot;
+	uint32_t head, tail, index;
+	int32_t res;
+
+	FAudio_PlatformThreadPriority(FAUDIO_THREAD_PRIORITY_HIGH);
+
+	while (file->running)
+	{
+		FACT_URING_Enter(file->ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+
+		head = *file->cqHead;
+		tail = __atomic_load_n(file->cqTail, __ATOMIC_ACQUIRE);
+		while (head != tail)
+		{
+			cqe = &file->cqes[head & *file->cqMask];
+			index = (uint32_t) cqe->user_data;
+			res = cqe->res;
+			head += 1;
+			__atomic_store_n(file->cqHead, head, __ATOMIC_RELEASE);
+
+			if (index == 0)
+			{
+				/* Wakeup from FACTURingCloseEXT */
+				continue;
+			}
+			slot = &file->slots[index - 1];
+
+			if (res == -EINVAL && slot->fd == file->directFd)
+			{
+				/* The device wants bigger blocks than we lined
+				 * up with, go through the page cache instead
+				 */
+				res = (int32_t) FACT_URING_ReadSync(
+					file->bufferedFd,
+					slot->buffer,
+					slot->length,
+					slot->offset
+				);
+			}
+			FACT_URING_Complete(slot->ovlp, res);
+
+			FAudio_PlatformLockMutex(file->lock);
+			file->freeSlots[file->freeCount++] = index - 1;
+			FAudio_PlatformUnlockMutex(file->lock);
+		}
+
+		/* Wake up anyone waiting in GetOverlappedResult */
+		__atomic_add_fetch(&file->completions, 1, __ATOMIC_RELEASE);
+		syscall(
+			__NR_futex,
+			&file->completions,
+			FUTEX_WAKE_PRIVATE,
+			INT_MAX,
+			NULL,
+			NULL,
+			0
+		);
+	}
+	return 0;
+}
+
+static void FACT_URING_DirectAlign(FACTURingFile *file)
+{
+#ifdef STATX_DIOALIGN
+	struct statx stx;
+
+	if (	statx(file->directFd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+		(stx.stx_mask & STATX_DIOALIGN)	)
+	{
+		if (stx.stx_dio_mem_align == 0 || stx.stx_dio_offset_align == 0)
+		{
+			/* Opened fine, but O_DIRECT isn't supported after all */
+			close(file->directFd);
+			file->directFd = -1;
+			return;
+		}
+		file->directMemMask = stx.stx_dio_mem_align - 1;
+		file->directOffsetMask = stx.stx_dio_offset_align - 1;
+		return;
+	}
+#endif /* STATX_DIOALIGN */
+	file->directMemMask = URING_DIRECT_ALIGN - 1;
+	file->directOffsetMask = URING_DIRECT_ALIGN - 1;
+}
+
+static uint8_t FACT_URING_Init(FACTURingFile *file)
+{
+	struct io_uring_params p;
+	uint8_t *sqRing;
+
+	FAudio_zero(&p, sizeof(p));
+	file->ringFd = FACT_URING_Setup(URING_ENTRIES, &p);
+	if (file->ringFd < 0)
+	{
+		return 0;
+	}
+
+	/* IORING_OP_READ came with 5.6, as did this flag */
+	if (!(p.features & IORING_FEAT_RW_CUR_POS))
+	{
+		close(file->ringFd);
+		file->ringFd = -1;
+		return 0;
+	}
+
+	file->sqRingSize = p.sq_off.array + (p.sq_entries * sizeof(uint32_t));
+	file->cqRingSize = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		file->sqRingSize = FAudio_max(file->sqRingSize, file->cqRingSize);
+		file->cqRingSize = 0;
+	}
+
+	sqRing = (uint8_t*) mmap(
+		NULL,
+		file->sqRingSize,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE,
+		file->ringFd,
+		IORING_OFF_SQ_RING
+	);
+	if (sqRing == MAP_FAILED)
+	{
+		goto fail;
+	}
+	file->sqRing = sqRing;
+
+	if (file->cqRingSize > 0)
+	{
+		file->cqRing = (uint8_t*) mmap(
+			NULL,
+			file->cqRingSize,
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE,
+			file->ringFd,
+			IORING_OFF_CQ_RING
+		);
+		if (file->cqRing == MAP_FAILED)
+		{
+			file->cqRing = NULL;
+			goto fail;
+		}
+	}
+	else
+	{
+		file->cqRing = file->sqRing;
+	}
+
+	file->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+	file->sqes = (struct io_uring_sqe*) mmap(
+		NULL,
+		file->sqesSize,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE,
+		file->ringFd,
+		IORING_OFF_SQES
+	);
+	if (file->sqes == MAP_FAILED)
+	{
+		file->sqes = NULL;
+		goto fail;
+	}
+
+	file->sqHead = (uint32_t*) (sqRing + p.sq_off.head);
+	file->sqTail = (uint32_t*) (sqRing + p.sq_off.tail);
+	file->sqMask = (uint32_t*) (sqRing + p.sq_off.ring_mask);
+	file->sqArray = (uint32_t*) (sqRing + p.sq_off.array);
+	file->cqHead = (uint32_t*) (file->cqRing + p.cq_off.head);
+	file->cqTail = (uint32_t*) (file->cqRing + p.cq_off.tail);
+	file->cqMask = (uint32_t*) (file->cqRing + p.cq_off.ring_mask);
+	file->cqes = (struct io_uring_cqe*) (file->cqRing + p.cq_off.cqes);
+	return 1;
+
+fail:
+	if (file->sqes != NULL)
+	{
+		munmap(file->sqes, file->sqesSize);
+		file->sqes = NULL;
+	}
+	if (file->cqRing != NULL && file->cqRing != file->sqRing)
+	{
+		munmap(file->cqRing, file->cqRingSize);
+	}
+	file->cqRing = NULL;
+	if (file->sqRing != NULL)
+	{
+		munmap(file->sqRing, file->sqRingSize);
+		file->sqRing = NULL;
+	}
+	close(file->ringFd);
+	file->ringFd = -1;
+	return 0;
+}
+
+static int32_t FACTCALL FACT_URING_ReadFile(
+	void *hFile,
+	void *buffer,
+	uint32_t nNumberOfBytesToRead,
+	uint32_t *lpNumberOfBytesRead, /* Not referenced! */
+	FACTOverlapped *lpOverlapped
+) {
+	FACTURingFile *file = (FACTURingFile*) hFile;
+	FACTURingSlot *slot;
+	uint64_t offset;
+	uint32_t index;
+	int fd, result;
+
+	offset = (
+		(uint64_t) lpOverlapped->Offset |
+		((uint64_t) lpOverlapped->OffsetHigh << 32)
+	);
+	lpOverlapped->Internal = URING_STATUS_PENDING;
+
+	/* Unaligned reads (mostly the bank headers) can't go direct */
+	if (	file->directFd >= 0 &&
+		!((size_t) buffer & file->directMemMask) &&
+		!((offset | nNumberOfBytesToRead) & file->directOffsetMask)	)
+	{
+		fd = file->directFd;
+	}
+	else
+	{
+		fd = file->bufferedFd;
+	}
+
+	if (file->ringFd >= 0)
+	{
+		FAudio_PlatformLockMutex(file->lock);
+		if (file->freeCount > 0)
+		{
+			index = file->freeSlots[--file->freeCount];
+			slot = &file->slots[index];
+			slot->ovlp = lpOverlapped;
+			slot->buffer = buffer;
+			slot->length = nNumberOfBytesToRead;
+			slot->offset = offset;
+			slot->fd = fd;
+			result = FACT_URING_Submit(
+				file,
+				IORING_OP_READ,
+				fd,
+				buffer,
+				nNumberOfBytesToRead,
+				offset,
+				index + 1
+			);
+			if (result < 0)
+			{
+				/* Fail the read, same as a ReadFile error */
+				file->freeSlots[file->freeCount++] = index;
+				FAudio_PlatformUnlockMutex(file->lock);
+				FACT_URING_Complete(lpOverlapped, result);
+				return 0;
+			}
+			FAudio_PlatformUnlockMutex(file->lock);
+			return 0; /* ERROR_IO_PENDING */
+		}
+		FAudio_PlatformUnlockMutex(file->lock);
+	}
+
+	/* Ring is full or unavailable, just read it here */
+	FACT_URING_Complete(
+		lpOverlapped,
+		FACT_URING_ReadSync(
+			file->bufferedFd,
+			buffer,
+			nNumberOfBytesToRead,
+			offset
+		)
+	);
+	return 1;
+}
+
+static int32_t FACTCALL FACT_URING_GetOverlappedResult(
+	void *hFile,
+	FACTOverlapped *lpOverlapped,
+	uint32_t *lpNumberOfBytesTransferred,
+	int32_t bWait
+) {
+	FACTURingFile *file = (FACTURingFile*) hFile;
+	uint32_t completions;
+	void *status;
+
+	status = __atomic_load_n(&lpOverlapped->Internal, __ATOMIC_ACQUIRE);
+	while (bWait && status == URING_STATUS_PENDING)
+	{
+		/* Sleep until the next batch of completions. The counter is
+		 * read first, so a wakeup between the two loads isn't lost.
+		 */
+		completions = __atomic_load_n(&file->completions, __ATOMIC_ACQUIRE);
+		status = __atomic_load_n(
+			&lpOverlapped->Internal,
+			__ATOMIC_ACQUIRE
+		);
+		if (status != URING_STATUS_PENDING)
+		{
+			break;
+		}
+		syscall(
+			__NR_futex,
+			&file->completions,
+			FUTEX_WAIT_PRIVATE,
+			completions,
+			NULL,
+			NULL,
+			0
+		);
+		status = __atomic_load_n(
+			&lpOverlapped->Internal,
+			__ATOMIC_ACQUIRE
+		);
+	}
+	if (status == URING_STATUS_PENDING)
+	{
+		*lpNumberOfBytesTransferred = 0;
+		return 0;
+	}
+	*lpNumberOfBytesTransferred = (uint32_t) (size_t) lpOverlapped->InternalHigh;
+	return status == URING_STATUS_SUCCESS;
+}
+
+FACTAPI uint32_t FACTURingGetFileIOCallbacksEXT(FACTFileIOCallbacks *pCallbacks)
+{
+	pCallbacks->readFileCallback = FACT_URING_ReadFile;
+	pCallbacks->getOverlappedResultCallback = FACT_URING_GetOverlappedResult;
+	return 0;
+}
+
+FACTAPI void* FACTURingOpenEXT(const char *path)
+{
+	FACTURingFile *file;
+	uint32_t i;
+
+	file = (FACTURingFile*) FAudio_malloc(sizeof(FACTURingFile));
+	FAudio_zero(file, sizeof(FACTURingFile));
+
+	file->bufferedFd = open(path, O_RDONLY | O_CLOEXEC);
+	if (file->bufferedFd < 0)
+	{
+		FAudio_free(file);
+		return NULL;
+	}
+
+	/* tmpfs and friends refuse O_DIRECT, the ring still helps there */
+	file->directFd = open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+	if (file->directFd >= 0)
+	{
+		FACT_URING_DirectAlign(file);
+	}
+
+	if (FACT_URING_Init(file))
+	{
+		for (i = 0; i < URING_ENTRIES; i += 1)
+		{
+			file->freeSlots[i] = URING_ENTRIES - 1 - i;
+		}
+		file->freeCount = URING_ENTRIES;
+		file->lock = FAudio_PlatformCreateMutex();
+		file->running = 1;
+		file->thread = FAudio_PlatformCreateThread(
+			FACT_URING_Thread,
+			"FACT URing Thread",
+			file
+		);
+	}
+	return file;
+}
+
+FACTAPI void FACTURingCloseEXT(void *pFile)
+{
+	FACTURingFile *file = (FACTURingFile*) pFile;
+
+	if (file == NULL)
+	{
+		return;
+	}
+
+	if (file->ringFd >= 0)
+	{
+		FAudio_PlatformLockMutex(file->lock);
+		file->running = 0;
+		FACT_URING_Submit(file, IORING_OP_NOP, -1, NULL, 0, 0, 0);
+		FAudio_PlatformUnlockMutex(file->lock);
+		FAudio_PlatformWaitThread(file->thread, NULL);
+		FAudio_PlatformDestroyMutex(file->lock);
+
+		munmap(file->sqes, file->sqesSize);
+		if (file->cqRing != file->sqRing)
+		{
+			munmap(file->cqRing, file->cqRingSize);
+		}
+		munmap(file->sqRing, file->sqRingSize);
+		close(file->ringFd);
+	}
+	if (file->directFd >= 0)
+	{
+		close(file->directFd);
+	}
+	close(file->bufferedFd);
+	FAudio_free(file);
+}
+
+#else /* HAVE_IO_URING */
+
+FACTAPI uint32_t FACTURingGetFileIOCallbacksEXT(FACTFileIOCallbacks *pCallbacks)
+{
+	pCallbacks->readFileCallback = NULL;
+	pCallbacks->getOverlappedResultCallback = NULL;
+	return 1;
+}
+
+FACTAPI void* FACTURingOpenEXT(const char *path)
+{
+	return NULL;
+}
+
+FACTAPI void FACTURingCloseEXT(void *pFile)
+{
+}
+
+#endif /* HAVE_IO_URING */
+
+/* vim: set noexpandtab shiftwidth=8 tabstop=8: */
@@ -138,6 +138,8 @@ uint32_t FAudioCOMConstructWithCustomAllocatorEXT(
 	LOG_MUTEX_CREATE((*ppFAudio), (*ppFAudio)->callbackLock)
 	(*ppFAudio)->operationLock = FAudio_PlatformCreateMutex();
 	LOG_MUTEX_CREATE((*ppFAudio), (*ppFAudio)->operationLock)
+	(*ppFAudio)->decodeAheadLock = FAudio_PlatformCreateMutex();
+	LOG_MUTEX_CREATE((*ppFAudio), (*ppFAudio)->decodeAheadLock)
 	(*ppFAudio)->pMalloc = customMalloc;
 	(*ppFAudio)->pFree = customFree;
 	(*ppFAudio)->pRealloc = customRealloc;
@@ -196,6 +198,7 @@ uint32_t FAudio_Release(FAudio *audio)
 			destroy_voice(audio->master);
 		FAudio_OPERATIONSET_ClearAll(audio);
 		FAudio_StopEngine(audio);
+		FAudio_INTERNAL_DecodeAheadQuit(audio);
 		audio->pFree(audio->decodeCache);
 		audio->pFree(audio->resampleCache);
 		audio->pFree(audio->effectChainCache);
@@ -209,6 +212,8 @@ uint32_t FAudio_Release(FAudio *audio)
 		FAudio_PlatformDestroyMutex(audio->callbackLock);
 		LOG_MUTEX_DESTROY(audio, audio->operationLock)
 		FAudio_PlatformDestroyMutex(audio->operationLock);
+		LOG_MUTEX_DESTROY(audio, audio->decodeAheadLock)
+		FAudio_PlatformDestroyMutex(audio->decodeAheadLock);
 		audio->pFree(audio);
 		FAudio_PlatformRelease();
 	}
@@ -352,6 +357,28 @@ static uint32_t fixup_wma_bitrate(FAudio *audio, const FAudioWaveFormatEx *forma
 	return format->nAvgBytesPerSec;
 }
 
+/* Undoes a partially created source voice when its decoder fails to start.
+ * At that point the voice only owns its mutexes and its format copy.
+ */
+static void FAudio_INTERNAL_AbortSourceVoice(FAudioSourceVoice **ppSourceVoice)
+{
+	FAudioSourceVoice *voice = *ppSourceVoice;
+
+	LOG_MUTEX_DESTROY(voice->audio, voice->src.bufferLock)
+	FAudio_PlatformDestroyMutex(voice->src.bufferLock);
+	LOG_MUTEX_DESTROY(voice->audio, voice->sendLock)
+	FAudio_PlatformDestroyMutex(voice->sendLock);
+	LOG_MUTEX_DESTROY(voice->audio, voice->effectLock)
+	FAudio_PlatformDestroyMutex(voice->effectLock);
+	LOG_MUTEX_DESTROY(voice->audio, voice->filterLock)
+	FAudio_PlatformDestroyMutex(voice->filterLock);
+	LOG_MUTEX_DESTROY(voice->audio, voice->volumeLock)
+	FAudio_PlatformDestroyMutex(voice->volumeLock);
+	voice->audio->pFree(voice->src.format);
+	voice->audio->pFree(voice);
+	*ppSourceVoice = NULL;
+}
+
 uint32_t FAudio_CreateSourceVoice(
 	FAudio *audio,
 	FAudioSourceVoice **ppSourceVoice,
@@ -573,7 +600,8 @@ uint32_t FAudio_CreateSourceVoice(
 
 			if ((hr = FAudio_WMADEC_init(*ppSourceVoice, fmtex->SubFormat.Data1)))
 			{
-				audio->pFree(*ppSourceVoice);
+				FAudio_INTERNAL_AbortSourceVoice(ppSourceVoice);
+				LOG_API_EXIT(audio)
 				return hr;
 			}
 #else
@@ -593,7 +621,8 @@ uint32_t FAudio_CreateSourceVoice(
 
 		if ((hr = FAudio_WMADEC_init(*ppSourceVoice, FAUDIO_FORMAT_XMAUDIO2)))
 		{
-			audio->pFree(*ppSourceVoice);
+			FAudio_INTERNAL_AbortSourceVoice(ppSourceVoice);
+			LOG_API_EXIT(audio)
 			return hr;
 		}
 #else
@@ -606,6 +635,22 @@ uint32_t FAudio_CreateSourceVoice(
 			FAudio_INTERNAL_DecodeStereoMSADPCM :
 			FAudio_INTERNAL_DecodeMonoMSADPCM;
 	}
+	else if ((*ppSourceVoice)->src.format->wFormatTag == FAUDIO_FORMAT_VORBIS_EXT)
+	{
+		FAudio_VORBIS_init(*ppSourceVoice);
+		(*ppSourceVoice)->src.samples_per_block = 1;
+	}
+	else if ((*ppSourceVoice)->src.format->wFormatTag == FAUDIO_FORMAT_QOA_EXT)
+	{
+		uint32_t hr;
+
+		if ((hr = FAudio_QOA_init(*ppSourceVoice)))
+		{
+			FAudio_INTERNAL_AbortSourceVoice(ppSourceVoice);
+			LOG_API_EXIT(audio)
+			return hr;
+		}
+	}
 	else
 	{
 		FAudio_assert(0 && "Unsupported format tag!");
@@ -666,6 +711,12 @@ uint32_t FAudio_CreateSourceVoice(
 		((*ppSourceVoice)->src.decodeSamples + EXTRA_DECODE_PADDING) * (*ppSourceVoice)->src.format->nChannels
 	);
 
+	/* Decode-ahead */
+	if (Flags & FAUDIO_VOICE_DECODEAHEAD_EXT)
+	{
+		FAudio_INTERNAL_DecodeAheadAddVoice(*ppSourceVoice);
+	}
+
 	LOG_INFO(audio, "-> %p", (void*) (*ppSourceVoice))
 
 	/* Add to list, finally. */
@@ -2497,6 +2548,8 @@ static void destroy_voice(FAudioVoice *voice)
 		FAudio_PlatformUnlockMutex(voice->audio->sourceLock);
 		LOG_MUTEX_UNLOCK(voice->audio, voice->audio->sourceLock)
 
+		FAudio_INTERNAL_DecodeAheadRemoveVoice(voice);
+
 		voice->audio->pFree(voice->src.queued_buffers);
 		voice->audio->pFree(voice->src.flush_buffers);
 		voice->audio->pFree(voice->src.format);
@@ -2508,6 +2561,14 @@ static void destroy_voice(FAudioVoice *voice)
 			FAudio_WMADEC_free(voice);
 		}
 #endif /* HAVE_WMADEC */
+		if (voice->src.vorbis)
+		{
+			FAudio_VORBIS_free(voice);
+		}
+		if (voice->src.qoa)
+		{
+			FAudio_QOA_free(voice);
+		}
 		voice->audio->pFree(voice->src.unaligned_data);
 	}
 	else if (voice->type == FAUDIO_VOICE_SUBMIX)
@@ -2656,6 +2717,116 @@ void FAudioVoice_DestroyVoice(FAudioVoice *voice)
 	FAudioVoice_DestroyVoiceSafeEXT(voice);
 }
 
+void FAudio_INTERNAL_ResetSourceVoice(
+	FAudioSourceVoice *voice,
+	FAudioVoiceCallback *callback
+) {
+	uint32_t i, oChan;
+
+	FAudio_assert(voice->type == FAUDIO_VOICE_SOURCE);
+	FAudio_OPERATIONSET_ClearAllForVoice(voice);
+
+	/* Same dance as destroy_voice, the mixer must be done with us before
+	 * the buffers (and the callback that owns them) go away
+	 */
+	FAudio_PlatformLockMutex(voice->audio->sourceLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->audio->sourceLock)
+	while (voice == voice->audio->processingSource)
+	{
+		FAudio_PlatformUnlockMutex(voice->audio->sourceLock);
+		LOG_MUTEX_UNLOCK(voice->audio, voice->audio->sourceLock)
+		FAudio_PlatformLockMutex(voice->audio->sourceLock);
+		LOG_MUTEX_LOCK(voice->audio, voice->audio->sourceLock)
+	}
+
+	/* Drop everything without callbacks, the old owner is gone */
+	FAudio_PlatformLockMutex(voice->src.bufferLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
+	for (i = 0; i < voice->src.queued_buffer_count; i += 1)
+	{
+		FAudio_INTERNAL_DecodeAheadInvalidate(
+			voice,
+			&voice->src.queued_buffers[i]
+		);
+
+		/* Copies of unaligned data are ours, see end_buffer */
+		if (voice->src.queued_buffers[i].internal)
+		{
+			voice->audio->pFree(
+				(void*) voice->src.queued_buffers[i].buffer.pAudioData
+			);
+		}
+	}
+	if (voice->src.qoa != NULL)
+	{
+		FAudio_QOA_end_buffer(voice);
+	}
+	voice->src.queued_buffer_count = 0;
+	voice->src.flush_buffer_count = 0;
+	voice->src.active = 0;
+	voice->src.curBufferOffset = 0;
+	voice->src.curBufferOffsetDec = 0;
+	voice->src.resampleOffset = 0;
+	voice->src.totalSamples = 0;
+	voice->src.unaligned_size = 0;
+	voice->src.freqRatio = 1.0f;
+	voice->src.callback = callback;
+	FAudio_PlatformUnlockMutex(voice->src.bufferLock);
+	LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
+
+	FAudio_PlatformUnlockMutex(voice->audio->sourceLock);
+	LOG_MUTEX_UNLOCK(voice->audio, voice->audio->sourceLock)
+
+	/* Default levels and output matrix for the current sends */
+	FAudio_PlatformLockMutex(voice->sendLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->sendLock)
+	FAudio_PlatformLockMutex(voice->volumeLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->volumeLock)
+	voice->volume = 1.0f;
+	for (i = 0; i < voice->outputChannels; i += 1)
+	{
+		voice->channelVolume[i] = 1.0f;
+	}
+	for (i = 0; i < voice->sends.SendCount; i += 1)
+	{
+		if (voice->sends.pSends[i].pOutputVoice->type == FAUDIO_VOICE_MASTER)
+		{
+			oChan = voice->sends.pSends[i].pOutputVoice->master.inputChannels;
+		}
+		else
+		{
+			oChan = voice->sends.pSends[i].pOutputVoice->mix.inputChannels;
+		}
+		FAudio_memcpy(
+			voice->sendCoefficients[i],
+			FAUDIO_INTERNAL_MATRIX_DEFAULTS[voice->outputChannels - 1][oChan - 1],
+			voice->outputChannels * oChan * sizeof(float)
+		);
+		FAudio_RecalcMixMatrix(voice, i);
+	}
+	FAudio_PlatformUnlockMutex(voice->volumeLock);
+	LOG_MUTEX_UNLOCK(voice->audio, voice->volumeLock)
+	FAudio_PlatformUnlockMutex(voice->sendLock);
+	LOG_MUTEX_UNLOCK(voice->audio, voice->sendLock)
+
+	/* Default filter, with no history from the last sound */
+	FAudio_PlatformLockMutex(voice->filterLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->filterLock)
+	voice->filter.Type = FAUDIO_DEFAULT_FILTER_TYPE;
+	voice->filter.Frequency = FAUDIO_DEFAULT_FILTER_FREQUENCY;
+	voice->filter.OneOverQ = FAUDIO_DEFAULT_FILTER_ONEOVERQ;
+	voice->filter.WetDryMix = FAUDIO_DEFAULT_FILTER_WETDRYMIX_EXT;
+	if (voice->filterState != NULL)
+	{
+		FAudio_zero(
+			voice->filterState,
+			sizeof(FAudioFilterState) * voice->src.format->nChannels
+		);
+	}
+	FAudio_PlatformUnlockMutex(voice->filterLock);
+	LOG_MUTEX_UNLOCK(voice->audio, voice->filterLock)
+}
+
 /* FAudioSourceVoice Interface */
 
 uint32_t FAudioSourceVoice_Start(
@@ -2717,6 +2888,61 @@ uint32_t FAudioSourceVoice_Stop(
 	return 0;
 }
 
+/* Checks the play and loop regions against the length of the buffer */
+static uint8_t FAudio_INTERNAL_CheckBufferRegions(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *pBuffer,
+	const FAudioBufferWMA *pBufferWMA,
+	uint32_t bufferLength
+) {
+	const uint32_t playBegin = pBuffer->PlayBegin;
+	const uint32_t playLength = pBuffer->PlayLength;
+	const uint32_t loopBegin = pBuffer->LoopBegin;
+	const uint32_t loopLength = pBuffer->LoopLength;
+
+	if (playBegin + playLength > bufferLength || playBegin + playLength < playLength)
+	{
+		/* Reading past the end of the buffer, or begin + length overflow uint32_t, which
+		 * would also read past the end of the buffer. */
+		return 0;
+	}
+
+	if (pBuffer->LoopCount > 0 && pBufferWMA == NULL && voice->src.format->wFormatTag != FAUDIO_FORMAT_XMAUDIO2)
+	{
+		uint32_t realPlayLength = playLength;
+		uint32_t realLoopLength = loopLength;
+
+		/* PlayLength Default */
+		if (realPlayLength == 0)
+		{
+			realPlayLength = bufferLength - playBegin;
+		}
+
+		/* LoopLength Default */
+		if (realLoopLength == 0)
+		{
+			realLoopLength = playBegin + realPlayLength - loopBegin;
+		}
+
+		/* "The value of LoopBegin must be less than PlayBegin + PlayLength" */
+		if (loopBegin >= (playBegin + realPlayLength))
+		{
+			return 0;
+		}
+
+		/* "The value of LoopBegin + LoopLength must be greater than PlayBegin
+		 * and less than PlayBegin + PlayLength"
+		 */
+		if (	voice->audio->version > 7 && (
+			(loopBegin + realLoopLength) <= playBegin ||
+			(loopBegin + realLoopLength) > (playBegin + realPlayLength))	)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
 uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 	FAudioSourceVoice *voice,
 	const FAudioBuffer *pBuffer,
@@ -2726,6 +2952,10 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 	const uint32_t block_size = voice->src.format->nBlockAlign;
 	uint32_t adpcmMask;
 	uint32_t playBegin, playLength, loopBegin, loopLength, bufferLength;
+	uint32_t qoaHeader = 0;
+	uint8_t vorbisStarts = 0;
+	struct FAudioVorbisStream *vorbisStream = NULL;
+	FAudioVorbisSeek vorbisStart;
 	struct queued_buffer *entry;
 
 	LOG_API_ENTER(voice->audio)
@@ -2777,6 +3007,34 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 		FAudioXMA2WaveFormat *fmtex = (FAudioXMA2WaveFormat*) voice->src.format;
 		bufferLength = fmtex->dwSamplesEncoded;
 	}
+	else if (voice->src.vorbis != NULL)
+	{
+		bufferLength = FAudio_VORBIS_get_length(voice, pBuffer, &vorbisStarts);
+		if (bufferLength == 0)
+		{
+			LOG_ERROR(
+				voice->audio,
+				"%p: buffer is not whole Ogg pages of a Vorbis stream",
+				(void*) voice
+			)
+			LOG_API_EXIT(voice->audio)
+			return FAUDIO_E_INVALID_CALL;
+		}
+	}
+	else if (voice->src.qoa != NULL)
+	{
+		bufferLength = FAudio_QOA_get_length(voice, pBuffer, &qoaHeader);
+		if (bufferLength == 0)
+		{
+			LOG_ERROR(
+				voice->audio,
+				"%p: buffer is not QOA data for this voice",
+				(void*) voice
+			)
+			LOG_API_EXIT(voice->audio)
+			return FAUDIO_E_INVALID_CALL;
+		}
+	}
 	else if (pBufferWMA != NULL)
 	{
 		bufferLength =
@@ -2790,50 +3048,16 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 			voice->src.format->nBlockAlign;
 	}
 
-	if (playBegin + playLength > bufferLength || playBegin + playLength < playLength)
+	/* A Vorbis buffer that continues a stream is only measured once the
+	 * bufferLock is held, since the stream is shared with other submits
+	 */
+	if (	(voice->src.vorbis == NULL || vorbisStarts) &&
+		!FAudio_INTERNAL_CheckBufferRegions(voice, pBuffer, pBufferWMA, bufferLength)	)
 	{
-		/* Reading past the end of the buffer, or begin + length overflow uint32_t, which
-		 * would also read past the end of the buffer. */
 		LOG_API_EXIT(voice->audio)
 		return FAUDIO_E_INVALID_CALL;
 	}
 
-	if (pBuffer->LoopCount > 0 && pBufferWMA == NULL && voice->src.format->wFormatTag != FAUDIO_FORMAT_XMAUDIO2)
-	{
-		uint32_t realPlayLength = playLength;
-		uint32_t realLoopLength = loopLength;
-
-		/* PlayLength Default */
-		if (realPlayLength == 0)
-		{
-			realPlayLength = bufferLength - playBegin;
-		}
-
-		/* LoopLength Default */
-		if (realLoopLength == 0)
-		{
-			realLoopLength = playBegin + realPlayLength - loopBegin;
-		}
-
-		/* "The value of LoopBegin must be less than PlayBegin + PlayLength" */
-		if (loopBegin >= (playBegin + realPlayLength))
-		{
-			LOG_API_EXIT(voice->audio)
-			return FAUDIO_E_INVALID_CALL;
-		}
-
-		/* "The value of LoopBegin + LoopLength must be greater than PlayBegin
-		 * and less than PlayBegin + PlayLength"
-		 */
-		if (	voice->audio->version > 7 && (
-			(loopBegin + realLoopLength) <= playBegin ||
-			(loopBegin + realLoopLength) > (playBegin + realPlayLength))	)
-		{
-			LOG_API_EXIT(voice->audio)
-			return FAUDIO_E_INVALID_CALL;
-		}
-	}
-
 	/* For ADPCM, round down to the nearest sample block size */
 	if (voice->src.format->wFormatTag == FAUDIO_FORMAT_MSADPCM)
 	{
@@ -2850,15 +3074,45 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 		loopLength = playBegin + playLength;
 	}
 
+	/* Parse the headers now, rather than on the mixer thread */
+	if (vorbisStarts)
+	{
+		vorbisStream = FAudio_VORBIS_open(voice, pBuffer, &vorbisStart);
+		if (vorbisStream == NULL)
+		{
+			LOG_API_EXIT(voice->audio)
+			return FAUDIO_E_INVALID_CALL;
+		}
+	}
+
 	FAudio_PlatformLockMutex(voice->src.bufferLock);
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
+	if (voice->src.vorbis != NULL && !vorbisStarts)
+	{
+		bufferLength = FAudio_VORBIS_continue_length(voice, bufferLength);
+		if (	bufferLength == 0 ||
+			!FAudio_INTERNAL_CheckBufferRegions(voice, pBuffer, pBufferWMA, bufferLength)	)
+		{
+			FAudio_PlatformUnlockMutex(voice->src.bufferLock);
+			LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
+			LOG_ERROR(
+				voice->audio,
+				"%p: buffer does not continue the voice's Vorbis stream",
+				(void*) voice
+			)
+			LOG_API_EXIT(voice->audio)
+			return FAUDIO_E_INVALID_CALL;
+		}
+	}
+
 	array_reserve(voice->audio, (void **)&voice->src.queued_buffers, &voice->src.queued_buffers_capacity,
 		voice->src.queued_buffer_count + 1, sizeof(*voice->src.queued_buffers));
 
 	entry = &voice->src.queued_buffers[voice->src.queued_buffer_count++];
 	FAudio_memset(entry, 0, sizeof(*entry));
 	FAudio_memcpy(&entry->buffer, pBuffer, sizeof(FAudioBuffer));
+	entry->serial = voice->src.nextBufferSerial++;
 	entry->buffer.PlayBegin = playBegin;
 	entry->buffer.PlayLength = playLength;
 	entry->buffer.LoopBegin = loopBegin;
@@ -2867,6 +3121,18 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 	{
 		FAudio_memcpy(&entry->bufferWMA, pBufferWMA, sizeof(FAudioBufferWMA));
 	}
+	else if (voice->src.vorbis != NULL)
+	{
+		entry->sample_count = bufferLength;
+		FAudio_VORBIS_queue(voice, entry, vorbisStream, &vorbisStart);
+	}
+	else if (voice->src.qoa != NULL)
+	{
+		/* Blocks are counted from the first frame */
+		entry->buffer.pAudioData += qoaHeader;
+		entry->buffer.AudioBytes -= qoaHeader;
+		entry->sample_count = bufferLength;
+	}
 	else
 	{
 		if (playLength)
@@ -2909,6 +3175,13 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 	)
 	FAudio_PlatformUnlockMutex(voice->src.bufferLock);
 	LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
+
+	/* Get a head start on the new data */
+	if (voice->src.decodeahead != NULL)
+	{
+		FAudio_INTERNAL_DecodeAheadWake(voice->audio);
+	}
+
 	LOG_API_EXIT(voice->audio)
 	return 0;
 }
@@ -2916,7 +3189,7 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 uint32_t FAudioSourceVoice_FlushSourceBuffers(
 	FAudioSourceVoice *voice
 ) {
-	size_t offset = 0;
+	size_t offset = 0, i;
 
 	LOG_API_ENTER(voice->audio)
 	FAudio_assert(voice->type == FAUDIO_VOICE_SOURCE);
@@ -2936,6 +3209,10 @@ uint32_t FAudioSourceVoice_FlushSourceBuffers(
 	else
 	{
 		voice->src.curBufferOffset = 0;
+		if (voice->src.qoa != NULL)
+		{
+			FAudio_QOA_end_buffer(voice);
+		}
 	}
 
 	if (voice->src.queued_buffer_count > offset)
@@ -2945,6 +3222,15 @@ uint32_t FAudioSourceVoice_FlushSourceBuffers(
 			(voice->src.queued_buffer_count - offset) * sizeof(*voice->src.flush_buffers));
 	}
 
+	/* The client may free these as soon as OnBufferEnd is sent */
+	for (i = offset; i < voice->src.queued_buffer_count; i += 1)
+	{
+		FAudio_INTERNAL_DecodeAheadInvalidate(
+			voice,
+			&voice->src.queued_buffers[i]
+		);
+	}
+
 	voice->src.flush_buffer_count += voice->src.queued_buffer_count - offset;
 	voice->src.queued_buffer_count = offset;
 
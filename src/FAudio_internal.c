@@ -107,6 +107,8 @@ static const char *get_wformattag_string(const FAudioWaveFormatEx *fmt)
 	FMT_STRING(WMAUDIO2)
 	FMT_STRING(WMAUDIO3)
 	FMT_STRING(EXTENSIBLE)
+	FMT_STRING(VORBIS_EXT)
+	FMT_STRING(QOA_EXT)
 #undef FMT_STRING
 	return "UNKNOWN!";
 }
@@ -341,6 +343,12 @@ static uint32_t FAudio_INTERNAL_GetBytesRequested(
 		return 0;
 	}
 #endif /* HAVE_WMADEC */
+	if (voice->src.vorbis != NULL || voice->src.qoa != NULL)
+	{
+		/* Same as WMA, there's no meaningful byte count */
+		LOG_FUNC_EXIT(voice->audio)
+		return 0;
+	}
 
 	for (size_t i = 0; i < voice->src.queued_buffer_count; ++i)
 	{
@@ -399,6 +407,16 @@ static uint32_t buffer_get_end(FAudioSourceVoice *voice, const struct queued_buf
 	}
 #endif
 
+	/* QOA is made of blocks, but the last one is usually short */
+	if (voice->src.vorbis || voice->src.qoa)
+	{
+		if (buffer->buffer.LoopCount && buffer->buffer.LoopLength)
+			return buffer->buffer.LoopBegin + buffer->buffer.LoopLength;
+		if (buffer->buffer.PlayLength)
+			return buffer->buffer.PlayBegin + buffer->buffer.PlayLength;
+		return buffer->sample_count;
+	}
+
 	if (buffer->buffer.LoopCount)
 		return buffer->buffer.LoopBegin + ((buffer->loop_bytes - buffer->first_block_offset) / block_size * samples_per_block);
 
@@ -418,6 +436,8 @@ static void save_unaligned_end_data(FAudioSourceVoice *voice, const struct queue
 	if (voice->src.wmadec)
 		return;
 #endif
+	if (voice->src.vorbis || voice->src.qoa)
+		return;
 
 	byte_pos = buffer->first_block_offset;
 	byte_pos += voice->src.curBufferOffset / samples_per_block * block_size;
@@ -533,6 +553,8 @@ static void end_buffer(FAudioSourceVoice *voice)
 	if (voice->src.wmadec)
 		FAudio_WMADEC_end_buffer(voice);
 #endif /* HAVE_WMADEC */
+	if (voice->src.qoa)
+		FAudio_QOA_end_buffer(voice);
 
 	if (eos)
 	{
@@ -542,6 +564,8 @@ static void end_buffer(FAudioSourceVoice *voice)
 
 	LOG_INFO(voice->audio, "Voice %p, finished with buffer %p", voice, buffer)
 
+	FAudio_INTERNAL_DecodeAheadInvalidate(voice, buffer);
+
 	if (buffer->internal)
 		voice->audio->pFree((void *)buffer->buffer.pAudioData);
 
@@ -628,6 +652,7 @@ static void try_collect_unaligned_data(FAudioSourceVoice *voice)
 	buffer->buffer.pAudioData = voice->src.unaligned_data;
 	buffer->internal = true;
 	buffer->play_bytes = block_size;
+	buffer->serial = voice->src.nextBufferSerial++;
 
 	voice->src.curBufferOffset = 0;
 
@@ -636,6 +661,85 @@ static void try_collect_unaligned_data(FAudioSourceVoice *voice)
 	voice->src.unaligned_size = 0;
 }
 
+static struct decodeahead_block *FAudio_INTERNAL_DecodeAheadFind(
+	FAudioDecodeAhead *da,
+	FAudioDecodeAheadState state,
+	uint64_t serial,
+	const uint8_t *src
+) {
+	uint32_t i;
+	for (i = 0; i < da->blockCount; i += 1)
+	{
+		if (	da->blocks[i].state == state &&
+			da->blocks[i].serial == serial &&
+			da->blocks[i].src == src	)
+		{
+			return &da->blocks[i];
+		}
+	}
+	return NULL;
+}
+
+/* Decodes from the block at src, taking any blocks that the decode-ahead
+ * thread has already finished rather than decoding them a second time.
+ */
+static void FAudio_INTERNAL_DecodeBlocks(
+	FAudioSourceVoice *voice,
+	const struct queued_buffer *buffer,
+	const uint8_t *src,
+	float *dst,
+	uint32_t block_offset,
+	uint32_t sample_count
+) {
+	FAudioDecodeAhead *da = voice->src.decodeahead;
+	const uint32_t samples_per_block = voice->src.samples_per_block;
+	const uint32_t block_size = voice->src.format->nBlockAlign;
+	const uint16_t channels = voice->src.format->nChannels;
+	struct decodeahead_block *block;
+	uint32_t copy, done = 0;
+
+	if (da == NULL)
+	{
+		voice->src.decode(voice, src, dst, block_offset, sample_count);
+		return;
+	}
+
+	while (done < sample_count)
+	{
+		copy = FAudio_min(sample_count - done, samples_per_block - block_offset);
+
+		FAudio_PlatformLockMutex(da->lock);
+		LOG_MUTEX_LOCK(voice->audio, da->lock)
+		block = FAudio_INTERNAL_DecodeAheadFind(
+			da,
+			FAUDIO_DECODEAHEAD_READY,
+			buffer->serial,
+			src
+		);
+		if (block != NULL)
+		{
+			FAudio_memcpy(
+				dst,
+				block->samples + (block_offset * channels),
+				sizeof(float) * copy * channels
+			);
+		}
+		FAudio_PlatformUnlockMutex(da->lock);
+		LOG_MUTEX_UNLOCK(voice->audio, da->lock)
+
+		if (block == NULL)
+		{
+			/* Decode thread fell behind, do it ourselves */
+			voice->src.decode(voice, src, dst, block_offset, copy);
+		}
+
+		src += block_size;
+		dst += copy * channels;
+		done += copy;
+		block_offset = 0;
+	}
+}
+
 static void FAudio_INTERNAL_DecodeBuffers(
 	FAudioSourceVoice *voice,
 	uint64_t *toDecode
@@ -671,13 +775,18 @@ static void FAudio_INTERNAL_DecodeBuffers(
 		}
 		else
 #endif
+		if (voice->src.vorbis)
+		{
+			decode_vorbis(voice, buffer, dst, decode_count);
+		}
+		else
 		{
 			uint32_t block_offset = voice->src.curBufferOffset % samples_per_block;
 			const uint8_t *src = buffer->buffer.pAudioData + buffer->first_block_offset;
 
 			src += (voice->src.curBufferOffset / samples_per_block) * block_size;
 
-			voice->src.decode(voice, src, dst, block_offset, decode_count);
+			FAudio_INTERNAL_DecodeBlocks(voice, buffer, src, dst, block_offset, decode_count);
 		}
 
 		LOG_INFO(
@@ -732,13 +841,18 @@ static void FAudio_INTERNAL_DecodeBuffers(
 		}
 		else
 #endif
+		if (voice->src.vorbis)
+		{
+			decode_vorbis(voice, buffer, dst, decode_count);
+		}
+		else
 		{
 			uint32_t block_offset = voice->src.curBufferOffset % samples_per_block;
 			const uint8_t *src = buffer->buffer.pAudioData;
 
 			src += (voice->src.curBufferOffset / samples_per_block) * block_size;
 
-			voice->src.decode(voice, src, dst, block_offset, decode_count);
+			FAudio_INTERNAL_DecodeBlocks(voice, buffer, src, dst, block_offset, decode_count);
 		}
 
 		/* Do NOT increment curBufferOffset! */
@@ -773,6 +887,89 @@ static void FAudio_INTERNAL_DecodeBuffers(
 	LOG_FUNC_EXIT(voice->audio)
 }
 
+/* Float data played back at its own rate doesn't need to be decoded at all.
+ * If the whole update fits inside the current buffer, the mixer can read it
+ * straight from the client's memory; otherwise this returns NULL and the data
+ * goes through DecodeBuffers as usual, so that buffer boundaries, loops and
+ * resampler padding are still handled in one place.
+ */
+static float *FAudio_INTERNAL_DirectBuffer(
+	FAudioSourceVoice *voice,
+	uint64_t toDecode
+) {
+	const uint32_t block_size = voice->src.format->nBlockAlign;
+	struct queued_buffer *buffer = NULL;
+	float *result;
+
+	if (	voice->src.decode != FAudio_INTERNAL_DecodePCM32F ||
+		voice->src.resampleStep != FIXED_ONE ||
+		voice->src.curBufferOffsetDec != 0 ||
+		toDecode != voice->src.resampleSamples ||
+		block_size != voice->src.format->nChannels * sizeof(float) ||
+		(voice->flags & FAUDIO_VOICE_USEFILTER)	)
+	{
+		return NULL;
+	}
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	while (voice->src.queued_buffer_count)
+	{
+		try_collect_unaligned_data(voice);
+
+		/* Start-of-buffer behavior */
+		start_buffer(voice, &voice->src.queued_buffers[0]);
+
+		/* The callback may have flushed the queue */
+		if (!voice->src.queued_buffer_count)
+		{
+			break;
+		}
+
+		/* Buffers the size of an update will have been used up exactly
+		 * by the last one, so end them here just like DecodeBuffers
+		 * would have before moving on to the next.
+		 */
+		buffer = &voice->src.queued_buffers[0];
+		if (buffer_get_end(voice, buffer) > voice->src.curBufferOffset)
+		{
+			break;
+		}
+		end_buffer(voice);
+		buffer = NULL;
+	}
+
+	if (	buffer == NULL ||
+		!voice->src.queued_buffer_count ||
+		buffer_get_end(voice, buffer) - voice->src.curBufferOffset < toDecode	)
+	{
+		LOG_FUNC_EXIT(voice->audio)
+		return NULL;
+	}
+
+	result = (float*) (
+		buffer->buffer.pAudioData +
+		buffer->first_block_offset +
+		(voice->src.curBufferOffset * block_size)
+	);
+
+	LOG_INFO(
+		voice->audio,
+		"Voice %p, buffer %p, mixing %u samples directly from [%u,%u)",
+		(void*) voice,
+		(void*) buffer,
+		(uint32_t) toDecode,
+		voice->src.curBufferOffset,
+		voice->src.curBufferOffset + (uint32_t) toDecode
+	)
+
+	voice->src.curBufferOffset += toDecode;
+	voice->src.totalSamples += toDecode;
+
+	LOG_FUNC_EXIT(voice->audio)
+	return result;
+}
+
 static inline void FAudio_INTERNAL_FilterVoice(
 	FAudio *audio,
 	const FAudioFilterParametersEXT *filter,
@@ -945,6 +1142,7 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	uint32_t outputRate;
 	double stepd;
 	float *finalSamples;
+	float *directSamples = NULL;
 
 	LOG_FUNC_ENTER(voice->audio)
 
@@ -1061,7 +1259,11 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	}
 
 	/* Decode... */
-	FAudio_INTERNAL_DecodeBuffers(voice, &toDecode);
+	directSamples = FAudio_INTERNAL_DirectBuffer(voice, toDecode);
+	if (directSamples == NULL)
+	{
+		FAudio_INTERNAL_DecodeBuffers(voice, &toDecode);
+	}
 
 	/* Subtract any padding samples from the total, if applicable */
 	if (	voice->src.curBufferOffsetDec > 0 &&
@@ -1124,7 +1326,12 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	toResample = FAudio_min(toResample, voice->src.resampleSamples);
 
 	/* Resample... */
-	if (voice->src.resampleStep == FIXED_ONE)
+	if (directSamples != NULL)
+	{
+		/* Nothing to do, we're reading the client buffer! */
+		finalSamples = directSamples;
+	}
+	else if (voice->src.resampleStep == FIXED_ONE)
 	{
 		/* Actually, just use the existing buffer... */
 		finalSamples = voice->audio->decodeCache;
@@ -1198,6 +1405,17 @@ sendwork:
 	LOG_MUTEX_LOCK(voice->audio, voice->effectLock)
 	if (voice->effects.count > 0)
 	{
+		/* Effects may process in-place, so never hand them client data */
+		if (finalSamples == directSamples)
+		{
+			FAudio_memcpy(
+				voice->audio->decodeCache,
+				directSamples,
+				mixed * voice->src.format->nChannels * sizeof(float)
+			);
+			finalSamples = voice->audio->decodeCache;
+		}
+
 		/* If we didn't get the full size of the update, we have to fill
 		 * it with silence so the effect can process a whole update
 		 */
@@ -1601,6 +1819,12 @@ static void FAUDIOCALL FAudio_INTERNAL_GenerateOutput(FAudio *audio, float *outp
 	FAudio_PlatformUnlockMutex(audio->callbackLock);
 	LOG_MUTEX_UNLOCK(audio, audio->callbackLock)
 
+	/* Sources have moved forward, so the decode-ahead window has too */
+	if (audio->decodeAheadVoices != NULL)
+	{
+		FAudio_INTERNAL_DecodeAheadWake(audio);
+	}
+
 	LOG_FUNC_EXIT(audio)
 }
 
@@ -1785,6 +2009,375 @@ uint32_t FAudio_INTERNAL_VoiceOutputFrequency(
 	return 0;
 }
 
+/* Decode-ahead */
+
+/* How many quanta of audio the decode thread tries to keep ready */
+#define DECODEAHEAD_QUANTA 4
+
+static void FAudio_INTERNAL_DecodeAheadVoice(FAudioSourceVoice *voice)
+{
+	FAudioDecodeAhead *da = voice->src.decodeahead;
+	const uint32_t samples_per_block = voice->src.samples_per_block;
+	const uint32_t block_size = voice->src.format->nBlockAlign;
+	struct queued_buffer *buffer;
+	struct decodeahead_block *block;
+	uint32_t windowCount = 0, pendingCount = 0;
+	uint32_t offset, end, i, j;
+	size_t b;
+	const uint8_t *src;
+
+	FAudio_PlatformLockMutex(voice->src.bufferLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
+
+	/* Walk the queue from the current position to find the blocks that
+	 * are about to be played...
+	 */
+	offset = voice->src.curBufferOffset;
+	for (b = 0; b < voice->src.queued_buffer_count && windowCount < da->blockCount; b += 1)
+	{
+		buffer = &voice->src.queued_buffers[b];
+		if (b > 0)
+		{
+			offset = buffer->buffer.PlayBegin;
+		}
+		end = buffer_get_end(voice, buffer);
+		src = buffer->buffer.pAudioData + buffer->first_block_offset;
+
+		for (	j = offset / samples_per_block;
+			(j * samples_per_block) < end && windowCount < da->blockCount;
+			j += 1	)
+		{
+			da->window[windowCount].serial = buffer->serial;
+			da->window[windowCount].src = src + (j * block_size);
+			windowCount += 1;
+		}
+
+		/* Where we go after a loop depends on LoopCount/ExitLoop */
+		if (buffer->buffer.LoopCount > 0)
+		{
+			break;
+		}
+	}
+
+	FAudio_PlatformLockMutex(da->lock);
+	LOG_MUTEX_LOCK(voice->audio, da->lock)
+
+	/* ... recycle anything that isn't one of them... */
+	for (i = 0; i < da->blockCount; i += 1)
+	{
+		block = &da->blocks[i];
+		if (block->state != FAUDIO_DECODEAHEAD_READY)
+		{
+			continue;
+		}
+		for (j = 0; j < windowCount; j += 1)
+		{
+			if (	da->window[j].serial == block->serial &&
+				da->window[j].src == block->src	)
+			{
+				break;
+			}
+		}
+		if (j == windowCount)
+		{
+			block->state = FAUDIO_DECODEAHEAD_FREE;
+		}
+	}
+
+	/* ... and claim storage for whatever we don't have yet. */
+	for (j = 0, i = 0; j < windowCount; j += 1)
+	{
+		if (FAudio_INTERNAL_DecodeAheadFind(
+			da,
+			FAUDIO_DECODEAHEAD_READY,
+			da->window[j].serial,
+			da->window[j].src
+		) != NULL) {
+			continue;
+		}
+		while (	i < da->blockCount &&
+			da->blocks[i].state != FAUDIO_DECODEAHEAD_FREE	)
+		{
+			i += 1;
+		}
+		if (i == da->blockCount)
+		{
+			/* Everything is claimed, the rest waits for next time */
+			break;
+		}
+		da->blocks[i].serial = da->window[j].serial;
+		da->blocks[i].src = da->window[j].src;
+		da->blocks[i].state = FAUDIO_DECODEAHEAD_CLAIMED;
+		da->pending[pendingCount++] = i;
+	}
+
+	FAudio_PlatformUnlockMutex(da->lock);
+	LOG_MUTEX_UNLOCK(voice->audio, da->lock)
+	FAudio_PlatformUnlockMutex(voice->src.bufferLock);
+	LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
+
+	/* Decode nearest-first. The buffer may have been ended or flushed in
+	 * the meantime, in which case the claim will have been dropped and
+	 * the client's memory must not be touched.
+	 *
+	 * A DECODING block belongs to this thread: nobody reads it and only
+	 * we claim blocks, so the decode itself runs without da->lock. An
+	 * invalidate in the middle of it frees the block and then waits on
+	 * decodeLock for us to stop reading the client's memory.
+	 */
+	for (j = 0; j < pendingCount; j += 1)
+	{
+		block = &da->blocks[da->pending[j]];
+
+		FAudio_PlatformLockMutex(da->decodeLock);
+		LOG_MUTEX_LOCK(voice->audio, da->decodeLock)
+		FAudio_PlatformLockMutex(da->lock);
+		LOG_MUTEX_LOCK(voice->audio, da->lock)
+		if (block->state != FAUDIO_DECODEAHEAD_CLAIMED)
+		{
+			FAudio_PlatformUnlockMutex(da->lock);
+			LOG_MUTEX_UNLOCK(voice->audio, da->lock)
+			FAudio_PlatformUnlockMutex(da->decodeLock);
+			LOG_MUTEX_UNLOCK(voice->audio, da->decodeLock)
+			continue;
+		}
+		block->state = FAUDIO_DECODEAHEAD_DECODING;
+		da->decoding = block;
+		FAudio_PlatformUnlockMutex(da->lock);
+		LOG_MUTEX_UNLOCK(voice->audio, da->lock)
+
+		voice->src.decode(
+			voice,
+			block->src,
+			block->samples,
+			0,
+			samples_per_block
+		);
+
+		FAudio_PlatformLockMutex(da->lock);
+		LOG_MUTEX_LOCK(voice->audio, da->lock)
+		if (block->state == FAUDIO_DECODEAHEAD_DECODING)
+		{
+			block->state = FAUDIO_DECODEAHEAD_READY;
+		}
+		da->decoding = NULL;
+		FAudio_PlatformUnlockMutex(da->lock);
+		LOG_MUTEX_UNLOCK(voice->audio, da->lock)
+		FAudio_PlatformUnlockMutex(da->decodeLock);
+		LOG_MUTEX_UNLOCK(voice->audio, da->decodeLock)
+	}
+}
+
+static int32_t FAUDIOCALL FAudio_INTERNAL_DecodeAheadThread(void *user)
+{
+	FAudio *audio = (FAudio*) user;
+	LinkedList *list;
+
+	FAudio_PlatformThreadPriority(FAUDIO_THREAD_PRIORITY_HIGH);
+
+	while (audio->decodeAheadRunning)
+	{
+		/* Anything that moves the window after this wakes us again */
+		FAudio_PlatformAtomicSet(&audio->decodeAheadSignaled, 0);
+
+		FAudio_PlatformLockMutex(audio->decodeAheadLock);
+		LOG_MUTEX_LOCK(audio, audio->decodeAheadLock)
+		list = audio->decodeAheadVoices;
+		while (list != NULL)
+		{
+			FAudio_INTERNAL_DecodeAheadVoice(
+				(FAudioSourceVoice*) list->entry
+			);
+			list = list->next;
+		}
+		FAudio_PlatformUnlockMutex(audio->decodeAheadLock);
+		LOG_MUTEX_UNLOCK(audio, audio->decodeAheadLock)
+
+		/* The mixer wakes us after every update, the timeout is just
+		 * for when the engine is stopped.
+		 */
+		FAudio_PlatformWaitSemaphore(audio->decodeAheadSignal, 100);
+	}
+	return 0;
+}
+
+void FAudio_INTERNAL_DecodeAheadAddVoice(FAudioSourceVoice *voice)
+{
+	FAudio *audio = voice->audio;
+	FAudioDecodeAhead *da;
+	uint32_t quantumSamples, blockSamples, i;
+
+	LOG_FUNC_ENTER(audio)
+
+	/* Only block-compressed formats are worth doing this for */
+	if (	voice->src.decode == NULL ||
+		voice->src.samples_per_block <= 1	)
+	{
+		LOG_FUNC_EXIT(audio)
+		return;
+	}
+
+	quantumSamples = (uint32_t) FAudio_ceil(
+		(double) audio->updateSize *
+		(double) voice->src.format->nSamplesPerSec /
+		(double) audio->master->master.inputSampleRate
+	);
+	blockSamples = voice->src.samples_per_block * voice->src.format->nChannels;
+
+	da = (FAudioDecodeAhead*) audio->pMalloc(sizeof(FAudioDecodeAhead));
+	da->lock = FAudio_PlatformCreateMutex();
+	LOG_MUTEX_CREATE(audio, da->lock)
+	da->decodeLock = FAudio_PlatformCreateMutex();
+	LOG_MUTEX_CREATE(audio, da->decodeLock)
+	da->decoding = NULL;
+	da->blockCount = (
+		(quantumSamples * DECODEAHEAD_QUANTA) /
+		voice->src.samples_per_block
+	) + 2;
+	da->blocks = (struct decodeahead_block*) audio->pMalloc(
+		sizeof(struct decodeahead_block) * da->blockCount
+	);
+	FAudio_zero(da->blocks, sizeof(struct decodeahead_block) * da->blockCount);
+	da->window = (struct decodeahead_block*) audio->pMalloc(
+		sizeof(struct decodeahead_block) * da->blockCount
+	);
+	da->pending = (uint32_t*) audio->pMalloc(
+		sizeof(uint32_t) * da->blockCount
+	);
+	da->samples = (float*) audio->pMalloc(
+		sizeof(float) * blockSamples * da->blockCount
+	);
+	for (i = 0; i < da->blockCount; i += 1)
+	{
+		da->blocks[i].samples = da->samples + (i * blockSamples);
+	}
+	voice->src.decodeahead = da;
+
+	FAudio_PlatformLockMutex(audio->decodeAheadLock);
+	LOG_MUTEX_LOCK(audio, audio->decodeAheadLock)
+	if (!audio->decodeAheadRunning)
+	{
+		audio->decodeAheadSignal = FAudio_PlatformCreateSemaphore(0);
+		audio->decodeAheadSignaled = 0;
+		audio->decodeAheadRunning = 1;
+		audio->decodeAheadThread = FAudio_PlatformCreateThread(
+			FAudio_INTERNAL_DecodeAheadThread,
+			"FAudioDecodeAhead",
+			audio
+		);
+	}
+	FAudio_PlatformUnlockMutex(audio->decodeAheadLock);
+	LOG_MUTEX_UNLOCK(audio, audio->decodeAheadLock)
+
+	LinkedList_AddEntry(
+		&audio->decodeAheadVoices,
+		voice,
+		audio->decodeAheadLock,
+		audio->pMalloc
+	);
+
+	LOG_FUNC_EXIT(audio)
+}
+
+void FAudio_INTERNAL_DecodeAheadRemoveVoice(FAudioSourceVoice *voice)
+{
+	FAudio *audio = voice->audio;
+	FAudioDecodeAhead *da = voice->src.decodeahead;
+
+	if (da == NULL)
+	{
+		return;
+	}
+
+	LOG_FUNC_ENTER(audio)
+
+	/* Waits for the decode thread to finish with this voice */
+	LinkedList_RemoveEntry(
+		&audio->decodeAheadVoices,
+		voice,
+		audio->decodeAheadLock,
+		audio->pFree
+	);
+
+	voice->src.decodeahead = NULL;
+	LOG_MUTEX_DESTROY(audio, da->decodeLock)
+	FAudio_PlatformDestroyMutex(da->decodeLock);
+	LOG_MUTEX_DESTROY(audio, da->lock)
+	FAudio_PlatformDestroyMutex(da->lock);
+	audio->pFree(da->samples);
+	audio->pFree(da->pending);
+	audio->pFree(da->window);
+	audio->pFree(da->blocks);
+	audio->pFree(da);
+
+	LOG_FUNC_EXIT(audio)
+}
+
+void FAudio_INTERNAL_DecodeAheadInvalidate(
+	FAudioSourceVoice *voice,
+	const struct queued_buffer *buffer
+) {
+	FAudioDecodeAhead *da = voice->src.decodeahead;
+	uint8_t wait;
+	uint32_t i;
+
+	if (da == NULL)
+	{
+		return;
+	}
+
+	FAudio_PlatformLockMutex(da->lock);
+	LOG_MUTEX_LOCK(voice->audio, da->lock)
+	for (i = 0; i < da->blockCount; i += 1)
+	{
+		if (da->blocks[i].serial == buffer->serial)
+		{
+			da->blocks[i].state = FAUDIO_DECODEAHEAD_FREE;
+		}
+	}
+	wait = (	da->decoding != NULL &&
+			da->decoding->serial == buffer->serial	);
+	FAudio_PlatformUnlockMutex(da->lock);
+	LOG_MUTEX_UNLOCK(voice->audio, da->lock)
+
+	/* Once this returns, the decode thread is done reading the buffer.
+	 * At worst that is one block, and only if it is from this buffer.
+	 */
+	if (wait)
+	{
+		FAudio_PlatformLockMutex(da->decodeLock);
+		LOG_MUTEX_LOCK(voice->audio, da->decodeLock)
+		FAudio_PlatformUnlockMutex(da->decodeLock);
+		LOG_MUTEX_UNLOCK(voice->audio, da->decodeLock)
+	}
+}
+
+void FAudio_INTERNAL_DecodeAheadWake(FAudio *audio)
+{
+	/* One pending wakeup is enough, the thread looks at every voice */
+	if (FAudio_PlatformAtomicExchange(&audio->decodeAheadSignaled, 1) == 0)
+	{
+		FAudio_PlatformSignalSemaphore(audio->decodeAheadSignal);
+	}
+}
+
+void FAudio_INTERNAL_DecodeAheadQuit(FAudio *audio)
+{
+	if (!audio->decodeAheadRunning)
+	{
+		return;
+	}
+
+	LOG_FUNC_ENTER(audio)
+	audio->decodeAheadRunning = 0;
+	FAudio_PlatformSignalSemaphore(audio->decodeAheadSignal);
+	FAudio_PlatformWaitThread(audio->decodeAheadThread, NULL);
+	FAudio_PlatformDestroySemaphore(audio->decodeAheadSignal);
+	audio->decodeAheadThread = NULL;
+	audio->decodeAheadSignal = NULL;
+	LOG_FUNC_EXIT(audio)
+}
+
 const float FAUDIO_INTERNAL_MATRIX_DEFAULTS[8][8][64] =
 {
 	#include "matrix_defaults.inl"
@@ -1815,7 +2408,14 @@ void FAudio_INTERNAL_DecodePCM24(FAudioVoice *voice, const void *src,
 	const uint8_t *buf = src;
 	LOG_FUNC_ENTER(voice->audio)
 
-	/* FIXME: Uh... is this something that can be SIMD-ified? */
+	/* Tightly packed samples can be converted in one go */
+	if (voice->src.format->nBlockAlign == voice->src.format->nChannels * 3)
+	{
+		FAudio_INTERNAL_Convert_S24_To_F32(src, decodeCache, samples * voice->src.format->nChannels);
+		LOG_FUNC_EXIT(voice->audio)
+		return;
+	}
+
 	for (i = 0; i < samples; i += 1, buf += voice->src.format->nBlockAlign)
 	for (j = 0; j < voice->src.format->nChannels; j += 1)
 	{
@@ -1847,42 +2447,29 @@ void FAudio_INTERNAL_DecodePCM32F(FAudioVoice *voice, const void *src,
 
 /* MSADPCM Decoding */
 
-static float FAudio_INTERNAL_ParseNibble(
+/* Decoded samples are collected here and converted to float in bulk */
+#define ADPCM_SCRATCH_SIZE 512
+
+static inline int16_t FAudio_INTERNAL_ParseNibble(
 	uint8_t nibble,
-	uint8_t predictor,
+	int32_t coeff1,
+	int32_t coeff2,
 	int16_t *delta,
 	int16_t *sample1,
 	int16_t *sample2
 ) {
-	static const int32_t AdaptionTable[16] =
+	static const int16_t AdaptionTable[16] =
 	{
 		230, 230, 230, 230, 307, 409, 512, 614,
 		768, 614, 512, 409, 307, 230, 230, 230
 	};
-	static const int32_t AdaptCoeff_1[7] =
-	{
-		256, 512, 0, 192, 240, 460, 392
-	};
-	static const int32_t AdaptCoeff_2[7] =
-	{
-		0, -256, 0, 64, 0, -208, -232
-	};
 
-	int8_t signedNibble;
 	int32_t sampleInt;
 	int16_t sample;
 
-	signedNibble = (int8_t) nibble;
-	if (signedNibble & 0x08)
-	{
-		signedNibble -= 0x10;
-	}
-
-	sampleInt = (
-		(*sample1 * AdaptCoeff_1[predictor]) +
-		(*sample2 * AdaptCoeff_2[predictor])
-	) / 256;
-	sampleInt += signedNibble * (*delta);
+	/* Sign-extend the nibble, then apply the predictor */
+	sampleInt = ((*sample1 * coeff1) + (*sample2 * coeff2)) / 256;
+	sampleInt += (((int32_t) nibble ^ 8) - 8) * (*delta);
 	sample = FAudio_clamp(sampleInt, -32768, 32767);
 
 	*sample2 = *sample1;
@@ -1892,69 +2479,92 @@ static float FAudio_INTERNAL_ParseNibble(
 	{
 		*delta = 16;
 	}
-	return sample / 32768.0;
+	return sample;
 }
 
+static const int32_t AdaptCoeff_1[7] =
+{
+	256, 512, 0, 192, 240, 460, 392
+};
+static const int32_t AdaptCoeff_2[7] =
+{
+	0, -256, 0, 64, 0, -208, -232
+};
+
 static void decode_mono_adpcm_block(const uint8_t *src, float *dst, uint32_t offset, uint32_t count)
 {
-	uint32_t i;
+	int16_t scratch[ADPCM_SCRATCH_SIZE];
+	const uint32_t end = offset + count;
+	uint32_t i, cached = 0;
+	int16_t sample;
 
 	/* Temp storage for ADPCM blocks */
-	uint8_t predictor;
+	int32_t coeff1;
+	int32_t coeff2;
 	int16_t delta;
 	int16_t sample1;
 	int16_t sample2;
 
-	predictor = src[0];
+	coeff1 = AdaptCoeff_1[src[0]];
+	coeff2 = AdaptCoeff_2[src[0]];
 	delta = *(int16_t *)&src[1];
 	sample1 = *(int16_t *)&src[3];
 	sample2 = *(int16_t *)&src[5];
 	src += 7;
 
-	/* Samples */
-	for (i = 0; i < FAudio_min(2, offset + count); ++i)
-	{
-		if (i < offset) continue;
-		if (i == 0) *dst++ = sample2 / 32768.0;
-		if (i == 1) *dst++ = sample1 / 32768.0;
-	}
-	for (; i < offset + count; i += 2)
-	{
-		float high, low;
+	/* The first two samples are stored as-is in the preamble */
+	if (offset == 0 && end > 0) scratch[cached++] = sample2;
+	if (offset <= 1 && end > 1) scratch[cached++] = sample1;
 
-		high = FAudio_INTERNAL_ParseNibble(
+	/* Samples before the offset still have to go through the predictor */
+	for (i = 2; i < end; i += 2, src += 1)
+	{
+		sample = FAudio_INTERNAL_ParseNibble(
 			*src >> 4,
-			predictor,
+			coeff1,
+			coeff2,
 			&delta,
 			&sample1,
 			&sample2
 		);
-		low = FAudio_INTERNAL_ParseNibble(
-			*src & 0xf,
-			predictor,
+		if (i >= offset)
+		{
+			scratch[cached++] = sample;
+		}
+		sample = FAudio_INTERNAL_ParseNibble(
+			*src & 0xF,
+			coeff1,
+			coeff2,
 			&delta,
 			&sample1,
 			&sample2
 		);
-
-		if (i >= offset)
+		if (i + 1 >= offset && i + 1 < end)
 		{
-			*dst++ = high;
-			if (i + 1 < offset + count)
-				*dst++ = low;
+			scratch[cached++] = sample;
 		}
 
-		++src;
+		if (cached >= ADPCM_SCRATCH_SIZE - 2)
+		{
+			FAudio_INTERNAL_Convert_S16_To_F32(scratch, dst, cached);
+			dst += cached;
+			cached = 0;
+		}
 	}
+	FAudio_INTERNAL_Convert_S16_To_F32(scratch, dst, cached);
 }
 
 static void decode_stereo_adpcm_block(const uint8_t *src, float *dst, uint32_t offset, uint32_t count)
 {
-	uint32_t i;
+	int16_t scratch[ADPCM_SCRATCH_SIZE];
+	const uint32_t end = offset + count;
+	uint32_t i, cached = 0;
 
 	/* Temp storage for ADPCM blocks */
-	uint8_t l_predictor;
-	uint8_t r_predictor;
+	int32_t l_coeff1;
+	int32_t r_coeff1;
+	int32_t l_coeff2;
+	int32_t r_coeff2;
 	int16_t l_delta;
 	int16_t r_delta;
 	int16_t l_sample1;
@@ -1963,8 +2573,10 @@ static void decode_stereo_adpcm_block(const uint8_t *src, float *dst, uint32_t o
 	int16_t r_sample2;
 
 	/* Preamble */
-	l_predictor = src[0];
-	r_predictor = src[1];
+	l_coeff1 = AdaptCoeff_1[src[0]];
+	r_coeff1 = AdaptCoeff_1[src[1]];
+	l_coeff2 = AdaptCoeff_2[src[0]];
+	r_coeff2 = AdaptCoeff_2[src[1]];
 	l_delta = *(int16_t *)&src[2];
 	r_delta = *(int16_t *)&src[4];
 	l_sample1 = *(int16_t *)&src[6];
@@ -1973,48 +2585,54 @@ static void decode_stereo_adpcm_block(const uint8_t *src, float *dst, uint32_t o
 	r_sample2 = *(int16_t *)&src[12];
 	src += 14;
 
-	/* Samples */
-	for (i = 0; i < FAudio_min(2, offset + count); ++i)
+	/* The first two samples are stored as-is in the preamble */
+	if (offset == 0 && end > 0)
 	{
-		if (i < offset) continue;
-		if (i == 0)
-		{
-			*dst++ = l_sample2 / 32768.0;
-			*dst++ = r_sample2 / 32768.0;
-		}
-		if (i == 1)
-		{
-			*dst++ = l_sample1 / 32768.0;
-			*dst++ = r_sample1 / 32768.0;
-		}
+		scratch[cached++] = l_sample2;
+		scratch[cached++] = r_sample2;
 	}
-	for (; i < offset + count; ++i)
+	if (offset <= 1 && end > 1)
 	{
-		float left, right;
+		scratch[cached++] = l_sample1;
+		scratch[cached++] = r_sample1;
+	}
 
-		left = FAudio_INTERNAL_ParseNibble(
+	/* Each byte is one left sample and one right sample. The two
+	 * predictors don't depend on each other, so running them in the same
+	 * loop lets the CPU overlap them.
+	 */
+	for (i = 2; i < end; i += 1, src += 1)
+	{
+		const int16_t left = FAudio_INTERNAL_ParseNibble(
 			*src >> 4,
-			l_predictor,
+			l_coeff1,
+			l_coeff2,
 			&l_delta,
 			&l_sample1,
 			&l_sample2
 		);
-		right = FAudio_INTERNAL_ParseNibble(
-			*src & 0xf,
-			r_predictor,
+		const int16_t right = FAudio_INTERNAL_ParseNibble(
+			*src & 0xF,
+			r_coeff1,
+			r_coeff2,
 			&r_delta,
 			&r_sample1,
 			&r_sample2
 		);
-
 		if (i >= offset)
 		{
-			*dst++ = left;
-			*dst++ = right;
+			scratch[cached++] = left;
+			scratch[cached++] = right;
 		}
 
-		++src;
+		if (cached == ADPCM_SCRATCH_SIZE)
+		{
+			FAudio_INTERNAL_Convert_S16_To_F32(scratch, dst, cached);
+			dst += cached;
+			cached = 0;
+		}
 	}
+	FAudio_INTERNAL_Convert_S16_To_F32(scratch, dst, cached);
 }
 
 void FAudio_INTERNAL_DecodeMonoMSADPCM(FAudioVoice *voice, const void *src,
@@ -2069,4 +2687,20 @@ void FAudio_INTERNAL_DecodeStereoMSADPCM(FAudioVoice *voice, const void *src,
 	LOG_FUNC_EXIT(voice->audio)
 }
 
+void FAudio_INTERNAL_DecodeMSADPCMBlock(
+	const uint8_t *src,
+	float *dst,
+	uint16_t channels,
+	uint32_t samples
+) {
+	if (channels == 2)
+	{
+		decode_stereo_adpcm_block(src, dst, 0, samples);
+	}
+	else
+	{
+		decode_mono_adpcm_block(src, dst, 0, samples);
+	}
+}
+
 /* vim: set noexpandtab shiftwidth=8 tabstop=8: */
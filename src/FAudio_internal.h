@@ -253,6 +253,7 @@ extern void FAudio_Log(char const *msg);
 
 typedef void* FAudioThread;
 typedef void* FAudioMutex;
+typedef void* FAudioSemaphore;
 typedef int32_t (FAUDIOCALL * FAudioThreadFunc)(void* data);
 typedef enum FAudioThreadPriority
 {
@@ -297,6 +298,18 @@ typedef enum FAudioVoiceType
 	FAUDIO_VOICE_MASTER
 } FAudioVoiceType;
 
+/* Where a Vorbis decode starts from: the page at offset, after a sync on a
+ * page with the given granule, or the first audio page of the stream.
+ */
+typedef struct FAudioVorbisSeek
+{
+	uint32_t offset;
+	uint32_t sample;
+	uint8_t start;
+} FAudioVorbisSeek;
+
+struct FAudioVorbisStream;
+
 struct queued_buffer
 {
 	FAudioBuffer buffer;
@@ -309,8 +322,62 @@ struct queued_buffer
 	 * but will be nonzero if the previous buffer did not have an aligned
 	 * size. */
 	uint32_t first_block_offset;
+
+	/* Unique per voice, used to match decode-ahead blocks to buffers */
+	uint64_t serial;
+
+	/* Decoded length, for formats where the byte size doesn't tell us */
+	uint32_t sample_count;
+
+	/* VorbisEXT: the stream this buffer is part of, the stream sample it
+	 * starts at, and where to start decoding for its start, PlayBegin
+	 * and LoopBegin
+	 */
+	struct FAudioVorbisStream *vorbis;
+	uint32_t vorbis_first;
+	FAudioVorbisSeek vorbis_start, vorbis_play, vorbis_loop;
+};
+
+/* Decode-ahead, see "extensions/DecodeAheadEXT.txt" */
+
+typedef enum FAudioDecodeAheadState
+{
+	FAUDIO_DECODEAHEAD_FREE,
+	FAUDIO_DECODEAHEAD_CLAIMED,
+	FAUDIO_DECODEAHEAD_DECODING,
+	FAUDIO_DECODEAHEAD_READY
+} FAudioDecodeAheadState;
+
+struct decodeahead_block
+{
+	uint64_t serial;
+	const uint8_t *src;
+	float *samples;
+	FAudioDecodeAheadState state;
 };
 
+typedef struct FAudioDecodeAhead
+{
+	/* Guards the block states. Only ever held for a lookup or a copy,
+	 * never for a decode. Always taken after bufferLock, never before.
+	 */
+	FAudioMutex lock;
+
+	/* Held by the decode thread for as long as it reads from the block
+	 * in `decoding`, so that invalidating a buffer can wait for it.
+	 */
+	FAudioMutex decodeLock;
+	struct decodeahead_block *decoding;
+
+	struct decodeahead_block *blocks;
+	uint32_t blockCount;
+	float *samples;
+
+	/* Scratch space for the decode thread */
+	struct decodeahead_block *window;
+	uint32_t *pending;
+} FAudioDecodeAhead;
+
 typedef void (FAUDIOCALL * FAudioDecodeCallback)(FAudioVoice *voice,
 	const void *src, float *dst, uint32_t block_offset, uint32_t sample_count);
 
@@ -456,6 +523,14 @@ struct FAudio
 	void *clientEngineUser;
 	FAudioEngineProcedureEXT pClientEngineProc;
 
+	/* DecodeAheadEXT */
+	LinkedList *decodeAheadVoices;
+	FAudioMutex decodeAheadLock;
+	FAudioThread decodeAheadThread;
+	FAudioSemaphore decodeAheadSignal;
+	uint32_t decodeAheadSignaled;
+	uint8_t decodeAheadRunning;
+
 #ifndef FAUDIO_DISABLE_DEBUGCONFIGURATION
 	/* Debug Information */
 	FAudioDebugConfiguration debug;
@@ -517,6 +592,8 @@ struct FAudioVoice
 #ifdef HAVE_WMADEC
 			struct FAudioWMADEC *wmadec;
 #endif /* HAVE_WMADEC*/
+			struct FAudioVorbis *vorbis;
+			struct FAudioQOA *qoa;
 
 			/* Read-only */
 			float maxFreqRatio;
@@ -547,6 +624,12 @@ struct FAudioVoice
 			uint8_t *unaligned_data;
 			uint32_t unaligned_size;
 
+			/* Assigned to each queued_buffer as it is queued */
+			uint64_t nextBufferSerial;
+
+			/* NULL unless FAUDIO_VOICE_DECODEAHEAD_EXT was used */
+			FAudioDecodeAhead *decodeahead;
+
 			FAudioMutex bufferLock;
 		} src;
 		struct
@@ -586,6 +669,10 @@ void FAudio_INTERNAL_InsertSubmixSorted(
 	FAudioMallocFunc pMalloc
 );
 void FAudio_INTERNAL_UpdateEngine(FAudio *audio, float *output);
+void FAudio_INTERNAL_ResetSourceVoice(
+	FAudioSourceVoice *voice,
+	FAudioVoiceCallback *callback
+);
 void FAudio_INTERNAL_ResizeDecodeCache(FAudio *audio, uint32_t size);
 void FAudio_INTERNAL_AllocEffectChain(
 	FAudioVoice *voice,
@@ -596,6 +683,14 @@ uint32_t FAudio_INTERNAL_VoiceOutputFrequency(
 	FAudioVoice *voice,
 	const FAudioVoiceSends *pSendList
 );
+void FAudio_INTERNAL_DecodeAheadAddVoice(FAudioSourceVoice *voice);
+void FAudio_INTERNAL_DecodeAheadRemoveVoice(FAudioSourceVoice *voice);
+void FAudio_INTERNAL_DecodeAheadWake(FAudio *audio);
+void FAudio_INTERNAL_DecodeAheadInvalidate(
+	FAudioSourceVoice *voice,
+	const struct queued_buffer *buffer
+);
+void FAudio_INTERNAL_DecodeAheadQuit(FAudio *audio);
 extern const float FAUDIO_INTERNAL_MATRIX_DEFAULTS[8][8][64];
 
 bool array_reserve(FAudio *audio, void **elements, size_t *capacity, size_t count, size_t size);
@@ -732,6 +827,11 @@ extern void (*FAudio_INTERNAL_Convert_S16_To_F32)(
 	float *restrict dst,
 	uint32_t len
 );
+extern void (*FAudio_INTERNAL_Convert_S24_To_F32)(
+	const uint8_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+);
 extern void (*FAudio_INTERNAL_Convert_S32_To_F32)(
 	const int32_t *restrict src,
 	float *restrict dst,
@@ -757,6 +857,10 @@ extern void (*FAudio_INTERNAL_Amplify)(
 
 extern FAudioMixCallback FAudio_INTERNAL_Mix_Generic;
 
+/* In-place byte swaps for big-endian content, len is in elements */
+extern void (*FAudio_INTERNAL_SwapBE16)(uint16_t *data, uint32_t len);
+extern void (*FAudio_INTERNAL_SwapBE32)(uint32_t *data, uint32_t len);
+
 #define MIX_FUNC(type) \
 	extern void FAudio_INTERNAL_Mix_##type##_Scalar( \
 		uint32_t toMix, \
@@ -790,9 +894,18 @@ DECODE_FUNC(PCM32)
 DECODE_FUNC(PCM32F)
 DECODE_FUNC(MonoMSADPCM)
 DECODE_FUNC(StereoMSADPCM)
+DECODE_FUNC(QOA)
 DECODE_FUNC(WMAERROR)
 #undef DECODE_FUNC
 
+/* Decodes one whole MSADPCM block outside of a voice, for FACT */
+void FAudio_INTERNAL_DecodeMSADPCMBlock(
+	const uint8_t *src,
+	float *dst,
+	uint16_t channels,
+	uint32_t samples
+);
+
 /* WMA decoding */
 
 void decode_wma(FAudioVoice *voice, struct queued_buffer *buffer, float *dst, uint32_t sample_count);
@@ -802,6 +915,70 @@ void FAudio_WMADEC_free(FAudioSourceVoice *voice);
 void FAudio_WMADEC_end_buffer(FAudioSourceVoice *voice);
 #endif /* HAVE_WMADEC */
 
+/* Vorbis decoding */
+
+void decode_vorbis(FAudioVoice *voice, struct queued_buffer *buffer, float *dst, uint32_t sample_count);
+uint32_t FAudio_VORBIS_init(FAudioSourceVoice *voice);
+void FAudio_VORBIS_free(FAudioSourceVoice *voice);
+uint32_t FAudio_VORBIS_get_length(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *buffer,
+	uint8_t *starts
+);
+uint32_t FAudio_VORBIS_continue_length(
+	FAudioSourceVoice *voice,
+	uint32_t granule
+);
+struct FAudioVorbisStream *FAudio_VORBIS_open(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *buffer,
+	FAudioVorbisSeek *start
+);
+void FAudio_VORBIS_queue(
+	FAudioSourceVoice *voice,
+	struct queued_buffer *entry,
+	struct FAudioVorbisStream *opened,
+	const FAudioVorbisSeek *start
+);
+
+/* Ogg page index, for XNA_Song */
+
+struct stb_vorbis;
+
+typedef struct FAudioVorbisSeekPoint
+{
+	uint32_t offset;
+	uint32_t sample;
+} FAudioVorbisSeekPoint;
+
+uint32_t FAudio_VORBIS_index_build(
+	struct stb_vorbis *f,
+	const uint8_t *running,
+	FAudioVorbisSeekPoint **index
+);
+uint32_t FAudio_VORBIS_index_load(
+	struct stb_vorbis *f,
+	FAudioIOStream *io,
+	FAudioVorbisSeekPoint **index
+);
+uint32_t FAudio_VORBIS_index_seek(
+	struct stb_vorbis *f,
+	const FAudioVorbisSeekPoint *index,
+	uint32_t count,
+	uint32_t sample
+);
+
+/* QOA decoding */
+
+uint32_t FAudio_QOA_init(FAudioSourceVoice *voice);
+void FAudio_QOA_free(FAudioSourceVoice *voice);
+void FAudio_QOA_end_buffer(FAudioSourceVoice *voice);
+uint32_t FAudio_QOA_get_length(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *buffer,
+	uint32_t *headerSize
+);
+
 /* Platform Functions */
 
 void FAudio_PlatformAddRef(void);
@@ -822,6 +999,11 @@ uint32_t FAudio_PlatformGetDeviceDetails(
 	FAudioDeviceDetails *details
 );
 
+/* Maps a whole file into memory, copy-on-write. The result works with
+ * FAudio_memptr, and FAudio_close unmaps it. NULL if the file can't be opened.
+ */
+FAudioIOStream* FAudio_PlatformMapFile(const char *path);
+
 /* Threading */
 
 FAudioThread FAudio_PlatformCreateThread(
@@ -836,6 +1018,16 @@ FAudioMutex FAudio_PlatformCreateMutex(void);
 void FAudio_PlatformDestroyMutex(FAudioMutex mutex);
 void FAudio_PlatformLockMutex(FAudioMutex mutex);
 void FAudio_PlatformUnlockMutex(FAudioMutex mutex);
+FAudioSemaphore FAudio_PlatformCreateSemaphore(uint32_t initialValue);
+void FAudio_PlatformDestroySemaphore(FAudioSemaphore sem);
+void FAudio_PlatformSignalSemaphore(FAudioSemaphore sem);
+/* Returns 1 if the semaphore was signaled, 0 on timeout. -1 waits forever. */
+uint8_t FAudio_PlatformWaitSemaphore(FAudioSemaphore sem, int32_t timeoutMS);
+/* Full barriers, for the few fields that are shared without a lock */
+uint32_t FAudio_PlatformAtomicGet(uint32_t *ptr);
+void FAudio_PlatformAtomicSet(uint32_t *ptr, uint32_t value);
+/* Returns the previous value */
+uint32_t FAudio_PlatformAtomicExchange(uint32_t *ptr, uint32_t value);
 void FAudio_sleep(uint32_t ms);
 
 /* Time */
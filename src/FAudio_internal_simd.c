@@ -83,6 +83,16 @@
 #define DIVBY32768 0.000030517578125f
 #define DIVBY8388607 0.00000011920930376163766f
 
+/* 24-bit samples are packed, so the leftovers have to be assembled by hand */
+static inline float FAudio_INTERNAL_S24_To_F32(const uint8_t *src)
+{
+	return ((int32_t) (
+		((uint32_t) src[2] << 24) |
+		((uint32_t) src[1] << 16) |
+		((uint32_t) src[0] << 8)
+	) >> 8) * DIVBY8388607;
+}
+
 #if NEED_SCALAR_CONVERTER_FALLBACKS
 void FAudio_INTERNAL_Convert_U8_To_F32_Scalar(
 	const uint8_t *restrict src,
@@ -119,6 +129,18 @@ void FAudio_INTERNAL_Convert_S32_To_F32_Scalar(
 		*dst++ = (*src++ >> 8) * DIVBY8388607;
 	}
 }
+
+void FAudio_INTERNAL_Convert_S24_To_F32_Scalar(
+	const uint8_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+) {
+	uint32_t i;
+	for (i = 0; i < len; i += 1, src += 3)
+	{
+		*dst++ = FAudio_INTERNAL_S24_To_F32(src);
+	}
+}
 #endif /* NEED_SCALAR_CONVERTER_FALLBACKS */
 
 #if HAVE_SSE2_INTRINSICS
@@ -195,12 +217,12 @@ void FAudio_INTERNAL_Convert_S16_To_F32_SSE2(
     src -= 7; dst -= 7;  /* adjust to read SSE blocks from the start. */
     FAudio_assert(!i || ((((size_t) dst) & 15) == 0));
 
-    /* Make sure src is aligned too. */
-    if ((((size_t) src) & 15) == 0) {
-        /* Aligned! Do SSE blocks as long as we have 16 bytes available. */
+    /* src doesn't have to be aligned, decoders convert out of scratch buffers at arbitrary offsets. */
+    {
+        /* Do SSE blocks as long as we have 16 bytes available. */
         const __m128 divby32768 = _mm_set1_ps(DIVBY32768);
         while (i >= 8) {   /* 8 * 16-bit */
-            const __m128i ints = _mm_load_si128((__m128i const *) src);  /* get 8 sint16 into an XMM register. */
+            const __m128i ints = _mm_loadu_si128((__m128i const *) src);  /* get 8 sint16 into an XMM register. */
             /* treat as int32, shift left to clear every other sint16, then back right with sign-extend. Now sint32. */
             const __m128i a = _mm_srai_epi32(_mm_slli_epi32(ints, 16), 16);
             /* right-shift-sign-extend gets us sint32 with the other set of values. */
@@ -254,6 +276,42 @@ void FAudio_INTERNAL_Convert_S32_To_F32_SSE2(
         i--; src++; dst++;
     }
 }
+
+void FAudio_INTERNAL_Convert_S24_To_F32_SSE2(
+	const uint8_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+) {
+    int i;
+
+    /* Get dst aligned to 16 bytes */
+    for (i = len; i && (((size_t) dst) & 15); --i, src += 3, ++dst) {
+        *dst = FAudio_INTERNAL_S24_To_F32(src);
+    }
+
+    FAudio_assert(!i || ((((size_t) dst) & 15) == 0));
+
+    {
+        /* Each pass uses 12 bytes but loads 16, so stop before we overread the end. */
+        const __m128 divby8388607 = _mm_set1_ps(DIVBY8388607);
+        while (i >= 6) {   /* 4 * sint24, plus 4 bytes of slack */
+            const __m128i bytes = _mm_loadu_si128((__m128i const *) src);
+            /* Shift each sample down to the bottom of the register, then interleave them into their own int32 lanes. */
+            const __m128i ab = _mm_unpacklo_epi32(bytes, _mm_srli_si128(bytes, 3));
+            const __m128i cd = _mm_unpacklo_epi32(_mm_srli_si128(bytes, 6), _mm_srli_si128(bytes, 9));
+            /* Each lane has a junk top byte; shift it out, then back with sign-extend. Now sint32. */
+            const __m128i ints = _mm_srai_epi32(_mm_slli_epi32(_mm_unpacklo_epi64(ab, cd), 8), 8);
+            _mm_store_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(ints), divby8388607));
+            i -= 4; src += 12; dst += 4;
+        }
+    }
+
+    /* Finish off any leftovers with scalar operations. */
+    while (i) {
+        *dst = FAudio_INTERNAL_S24_To_F32(src);
+        i--; src += 3; dst++;
+    }
+}
 #endif /* HAVE_SSE2_INTRINSICS */
 
 #if HAVE_NEON_INTRINSICS
@@ -321,9 +379,9 @@ void FAudio_INTERNAL_Convert_S16_To_F32_NEON(
     src -= 7; dst -= 7;  /* adjust to read NEON blocks from the start. */
     FAudio_assert(!i || ((((size_t) dst) & 15) == 0));
 
-    /* Make sure src is aligned too. */
-    if ((((size_t) src) & 15) == 0) {
-        /* Aligned! Do NEON blocks as long as we have 16 bytes available. */
+    /* vld1q_s16 doesn't need src to be aligned. */
+    {
+        /* Do NEON blocks as long as we have 16 bytes available. */
         const float32x4_t divby32768 = vdupq_n_f32(DIVBY32768);
         while (i >= 8) {   /* 8 * 16-bit */
             const int16x8_t ints = vld1q_s16((int16_t const *) src);  /* get 8 sint16 into a NEON register. */
@@ -376,6 +434,48 @@ void FAudio_INTERNAL_Convert_S32_To_F32_NEON(
         i--; src++; dst++;
     }
 }
+
+void FAudio_INTERNAL_Convert_S24_To_F32_NEON(
+	const uint8_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+) {
+    int i;
+
+    /* Get dst aligned to 16 bytes */
+    for (i = len; i && (((size_t) dst) & 15); --i, src += 3, ++dst) {
+        *dst = FAudio_INTERNAL_S24_To_F32(src);
+    }
+
+    FAudio_assert(!i || ((((size_t) dst) & 15) == 0));
+
+    {
+        const float32x4_t divby8388607 = vdupq_n_f32(DIVBY8388607);
+        while (i >= 16) {   /* 16 * sint24 */
+            /* De-interleave into low, middle and high bytes. */
+            const uint8x16x3_t bytes = vld3q_u8(src);
+            /* Low 16 bits unsigned, high 8 bits signed, so the sign extends when widening. */
+            const uint16x8_t lo0 = vorrq_u16(vmovl_u8(vget_low_u8(bytes.val[0])), vshll_n_u8(vget_low_u8(bytes.val[1]), 8));
+            const uint16x8_t lo1 = vorrq_u16(vmovl_u8(vget_high_u8(bytes.val[0])), vshll_n_u8(vget_high_u8(bytes.val[1]), 8));
+            const int16x8_t hi0 = vmovl_s8(vget_low_s8(vreinterpretq_s8_u8(bytes.val[2])));
+            const int16x8_t hi1 = vmovl_s8(vget_high_s8(vreinterpretq_s8_u8(bytes.val[2])));
+            #define CONVERT_S24(lo, hi) \
+                vmulq_f32(vcvtq_f32_s32(vorrq_s32(vshll_n_s16(hi, 16), vreinterpretq_s32_u32(vmovl_u16(lo)))), divby8388607)
+            vst1q_f32(dst, CONVERT_S24(vget_low_u16(lo0), vget_low_s16(hi0)));
+            vst1q_f32(dst+4, CONVERT_S24(vget_high_u16(lo0), vget_high_s16(hi0)));
+            vst1q_f32(dst+8, CONVERT_S24(vget_low_u16(lo1), vget_low_s16(hi1)));
+            vst1q_f32(dst+12, CONVERT_S24(vget_high_u16(lo1), vget_high_s16(hi1)));
+            #undef CONVERT_S24
+            i -= 16; src += 48; dst += 16;
+        }
+    }
+
+    /* Finish off any leftovers with scalar operations. */
+    while (i) {
+        *dst = FAudio_INTERNAL_S24_To_F32(src);
+        i--; src += 3; dst++;
+    }
+}
 #endif /* HAVE_NEON_INTRINSICS */
 
 /* SECTION 2: Linear Resamplers */
@@ -1543,7 +1643,108 @@ void FAudio_INTERNAL_Mix_2in_8out_Scalar(
 	}
 }
 
-/* SECTION 5: InitSIMDFunctions. Assigns based on SSE2/NEON support. */
+/* SECTION 5: Byte Swapping, for big-endian (Xbox 360) content */
+
+#if NEED_SCALAR_CONVERTER_FALLBACKS
+void FAudio_INTERNAL_SwapBE16_Scalar(uint16_t *data, uint32_t len)
+{
+	uint32_t i;
+	for (i = 0; i < len; i += 1)
+	{
+		data[i] = FAudio_swap16BE(data[i]);
+	}
+}
+
+void FAudio_INTERNAL_SwapBE32_Scalar(uint32_t *data, uint32_t len)
+{
+	uint32_t i;
+	for (i = 0; i < len; i += 1)
+	{
+		data[i] = FAudio_swap32BE(data[i]);
+	}
+}
+#endif /* NEED_SCALAR_CONVERTER_FALLBACKS */
+
+#if HAVE_SSE2_INTRINSICS
+static inline __m128i FAudio_INTERNAL_Swap16_SSE2(__m128i v)
+{
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+void FAudio_INTERNAL_SwapBE16_SSE2(uint16_t *data, uint32_t len)
+{
+	uint32_t i;
+	__m128i v;
+
+	for (i = 0; (i + 8) <= len; i += 8)
+	{
+		v = _mm_loadu_si128((__m128i*) (data + i));
+		_mm_storeu_si128((__m128i*) (data + i), FAudio_INTERNAL_Swap16_SSE2(v));
+	}
+	for (; i < len; i += 1)
+	{
+		data[i] = FAudio_swap16BE(data[i]);
+	}
+}
+
+void FAudio_INTERNAL_SwapBE32_SSE2(uint32_t *data, uint32_t len)
+{
+	uint32_t i;
+	__m128i v;
+
+	for (i = 0; (i + 4) <= len; i += 4)
+	{
+		v = _mm_loadu_si128((__m128i*) (data + i));
+
+		/* Swap the 16-bit halves, then the bytes in each half */
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_si128((__m128i*) (data + i), FAudio_INTERNAL_Swap16_SSE2(v));
+	}
+	for (; i < len; i += 1)
+	{
+		data[i] = FAudio_swap32BE(data[i]);
+	}
+}
+#endif /* HAVE_SSE2_INTRINSICS */
+
+#if HAVE_NEON_INTRINSICS
+void FAudio_INTERNAL_SwapBE16_NEON(uint16_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; (i + 8) <= len; i += 8)
+	{
+		vst1q_u8(
+			(uint8_t*) (data + i),
+			vrev16q_u8(vld1q_u8((uint8_t*) (data + i)))
+		);
+	}
+	for (; i < len; i += 1)
+	{
+		data[i] = FAudio_swap16BE(data[i]);
+	}
+}
+
+void FAudio_INTERNAL_SwapBE32_NEON(uint32_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; (i + 4) <= len; i += 4)
+	{
+		vst1q_u8(
+			(uint8_t*) (data + i),
+			vrev32q_u8(vld1q_u8((uint8_t*) (data + i)))
+		);
+	}
+	for (; i < len; i += 1)
+	{
+		data[i] = FAudio_swap32BE(data[i]);
+	}
+}
+#endif /* HAVE_NEON_INTRINSICS */
+
+/* SECTION 6: InitSIMDFunctions. Assigns based on SSE2/NEON support. */
 
 void (*FAudio_INTERNAL_Convert_U8_To_F32)(
 	const uint8_t *restrict src,
@@ -1555,6 +1756,11 @@ void (*FAudio_INTERNAL_Convert_S16_To_F32)(
 	float *restrict dst,
 	uint32_t len
 );
+void (*FAudio_INTERNAL_Convert_S24_To_F32)(
+	const uint8_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+);
 void (*FAudio_INTERNAL_Convert_S32_To_F32)(
 	const int32_t *restrict src,
 	float *restrict dst,
@@ -1572,6 +1778,9 @@ void (*FAudio_INTERNAL_Amplify)(
 
 FAudioMixCallback FAudio_INTERNAL_Mix_Generic;
 
+void (*FAudio_INTERNAL_SwapBE16)(uint16_t *data, uint32_t len);
+void (*FAudio_INTERNAL_SwapBE32)(uint32_t *data, uint32_t len);
+
 void FAudio_INTERNAL_InitSIMDFunctions(uint8_t hasSSE2, uint8_t hasNEON)
 {
 #if HAVE_SSE2_INTRINSICS
@@ -1579,11 +1788,14 @@ void FAudio_INTERNAL_InitSIMDFunctions(uint8_t hasSSE2, uint8_t hasNEON)
 	{
 		FAudio_INTERNAL_Convert_U8_To_F32 = FAudio_INTERNAL_Convert_U8_To_F32_SSE2;
 		FAudio_INTERNAL_Convert_S16_To_F32 = FAudio_INTERNAL_Convert_S16_To_F32_SSE2;
+		FAudio_INTERNAL_Convert_S24_To_F32 = FAudio_INTERNAL_Convert_S24_To_F32_SSE2;
 		FAudio_INTERNAL_Convert_S32_To_F32 = FAudio_INTERNAL_Convert_S32_To_F32_SSE2;
 		FAudio_INTERNAL_ResampleMono = FAudio_INTERNAL_ResampleMono_SSE2;
 		FAudio_INTERNAL_ResampleStereo = FAudio_INTERNAL_ResampleStereo_SSE2;
 		FAudio_INTERNAL_Amplify = FAudio_INTERNAL_Amplify_SSE2;
 		FAudio_INTERNAL_Mix_Generic = FAudio_INTERNAL_Mix_Generic_SSE2;
+		FAudio_INTERNAL_SwapBE16 = FAudio_INTERNAL_SwapBE16_SSE2;
+		FAudio_INTERNAL_SwapBE32 = FAudio_INTERNAL_SwapBE32_SSE2;
 		return;
 	}
 #endif
@@ -1592,22 +1804,28 @@ void FAudio_INTERNAL_InitSIMDFunctions(uint8_t hasSSE2, uint8_t hasNEON)
 	{
 		FAudio_INTERNAL_Convert_U8_To_F32 = FAudio_INTERNAL_Convert_U8_To_F32_NEON;
 		FAudio_INTERNAL_Convert_S16_To_F32 = FAudio_INTERNAL_Convert_S16_To_F32_NEON;
+		FAudio_INTERNAL_Convert_S24_To_F32 = FAudio_INTERNAL_Convert_S24_To_F32_NEON;
 		FAudio_INTERNAL_Convert_S32_To_F32 = FAudio_INTERNAL_Convert_S32_To_F32_NEON;
 		FAudio_INTERNAL_ResampleMono = FAudio_INTERNAL_ResampleMono_NEON;
 		FAudio_INTERNAL_ResampleStereo = FAudio_INTERNAL_ResampleStereo_NEON;
 		FAudio_INTERNAL_Amplify = FAudio_INTERNAL_Amplify_NEON;
 		FAudio_INTERNAL_Mix_Generic = FAudio_INTERNAL_Mix_Generic_Scalar;
+		FAudio_INTERNAL_SwapBE16 = FAudio_INTERNAL_SwapBE16_NEON;
+		FAudio_INTERNAL_SwapBE32 = FAudio_INTERNAL_SwapBE32_NEON;
 		return;
 	}
 #endif
 #if NEED_SCALAR_CONVERTER_FALLBACKS
 	FAudio_INTERNAL_Convert_U8_To_F32 = FAudio_INTERNAL_Convert_U8_To_F32_Scalar;
 	FAudio_INTERNAL_Convert_S16_To_F32 = FAudio_INTERNAL_Convert_S16_To_F32_Scalar;
+	FAudio_INTERNAL_Convert_S24_To_F32 = FAudio_INTERNAL_Convert_S24_To_F32_Scalar;
 	FAudio_INTERNAL_Convert_S32_To_F32 = FAudio_INTERNAL_Convert_S32_To_F32_Scalar;
 	FAudio_INTERNAL_ResampleMono = FAudio_INTERNAL_ResampleMono_Scalar;
 	FAudio_INTERNAL_ResampleStereo = FAudio_INTERNAL_ResampleStereo_Scalar;
 	FAudio_INTERNAL_Amplify = FAudio_INTERNAL_Amplify_Scalar;
 	FAudio_INTERNAL_Mix_Generic = FAudio_INTERNAL_Mix_Generic_Scalar;
+	FAudio_INTERNAL_SwapBE16 = FAudio_INTERNAL_SwapBE16_Scalar;
+	FAudio_INTERNAL_SwapBE32 = FAudio_INTERNAL_SwapBE32_Scalar;
 #else
 	FAudio_assert(0 && "Need converter functions!");
 #endif
@@ -30,6 +30,16 @@
 
 #include <SDL.h>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #if !SDL_VERSION_ATLEAST(2, 24, 0)
 #error "SDL version older than 2.24.0"
 #endif /* !SDL_VERSION_ATLEAST */
@@ -394,6 +404,45 @@ void FAudio_PlatformUnlockMutex(FAudioMutex mutex)
 	SDL_UnlockMutex((SDL_mutex*) mutex);
 }
 
+FAudioSemaphore FAudio_PlatformCreateSemaphore(uint32_t initialValue)
+{
+	return (FAudioSemaphore) SDL_CreateSemaphore(initialValue);
+}
+
+void FAudio_PlatformDestroySemaphore(FAudioSemaphore sem)
+{
+	SDL_DestroySemaphore((SDL_sem*) sem);
+}
+
+void FAudio_PlatformSignalSemaphore(FAudioSemaphore sem)
+{
+	SDL_SemPost((SDL_sem*) sem);
+}
+
+uint8_t FAudio_PlatformWaitSemaphore(FAudioSemaphore sem, int32_t timeoutMS)
+{
+	if (timeoutMS < 0)
+	{
+		return SDL_SemWait((SDL_sem*) sem) == 0;
+	}
+	return SDL_SemWaitTimeout((SDL_sem*) sem, (Uint32) timeoutMS) == 0;
+}
+
+uint32_t FAudio_PlatformAtomicGet(uint32_t *ptr)
+{
+	return (uint32_t) SDL_AtomicGet((SDL_atomic_t*) ptr);
+}
+
+void FAudio_PlatformAtomicSet(uint32_t *ptr, uint32_t value)
+{
+	SDL_AtomicSet((SDL_atomic_t*) ptr, (int) value);
+}
+
+uint32_t FAudio_PlatformAtomicExchange(uint32_t *ptr, uint32_t value)
+{
+	return (uint32_t) SDL_AtomicSet((SDL_atomic_t*) ptr, (int) value);
+}
+
 void FAudio_sleep(uint32_t ms)
 {
 	SDL_Delay(ms);
@@ -414,6 +463,11 @@ FAudioIOStream* FAudio_fopen(const char *path)
 		sizeof(FAudioIOStream)
 	);
 	SDL_RWops *rwops = SDL_RWFromFile(path, "rb");
+	if (rwops == NULL)
+	{
+		FAudio_free(io);
+		return NULL;
+	}
 	io->data = rwops;
 	io->read = (FAudio_readfunc) rwops->read;
 	io->seek = (FAudio_seekfunc) rwops->seek;
@@ -450,6 +504,145 @@ void FAudio_close(FAudioIOStream *io)
 	FAudio_free(io);
 }
 
+/* Maps the file copy-on-write, so that in-place fixups (like swapping
+ * big-endian PCM) stay private to this process
+ */
+static void* FAudio_INTERNAL_mapfile(const char *path, size_t *size)
+{
+#if defined(_WIN32)
+	HANDLE file, mapping;
+	LARGE_INTEGER fileSize;
+	WCHAR *wpath;
+	void *mem;
+	int len;
+
+	len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+	if (len == 0)
+	{
+		return NULL;
+	}
+	wpath = (WCHAR*) FAudio_malloc(len * sizeof(WCHAR));
+	MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+	file = CreateFileW(
+		wpath,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL
+	);
+	FAudio_free(wpath);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+	mapping = CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+	{
+		return NULL;
+	}
+	mem = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping); /* The view keeps it alive */
+	*size = (size_t) fileSize.QuadPart;
+	return mem;
+#elif defined(__unix__) || defined(__APPLE__)
+	struct stat st;
+	void *mem;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	mem = mmap(
+		NULL,
+		(size_t) st.st_size,
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE,
+		fd,
+		0
+	);
+	close(fd); /* The mapping keeps it alive */
+	if (mem == MAP_FAILED)
+	{
+		return NULL;
+	}
+	*size = (size_t) st.st_size;
+	return mem;
+#else
+	/* No mmap here, just read the whole thing */
+	return SDL_LoadFile(path, size);
+#endif
+}
+
+static void FAudio_INTERNAL_unmapfile(void *mem, size_t size)
+{
+#if defined(_WIN32)
+	UnmapViewOfFile(mem);
+#elif defined(__unix__) || defined(__APPLE__)
+	munmap(mem, size);
+#else
+	SDL_free(mem);
+#endif
+}
+
+static int FAUDIOCALL FAudio_INTERNAL_mapclose(
+	void *data
+) {
+	SDL_RWops *rwops = (SDL_RWops*) data;
+	void *mem = rwops->hidden.mem.base;
+	size_t size = rwops->hidden.mem.stop - rwops->hidden.mem.base;
+	int result = rwops->close(rwops);
+	FAudio_INTERNAL_unmapfile(mem, size);
+	return result;
+}
+
+FAudioIOStream* FAudio_PlatformMapFile(const char *path)
+{
+	FAudioIOStream *io;
+	SDL_RWops *rwops;
+	size_t size;
+	void *mem;
+
+	mem = FAudio_INTERNAL_mapfile(path, &size);
+	if (mem == NULL)
+	{
+		return NULL;
+	}
+	if (size > SDL_MAX_SINT32)
+	{
+		/* SDL_RWFromMem can't go past 2GB */
+		FAudio_INTERNAL_unmapfile(mem, size);
+		return NULL;
+	}
+	rwops = SDL_RWFromMem(mem, (int) size);
+	if (rwops == NULL)
+	{
+		FAudio_INTERNAL_unmapfile(mem, size);
+		return NULL;
+	}
+	io = (FAudioIOStream*) FAudio_malloc(sizeof(FAudioIOStream));
+	io->data = rwops;
+	io->read = (FAudio_readfunc) rwops->read;
+	io->seek = (FAudio_seekfunc) rwops->seek;
+	io->close = FAudio_INTERNAL_mapclose;
+	io->lock = FAudio_PlatformCreateMutex();
+	return io;
+}
+
 #ifdef FAUDIO_DUMP_VOICES
 FAudioIOStreamOut* FAudio_fopen_out(const char *path, const char *mode)
 {
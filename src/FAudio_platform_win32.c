@@ -712,6 +712,44 @@ void FAudio_PlatformDestroyMutex(FAudioMutex mutex)
 	FAudio_free(mutex);
 }
 
+FAudioSemaphore FAudio_PlatformCreateSemaphore(uint32_t initialValue)
+{
+	return CreateSemaphoreW(NULL, initialValue, LONG_MAX, NULL);
+}
+
+void FAudio_PlatformDestroySemaphore(FAudioSemaphore sem)
+{
+	if (sem) CloseHandle(sem);
+}
+
+void FAudio_PlatformSignalSemaphore(FAudioSemaphore sem)
+{
+	if (sem) ReleaseSemaphore(sem, 1, NULL);
+}
+
+uint8_t FAudio_PlatformWaitSemaphore(FAudioSemaphore sem, int32_t timeoutMS)
+{
+	return WaitForSingleObject(
+		sem,
+		(timeoutMS < 0) ? INFINITE : (DWORD) timeoutMS
+	) == WAIT_OBJECT_0;
+}
+
+uint32_t FAudio_PlatformAtomicGet(uint32_t *ptr)
+{
+	return (uint32_t) InterlockedCompareExchange((LONG volatile*) ptr, 0, 0);
+}
+
+void FAudio_PlatformAtomicSet(uint32_t *ptr, uint32_t value)
+{
+	InterlockedExchange((LONG volatile*) ptr, (LONG) value);
+}
+
+uint32_t FAudio_PlatformAtomicExchange(uint32_t *ptr, uint32_t value)
+{
+	return (uint32_t) InterlockedExchange((LONG volatile*) ptr, (LONG) value);
+}
+
 struct FAudioThreadArgs
 {
 	FAudioThreadFunc func;
@@ -924,6 +962,69 @@ void FAudio_close(FAudioIOStream *io)
 	FAudio_free(io);
 }
 
+static int FAUDIOCALL FAudio_map_close(void *data)
+{
+	struct FAudio_mem *io = data;
+	if (!data) return 0;
+	UnmapViewOfFile(io->mem);
+	FAudio_free(data);
+	return 0;
+}
+
+FAudioIOStream* FAudio_PlatformMapFile(const char *path)
+{
+	HANDLE file, mapping;
+	LARGE_INTEGER size;
+	FAudioIOStream *io;
+	struct FAudio_mem *data;
+	WCHAR *wpath;
+	void *mem;
+	int len;
+
+	len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+	if (len == 0) return NULL;
+	wpath = FAudio_malloc(len * sizeof(WCHAR));
+	if (!wpath) return NULL;
+	MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+
+	file = CreateFileW(
+		wpath,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL
+	);
+	FAudio_free(wpath);
+	if (file == INVALID_HANDLE_VALUE) return NULL;
+
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+
+	/* Copy-on-write, in case we have to swap big-endian PCM in place */
+	mapping = CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping) return NULL;
+	mem = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!mem) return NULL;
+
+	io = FAudio_memopen(mem, 0);
+	if (!io)
+	{
+		UnmapViewOfFile(mem);
+		return NULL;
+	}
+	data = io->data;
+	data->len = size.QuadPart;
+	io->close = FAudio_map_close;
+	return io;
+}
+
 /* XNA Song implementation over Win32 MF */
 
 static FAudioWaveFormatEx activeSongFormat;
@@ -937,6 +1038,17 @@ static FAudioMasteringVoice *songMaster = NULL;
 
 static FAudioSourceVoice *songVoice = NULL;
 static FAudioVoiceCallback callbacks;
+static uint8_t songPaused = 0;
+
+/* Started from XNA_GetSongEnded, so this path isn't gapless */
+static char *songQueuedName = NULL;
+
+/* Media Foundation seeks land near the requested time, not on it, so the
+ * position is taken from the timestamp of the first sample read after a seek.
+ */
+static UINT64 songDuration = 0;
+static UINT64 songSeekBase = 0;
+static uint8_t songSeeking = 0;
 
 /* Internal Functions */
 
@@ -948,6 +1060,7 @@ static void XNA_SongSubmitBuffer(FAudioVoiceCallback *callback, void *pBufferCon
 	HRESULT hr;
 	DWORD flags, buffer_size = 0;
 	BYTE *buffer_ptr;
+	LONGLONG timestamp;
 
 	LOG_FUNC_ENTER(songAudio);
 
@@ -959,11 +1072,22 @@ static void XNA_SongSubmitBuffer(FAudioVoiceCallback *callback, void *pBufferCon
 		0,
 		NULL,
 		&flags,
-		NULL,
+		&timestamp,
 		&sample
 	);
 	FAudio_assert(!FAILED(hr) && "Failed to read audio sample!");
 
+	if (songSeeking)
+	{
+		songSeeking = 0;
+		if (!(flags & MF_SOURCE_READERF_ENDOFSTREAM))
+		{
+			songSeekBase = (UINT64) timestamp *
+				activeSongFormat.nSamplesPerSec /
+				10000000;
+		}
+	}
+
 	if (flags & MF_SOURCE_READERF_ENDOFSTREAM)
 	{
 		buffer.Flags = FAUDIO_END_OF_STREAM;
@@ -1019,7 +1143,31 @@ static void XNA_SongSubmitBuffer(FAudioVoiceCallback *callback, void *pBufferCon
 	LOG_FUNC_EXIT(songAudio);
 }
 
-static void XNA_SongKill()
+static void XNA_SongStartVoice()
+{
+	FAudio_zero(&callbacks, sizeof(FAudioVoiceCallback));
+	callbacks.OnBufferEnd = XNA_SongSubmitBuffer;
+	FAudio_CreateSourceVoice(
+		songAudio,
+		&songVoice,
+		&activeSongFormat,
+		0,
+		1.0f, /* No pitch shifting here! */
+		&callbacks,
+		NULL,
+		NULL
+	);
+	FAudioVoice_SetVolume(songVoice, songVolume, 0);
+	XNA_SongSubmitBuffer(NULL, NULL);
+
+	/* Finally. */
+	if (!songPaused)
+	{
+		FAudioSourceVoice_Start(songVoice, 0, 0);
+	}
+}
+
+static void XNA_SongStopVoice()
 {
 	if (songVoice != NULL)
 	{
@@ -1027,6 +1175,11 @@ static void XNA_SongKill()
 		FAudioVoice_DestroyVoice(songVoice);
 		songVoice = NULL;
 	}
+}
+
+static void XNA_SongKill()
+{
+	XNA_SongStopVoice();
 	if (activeSong)
 	{
 		IMFSourceReader_Release(activeSong);
@@ -1035,6 +1188,8 @@ static void XNA_SongKill()
 	FAudio_free(songBuffer);
 	songBuffer = NULL;
 	songBufferSize = 0;
+	FAudio_free(songQueuedName);
+	songQueuedName = NULL;
 }
 
 /* "Public" API */
@@ -1160,24 +1315,11 @@ FAUDIOAPI float XNA_PlaySong(const char *name)
 	activeSongFormat.nAvgBytesPerSec = activeSongFormat.nSamplesPerSec * activeSongFormat.nBlockAlign;
 	activeSongFormat.cbSize = 0;
 
-	/* Init voice */
-	FAudio_zero(&callbacks, sizeof(FAudioVoiceCallback));
-	callbacks.OnBufferEnd = XNA_SongSubmitBuffer;
-	FAudio_CreateSourceVoice(
-		songAudio,
-		&songVoice,
-		&activeSongFormat,
-		0,
-		1.0f, /* No pitch shifting here! */
-		&callbacks,
-		NULL,
-		NULL
-	);
-	FAudioVoice_SetVolume(songVoice, songVolume, 0);
-	XNA_SongSubmitBuffer(NULL, NULL);
-
-	/* Finally. */
-	FAudioSourceVoice_Start(songVoice, 0, 0);
+	songDuration = duration;
+	songSeekBase = 0;
+	songSeeking = 0;
+	songPaused = 0;
+	XNA_SongStartVoice();
 	LOG_FUNC_EXIT(songAudio);
 	return (float)(duration / 10000000.);
 }
@@ -1188,6 +1330,7 @@ FAUDIOAPI void XNA_PauseSong()
 	{
 		return;
 	}
+	songPaused = 1;
 	FAudioSourceVoice_Stop(songVoice, 0, 0);
 }
 
@@ -1197,6 +1340,7 @@ FAUDIOAPI void XNA_ResumeSong()
 	{
 		return;
 	}
+	songPaused = 0;
 	FAudioSourceVoice_Start(songVoice, 0, 0);
 }
 
@@ -1205,6 +1349,78 @@ FAUDIOAPI void XNA_StopSong()
 	XNA_SongKill();
 }
 
+FAUDIOAPI uint32_t XNA_QueueSongEXT(const char *name)
+{
+	size_t len;
+
+	if (songVoice == NULL)
+	{
+		XNA_PlaySong(name);
+		return (songVoice != NULL) ? 0 : FAUDIO_E_INVALID_CALL;
+	}
+
+	/* The queued song gets a voice of its own, so any format will do */
+	len = FAudio_strlen(name) + 1;
+	FAudio_free(songQueuedName);
+	songQueuedName = (char*) FAudio_malloc(len);
+	FAudio_memcpy(songQueuedName, name, len);
+	return 0;
+}
+
+FAUDIOAPI void XNA_SetSongPositionEXT(float seconds)
+{
+	PROPVARIANT var;
+	UINT64 position;
+	HRESULT hr;
+
+	if (songVoice == NULL)
+	{
+		return;
+	}
+
+	/* In 100ns units, like MF_PD_DURATION */
+	if (seconds <= 0.0f)
+	{
+		position = 0;
+	}
+	else
+	{
+		position = (UINT64) FAudio_min(
+			(double) seconds * 10000000.0,
+			(double) songDuration
+		);
+	}
+
+	/* The buffer in flight is thrown away, so start a new voice */
+	XNA_SongStopVoice();
+
+	hr = InitPropVariantFromInt64((LONGLONG) position, &var);
+	FAudio_assert(!FAILED(hr) && "Failed to set song position!");
+	hr = IMFSourceReader_SetCurrentPosition(activeSong, &GUID_NULL, &var);
+	FAudio_assert(!FAILED(hr) && "Failed to set song position!");
+	PropVariantClear(&var);
+
+	songSeekBase = position * activeSongFormat.nSamplesPerSec / 10000000;
+	songSeeking = 1;
+	XNA_SongStartVoice();
+}
+
+FAUDIOAPI float XNA_GetSongPositionEXT()
+{
+	FAudioVoiceState state;
+	if (songVoice == NULL)
+	{
+		return 0.0f;
+	}
+	FAudioSourceVoice_GetState(songVoice, &state, 0);
+	return (songSeekBase + state.SamplesPlayed) / (float) activeSongFormat.nSamplesPerSec;
+}
+
+FAUDIOAPI void XNA_SetSongDecodeAheadEXT(uint32_t milliseconds)
+{
+	/* Media Foundation decides how far ahead it reads */
+}
+
 FAUDIOAPI void XNA_SetSongVolume(float volume)
 {
 	songVolume = volume;
@@ -1217,12 +1433,25 @@ FAUDIOAPI void XNA_SetSongVolume(float volume)
 FAUDIOAPI uint32_t XNA_GetSongEnded()
 {
 	FAudioVoiceState state;
+	char *name;
 	if (songVoice == NULL || activeSong == NULL)
 	{
 		return 1;
 	}
 	FAudioSourceVoice_GetState(songVoice, &state, 0);
-	return state.BuffersQueued == 0 && state.SamplesPlayed == 0;
+	if (state.BuffersQueued == 0 && state.SamplesPlayed == 0)
+	{
+		if (songQueuedName != NULL)
+		{
+			name = songQueuedName;
+			songQueuedName = NULL;
+			XNA_PlaySong(name);
+			FAudio_free(name);
+			return 0;
+		}
+		return 1;
+	}
+	return 0;
 }
 
 FAUDIOAPI void XNA_EnableVisualization(uint32_t enable)
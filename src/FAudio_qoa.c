@@ -0,0 +1,411 @@
+/* FAudio - XAudio Reimplementation for FNA
+ *
+ * Copyright (c) 2011-2024 Ethan Lee, Luigi Auriemma, and the MonoGame Team
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Ethan "flibitijibibo" Lee <flibitijibibo@flibitijibibo.com>
+ *
+ */
+
+#include "FAudio_internal.h"
+
+/* qoa_decoder */
+
+#define malloc FAudio_malloc
+#define free FAudio_free
+
+#define FILE FAudioIOStream
+#ifdef SEEK_SET
+#undef SEEK_SET
+#endif
+#ifdef SEEK_END
+#undef SEEK_END
+#endif
+#define SEEK_SET FAUDIO_SEEK_SET
+#define SEEK_END FAUDIO_SEEK_END
+#define fopen(path, mode) FAudio_fopen(path)
+#define fclose(io) FAudio_close(io)
+#define fread(dst, size, count, io) io->read(io->data, dst, size, count)
+#define fseek(io, offset, whence) io->seek(io->data, offset, whence)
+#define ftell(io) io->seek(io->data, 0, FAUDIO_SEEK_CUR)
+
+#include "qoa_decoder.h"
+
+/* QOA Source Voices */
+
+/* Each frame is one block: a header, the LMS state of every channel, then up
+ * to 256 groups of slices, one 20-sample slice per channel in each group.
+ */
+#define QOA_FRAME_HEADER_SIZE(channels) (8 + QOA_LMS_LEN * 4 * (channels))
+#define QOA_GROUP_SIZE(channels) (8 * (channels))
+
+typedef struct FAudioQOALMS
+{
+	/* Channels are innermost, so that predicting one sample for every
+	 * channel is the same operation across adjacent values.
+	 */
+	int32_t history[QOA_LMS_LEN][QOA_MAX_CHANNELS];
+	int32_t weights[QOA_LMS_LEN][QOA_MAX_CHANNELS];
+} FAudioQOALMS;
+
+struct FAudioQOA
+{
+	/* The frame the mixer is in, how many slice groups of it have been
+	 * decoded, and the LMS state after the last of them
+	 */
+	const uint8_t *frame;
+	uint32_t slice;
+	FAudioQOALMS lms;
+
+	/* The last two slice groups, interleaved. The mixer reads the
+	 * resampler padding again on the next update, and keeping these
+	 * around means that never has to go back to the start of the frame.
+	 */
+	int16_t samples[2][QOA_SLICE_LEN * QOA_MAX_CHANNELS];
+};
+
+static inline uint16_t FAudio_QOA_read16(const uint8_t *bytes)
+{
+	return (uint16_t) ((bytes[0] << 8) | bytes[1]);
+}
+
+static inline uint64_t FAudio_QOA_read64(const uint8_t *bytes)
+{
+	return (
+		((uint64_t) bytes[0] << 56) |
+		((uint64_t) bytes[1] << 48) |
+		((uint64_t) bytes[2] << 40) |
+		((uint64_t) bytes[3] << 32) |
+		((uint64_t) bytes[4] << 24) |
+		((uint64_t) bytes[5] << 16) |
+		((uint64_t) bytes[6] << 8) |
+		((uint64_t) bytes[7])
+	);
+}
+
+static void FAudio_QOA_load_lms(
+	FAudioQOALMS *lms,
+	const uint8_t *frame,
+	uint16_t channels
+) {
+	const uint8_t *state = frame + 8;
+	uint32_t c, i;
+
+	for (c = 0; c < channels; c += 1)
+	{
+		for (i = 0; i < QOA_LMS_LEN; i += 1)
+		{
+			lms->history[i][c] = (int16_t) FAudio_QOA_read16(
+				state + (i * 2)
+			);
+			lms->weights[i][c] = (int16_t) FAudio_QOA_read16(
+				state + (QOA_LMS_LEN * 2) + (i * 2)
+			);
+		}
+		state += QOA_LMS_LEN * 4;
+	}
+}
+
+static void FAudio_QOA_decode_group(
+	FAudioQOALMS *restrict lms,
+	const uint8_t *group,
+	uint16_t channels,
+	uint32_t count,
+	int16_t *restrict dst
+) {
+	uint64_t residuals[QOA_MAX_CHANNELS];
+	const int *dequant[QOA_MAX_CHANNELS];
+	int32_t predicted, dequantized, reconstructed, delta;
+	uint32_t i, c;
+
+	for (c = 0; c < channels; c += 1)
+	{
+		residuals[c] = FAudio_QOA_read64(group + (c * 8));
+		dequant[c] = qoa_dequant_tab[residuals[c] >> 60];
+		residuals[c] <<= 4;
+	}
+
+	for (i = 0; i < count; i += 1)
+	{
+		for (c = 0; c < channels; c += 1)
+		{
+			predicted = (
+				lms->weights[0][c] * lms->history[0][c] +
+				lms->weights[1][c] * lms->history[1][c] +
+				lms->weights[2][c] * lms->history[2][c] +
+				lms->weights[3][c] * lms->history[3][c]
+			) >> 13;
+			dequantized = dequant[c][residuals[c] >> 61];
+			residuals[c] <<= 3;
+			reconstructed = qoa_clamp_s16(predicted + dequantized);
+
+			delta = dequantized >> 4;
+			lms->weights[0][c] += (lms->history[0][c] < 0) ? -delta : delta;
+			lms->weights[1][c] += (lms->history[1][c] < 0) ? -delta : delta;
+			lms->weights[2][c] += (lms->history[2][c] < 0) ? -delta : delta;
+			lms->weights[3][c] += (lms->history[3][c] < 0) ? -delta : delta;
+			lms->history[0][c] = lms->history[1][c];
+			lms->history[1][c] = lms->history[2][c];
+			lms->history[2][c] = lms->history[3][c];
+			lms->history[3][c] = reconstructed;
+
+			*dst++ = (int16_t) reconstructed;
+		}
+	}
+}
+
+static void FAudio_QOA_decode_frame(
+	struct FAudioQOA *impl,
+	const uint8_t *frame,
+	uint16_t channels,
+	float *dst,
+	uint32_t offset,
+	uint32_t count
+) {
+	const uint8_t *groups = frame + QOA_FRAME_HEADER_SIZE(channels);
+	const uint32_t frameSamples = FAudio_QOA_read16(frame + 4);
+	const uint32_t last = offset + count;
+	const uint32_t end = FAudio_min(last, frameSamples);
+	int16_t scratch[QOA_SLICE_LEN * QOA_MAX_CHANNELS];
+	FAudioQOALMS lms;
+	uint32_t slice, start, copy;
+
+	if (offset == 0 && end == frameSamples)
+	{
+		/* Whole frames don't need the cache, so leave it as it is. This
+		 * is also what the decode-ahead thread asks for, so the mixer's
+		 * position survives it.
+		 */
+		FAudio_QOA_load_lms(&lms, frame, channels);
+		for (start = 0; start < end; start += QOA_SLICE_LEN)
+		{
+			copy = FAudio_min(QOA_SLICE_LEN, end - start);
+			FAudio_QOA_decode_group(
+				&lms,
+				groups + ((start / QOA_SLICE_LEN) * QOA_GROUP_SIZE(channels)),
+				channels,
+				copy,
+				scratch
+			);
+			FAudio_INTERNAL_Convert_S16_To_F32(
+				scratch,
+				dst,
+				copy * channels
+			);
+			dst += copy * channels;
+		}
+		offset = end;
+	}
+
+	while (offset < end)
+	{
+		slice = offset / QOA_SLICE_LEN;
+
+		/* PlayBegin, LoopBegin or a new frame, start from its header */
+		if (impl->frame != frame || slice + 2 < impl->slice)
+		{
+			impl->frame = frame;
+			impl->slice = 0;
+			FAudio_QOA_load_lms(&impl->lms, frame, channels);
+		}
+
+		while (impl->slice <= slice)
+		{
+			FAudio_QOA_decode_group(
+				&impl->lms,
+				groups + (impl->slice * QOA_GROUP_SIZE(channels)),
+				channels,
+				FAudio_min(
+					QOA_SLICE_LEN,
+					frameSamples - (impl->slice * QOA_SLICE_LEN)
+				),
+				impl->samples[impl->slice & 1]
+			);
+			impl->slice += 1;
+		}
+
+		start = offset - (slice * QOA_SLICE_LEN);
+		copy = FAudio_min(QOA_SLICE_LEN - start, end - offset);
+		FAudio_INTERNAL_Convert_S16_To_F32(
+			impl->samples[slice & 1] + (start * channels),
+			dst,
+			copy * channels
+		);
+		dst += copy * channels;
+		offset += copy;
+	}
+
+	/* Only the last frame can be short, and only decode-ahead asks for a
+	 * whole block of it
+	 */
+	if (offset < last)
+	{
+		FAudio_zero(dst, sizeof(float) * (last - offset) * channels);
+	}
+}
+
+void FAudio_INTERNAL_DecodeQOA(
+	FAudioVoice *voice,
+	const void *src,
+	float *decodeCache,
+	uint32_t block_offset,
+	uint32_t samples
+) {
+	const uint32_t block_size = voice->src.format->nBlockAlign;
+	const uint16_t channels = voice->src.format->nChannels;
+	const uint8_t *frame = (const uint8_t*) src;
+	uint32_t copy, done = 0;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	while (done < samples)
+	{
+		copy = FAudio_min(samples - done, QOA_FRAME_LEN - block_offset);
+		FAudio_QOA_decode_frame(
+			voice->src.qoa,
+			frame,
+			channels,
+			decodeCache,
+			block_offset,
+			copy
+		);
+		frame += block_size;
+		decodeCache += copy * channels;
+		done += copy;
+		block_offset = 0;
+	}
+
+	LOG_FUNC_EXIT(voice->audio)
+}
+
+uint32_t FAudio_QOA_init(FAudioSourceVoice *voice)
+{
+	const uint16_t channels = voice->src.format->nChannels;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	if (channels == 0 || channels > QOA_MAX_CHANNELS)
+	{
+		LOG_ERROR(
+			voice->audio,
+			"QOA supports 1 to %d channels, got %d",
+			QOA_MAX_CHANNELS,
+			channels
+		)
+		LOG_FUNC_EXIT(voice->audio)
+		return FAUDIO_E_INVALID_CALL;
+	}
+
+	/* Only the last frame of a buffer may be smaller than this */
+	voice->src.format->nBlockAlign = QOA_FRAME_SIZE(
+		channels,
+		QOA_SLICES_PER_FRAME
+	);
+	voice->src.samples_per_block = QOA_FRAME_LEN;
+	voice->src.decode = FAudio_INTERNAL_DecodeQOA;
+
+	voice->src.qoa = (struct FAudioQOA*) voice->audio->pMalloc(
+		sizeof(struct FAudioQOA)
+	);
+	FAudio_zero(voice->src.qoa, sizeof(struct FAudioQOA));
+
+	LOG_FUNC_EXIT(voice->audio)
+	return 0;
+}
+
+void FAudio_QOA_free(FAudioSourceVoice *voice)
+{
+	LOG_FUNC_ENTER(voice->audio)
+	voice->audio->pFree(voice->src.qoa);
+	voice->src.qoa = NULL;
+	LOG_FUNC_EXIT(voice->audio)
+}
+
+void FAudio_QOA_end_buffer(FAudioSourceVoice *voice)
+{
+	LOG_FUNC_ENTER(voice->audio)
+
+	/* The client may reuse this memory, so forget where we were in it */
+	voice->src.qoa->frame = NULL;
+
+	LOG_FUNC_EXIT(voice->audio)
+}
+
+uint32_t FAudio_QOA_get_length(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *buffer,
+	uint32_t *headerSize
+) {
+	const uint16_t channels = voice->src.format->nChannels;
+	const uint8_t *data = buffer->pAudioData;
+	const uint32_t size = buffer->AudioBytes;
+	const uint8_t *frame;
+	uint32_t offset, frameSamples, frameSize, slices, total = 0;
+
+	/* Whole .qoa files are fine too, we just skip the file header */
+	*headerSize = 0;
+	if (size >= 8 && (FAudio_QOA_read64(data) >> 32) == QOA_MAGIC)
+	{
+		*headerSize = 8;
+	}
+
+	/* Check every frame header now, so the decoder can trust them */
+	for (offset = *headerSize; offset < size; offset += frameSize)
+	{
+		frame = data + offset;
+		if (size - offset < 8 || frame[0] != channels)
+		{
+			return 0;
+		}
+
+		frameSamples = FAudio_QOA_read16(frame + 4);
+		frameSize = FAudio_QOA_read16(frame + 6);
+		slices = (frameSamples + QOA_SLICE_LEN - 1) / QOA_SLICE_LEN;
+		if (	frameSamples == 0 ||
+			frameSamples > QOA_FRAME_LEN ||
+			frameSize != QOA_FRAME_SIZE(channels, slices) ||
+			frameSize > size - offset ||
+			(frameSamples < QOA_FRAME_LEN && frameSize < size - offset)	)
+		{
+			return 0;
+		}
+
+		/* Like the channels, the rate has to match the voice */
+		if (	offset == *headerSize &&
+			(	((uint32_t) frame[1] << 16) |
+				((uint32_t) frame[2] << 8) |
+				((uint32_t) frame[3])	) != voice->src.format->nSamplesPerSec	)
+		{
+			LOG_ERROR(
+				voice->audio,
+				"Voice %p, buffer %p is not %uHz",
+				(void*) voice,
+				(void*) buffer,
+				voice->src.format->nSamplesPerSec
+			)
+			return 0;
+		}
+
+		total += frameSamples;
+	}
+	return total;
+}
+
+/* vim: set noexpandtab shiftwidth=8 tabstop=8: */
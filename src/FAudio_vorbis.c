@@ -0,0 +1,1261 @@
+/* FAudio - XAudio Reimplementation for FNA
+ *
+ * Copyright (c) 2011-2024 Ethan Lee, Luigi Auriemma, and the MonoGame Team
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Ethan "flibitijibibo" Lee <flibitijibibo@flibitijibibo.com>
+ *
+ */
+
+#include "FAudio_internal.h"
+
+/* stb_vorbis */
+
+#define malloc FAudio_malloc
+#define realloc FAudio_realloc
+#define free FAudio_free
+#ifdef STB_MEMSET_OVERRIDE
+#ifdef memset /* Thanks, Apple! */
+#undef memset
+#endif
+#define memset FAudio_memset
+#endif /* STB_MEMSET_OVERRIDE */
+#ifdef STB_MEMCPY_OVERRIDE
+#ifdef memcpy /* Thanks, Apple! */
+#undef memcpy
+#endif
+#define memcpy FAudio_memcpy
+#endif /* STB_MEMCPY_OVERRIDE */
+#define memcmp FAudio_memcmp
+
+#define pow FAudio_pow
+#define log(x) FAudio_log(x)
+#define sin(x) FAudio_sin(x)
+#define cos(x) FAudio_cos(x)
+#define floor FAudio_floor
+#define abs(x) FAudio_abs(x)
+#define ldexp(v, e) FAudio_ldexp((v), (e))
+#define exp(x) FAudio_exp(x)
+
+#define qsort FAudio_qsort
+
+#define assert FAudio_assert
+
+#define FILE FAudioIOStream
+#ifdef SEEK_SET
+#undef SEEK_SET
+#endif
+#ifdef SEEK_END
+#undef SEEK_END
+#endif
+#ifdef EOF
+#undef EOF
+#endif
+#define SEEK_SET FAUDIO_SEEK_SET
+#define SEEK_END FAUDIO_SEEK_END
+#define EOF FAUDIO_EOF
+#define fopen(path, mode) FAudio_fopen(path)
+#define fopen_s(io, path, mode) (!(*io = FAudio_fopen(path)))
+#define fclose(io) FAudio_close(io)
+#define fread(dst, size, count, io) io->read(io->data, dst, size, count)
+#define fseek(io, offset, whence) io->seek(io->data, offset, whence)
+#define ftell(io) io->seek(io->data, 0, FAUDIO_SEEK_CUR)
+
+#define STB_VORBIS_NO_INTEGER_CONVERSION 1
+#include "stb_vorbis.h"
+
+/* Vorbis Source Voices
+ *
+ * The decoder is fed with the pushdata API, straight from the client's pages.
+ * Each stream gets its own decoder, opened when the buffer with its headers is
+ * submitted, so the mixer never parses a setup header or allocates. Buffers
+ * after that one may carry more pages of the same stream, and are decoded by
+ * the same decoder without any seeking when they follow on from each other.
+ *
+ * The only seeks are to PlayBegin and LoopBegin, and the page to start from
+ * for those is found at submit time too. A seek then costs the frames between
+ * that page and the sample, rather than a bisection over the whole stream.
+ */
+
+/* The mixer may read the resampler padding again, plus one frame before it */
+#define VORBIS_HISTORY (EXTRA_DECODE_PADDING + 1)
+
+/* Enough for most streams; grown if the setup headers need more */
+#define VORBIS_DEFAULT_ALLOC (256 * 1024)
+
+#define VORBIS_PAGE_HEADER 27
+#define VORBIS_PAGE_CONTINUED 0x01
+#define VORBIS_PAGE_FIRST 0x02
+#define VORBIS_PAGE_LAST 0x04
+
+/* A copy of the last page of a buffer. A seek to the very start of the buffer
+ * after it has to decode that page first, and by then the client may have
+ * freed it.
+ */
+struct FAudioVorbisLead
+{
+	struct FAudioVorbisLead *next;
+
+	/* Stream sample that the following buffer starts at */
+	uint32_t first;
+
+	/* Where to sync before decoding the page */
+	FAudioVorbisSeek sync;
+
+	uint8_t *data;
+	uint32_t size;
+};
+
+struct FAudioVorbisStream
+{
+	struct FAudioVorbisStream *next;
+	struct FAudioVorbisLead *leads;
+
+	stb_vorbis *decoder;
+	stb_vorbis_alloc alloc;
+
+	/* After a page sync, the first frame decoded is only used for its
+	 * overlap, so the sync page must be this far before the seek target.
+	 */
+	uint32_t margin;
+
+	/* The buffer the decoder is reading, and how far into it it is. Right
+	 * after a seek, the offset may be into a lead instead.
+	 */
+	uint64_t serial;
+	uint32_t offset;
+	const struct FAudioVorbisLead *lead;
+	uint8_t valid;
+	uint8_t exhausted;
+
+	/* Silence owed before the frame, when a seek came up short */
+	uint32_t silence;
+
+	/* Stream sample of the next frame we hand out, and what's left of
+	 * the frame the decoder last returned
+	 */
+	uint32_t position;
+	float **frame;
+	uint32_t frameOffset;
+	uint32_t frameLength;
+
+	/* The last few frames before position, interleaved */
+	float *history;
+	uint32_t historyCount;
+};
+
+struct FAudioVorbis
+{
+	/* Streams that queued buffers may still point to, newest first. The
+	 * newest is kept even when nothing points to it, so that a buffer
+	 * submitted later can continue it.
+	 */
+	struct FAudioVorbisStream *streams;
+
+	/* Stream sample at the end of the newest buffer */
+	uint32_t granule;
+};
+
+static uint64_t FAudio_VORBIS_granule(const uint8_t *page)
+{
+	return (
+		((uint64_t) page[6]) |
+		((uint64_t) page[7] << 8) |
+		((uint64_t) page[8] << 16) |
+		((uint64_t) page[9] << 24) |
+		((uint64_t) page[10] << 32) |
+		((uint64_t) page[11] << 40) |
+		((uint64_t) page[12] << 48) |
+		((uint64_t) page[13] << 56)
+	);
+}
+
+/* Returns the size of the page at offset, or 0 if there isn't a whole one */
+static uint32_t FAudio_VORBIS_page_size(
+	const FAudioBuffer *buffer,
+	uint32_t offset
+) {
+	const uint8_t *page = buffer->pAudioData + offset;
+	uint32_t size, i;
+
+	if (	buffer->AudioBytes - offset < VORBIS_PAGE_HEADER ||
+		page[0] != 'O' ||
+		page[1] != 'g' ||
+		page[2] != 'g' ||
+		page[3] != 'S' ||
+		page[4] != 0 ||
+		buffer->AudioBytes - offset < VORBIS_PAGE_HEADER + page[26]	)
+	{
+		return 0;
+	}
+	size = VORBIS_PAGE_HEADER + page[26];
+	for (i = 0; i < page[26]; i += 1)
+	{
+		size += page[VORBIS_PAGE_HEADER + i];
+	}
+	if (buffer->AudioBytes - offset < size)
+	{
+		return 0;
+	}
+	return size;
+}
+
+/* Pages that a decode can be started after: the granule is known, and the
+ * next page doesn't begin with the rest of a packet.
+ */
+static uint8_t FAudio_VORBIS_page_syncs(const uint8_t *page)
+{
+	return (
+		page[26] > 0 &&
+		page[VORBIS_PAGE_HEADER + page[26] - 1] != 255 &&
+		FAudio_VORBIS_granule(page) != ~((uint64_t) 0)
+	);
+}
+
+uint32_t FAudio_VORBIS_init(FAudioSourceVoice *voice)
+{
+	LOG_FUNC_ENTER(voice->audio)
+
+	voice->src.vorbis = (struct FAudioVorbis*) voice->audio->pMalloc(
+		sizeof(struct FAudioVorbis)
+	);
+	FAudio_zero(voice->src.vorbis, sizeof(struct FAudioVorbis));
+
+	LOG_FUNC_EXIT(voice->audio)
+	return 0;
+}
+
+static void FAudio_VORBIS_free_lead(
+	FAudioSourceVoice *voice,
+	struct FAudioVorbisLead *lead
+) {
+	voice->audio->pFree(lead->data);
+	voice->audio->pFree(lead);
+}
+
+static void FAudio_VORBIS_free_stream(
+	FAudioSourceVoice *voice,
+	struct FAudioVorbisStream *stream
+) {
+	struct FAudioVorbisLead *lead;
+
+	while (stream->leads != NULL)
+	{
+		lead = stream->leads;
+		stream->leads = lead->next;
+		FAudio_VORBIS_free_lead(voice, lead);
+	}
+	stb_vorbis_close(stream->decoder);
+	voice->audio->pFree(stream->alloc.alloc_buffer);
+	voice->audio->pFree(stream->history);
+	voice->audio->pFree(stream);
+}
+
+void FAudio_VORBIS_free(FAudioSourceVoice *voice)
+{
+	struct FAudioVorbis *impl = voice->src.vorbis;
+	struct FAudioVorbisStream *stream;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	while (impl->streams != NULL)
+	{
+		stream = impl->streams;
+		impl->streams = stream->next;
+		FAudio_VORBIS_free_stream(voice, stream);
+	}
+	voice->audio->pFree(impl);
+	voice->src.vorbis = NULL;
+
+	LOG_FUNC_EXIT(voice->audio)
+}
+
+uint32_t FAudio_VORBIS_get_length(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *buffer,
+	uint8_t *starts
+) {
+	const uint8_t *page = NULL;
+	uint32_t offset = 0, size;
+	uint64_t granule;
+
+	/* Whole pages only, and they can't break off in the middle of a
+	 * packet, so that each buffer can be decoded on its own
+	 */
+	while (offset < buffer->AudioBytes)
+	{
+		size = FAudio_VORBIS_page_size(buffer, offset);
+		if (size == 0)
+		{
+			return 0;
+		}
+		page = buffer->pAudioData + offset;
+		if (offset == 0)
+		{
+			*starts = (page[5] & VORBIS_PAGE_FIRST) != 0;
+			if (!*starts && (page[5] & VORBIS_PAGE_CONTINUED))
+			{
+				return 0;
+			}
+		}
+		else if (page[5] & VORBIS_PAGE_FIRST)
+		{
+			/* One stream per buffer */
+			return 0;
+		}
+		offset += size;
+	}
+	if (page == NULL || !FAudio_VORBIS_page_syncs(page))
+	{
+		return 0;
+	}
+
+	/* A continuation is measured from where the stream is at, which only
+	 * FAudio_VORBIS_continue_length can look at
+	 */
+	granule = FAudio_min(FAudio_VORBIS_granule(page), UINT32_MAX);
+	return (uint32_t) granule;
+}
+
+uint32_t FAudio_VORBIS_continue_length(
+	FAudioSourceVoice *voice,
+	uint32_t granule
+) {
+	struct FAudioVorbis *impl = voice->src.vorbis;
+
+	/* Called with bufferLock held, like FAudio_VORBIS_queue */
+	if (impl->streams == NULL || granule <= impl->granule)
+	{
+		return 0;
+	}
+	return granule - impl->granule;
+}
+
+struct FAudioVorbisStream *FAudio_VORBIS_open(
+	FAudioSourceVoice *voice,
+	const FAudioBuffer *buffer,
+	FAudioVorbisSeek *start
+) {
+	struct FAudioVorbisStream *stream;
+	stb_vorbis_info info;
+	int used, error;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	stream = (struct FAudioVorbisStream*) voice->audio->pMalloc(
+		sizeof(struct FAudioVorbisStream)
+	);
+	FAudio_zero(stream, sizeof(struct FAudioVorbisStream));
+
+	/* The decoder works entirely out of our allocation, so decoding on
+	 * the mixer thread never allocates
+	 */
+	stream->alloc.alloc_buffer_length_in_bytes = VORBIS_DEFAULT_ALLOC;
+	while (1)
+	{
+		stream->alloc.alloc_buffer = (char*) voice->audio->pMalloc(
+			stream->alloc.alloc_buffer_length_in_bytes
+		);
+		stream->decoder = stb_vorbis_open_pushdata(
+			buffer->pAudioData,
+			(int) buffer->AudioBytes,
+			&used,
+			&error,
+			&stream->alloc
+		);
+		if (stream->decoder != NULL || error != VORBIS_outofmem)
+		{
+			break;
+		}
+		voice->audio->pFree(stream->alloc.alloc_buffer);
+		stream->alloc.alloc_buffer_length_in_bytes *= 2;
+	}
+
+	if (stream->decoder == NULL)
+	{
+		LOG_ERROR(
+			voice->audio,
+			"Voice %p, buffer %p is not a Vorbis stream (error %d)",
+			(void*) voice,
+			(void*) buffer,
+			error
+		)
+		goto fail;
+	}
+
+	info = stb_vorbis_get_info(stream->decoder);
+	if (	info.channels != voice->src.format->nChannels ||
+		info.sample_rate != voice->src.format->nSamplesPerSec	)
+	{
+		LOG_ERROR(
+			voice->audio,
+			"Voice %p, buffer %p is %dch %uHz, voice is %dch %uHz",
+			(void*) voice,
+			(void*) buffer,
+			info.channels,
+			info.sample_rate,
+			voice->src.format->nChannels,
+			voice->src.format->nSamplesPerSec
+		)
+		goto fail;
+	}
+
+	/* The spec has audio start on a fresh page, we rely on it to rewind */
+	if (stream->decoder->next_seg != -1)
+	{
+		LOG_ERROR(
+			voice->audio,
+			"Voice %p, buffer %p has audio on a header page",
+			(void*) voice,
+			(void*) buffer
+		)
+		goto fail;
+	}
+
+	stream->margin = stream->decoder->blocksize_1 / 2;
+	stream->history = (float*) voice->audio->pMalloc(
+		sizeof(float) *
+		VORBIS_HISTORY *
+		voice->src.format->nChannels
+	);
+
+	start->offset = (uint32_t) used;
+	start->sample = 0;
+	start->start = 1;
+
+	LOG_FUNC_EXIT(voice->audio)
+	return stream;
+
+fail:
+	if (stream->decoder != NULL)
+	{
+		stb_vorbis_close(stream->decoder);
+	}
+	voice->audio->pFree(stream->alloc.alloc_buffer);
+	voice->audio->pFree(stream);
+	LOG_FUNC_EXIT(voice->audio)
+	return NULL;
+}
+
+/* Finds the last page that can be synced to, whose granule is far enough
+ * before sample for the decode to get there. Before the first such page,
+ * it's wherever the buffer itself starts decoding from.
+ */
+static void FAudio_VORBIS_find_seek(
+	const struct FAudioVorbisStream *stream,
+	const FAudioBuffer *buffer,
+	const FAudioVorbisSeek *start,
+	uint32_t sample,
+	FAudioVorbisSeek *seek
+) {
+	const uint8_t *page;
+	uint32_t offset, size;
+	uint64_t granule;
+
+	*seek = *start;
+	for (offset = start->offset; offset < buffer->AudioBytes; offset += size)
+	{
+		size = FAudio_VORBIS_page_size(buffer, offset);
+		if (size == 0 || offset + size >= buffer->AudioBytes)
+		{
+			break;
+		}
+		page = buffer->pAudioData + offset;
+		if (!FAudio_VORBIS_page_syncs(page))
+		{
+			continue;
+		}
+		granule = FAudio_VORBIS_granule(page);
+		if (granule + stream->margin > sample)
+		{
+			break;
+		}
+		seek->offset = offset + size;
+		seek->sample = (uint32_t) granule;
+		seek->start = 0;
+	}
+}
+
+static uint8_t FAudio_VORBIS_referenced(
+	FAudioSourceVoice *voice,
+	const struct FAudioVorbisStream *stream,
+	const struct FAudioVorbisLead *lead
+) {
+	const struct queued_buffer *buffer;
+	size_t i;
+
+	for (i = 0; i < voice->src.queued_buffer_count + voice->src.flush_buffer_count; i += 1)
+	{
+		buffer = (i < voice->src.queued_buffer_count) ?
+			&voice->src.queued_buffers[i] :
+			&voice->src.flush_buffers[i - voice->src.queued_buffer_count];
+		if (	buffer->vorbis == stream &&
+			(lead == NULL || buffer->vorbis_first == lead->first)	)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Frees the streams and leads that no buffer needs anymore */
+static void FAudio_VORBIS_collect(FAudioSourceVoice *voice)
+{
+	struct FAudioVorbis *impl = voice->src.vorbis;
+	struct FAudioVorbisStream **prev, *stream;
+	struct FAudioVorbisLead **prevLead, *lead;
+
+	prev = &impl->streams;
+	while (*prev != NULL)
+	{
+		stream = *prev;
+		if (	stream != impl->streams &&
+			!FAudio_VORBIS_referenced(voice, stream, NULL)	)
+		{
+			*prev = stream->next;
+			FAudio_VORBIS_free_stream(voice, stream);
+			continue;
+		}
+
+		prevLead = &stream->leads;
+		while (*prevLead != NULL)
+		{
+			lead = *prevLead;
+			if (	!(stream == impl->streams && lead->first == impl->granule) &&
+				!FAudio_VORBIS_referenced(voice, stream, lead)	)
+			{
+				*prevLead = lead->next;
+				FAudio_VORBIS_free_lead(voice, lead);
+				continue;
+			}
+			prevLead = &lead->next;
+		}
+		prev = &stream->next;
+	}
+}
+
+/* Keeps the last page of entry, for a buffer that continues the stream */
+static void FAudio_VORBIS_add_lead(
+	FAudioSourceVoice *voice,
+	const struct queued_buffer *entry
+) {
+	struct FAudioVorbisStream *stream = entry->vorbis;
+	struct FAudioVorbisLead *lead;
+	const uint8_t *page;
+	uint32_t offset, size, last = 0, before = 0;
+	uint8_t haveBefore = 0;
+
+	for (	offset = entry->vorbis_start.offset;
+		offset < entry->buffer.AudioBytes;
+		offset += size	)
+	{
+		size = FAudio_VORBIS_page_size(&entry->buffer, offset);
+		if (size == 0)
+		{
+			return;
+		}
+		if (offset + size < entry->buffer.AudioBytes)
+		{
+			before = offset;
+			haveBefore = 1;
+		}
+		last = offset;
+	}
+
+	page = entry->buffer.pAudioData + last;
+	if (page[5] & VORBIS_PAGE_LAST)
+	{
+		return;
+	}
+
+	lead = (struct FAudioVorbisLead*) voice->audio->pMalloc(
+		sizeof(struct FAudioVorbisLead)
+	);
+	lead->first = entry->vorbis_first + entry->sample_count;
+	if (haveBefore)
+	{
+		/* Only usable if the page doesn't start mid-packet */
+		if (!FAudio_VORBIS_page_syncs(entry->buffer.pAudioData + before))
+		{
+			voice->audio->pFree(lead);
+			return;
+		}
+		lead->sync.sample = (uint32_t) FAudio_VORBIS_granule(
+			entry->buffer.pAudioData + before
+		);
+		lead->sync.start = 0;
+	}
+	else
+	{
+		/* The page is where the buffer starts decoding from */
+		lead->sync = entry->vorbis_start;
+	}
+	lead->sync.offset = 0;
+	lead->size = entry->buffer.AudioBytes - last;
+	lead->data = (uint8_t*) voice->audio->pMalloc(lead->size);
+	FAudio_memcpy(lead->data, page, lead->size);
+	lead->next = stream->leads;
+	stream->leads = lead;
+}
+
+void FAudio_VORBIS_queue(
+	FAudioSourceVoice *voice,
+	struct queued_buffer *entry,
+	struct FAudioVorbisStream *opened,
+	const FAudioVorbisSeek *start
+) {
+	struct FAudioVorbis *impl = voice->src.vorbis;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	/* Called with bufferLock held, which is also how the mixer uses them */
+	if (opened != NULL)
+	{
+		opened->next = impl->streams;
+		impl->streams = opened;
+		entry->vorbis_first = 0;
+		entry->vorbis_start = *start;
+	}
+	else
+	{
+		entry->vorbis_first = impl->granule;
+		entry->vorbis_start.offset = 0;
+		entry->vorbis_start.sample = impl->granule;
+		entry->vorbis_start.start = 0;
+	}
+	entry->vorbis = impl->streams;
+	impl->granule = entry->vorbis_first + entry->sample_count;
+	FAudio_VORBIS_add_lead(voice, entry);
+	FAudio_VORBIS_collect(voice);
+
+	FAudio_VORBIS_find_seek(
+		entry->vorbis,
+		&entry->buffer,
+		&entry->vorbis_start,
+		entry->vorbis_first + entry->buffer.PlayBegin,
+		&entry->vorbis_play
+	);
+	if (entry->buffer.LoopCount > 0)
+	{
+		FAudio_VORBIS_find_seek(
+			entry->vorbis,
+			&entry->buffer,
+			&entry->vorbis_start,
+			entry->vorbis_first + entry->buffer.LoopBegin,
+			&entry->vorbis_loop
+		);
+	}
+
+	LOG_FUNC_EXIT(voice->audio)
+}
+
+/* Puts the decoder where stb_vorbis_open_pushdata leaves it, or where its
+ * resync leaves it after finding the page before seek->offset. We already
+ * know where the pages are, so there's no need to search for one.
+ */
+static void FAudio_VORBIS_sync(stb_vorbis *f, const FAudioVorbisSeek *seek)
+{
+	stb_vorbis_flush_pushdata(f);
+	f->page_crc_tests = -1;
+	f->next_seg = -1;
+	f->first_decode = seek->start;
+	f->current_loc = seek->sample;
+	f->current_loc_valid = !seek->start;
+	f->error = VORBIS__no_error;
+	f->eof = FALSE;
+}
+
+/* Decodes the next frame with samples in it, and returns where it starts */
+static uint8_t FAudio_VORBIS_next_frame(
+	FAudioSourceVoice *voice,
+	struct FAudioVorbisStream *stream,
+	const struct queued_buffer *buffer,
+	uint32_t *start
+) {
+	stb_vorbis *f = stream->decoder;
+	int used, samples;
+
+	do
+	{
+		*start = f->current_loc_valid ? f->current_loc : stream->position;
+		if (stream->lead != NULL)
+		{
+			used = stb_vorbis_decode_frame_pushdata(
+				f,
+				stream->lead->data + stream->offset,
+				(int) (stream->lead->size - stream->offset),
+				NULL,
+				&stream->frame,
+				&samples
+			);
+		}
+		else
+		{
+			used = stb_vorbis_decode_frame_pushdata(
+				f,
+				buffer->buffer.pAudioData + stream->offset,
+				(int) (buffer->buffer.AudioBytes - stream->offset),
+				NULL,
+				&stream->frame,
+				&samples
+			);
+		}
+		if (f->page_crc_tests >= 0)
+		{
+			/* stb_vorbis gave up on a packet and went looking
+			 * for a page. We know where those are, so seek
+			 * again next time instead.
+			 */
+			LOG_ERROR(
+				voice->audio,
+				"Voice %p, buffer %p, decode error %d",
+				(void*) voice,
+				(void*) buffer,
+				f->error
+			)
+			stream->valid = 0;
+			stream->lead = NULL;
+			return 0;
+		}
+		stream->offset += used;
+		if (stream->lead != NULL && stream->offset == stream->lead->size)
+		{
+			/* On to the buffer the lead leads into */
+			stream->lead = NULL;
+			stream->offset = 0;
+			if (samples == 0)
+			{
+				/* Keep going, in the buffer this time */
+				used = 1;
+			}
+		}
+	} while (used > 0 && samples == 0);
+
+	stream->exhausted = (stream->offset == buffer->buffer.AudioBytes);
+	stream->frameOffset = 0;
+	stream->frameLength = samples;
+	return samples > 0;
+}
+
+static uint8_t FAudio_VORBIS_seek(
+	FAudioSourceVoice *voice,
+	struct FAudioVorbisStream *stream,
+	const struct queued_buffer *buffer,
+	uint32_t sample
+) {
+	const uint32_t offset = sample - buffer->vorbis_first;
+	const struct FAudioVorbisLead *lead;
+	FAudioVorbisSeek seek;
+	uint32_t start;
+
+	if (offset == buffer->buffer.PlayBegin)
+	{
+		seek = buffer->vorbis_play;
+	}
+	else if (buffer->buffer.LoopCount > 0 && offset == buffer->buffer.LoopBegin)
+	{
+		seek = buffer->vorbis_loop;
+	}
+	else
+	{
+		/* Not something a buffer normally asks for, find it now */
+		FAudio_VORBIS_find_seek(
+			stream,
+			&buffer->buffer,
+			&buffer->vorbis_start,
+			sample,
+			&seek
+		);
+	}
+
+	stream->lead = NULL;
+	if (!seek.start && seek.offset == 0)
+	{
+		/* Too close to the start of a buffer that continues the
+		 * stream, the decode has to begin in the buffer before it
+		 */
+		for (lead = stream->leads; lead != NULL; lead = lead->next)
+		{
+			if (lead->first == buffer->vorbis_first)
+			{
+				seek = lead->sync;
+				stream->lead = lead;
+				break;
+			}
+		}
+	}
+
+	FAudio_VORBIS_sync(stream->decoder, &seek);
+	stream->serial = buffer->serial;
+	stream->offset = seek.offset;
+	stream->valid = 1;
+	stream->position = seek.sample;
+	stream->silence = 0;
+	stream->historyCount = 0;
+
+	while (FAudio_VORBIS_next_frame(voice, stream, buffer, &start))
+	{
+		if (start + stream->frameLength > sample)
+		{
+			/* Without a lead to decode from, the start of a
+			 * buffer can't be reached, so pad up to it instead
+			 */
+			if (start < sample)
+			{
+				stream->frameOffset = sample - start;
+			}
+			else
+			{
+				stream->silence = start - sample;
+			}
+			stream->position = sample;
+			return 1;
+		}
+	}
+
+	LOG_ERROR(
+		voice->audio,
+		"Voice %p, failed to seek to %u",
+		(void*) voice,
+		offset
+	)
+	stream->valid = 0;
+	return 0;
+}
+
+static void FAudio_VORBIS_remember(
+	struct FAudioVorbisStream *stream,
+	const float *samples,
+	uint32_t count,
+	uint16_t channels
+) {
+	uint32_t keep, add;
+
+	add = FAudio_min(count, VORBIS_HISTORY);
+	keep = FAudio_min(stream->historyCount, VORBIS_HISTORY - add);
+	FAudio_memmove(
+		stream->history,
+		stream->history + ((stream->historyCount - keep) * channels),
+		sizeof(float) * keep * channels
+	);
+	FAudio_memcpy(
+		stream->history + (keep * channels),
+		samples + ((count - add) * channels),
+		sizeof(float) * add * channels
+	);
+	stream->historyCount = keep + add;
+}
+
+void decode_vorbis(
+	FAudioVoice *voice,
+	struct queued_buffer *buffer,
+	float *decodeCache,
+	uint32_t samples
+) {
+	struct FAudioVorbisStream *stream = buffer->vorbis;
+	const uint16_t channels = voice->src.format->nChannels;
+	const uint32_t sample = buffer->vorbis_first + voice->src.curBufferOffset;
+	uint32_t decoded = 0, copy, start, frameStart, i, c;
+	float *dst;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	if (	stream->valid &&
+		stream->serial != buffer->serial &&
+		stream->exhausted &&
+		stream->position == sample &&
+		sample == buffer->vorbis_first	)
+	{
+		/* The previous buffer ran out right where this one begins */
+		stream->serial = buffer->serial;
+		stream->offset = 0;
+		stream->exhausted = 0;
+	}
+
+	if (	stream->valid &&
+		stream->serial == buffer->serial &&
+		sample < stream->position &&
+		sample + stream->historyCount >= stream->position	)
+	{
+		/* Padding/resampling is asking for samples we already have */
+		copy = FAudio_min(stream->position - sample, samples);
+		FAudio_memcpy(
+			decodeCache,
+			stream->history + (
+				(stream->historyCount - (stream->position - sample)) *
+				channels
+			),
+			sizeof(float) * copy * channels
+		);
+		decoded = copy;
+	}
+	else if (	!stream->valid ||
+			stream->serial != buffer->serial ||
+			stream->position != sample	)
+	{
+		/* PlayBegin or a loop point, go find it */
+		if (!FAudio_VORBIS_seek(voice, stream, buffer, sample))
+		{
+			goto end;
+		}
+	}
+
+	dst = decodeCache + (decoded * channels);
+	start = decoded;
+	while (decoded < samples && stream->silence > 0)
+	{
+		copy = FAudio_min(samples - decoded, stream->silence);
+		FAudio_zero(dst, sizeof(float) * copy * channels);
+		dst += copy * channels;
+		stream->silence -= copy;
+		decoded += copy;
+	}
+	while (decoded < samples)
+	{
+		if (stream->frameOffset == stream->frameLength)
+		{
+			if (!FAudio_VORBIS_next_frame(voice, stream, buffer, &frameStart))
+			{
+				break;
+			}
+		}
+		copy = FAudio_min(
+			samples - decoded,
+			stream->frameLength - stream->frameOffset
+		);
+		for (i = 0; i < copy; i += 1)
+		{
+			for (c = 0; c < channels; c += 1)
+			{
+				*dst++ = stream->frame[c][stream->frameOffset + i];
+			}
+		}
+		stream->frameOffset += copy;
+		decoded += copy;
+	}
+	FAudio_VORBIS_remember(
+		stream,
+		decodeCache + (start * channels),
+		decoded - start,
+		channels
+	);
+	stream->position += decoded - start;
+
+end:
+	FAudio_zero(
+		decodeCache + (decoded * channels),
+		sizeof(float) * (samples - decoded) * channels
+	);
+	LOG_FUNC_EXIT(voice->audio)
+}
+
+/* Ogg Page Index
+ *
+ * stb_vorbis finds the page for a seek by bisecting over the file, which on a
+ * long song means a dozen or more reads spread across the whole stream. With
+ * the page list at hand the page is found in memory, and the seek costs one
+ * read at the page plus whatever decoding leads up to the sample.
+ *
+ * Entries only cover pages on which a packet ends, which are the only pages
+ * stb_vorbis can start decoding from. The sample is the page's granule
+ * position, truncated to 32 bits like everywhere else in stb_vorbis.
+ *
+ * Building reads every page header, so it gives up with no index as soon as
+ * *running goes to 0, if running isn't NULL.
+ */
+
+uint32_t FAudio_VORBIS_index_build(
+	struct stb_vorbis *f,
+	const uint8_t *running,
+	FAudioVorbisSeekPoint **index
+) {
+	ProbedPage page;
+	uint32_t offset = f->first_audio_page_offset;
+	uint32_t count = 0, capacity = 0;
+
+	*index = NULL;
+	while (offset < f->stream_len)
+	{
+		if (running != NULL && !*running)
+		{
+			FAudio_free(*index);
+			*index = NULL;
+			count = 0;
+			break;
+		}
+		set_file_offset(f, offset);
+		if (!get_seek_page_info(f, &page) || page.page_end <= offset)
+		{
+			break;
+		}
+		if (page.last_decoded_sample != ~0U)
+		{
+			if (count == capacity)
+			{
+				capacity = FAudio_max(capacity * 2, 64);
+				*index = (FAudioVorbisSeekPoint*) FAudio_realloc(
+					*index,
+					sizeof(FAudioVorbisSeekPoint) * capacity
+				);
+			}
+			(*index)[count].offset = page.page_start;
+			(*index)[count].sample = page.last_decoded_sample;
+			count += 1;
+		}
+		offset = page.page_end;
+	}
+
+	/* Leave the file where a fresh decoder would be */
+	stb_vorbis_seek_start(f);
+	return count;
+}
+
+/* Sidecar layout, all little-endian uint32:
+ *   'F' 'S' 'I' 'X', version (1), Ogg file size, entry count,
+ *   then each entry as page offset, sample.
+ * Entries for header pages are dropped, so a plain page list works too.
+ */
+#define VORBIS_INDEX_MAGIC 0x58495346
+#define VORBIS_INDEX_VERSION 1
+
+static uint32_t FAudio_VORBIS_index_read32(FAudioIOStream *io, uint32_t *value)
+{
+	uint8_t b[4];
+	if (io->read(io->data, b, 4, 1) != 1)
+	{
+		return 0;
+	}
+	*value = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t) b[3] << 24);
+	return 1;
+}
+
+uint32_t FAudio_VORBIS_index_load(
+	struct stb_vorbis *f,
+	FAudioIOStream *io,
+	FAudioVorbisSeekPoint **index
+) {
+	uint32_t header[4];
+	uint32_t i, count = 0;
+	FAudioVorbisSeekPoint point;
+
+	*index = NULL;
+	for (i = 0; i < 4; i += 1)
+	{
+		if (!FAudio_VORBIS_index_read32(io, &header[i]))
+		{
+			return 0;
+		}
+	}
+
+	/* A stale sidecar is worse than none at all */
+	if (	header[0] != VORBIS_INDEX_MAGIC ||
+		header[1] != VORBIS_INDEX_VERSION ||
+		header[2] != f->stream_len ||
+		header[3] == 0	)
+	{
+		return 0;
+	}
+
+	*index = (FAudioVorbisSeekPoint*) FAudio_malloc(
+		sizeof(FAudioVorbisSeekPoint) * header[3]
+	);
+	for (i = 0; i < header[3]; i += 1)
+	{
+		if (	!FAudio_VORBIS_index_read32(io, &point.offset) ||
+			!FAudio_VORBIS_index_read32(io, &point.sample) ||
+			point.offset >= f->stream_len	)
+		{
+			goto fail;
+		}
+		if (point.offset < f->first_audio_page_offset)
+		{
+			continue;
+		}
+		if (	count > 0 && (
+				point.offset <= (*index)[count - 1].offset ||
+				point.sample < (*index)[count - 1].sample
+			)	)
+		{
+			goto fail;
+		}
+		(*index)[count++] = point;
+	}
+	if (count > 0)
+	{
+		return count;
+	}
+
+fail:
+	FAudio_free(*index);
+	*index = NULL;
+	return 0;
+}
+
+/* Same as stb_vorbis_seek, with the bisection replaced by an index lookup */
+uint32_t FAudio_VORBIS_index_seek(
+	struct stb_vorbis *f,
+	const FAudioVorbisSeekPoint *index,
+	uint32_t count,
+	uint32_t sample
+) {
+	uint32_t padding, limit, lo, hi, mid, page_start, frame_start;
+	uint32_t max_frame_samples;
+	int end_pos, start_seg, left_start, left_end, right_start, right_end;
+	int mode, frame_samples, i, n;
+
+	if (sample > stb_vorbis_stream_length_in_samples(f))
+	{
+		return 0;
+	}
+
+	/* The granule position may sit up to this far past where the last
+	 * packet on the page starts returning samples
+	 */
+	padding = (f->blocksize_1 - f->blocksize_0) >> 2;
+	limit = (sample < padding) ? 0 : sample - padding;
+
+	if (limit <= index[0].sample)
+	{
+		if (!stb_vorbis_seek_start(f))
+		{
+			return 0;
+		}
+	}
+	else
+	{
+		/* Last page that ends at or before the limit */
+		lo = 0;
+		hi = count;
+		while (hi - lo > 1)
+		{
+			mid = lo + ((hi - lo) / 2);
+			if (index[mid].sample <= limit)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+
+		/* Seek back to the start of the last packet on that page */
+		page_start = index[lo].offset;
+		set_file_offset(f, page_start);
+		if (!start_page(f))
+		{
+			goto fail;
+		}
+		end_pos = f->end_seg_with_known_loc;
+		if (end_pos < 0)
+		{
+			goto fail;
+		}
+		for (;;)
+		{
+			for (i = end_pos; i > 0; i -= 1)
+			{
+				if (f->segments[i - 1] != 255)
+				{
+					break;
+				}
+			}
+			start_seg = i;
+			if (start_seg > 0 || !(f->page_flag & PAGEFLAG_continued_packet))
+			{
+				break;
+			}
+
+			/* The packet begins on an earlier page */
+			if (!go_to_page_before(f, page_start))
+			{
+				goto fail;
+			}
+			page_start = stb_vorbis_get_file_offset(f);
+			if (!start_page(f))
+			{
+				goto fail;
+			}
+			end_pos = f->segment_count - 1;
+		}
+
+		f->current_loc_valid = FALSE;
+		f->last_seg = FALSE;
+		f->valid_bits = 0;
+		f->packet_bytes = 0;
+		f->bytes_in_seg = 0;
+		f->previous_length = 0;
+		f->next_seg = start_seg;
+		for (i = 0; i < start_seg; i += 1)
+		{
+			skip(f, f->segments[i]);
+		}
+		if (!vorbis_pump_first_frame(f) || f->current_loc > sample)
+		{
+			goto fail;
+		}
+	}
+
+	/* From here on this is stb_vorbis_seek_frame's packet walk... */
+	max_frame_samples = (f->blocksize_1 * 3 - f->blocksize_0) >> 2;
+	while (f->current_loc < sample)
+	{
+		if (!peek_decode_initial(f, &left_start, &left_end, &right_start, &right_end, &mode))
+		{
+			goto fail;
+		}
+		frame_samples = right_start - left_start;
+		if (f->current_loc + frame_samples > sample)
+		{
+			break;
+		}
+		else if (f->current_loc + frame_samples + max_frame_samples > sample)
+		{
+			vorbis_pump_first_frame(f);
+		}
+		else
+		{
+			f->current_loc += frame_samples;
+			f->previous_length = 0;
+			maybe_start_packet(f);
+			flush_packet(f);
+		}
+	}
+
+	/* ... and stb_vorbis_seek's trim to the exact sample */
+	if (sample != f->current_loc)
+	{
+		frame_start = f->current_loc;
+		stb_vorbis_get_frame_float(f, &n, NULL);
+		if (	sample < frame_start ||
+			f->channel_buffer_start + (int) (sample - frame_start) > f->channel_buffer_end	)
+		{
+			goto fail;
+		}
+		f->channel_buffer_start += (sample - frame_start);
+	}
+	return 1;
+
+fail:
+	stb_vorbis_seek_start(f);
+	return 0;
+}
+
+/* vim: set noexpandtab shiftwidth=8 tabstop=8: */
@@ -80,10 +80,14 @@
 #define fseek(io, offset, whence) io->seek(io->data, offset, whence)
 #define ftell(io) io->seek(io->data, 0, FAUDIO_SEEK_CUR)
 
+/* The implementation lives in FAudio_vorbis.c */
+#define STB_VORBIS_HEADER_ONLY 1
 #define STB_VORBIS_NO_PUSHDATA_API 1
 #define STB_VORBIS_NO_INTEGER_CONVERSION 1
 #include "stb_vorbis.h"
 
+/* The implementation lives in FAudio_qoa.c */
+#define QOA_HEADER_ONLY 1
 #include "qoa_decoder.h"
 
 /* Globals */
@@ -97,51 +101,213 @@ static unsigned int songOffset = 0;
 static FAudioSourceVoice *songVoice = NULL;
 static FAudioVoiceCallback callbacks;
 static stb_vorbis *activeVorbisSong = NULL;
-static stb_vorbis_info activeVorbisSongInfo;
-
 static qoa *activeQoaSong = NULL;
-static unsigned int qoaChannels = 0;
-static unsigned int qoaSampleRate = 0;
-static unsigned int qoaSamplesPerChannelPerFrame = 0;
-static unsigned int qoaTotalSamplesPerChannel = 0;
+static unsigned int songChannels = 0;
+static unsigned int songSampleRate = 0;
+static char *songName = NULL;
+static uint8_t songPaused = 0;
+
+/* Where the voice started playing from, in samples. SamplesPlayed counts from
+ * here until the end of the stream, where it starts over for the queued song.
+ */
+static unsigned int songSeekBase = 0;
+
+/* Vorbis seek index, built or loaded by the song thread once it has decoded
+ * ahead, and only touched by the application's thread while the song thread
+ * is stopped. Seeks bisect with stb_vorbis until it's there. QOA frames are
+ * all the same size, so those seek straight to the frame and decode the first
+ * one from songSkipSamples on.
+ */
+static FAudioVorbisSeekPoint *songIndex = NULL;
+static uint32_t songIndexCount = 0;
+static uint8_t songIndexPending = 0;
+static uint32_t songSkipSamples = 0;
+
+/* QOA frames are decoded here, then converted into the float slot */
+static short songQoaFrame[QOA_FRAME_LEN * QOA_MAX_CHANNELS];
+
+/* The song is decoded on its own thread into a ring of slots, each of which
+ * is submitted as one buffer. OnBufferEnd hands a slot back to the thread,
+ * so the mixer never waits on the decoder. Slots are long because a buffer
+ * that ends right at the end of an update gets silence as resampler padding.
+ */
+#define SONG_SLOT_MS 1000
 
+static uint32_t songAheadMS = 2000;
 static uint8_t *songCache;
+static uint32_t songCacheSize = 0;
+static uint32_t songSlotCount = 0;
+static uint32_t songSlotSamples = 0;
+static uint32_t songSlotSize = 0;
+static uint32_t songSlotIndex = 0;
+
+static FAudioThread songThread = NULL;
+static FAudioSemaphore songFreeSlots = NULL;
+static uint8_t songThreadRunning = 0;
+
+/* XNA_QueueSongEXT opens the next song and hands it to the thread, which
+ * switches to it once the current song is fully decoded and keeps going on the
+ * same voice. songQueueLock guards the queued song and songSwitching, and
+ * songSampleRate while the thread is running, since the thread changes it.
+ */
+static FAudioMutex songQueueLock = NULL;
+static FAudioSemaphore songQueueSignal = NULL;
+static char *songQueuedName = NULL;
+static stb_vorbis *songQueuedVorbis = NULL;
+static qoa *songQueuedQoa = NULL;
+static unsigned int songQueuedSampleRate = 0;
+static unsigned int songQueuedLength = 0;
+static uint8_t songSwitching = 0;
 
 /* Internal Functions */
 
-static void XNA_SongSubmitBuffer(FAudioVoiceCallback *callback, void *pBufferContext)
+static uint8_t XNA_SongOpen(
+	const char *name,
+	stb_vorbis **vorbis,
+	qoa **qoaSong,
+	unsigned int *channels,
+	unsigned int *sampleRate,
+	unsigned int *length
+) {
+	stb_vorbis_info info;
+	unsigned int samplesPerFrame;
+
+	*vorbis = stb_vorbis_open_filename(name, NULL, NULL);
+	*qoaSong = NULL;
+
+	if (*vorbis != NULL)
+	{
+		info = stb_vorbis_get_info(*vorbis);
+		*channels = info.channels;
+		*sampleRate = info.sample_rate;
+		*length = stb_vorbis_stream_length_in_samples(*vorbis);
+		stb_vorbis_seek_start(*vorbis);
+		return 1;
+	}
+
+	/* It's not vorbis, try qoa! */
+	*qoaSong = qoa_open_from_filename(name);
+	if (*qoaSong != NULL)
+	{
+		qoa_attributes(
+			*qoaSong,
+			channels,
+			sampleRate,
+			&samplesPerFrame,
+			length
+		);
+		qoa_seek_frame(*qoaSong, 0);
+		return 1;
+	}
+
+	/* It's neither vorbis nor qoa, time to bail */
+	return 0;
+}
+
+static void XNA_SongClose(stb_vorbis *vorbis, qoa *qoaSong)
+{
+	if (vorbis != NULL)
+	{
+		stb_vorbis_close(vorbis);
+	}
+	if (qoaSong != NULL)
+	{
+		qoa_close(qoaSong);
+	}
+}
+
+static void XNA_SongSetSwitching(uint8_t switching)
+{
+	FAudio_PlatformLockMutex(songQueueLock);
+	songSwitching = switching;
+	FAudio_PlatformUnlockMutex(songQueueLock);
+}
+
+/* Slot length depends on the format, slot placement only on the sample rate,
+ * so buffers in flight stay put when a song with the same rate follows.
+ */
+static void XNA_SongSetSlotSamples()
+{
+	songSlotSamples = songSampleRate * SONG_SLOT_MS / 1000;
+	if (activeQoaSong != NULL)
+	{
+		songSlotSamples = FAudio_max(
+			songSlotSamples / QOA_FRAME_LEN,
+			1
+		) * QOA_FRAME_LEN;
+	}
+}
+
+/* Only safe while no slot is queued on the voice */
+static void XNA_SongAllocSlots()
+{
+	songSlotSize = FAudio_max(
+		songSampleRate * SONG_SLOT_MS / 1000,
+		QOA_FRAME_LEN
+	) * songChannels * sizeof(float);
+	if (songSlotSize * songSlotCount > songCacheSize)
+	{
+		songCacheSize = songSlotSize * songSlotCount;
+		songCache = (uint8_t*) FAudio_realloc(songCache, songCacheSize);
+	}
+	songSlotIndex = 0;
+}
+
+/* Returns 1 if there is more of the song left to decode */
+static uint8_t XNA_SongSubmitBuffer()
 {
 	FAudioBuffer buffer;
-	uint32_t decoded = 0;
+	float *slot = (float*) (songCache + (songSlotIndex * songSlotSize));
+	uint32_t decoded = 0, frame;
 
 	if (activeVorbisSong != NULL)
 	{
 		decoded = stb_vorbis_get_samples_float_interleaved(
 			activeVorbisSong,
-			activeVorbisSongInfo.channels,
-			(float*) songCache,
-			activeVorbisSongInfo.sample_rate * activeVorbisSongInfo.channels
+			songChannels,
+			slot,
+			songSlotSamples * songChannels
 		);
-		buffer.AudioBytes = decoded * activeVorbisSongInfo.channels * sizeof(float);
 	}
 	else if (activeQoaSong != NULL)
 	{
-		/* TODO: decode multiple frames? */
-		decoded = qoa_decode_next_frame(
-			activeQoaSong,
-			(short*) songCache
-		);
-		buffer.AudioBytes = decoded * qoaChannels * sizeof(short);
+		/* Slots are sized to a whole number of frames */
+		while (decoded + QOA_FRAME_LEN <= songSlotSamples)
+		{
+			frame = qoa_decode_next_frame(
+				activeQoaSong,
+				songQoaFrame
+			);
+			if (frame <= songSkipSamples)
+			{
+				songSkipSamples = 0;
+				if (frame == 0)
+				{
+					break;
+				}
+				continue;
+			}
+			FAudio_INTERNAL_Convert_S16_To_F32(
+				songQoaFrame + (songSkipSamples * songChannels),
+				slot + (decoded * songChannels),
+				(frame - songSkipSamples) * songChannels
+			);
+			decoded += frame - songSkipSamples;
+			songSkipSamples = 0;
+		}
 	}
 
 	if (decoded == 0)
 	{
-		return;
+		/* Nothing went into the slot, so it's still free */
+		FAudio_PlatformSignalSemaphore(songFreeSlots);
+		return 0;
 	}
 
 	songOffset += decoded;
 	buffer.Flags = (songOffset >= songLength) ? FAUDIO_END_OF_STREAM : 0;
-	buffer.pAudioData = songCache;
+	buffer.AudioBytes = decoded * songChannels * sizeof(float);
+	buffer.pAudioData = (uint8_t*) slot;
 	buffer.PlayBegin = 0;
 	buffer.PlayLength = decoded;
 	buffer.LoopBegin = 0;
@@ -153,20 +319,303 @@ static void XNA_SongSubmitBuffer(FAudioVoiceCallback *callback, void *pBufferCon
 		&buffer,
 		NULL
 	);
+
+	songSlotIndex = (songSlotIndex + 1) % songSlotCount;
+	return !(buffer.Flags & FAUDIO_END_OF_STREAM);
 }
 
-static void XNA_SongKill()
+/* Returns 1 once the queued song is the active one */
+static uint8_t XNA_SongNext()
+{
+	char *name;
+	stb_vorbis *vorbis;
+	qoa *qoaSong;
+	unsigned int sampleRate, length;
+	uint32_t i;
+
+	FAudio_PlatformLockMutex(songQueueLock);
+	name = songQueuedName;
+	vorbis = songQueuedVorbis;
+	qoaSong = songQueuedQoa;
+	sampleRate = songQueuedSampleRate;
+	length = songQueuedLength;
+	songQueuedName = NULL;
+	songQueuedVorbis = NULL;
+	songQueuedQoa = NULL;
+	songSwitching = (name != NULL);
+	FAudio_PlatformUnlockMutex(songQueueLock);
+
+	if (name == NULL)
+	{
+		return 0;
+	}
+
+	/* SetSourceSampleRate needs an empty queue, so let the voice play out
+	 * the old song first. Otherwise the new one is submitted right behind it.
+	 * XNA_QueueSongEXT already checked the channel count.
+	 */
+	if (sampleRate != songSampleRate)
+	{
+		for (i = 0; i < songSlotCount && songThreadRunning; i += 1)
+		{
+			FAudio_PlatformWaitSemaphore(songFreeSlots, -1);
+		}
+	}
+
+	/* If we were stopped mid-drain, slots may still be queued; leave them be */
+	if (!songThreadRunning)
+	{
+		FAudio_free(name);
+		XNA_SongClose(vorbis, qoaSong);
+		XNA_SongSetSwitching(0);
+		return 0;
+	}
+	if (sampleRate != songSampleRate)
+	{
+		FAudioSourceVoice_SetSourceSampleRate(songVoice, sampleRate);
+	}
+
+	/* Swap the decoders over */
+	if (activeVorbisSong != NULL)
+	{
+		stb_vorbis_close(activeVorbisSong);
+	}
+	if (activeQoaSong != NULL)
+	{
+		qoa_close(activeQoaSong);
+	}
+	activeVorbisSong = vorbis;
+	activeQoaSong = qoaSong;
+	songOffset = 0;
+	songLength = length;
+	FAudio_free(songName);
+	songName = name;
+	FAudio_free(songIndex);
+	songIndex = NULL;
+	songIndexCount = 0;
+	songIndexPending = (vorbis != NULL);
+	XNA_SongSetSlotSamples();
+
+	if (sampleRate != songSampleRate)
+	{
+		/* The queue is empty, so the ring can be laid out again */
+		FAudio_PlatformLockMutex(songQueueLock);
+		songSampleRate = sampleRate;
+		FAudio_PlatformUnlockMutex(songQueueLock);
+		XNA_SongAllocSlots();
+		for (i = 0; i < songSlotCount; i += 1)
+		{
+			FAudio_PlatformSignalSemaphore(songFreeSlots);
+		}
+	}
+	return 1;
+}
+
+static void XNA_SongBufferEnd(FAudioVoiceCallback *callback, void *pBufferContext)
+{
+	/* That slot can be decoded into again */
+	FAudio_PlatformSignalSemaphore(songFreeSlots);
+}
+
+static void XNA_SongStreamEnd(FAudioVoiceCallback *callback)
+{
+	/* Anything played after this is a queued song, from its start */
+	songSeekBase = 0;
+}
+
+/* Runs on the song thread, so the first seek doesn't have to scan the file on
+ * the application's thread. Stopping the thread cancels the scan, and the next
+ * start picks it up again.
+ */
+static void XNA_SongLoadIndex()
+{
+	FAudioIOStream *io;
+	stb_vorbis *scan;
+	char *path;
+	size_t len;
+
+	/* A sidecar next to the song saves the scan */
+	len = FAudio_strlen(songName);
+	path = (char*) FAudio_malloc(len + sizeof(".seek"));
+	FAudio_memcpy(path, songName, len);
+	FAudio_memcpy(path + len, ".seek", sizeof(".seek"));
+	io = FAudio_fopen(path);
+	FAudio_free(path);
+	if (io != NULL)
+	{
+		songIndexCount = FAudio_VORBIS_index_load(
+			activeVorbisSong,
+			io,
+			&songIndex
+		);
+		FAudio_close(io);
+	}
+
+	if (songIndex == NULL)
+	{
+		/* The active decoder is mid-song, so scan with one of our own */
+		scan = stb_vorbis_open_filename(songName, NULL, NULL);
+		if (scan != NULL)
+		{
+			songIndexCount = FAudio_VORBIS_index_build(
+				scan,
+				&songThreadRunning,
+				&songIndex
+			);
+			stb_vorbis_close(scan);
+		}
+	}
+	songIndexPending = (songIndex == NULL && !songThreadRunning);
+}
+
+static int32_t FAUDIOCALL XNA_SongThread(void *data)
+{
+	uint32_t decoded = 1; /* XNA_SongStartStream did the first slot */
+	uint8_t more;
+
+	while (songThreadRunning)
+	{
+		/* Once the ring has been filled there's time to spare */
+		if (songIndexPending && decoded >= songSlotCount)
+		{
+			XNA_SongLoadIndex();
+		}
+
+		FAudio_PlatformWaitSemaphore(songFreeSlots, -1);
+		if (!songThreadRunning)
+		{
+			break;
+		}
+		more = XNA_SongSubmitBuffer();
+		XNA_SongSetSwitching(0);
+		decoded += 1;
+		if (more)
+		{
+			continue;
+		}
+
+		/* This song is fully decoded, carry on with the queued one */
+		do
+		{
+			FAudio_PlatformWaitSemaphore(songQueueSignal, -1);
+		} while (songThreadRunning && !XNA_SongNext());
+		decoded = 0;
+	}
+	return 0;
+}
+
+static void XNA_SongStartStream()
+{
+	FAudioWaveFormatEx format;
+
+	/* Both formats decode to float, so any queued song can share the voice */
+	format.wFormatTag = FAUDIO_FORMAT_IEEE_FLOAT;
+	format.nChannels = songChannels;
+	format.nSamplesPerSec = songSampleRate;
+	format.wBitsPerSample = sizeof(float) * 8;
+	format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+	format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+	format.cbSize = 0;
+
+	/* Allocate decode cache */
+	XNA_SongAllocSlots();
+
+	/* Init voice */
+	FAudio_zero(&callbacks, sizeof(FAudioVoiceCallback));
+	callbacks.OnBufferEnd = XNA_SongBufferEnd;
+	callbacks.OnStreamEnd = XNA_SongStreamEnd;
+	FAudio_CreateSourceVoice(
+		songAudio,
+		&songVoice,
+		&format,
+		0,
+		1.0f, /* No pitch shifting here! */
+		&callbacks,
+		NULL,
+		NULL
+	);
+	FAudioVoice_SetVolume(songVoice, songVolume, 0);
+
+	/* The first slot is decoded right away, the thread does the rest */
+	songFreeSlots = FAudio_PlatformCreateSemaphore(songSlotCount - 1);
+	XNA_SongSubmitBuffer();
+	songThreadRunning = 1;
+	songThread = FAudio_PlatformCreateThread(
+		XNA_SongThread,
+		"FAudio_XNASong",
+		NULL
+	);
+
+	/* Finally. */
+	if (!songPaused)
+	{
+		FAudioSourceVoice_Start(songVoice, 0, 0);
+	}
+}
+
+static void XNA_SongStopStream()
 {
+	/* The thread submits to the voice, so it has to go first */
+	if (songThread != NULL)
+	{
+		songThreadRunning = 0;
+		FAudio_PlatformSignalSemaphore(songFreeSlots);
+		FAudio_PlatformSignalSemaphore(songQueueSignal);
+		FAudio_PlatformWaitThread(songThread, NULL);
+		songThread = NULL;
+	}
 	if (songVoice != NULL)
 	{
 		FAudioSourceVoice_Stop(songVoice, 0, 0);
 		FAudioVoice_DestroyVoice(songVoice);
 		songVoice = NULL;
 	}
+	if (songFreeSlots != NULL)
+	{
+		FAudio_PlatformDestroySemaphore(songFreeSlots);
+		songFreeSlots = NULL;
+	}
+}
+
+static void XNA_SongKill()
+{
+	XNA_SongStopStream();
+	if (songQueueSignal != NULL)
+	{
+		FAudio_PlatformDestroySemaphore(songQueueSignal);
+		songQueueSignal = NULL;
+	}
+	if (songQueueLock != NULL)
+	{
+		FAudio_PlatformDestroyMutex(songQueueLock);
+		songQueueLock = NULL;
+	}
+	if (songQueuedName != NULL)
+	{
+		FAudio_free(songQueuedName);
+		XNA_SongClose(songQueuedVorbis, songQueuedQoa);
+		songQueuedName = NULL;
+		songQueuedVorbis = NULL;
+		songQueuedQoa = NULL;
+	}
+	songSwitching = 0;
 	if (songCache != NULL)
 	{
 		FAudio_free(songCache);
 		songCache = NULL;
+		songCacheSize = 0;
+	}
+	if (songIndex != NULL)
+	{
+		FAudio_free(songIndex);
+		songIndex = NULL;
+		songIndexCount = 0;
+	}
+	songIndexPending = 0;
+	if (songName != NULL)
+	{
+		FAudio_free(songName);
+		songName = NULL;
 	}
 	if (activeVorbisSong != NULL)
 	{
@@ -205,115 +654,182 @@ FAUDIOAPI void XNA_SongQuit()
 
 FAUDIOAPI float XNA_PlaySong(const char *name)
 {
-	FAudioWaveFormatEx format;
+	size_t len;
 	XNA_SongKill();
 
-	activeVorbisSong = stb_vorbis_open_filename(name, NULL, NULL);
+	if (!XNA_SongOpen(
+		name,
+		&activeVorbisSong,
+		&activeQoaSong,
+		&songChannels,
+		&songSampleRate,
+		&songLength
+	)) {
+		return 0;
+	}
+	len = FAudio_strlen(name) + 1;
+	songName = (char*) FAudio_malloc(len);
+	FAudio_memcpy(songName, name, len);
+	songOffset = 0;
+	songSeekBase = 0;
+	songSkipSamples = 0;
+	songIndexPending = (activeVorbisSong != NULL);
+	songPaused = 0;
+
+	songSlotCount = FAudio_max(
+		(songAheadMS + SONG_SLOT_MS - 1) / SONG_SLOT_MS,
+		2
+	);
+	XNA_SongSetSlotSamples();
+	songQueueSignal = FAudio_PlatformCreateSemaphore(0);
+	songQueueLock = FAudio_PlatformCreateMutex();
+	XNA_SongStartStream();
 
-	if (activeVorbisSong != NULL)
-	{
-		activeVorbisSongInfo = stb_vorbis_get_info(activeVorbisSong);
-		format.wFormatTag = FAUDIO_FORMAT_IEEE_FLOAT;
-		format.nChannels = activeVorbisSongInfo.channels;
-		format.nSamplesPerSec = activeVorbisSongInfo.sample_rate;
-		format.wBitsPerSample = sizeof(float) * 8;
-		format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
-		format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
-		format.cbSize = 0;
+	return songLength / (float) songSampleRate;
+}
 
-		songOffset = 0;
-		songLength = stb_vorbis_stream_length_in_samples(activeVorbisSong);
-	}
-	else /* It's not vorbis, try qoa!*/
+FAUDIOAPI void XNA_PauseSong()
+{
+	if (songVoice == NULL)
 	{
-		activeQoaSong = qoa_open_from_filename(name);
+		return;
+	}
+	songPaused = 1;
+	FAudioSourceVoice_Stop(songVoice, 0, 0);
+}
 
-		if (activeQoaSong == NULL)
-		{
-			/* It's neither vorbis nor qoa, time to bail */
-			return 0;
-		}
+FAUDIOAPI void XNA_ResumeSong()
+{
+	if (songVoice == NULL)
+	{
+		return;
+	}
+	songPaused = 0;
+	FAudioSourceVoice_Start(songVoice, 0, 0);
+}
 
-		qoa_attributes(activeQoaSong, &qoaChannels, &qoaSampleRate, &qoaSamplesPerChannelPerFrame, &qoaTotalSamplesPerChannel);
+FAUDIOAPI void XNA_StopSong()
+{
+	XNA_SongKill();
+}
 
-		format.wFormatTag = FAUDIO_FORMAT_PCM;
-		format.nChannels = qoaChannels;
-		format.nSamplesPerSec = qoaSampleRate;
-		format.wBitsPerSample = 16;
-		format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
-		format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
-		format.cbSize = 0;
+FAUDIOAPI uint32_t XNA_QueueSongEXT(const char *name)
+{
+	stb_vorbis *vorbis;
+	qoa *qoaSong;
+	unsigned int channels, sampleRate, length;
+	size_t len;
 
-		songOffset = 0;
-		songLength = qoaTotalSamplesPerChannel;
+	if (songVoice == NULL)
+	{
+		/* Nothing to follow, so just play it */
+		XNA_PlaySong(name);
+		return (songVoice != NULL) ? 0 : FAUDIO_E_INVALID_CALL;
 	}
 
-	/* Allocate decode cache */
-	songCache = (uint8_t*) FAudio_malloc(format.nAvgBytesPerSec);
+	if (!XNA_SongOpen(name, &vorbis, &qoaSong, &channels, &sampleRate, &length))
+	{
+		return FAUDIO_E_INVALID_CALL;
+	}
 
-	/* Init voice */
-	FAudio_zero(&callbacks, sizeof(FAudioVoiceCallback));
-	callbacks.OnBufferEnd = XNA_SongSubmitBuffer;
-	FAudio_CreateSourceVoice(
-		songAudio,
-		&songVoice,
-		&format,
-		0,
-		1.0f, /* No pitch shifting here! */
-		&callbacks,
-		NULL,
-		NULL
-	);
-	FAudioVoice_SetVolume(songVoice, songVolume, 0);
+	/* The voice keeps its format, so only the sample rate may change */
+	if (channels != songChannels)
+	{
+		XNA_SongClose(vorbis, qoaSong);
+		return FAUDIO_E_INVALID_CALL;
+	}
 
-	/* Okay, this song is decoding now */
-	if (activeVorbisSong != NULL)
+	len = FAudio_strlen(name) + 1;
+	FAudio_PlatformLockMutex(songQueueLock);
+	if (songQueuedName != NULL)
 	{
-		stb_vorbis_seek_start(activeVorbisSong);
+		FAudio_free(songQueuedName);
+		XNA_SongClose(songQueuedVorbis, songQueuedQoa);
 	}
-	else if (activeQoaSong != NULL)
+	songQueuedName = (char*) FAudio_malloc(len);
+	FAudio_memcpy(songQueuedName, name, len);
+	songQueuedVorbis = vorbis;
+	songQueuedQoa = qoaSong;
+	songQueuedSampleRate = sampleRate;
+	songQueuedLength = length;
+	FAudio_PlatformUnlockMutex(songQueueLock);
+
+	FAudio_PlatformSignalSemaphore(songQueueSignal);
+	return 0;
+}
+
+FAUDIOAPI void XNA_SetSongPositionEXT(float seconds)
+{
+	unsigned int sample;
+
+	if (songVoice == NULL)
 	{
-		qoa_seek_frame(activeQoaSong, 0);
+		return;
 	}
 
-	XNA_SongSubmitBuffer(NULL, NULL);
+	if (seconds <= 0.0f)
+	{
+		sample = 0;
+	}
+	else
+	{
+		sample = (unsigned int) FAudio_min(
+			(double) seconds * songSampleRate,
+			songLength
+		);
+	}
 
-	/* Finally. */
-	FAudioSourceVoice_Start(songVoice, 0, 0);
+	/* Whatever is queued on the voice is thrown away, so start a new one */
+	XNA_SongStopStream();
 
+	songSkipSamples = 0;
 	if (activeVorbisSong != NULL)
 	{
-		return stb_vorbis_stream_length_in_seconds(activeVorbisSong);
+		/* Bisect until the song thread has the index ready */
+		if (	songIndexCount == 0 ||
+			!FAudio_VORBIS_index_seek(
+				activeVorbisSong,
+				songIndex,
+				songIndexCount,
+				sample
+			)	)
+		{
+			stb_vorbis_seek(activeVorbisSong, sample);
+		}
 	}
 	else if (activeQoaSong != NULL)
 	{
-		return qoaTotalSamplesPerChannel / (float) qoaSampleRate;
+		qoa_seek_frame(activeQoaSong, sample / QOA_FRAME_LEN);
+		songSkipSamples = sample % QOA_FRAME_LEN;
 	}
+	songOffset = sample;
+	songSeekBase = sample;
+	XNA_SongSetSwitching(0);
 
-	return 0;
+	XNA_SongSetSlotSamples();
+	XNA_SongStartStream();
 }
 
-FAUDIOAPI void XNA_PauseSong()
+FAUDIOAPI float XNA_GetSongPositionEXT()
 {
-	if (songVoice == NULL)
-	{
-		return;
-	}
-	FAudioSourceVoice_Stop(songVoice, 0, 0);
-}
+	FAudioVoiceState state;
+	unsigned int sampleRate;
 
-FAUDIOAPI void XNA_ResumeSong()
-{
 	if (songVoice == NULL)
 	{
-		return;
+		return 0.0f;
 	}
-	FAudioSourceVoice_Start(songVoice, 0, 0);
+	FAudio_PlatformLockMutex(songQueueLock);
+	sampleRate = songSampleRate;
+	FAudio_PlatformUnlockMutex(songQueueLock);
+	FAudioSourceVoice_GetState(songVoice, &state, 0);
+	return (songSeekBase + state.SamplesPlayed) / (float) sampleRate;
 }
 
-FAUDIOAPI void XNA_StopSong()
+FAUDIOAPI void XNA_SetSongDecodeAheadEXT(uint32_t milliseconds)
 {
-	XNA_SongKill();
+	/* Takes effect on the next XNA_PlaySong */
+	songAheadMS = milliseconds;
 }
 
 FAUDIOAPI void XNA_SetSongVolume(float volume)
@@ -328,10 +844,19 @@ FAUDIOAPI void XNA_SetSongVolume(float volume)
 FAUDIOAPI uint32_t XNA_GetSongEnded()
 {
 	FAudioVoiceState state;
+	uint8_t pending;
 	if (songVoice == NULL || (activeVorbisSong == NULL && activeQoaSong == NULL))
 	{
 		return 1;
 	}
+	FAudio_PlatformLockMutex(songQueueLock);
+	pending = (songQueuedName != NULL || songSwitching);
+	FAudio_PlatformUnlockMutex(songQueueLock);
+	if (pending)
+	{
+		/* The voice may run dry while it changes sample rate */
+		return 0;
+	}
 	FAudioSourceVoice_GetState(songVoice, &state, 0);
 	return state.BuffersQueued == 0 && state.SamplesPlayed == 0;
 }
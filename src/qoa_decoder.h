@@ -175,6 +175,8 @@ FAUDIOAPI void qoa_seek_frame(qoa *qoa, int frame_index);
 FAUDIOAPI void qoa_decode_entire(qoa *qoa, short *sample_data); /* fill a buffer with the entire qoa data decoded */
 FAUDIOAPI void qoa_close(qoa *qoa);
 
+#ifndef QOA_HEADER_ONLY
+
 /* The quant_tab provides an index into the dequant_tab for residuals in the
 range of -8 .. 8. It maps this range to just 3bits and becomes less accurate at
 the higher end. Note that the residual zero is identical to the lowest positive
@@ -401,7 +403,7 @@ qoa *qoa_open_from_filename(const char *filename)
 	f = fopen(filename, "rb");
 
 	if (f)
-		return qoa_open_from_file(f, TRUE);
+		return qoa_open_from_file(f, 1);
 
 	return NULL;
 }
@@ -534,3 +536,5 @@ void qoa_close(qoa *qoa)
 	}
 	free(qoa);
 }
+
+#endif /* QOA_HEADER_ONLY */
@@ -0,0 +1,1407 @@
+/* FAudio extension tests
+ *
+ * These test the FAudio-only formats and FACT extensions, which XAudio2 has no
+ * equivalent for, so unlike xaudio2.c they are written to the FAudio API and
+ * only built natively. Each test feeds the same content through two paths and
+ * checks that they agree bit for bit. Playback is captured from the mastering
+ * voice with the Collector FAPO.
+ *
+ * Copyright (c) 2011-2024 Ethan Lee, Luigi Auriemma, and the MonoGame Team
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "FAudio.h"
+#include "FAudioFX.h"
+#include "FAPO.h"
+#include "FACT.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef FAUDIO_TEST_DATA
+#define FAUDIO_TEST_DATA "tests/data"
+#endif
+
+#define RATE 44100
+#define RING_LENGTH (RATE * 8)
+
+static int failure_count = 0;
+static int success_count = 0;
+
+static void ok_(const char *file, int line, int success, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+#define ok(success, fmt, ...) ok_(__FILE__, __LINE__, success, fmt, ##__VA_ARGS__)
+static void ok_(const char *file, int line, int success, const char *fmt, ...)
+{
+    if(!success){
+        va_list va;
+        va_start(va, fmt);
+        fprintf(stdout, "test failed (%s:%u): ", file, line);
+        vfprintf(stdout, fmt, va);
+        va_end(va);
+        ++failure_count;
+    }else
+        ++success_count;
+}
+
+static void FAtest_sleep(uint64_t millis)
+{
+    usleep(millis * 1000);
+}
+
+/* Deterministic noise, so a failure can be reproduced */
+static uint32_t rand_state;
+
+static uint32_t FAtest_rand(void)
+{
+    rand_state = rand_state * 1664525 + 1013904223;
+    return rand_state >> 8;
+}
+
+static uint8_t *load_file(const char *name, uint32_t *len)
+{
+    char path[1024];
+    uint8_t *data;
+    FILE *f;
+    long size;
+
+    snprintf(path, sizeof(path), "%s/%s", FAUDIO_TEST_DATA, name);
+    f = fopen(path, "rb");
+    if(!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(size);
+    if(fread(data, 1, size, f) != (size_t)size){
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = size;
+    return data;
+}
+
+static uint32_t count_nonzero(const float *samples, uint32_t len)
+{
+    uint32_t i;
+    uint32_t count = 0;
+    for(i = 0; i < len; ++i)
+        if(samples[i] != 0.0f)
+            ++count;
+    return count;
+}
+
+/* Returns the first frame that differs, or len if they're identical */
+static uint32_t compare_frames(const float *a, const float *b, uint32_t len)
+{
+    uint32_t i;
+    for(i = 0; i < len; ++i)
+        if(a[i] != b[i])
+            break;
+    return i;
+}
+
+/* Capture
+ *
+ * The mastering voice is mono at the rate of every test sound, so each source
+ * sample maps to exactly one output sample. The engine is stopped while a test
+ * starts its voices, so they all start on the first update of the capture.
+ */
+
+static FAudio *audio;
+static FAudioMasteringVoice *master;
+static float ring[RING_LENGTH];
+static uint32_t capture_start;
+
+static int open_device(void)
+{
+    FAudioEffectDescriptor desc;
+    FAudioEffectChain chain;
+    FAPO *collector;
+    uint32_t hr;
+
+    hr = FAudioCreate(&audio, 0, FAUDIO_DEFAULT_PROCESSOR);
+    if(hr)
+        return 0;
+
+    hr = FAudioCreateCollectorEXT(&collector, 0, ring, RING_LENGTH);
+    ok(hr == 0, "FAudioCreateCollectorEXT failed: %08x\n", hr);
+    desc.InitialState = 1;
+    desc.OutputChannels = 1;
+    desc.pEffect = collector;
+    chain.EffectCount = 1;
+    chain.pEffectDescriptors = &desc;
+
+    hr = FAudio_CreateMasteringVoice(audio, &master, 1, RATE, 0, 0, &chain);
+    collector->Release(collector);
+    if(hr){
+        FAudio_Release(audio);
+        audio = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+static void close_device(void)
+{
+    FAudioVoice_DestroyVoice(master);
+    FAudio_Release(audio);
+    master = NULL;
+    audio = NULL;
+}
+
+static uint32_t collector_offset(void)
+{
+    FAudioFXCollectorState state;
+    FAudioVoice_GetEffectParameters(master, 0, &state, sizeof(state));
+    return state.WriteOffset;
+}
+
+static void capture_begin(void)
+{
+    FAudio_StopEngine(audio);
+    FAtest_sleep(50);
+    capture_start = collector_offset();
+}
+
+static int capture_end(float *out, uint32_t frames)
+{
+    uint32_t captured = 0, waited = 0, i;
+
+    FAudio_StartEngine(audio);
+    while(captured < frames && waited < 20000){
+        FAtest_sleep(10);
+        waited += 10;
+        captured = (collector_offset() + RING_LENGTH - capture_start) % RING_LENGTH;
+    }
+    FAudio_StopEngine(audio);
+    FAtest_sleep(50);
+
+    for(i = 0; i < frames; ++i)
+        out[i] = ring[(capture_start + i) % RING_LENGTH];
+    return captured >= frames;
+}
+
+static int play_buffers(const FAudioWaveFormatEx *fmt, const FAudioBuffer *buffers,
+        uint32_t count, float *out, uint32_t frames)
+{
+    FAudioSourceVoice *voice;
+    uint32_t hr, i;
+    int ret;
+
+    hr = FAudio_CreateSourceVoice(audio, &voice, fmt, 0, FAUDIO_DEFAULT_FREQ_RATIO, NULL, NULL, NULL);
+    ok(hr == 0, "CreateSourceVoice failed: %08x\n", hr);
+    if(hr)
+        return 0;
+    for(i = 0; i < count; ++i){
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[i], NULL);
+        ok(hr == 0, "SubmitSourceBuffer %u failed: %08x\n", i, hr);
+    }
+
+    capture_begin();
+    FAudioSourceVoice_Start(voice, 0, FAUDIO_COMMIT_NOW);
+    ret = capture_end(out, frames);
+    ok(ret, "Timed out capturing %u frames\n", frames);
+
+    FAudioVoice_DestroyVoice(voice);
+    return ret;
+}
+
+static int play_buffer(const FAudioWaveFormatEx *fmt, const FAudioBuffer *buffer,
+        float *out, uint32_t frames)
+{
+    return play_buffers(fmt, buffer, 1, out, frames);
+}
+
+static void init_format(FAudioWaveFormatEx *fmt, uint16_t tag, uint16_t channels, uint16_t bits)
+{
+    memset(fmt, 0, sizeof(*fmt));
+    fmt->wFormatTag = tag;
+    fmt->nChannels = channels;
+    fmt->nSamplesPerSec = RATE;
+    fmt->wBitsPerSample = bits;
+    fmt->nBlockAlign = channels * bits / 8;
+    fmt->nAvgBytesPerSec = fmt->nSamplesPerSec * fmt->nBlockAlign;
+}
+
+/* PCM conversion
+ *
+ * Each integer format is played next to a float voice holding the exact
+ * values the converters should produce. The length is odd so the SIMD
+ * converters' tails are covered as well.
+ */
+
+static void test_pcm_formats(void)
+{
+    static const uint16_t bits[] = { 8, 16, 24 };
+    const uint32_t frames = 8827;
+    FAudioWaveFormatEx fmt, float_fmt;
+    FAudioBuffer buffer, float_buffer;
+    float *expected, *out, *ref;
+    uint8_t *data, *p;
+    uint32_t i, b, channels, len;
+    int32_t v;
+
+    data = malloc(frames * 2 * 3);
+    expected = malloc(frames * 2 * sizeof(float));
+    out = malloc(frames * sizeof(float));
+    ref = malloc(frames * sizeof(float));
+
+    for(b = 0; b < sizeof(bits) / sizeof(bits[0]); ++b){
+        for(channels = 1; channels <= 2; ++channels){
+            rand_state = bits[b] * 10 + channels;
+            len = frames * channels;
+            p = data;
+            for(i = 0; i < len; ++i){
+                switch(bits[b]){
+                case 8:
+                    *p = FAtest_rand();
+                    expected[i] = (*p * 0.0078125f) - 1.0f;
+                    p += 1;
+                    break;
+                case 16:
+                    v = (int16_t)FAtest_rand();
+                    memcpy(p, &v, 2);
+                    expected[i] = v * 0.000030517578125f;
+                    p += 2;
+                    break;
+                case 24:
+                    v = FAtest_rand() & 0xFFFFFF;
+                    p[0] = v;
+                    p[1] = v >> 8;
+                    p[2] = v >> 16;
+                    v = (int32_t)((uint32_t)v << 8) >> 8;
+                    expected[i] = v * 0.00000011920930376163766f;
+                    p += 3;
+                    break;
+                }
+            }
+
+            init_format(&fmt, FAUDIO_FORMAT_PCM, channels, bits[b]);
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.AudioBytes = len * bits[b] / 8;
+            buffer.pAudioData = data;
+            buffer.Flags = FAUDIO_END_OF_STREAM;
+
+            init_format(&float_fmt, FAUDIO_FORMAT_IEEE_FLOAT, channels, 32);
+            memset(&float_buffer, 0, sizeof(float_buffer));
+            float_buffer.AudioBytes = len * sizeof(float);
+            float_buffer.pAudioData = (uint8_t*)expected;
+            float_buffer.Flags = FAUDIO_END_OF_STREAM;
+
+            if(!play_buffer(&fmt, &buffer, out, frames))
+                continue;
+            if(!play_buffer(&float_fmt, &float_buffer, ref, frames))
+                continue;
+
+            ok(count_nonzero(ref, frames) > frames / 2, "PCM%u x%u: float voice is silent\n",
+                    bits[b], channels);
+            i = compare_frames(out, ref, frames);
+            ok(i == frames, "PCM%u x%u: frame %u is %.9g, expected %.9g\n",
+                    bits[b], channels, i, out[i % frames], ref[i % frames]);
+        }
+    }
+
+    free(data);
+    free(expected);
+    free(out);
+    free(ref);
+}
+
+/* Vorbis
+ *
+ * tone.ogg is a 5 second mono stream in four pages: the two header pages and
+ * two audio pages, the first of which ends at byte 7915 and frame 115264.
+ */
+
+#define VORBIS_SPLIT_OFFSET 7915
+#define VORBIS_SPLIT_FRAME 115264
+#define VORBIS_TOTAL_FRAMES 220500
+#define VORBIS_REF_FRAMES 150000
+
+static void test_vorbis(void)
+{
+    FAudioSourceVoice *voice;
+    FAudioWaveFormatEx fmt;
+    FAudioBuffer buffers[2];
+    float *ref, *out, *expected;
+    uint8_t garbage[4096];
+    uint8_t *data;
+    uint32_t len, hr, i;
+
+    data = load_file("tone.ogg", &len);
+    ok(data != NULL, "Couldn't open %s/tone.ogg\n", FAUDIO_TEST_DATA);
+    if(!data)
+        return;
+
+    init_format(&fmt, FAUDIO_FORMAT_VORBIS_EXT, 1, 32);
+
+    /* Data that isn't a stream, or a stream without its headers, is refused */
+    hr = FAudio_CreateSourceVoice(audio, &voice, &fmt, 0, FAUDIO_DEFAULT_FREQ_RATIO, NULL, NULL, NULL);
+    ok(hr == 0, "CreateSourceVoice failed: %08x\n", hr);
+    if(hr == 0){
+        rand_state = 1;
+        for(i = 0; i < sizeof(garbage); ++i)
+            garbage[i] = FAtest_rand();
+        memset(buffers, 0, sizeof(buffers));
+        buffers[0].AudioBytes = sizeof(garbage);
+        buffers[0].pAudioData = garbage;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[0], NULL);
+        ok(hr != 0, "Garbage was accepted\n");
+
+        buffers[0].AudioBytes = len - VORBIS_SPLIT_OFFSET;
+        buffers[0].pAudioData = data + VORBIS_SPLIT_OFFSET;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[0], NULL);
+        ok(hr != 0, "A stream without headers was accepted\n");
+
+        /* A continuation is measured from the end of the one before it */
+        buffers[1] = buffers[0];
+        buffers[0].AudioBytes = VORBIS_SPLIT_OFFSET;
+        buffers[0].pAudioData = data;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[0], NULL);
+        ok(hr == 0, "SubmitSourceBuffer failed: %08x\n", hr);
+        buffers[1].PlayBegin = VORBIS_TOTAL_FRAMES - VORBIS_SPLIT_FRAME;
+        buffers[1].PlayLength = 1;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[1], NULL);
+        ok(hr != 0, "Play region past the end of a continuation was accepted\n");
+        buffers[1].PlayBegin -= 1;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[1], NULL);
+        ok(hr == 0, "SubmitSourceBuffer failed: %08x\n", hr);
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffers[1], NULL);
+        ok(hr != 0, "A continuation that doesn't move forward was accepted\n");
+
+        FAudioVoice_DestroyVoice(voice);
+    }
+
+    ref = malloc(VORBIS_REF_FRAMES * sizeof(float));
+    out = malloc(VORBIS_REF_FRAMES * sizeof(float));
+    expected = malloc(VORBIS_REF_FRAMES * sizeof(float));
+
+    /* The whole stream in one buffer */
+    memset(buffers, 0, sizeof(buffers));
+    buffers[0].AudioBytes = len;
+    buffers[0].pAudioData = data;
+    buffers[0].Flags = FAUDIO_END_OF_STREAM;
+    if(!play_buffer(&fmt, &buffers[0], ref, VORBIS_REF_FRAMES))
+        goto end;
+    ok(count_nonzero(ref, VORBIS_REF_FRAMES) > VORBIS_REF_FRAMES / 2, "Vorbis voice is silent\n");
+
+    /* The same stream split in two, which continues across the buffers */
+    buffers[0].AudioBytes = VORBIS_SPLIT_OFFSET;
+    buffers[0].Flags = 0;
+    buffers[1].AudioBytes = len - VORBIS_SPLIT_OFFSET;
+    buffers[1].pAudioData = data + VORBIS_SPLIT_OFFSET;
+    buffers[1].Flags = FAUDIO_END_OF_STREAM;
+    if(play_buffers(&fmt, buffers, 2, out, VORBIS_REF_FRAMES)){
+        i = compare_frames(out, ref, VORBIS_REF_FRAMES);
+        ok(i == VORBIS_REF_FRAMES, "Split stream: frame %u is %.9g, expected %.9g\n",
+                i, out[i % VORBIS_REF_FRAMES], ref[i % VORBIS_REF_FRAMES]);
+    }
+
+    /* Seeking to PlayBegin and LoopBegin lands on the same samples */
+    memset(buffers, 0, sizeof(buffers));
+    buffers[0].AudioBytes = len;
+    buffers[0].pAudioData = data;
+    buffers[0].Flags = FAUDIO_END_OF_STREAM;
+    buffers[0].PlayBegin = 100000;
+    buffers[0].PlayLength = 50000;
+    buffers[0].LoopBegin = 110000;
+    buffers[0].LoopLength = 20000;
+    buffers[0].LoopCount = 1;
+    memcpy(expected, ref + 100000, 30000 * sizeof(float));
+    memcpy(expected + 30000, ref + 110000, 40000 * sizeof(float));
+    if(play_buffer(&fmt, &buffers[0], out, 70000)){
+        i = compare_frames(out, expected, 70000);
+        ok(i == 70000, "Play/loop region: frame %u is %.9g, expected %.9g\n",
+                i, out[i % 70000], expected[i % 70000]);
+    }
+
+end:
+    free(ref);
+    free(out);
+    free(expected);
+    free(data);
+}
+
+/* QOA
+ *
+ * A small encoder writes a QOA stream and keeps the samples a decoder has to
+ * reconstruct from it, which are then played next to the QOA voice as PCM.
+ * The length ends in a partial frame that ends in a partial slice.
+ */
+
+#define QOA_FRAMES 12810
+#define QOA_FRAME_LEN 5120
+#define QOA_SLICE_LEN 20
+#define QOA_REGION_FRAMES 15000
+
+typedef struct qoa_lms
+{
+    int history[4];
+    int weights[4];
+} qoa_lms;
+
+static const int qoa_scalefactors[16] = {
+    1, 7, 21, 45, 84, 138, 211, 304, 421, 562, 731, 928, 1157, 1419, 1715, 2048
+};
+
+static int qoa_dequant(int sf, int q)
+{
+    /* 0.75, 2.5, 4.5 and 7 in quarters, rounded to nearest, ties away */
+    static const int quarters[8] = { 3, -3, 10, -10, 18, -18, 28, -28 };
+    int v = qoa_scalefactors[sf] * quarters[q];
+    return v < 0 ? -((-v + 2) / 4) : (v + 2) / 4;
+}
+
+static int qoa_predict(const qoa_lms *lms)
+{
+    int prediction = 0, i;
+    for(i = 0; i < 4; ++i)
+        prediction += lms->weights[i] * lms->history[i];
+    return prediction >> 13;
+}
+
+static void qoa_update(qoa_lms *lms, int sample, int residual)
+{
+    int delta = residual >> 4, i;
+    for(i = 0; i < 4; ++i)
+        lms->weights[i] += lms->history[i] < 0 ? -delta : delta;
+    for(i = 0; i < 3; ++i)
+        lms->history[i] = lms->history[i + 1];
+    lms->history[3] = sample;
+}
+
+static int qoa_clamp(int v)
+{
+    return v < -32768 ? -32768 : (v > 32767 ? 32767 : v);
+}
+
+static uint8_t *qoa_put(uint8_t *p, uint64_t v)
+{
+    int i;
+    for(i = 7; i >= 0; --i)
+        *p++ = v >> (i * 8);
+    return p;
+}
+
+static uint32_t qoa_encode(const int16_t *in, uint8_t *out, int16_t *recon)
+{
+    qoa_lms lms = { { 0, 0, 0, 0 }, { 0, 0, -(1 << 13), 1 << 14 } }, trial, best_lms;
+    int16_t trial_recon[QOA_SLICE_LEN], best_recon[QOA_SLICE_LEN];
+    uint32_t f, s, frame_len, slices, slice_len, i;
+    uint64_t history, weights, slice, best_slice = 0;
+    int64_t err, best_err;
+    int sf, q, best_q, predicted, rec, best_rec = 0, e, best_e;
+    uint8_t *p = out;
+
+    p = qoa_put(p, ((uint64_t)0x716f6166 << 32) | QOA_FRAMES);
+    for(f = 0; f < QOA_FRAMES; f += QOA_FRAME_LEN){
+        frame_len = QOA_FRAMES - f < QOA_FRAME_LEN ? QOA_FRAMES - f : QOA_FRAME_LEN;
+        slices = (frame_len + QOA_SLICE_LEN - 1) / QOA_SLICE_LEN;
+        p = qoa_put(p, ((uint64_t)1 << 56) | ((uint64_t)RATE << 32) |
+                ((uint64_t)frame_len << 16) | (8 + 16 + 8 * slices));
+
+        /* The decoder reads the state back as 16 bits, so we do too */
+        history = weights = 0;
+        for(i = 0; i < 4; ++i){
+            lms.history[i] = (int16_t)lms.history[i];
+            lms.weights[i] = (int16_t)lms.weights[i];
+            history = (history << 16) | (lms.history[i] & 0xFFFF);
+            weights = (weights << 16) | (lms.weights[i] & 0xFFFF);
+        }
+        p = qoa_put(p, history);
+        p = qoa_put(p, weights);
+
+        for(s = 0; s < frame_len; s += QOA_SLICE_LEN){
+            slice_len = frame_len - s < QOA_SLICE_LEN ? frame_len - s : QOA_SLICE_LEN;
+            best_err = INT64_MAX;
+            for(sf = 0; sf < 16; ++sf){
+                trial = lms;
+                slice = sf;
+                err = 0;
+                for(i = 0; i < slice_len; ++i){
+                    predicted = qoa_predict(&trial);
+                    best_q = 0;
+                    best_e = INT32_MAX;
+                    for(q = 0; q < 8; ++q){
+                        rec = qoa_clamp(predicted + qoa_dequant(sf, q));
+                        e = abs(rec - in[f + s + i]);
+                        if(e < best_e){
+                            best_e = e;
+                            best_q = q;
+                            best_rec = rec;
+                        }
+                    }
+                    err += (int64_t)best_e * best_e;
+                    qoa_update(&trial, best_rec, qoa_dequant(sf, best_q));
+                    trial_recon[i] = best_rec;
+                    slice = (slice << 3) | best_q;
+                }
+                if(err < best_err){
+                    best_err = err;
+                    best_slice = slice << ((QOA_SLICE_LEN - slice_len) * 3);
+                    best_lms = trial;
+                    memcpy(best_recon, trial_recon, sizeof(best_recon));
+                }
+            }
+            p = qoa_put(p, best_slice);
+            lms = best_lms;
+            memcpy(recon + f + s, best_recon, slice_len * sizeof(int16_t));
+        }
+    }
+    return p - out;
+}
+
+static void test_qoa(void)
+{
+    FAudioSourceVoice *voice;
+    FAudioWaveFormatEx fmt, pcm_fmt;
+    FAudioBuffer buffer, pcm_buffer;
+    int16_t *in, *recon;
+    float *out, *ref, x = 0.0f, y = 0.6f;
+    uint8_t *data, *bad;
+    uint32_t len, hr, i;
+
+    in = malloc(QOA_FRAMES * sizeof(int16_t));
+    recon = malloc(QOA_FRAMES * sizeof(int16_t));
+    data = malloc(8 + 3 * (8 + 16 + 8 * (QOA_FRAME_LEN / QOA_SLICE_LEN)));
+    out = malloc(QOA_REGION_FRAMES * sizeof(float));
+    ref = malloc(QOA_REGION_FRAMES * sizeof(float));
+
+    /* A sine with a bit of noise on top, from a rotating phasor */
+    rand_state = 2;
+    for(i = 0; i < QOA_FRAMES; ++i){
+        x += 0.05f * y;
+        y -= 0.05f * x;
+        in[i] = (int16_t)(x * 32767.0f) + (int16_t)(FAtest_rand() % 512) - 256;
+    }
+    len = qoa_encode(in, data, recon);
+
+    init_format(&fmt, FAUDIO_FORMAT_QOA_EXT, 1, 16);
+    fmt.nBlockAlign = 0;
+    fmt.nAvgBytesPerSec = 0;
+    init_format(&pcm_fmt, FAUDIO_FORMAT_PCM, 1, 16);
+
+    /* The channel count of every frame has to match the voice */
+    fmt.nChannels = 12;
+    hr = FAudio_CreateSourceVoice(audio, &voice, &fmt, 0, FAUDIO_DEFAULT_FREQ_RATIO, NULL, NULL, NULL);
+    ok(hr != 0, "QOA voice with 12 channels was created\n");
+    if(hr == 0)
+        FAudioVoice_DestroyVoice(voice);
+    fmt.nChannels = 1;
+
+    hr = FAudio_CreateSourceVoice(audio, &voice, &fmt, 0, FAUDIO_DEFAULT_FREQ_RATIO, NULL, NULL, NULL);
+    ok(hr == 0, "CreateSourceVoice failed: %08x\n", hr);
+    if(hr == 0){
+        bad = malloc(len);
+        memcpy(bad, data, len);
+        bad[8] = 2;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.AudioBytes = len;
+        buffer.pAudioData = bad;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffer, NULL);
+        ok(hr != 0, "QOA frame with the wrong channel count was accepted\n");
+
+        /* Same for the sample rate */
+        bad[8] = 1;
+        bad[11] ^= 1;
+        hr = FAudioSourceVoice_SubmitSourceBuffer(voice, &buffer, NULL);
+        ok(hr != 0, "QOA frame with the wrong sample rate was accepted\n");
+
+        FAudioVoice_DestroyVoice(voice);
+        free(bad);
+    }
+
+    /* The whole stream, including the file header */
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.AudioBytes = len;
+    buffer.pAudioData = data;
+    buffer.Flags = FAUDIO_END_OF_STREAM;
+    memset(&pcm_buffer, 0, sizeof(pcm_buffer));
+    pcm_buffer.AudioBytes = QOA_FRAMES * sizeof(int16_t);
+    pcm_buffer.pAudioData = (uint8_t*)recon;
+    pcm_buffer.Flags = FAUDIO_END_OF_STREAM;
+    if(play_buffer(&fmt, &buffer, out, QOA_FRAMES) &&
+            play_buffer(&pcm_fmt, &pcm_buffer, ref, QOA_FRAMES)){
+        ok(count_nonzero(ref, QOA_FRAMES) > QOA_FRAMES / 2, "QOA reference is silent\n");
+        i = compare_frames(out, ref, QOA_FRAMES);
+        ok(i == QOA_FRAMES, "QOA: frame %u is %.9g, expected %.9g\n",
+                i, out[i % QOA_FRAMES], ref[i % QOA_FRAMES]);
+    }
+
+    /* Starting and looping in the middle of frames */
+    buffer.PlayBegin = pcm_buffer.PlayBegin = 3000;
+    buffer.PlayLength = pcm_buffer.PlayLength = 9000;
+    buffer.LoopBegin = pcm_buffer.LoopBegin = 5000;
+    buffer.LoopLength = pcm_buffer.LoopLength = 6000;
+    buffer.LoopCount = pcm_buffer.LoopCount = 1;
+    if(play_buffer(&fmt, &buffer, out, QOA_REGION_FRAMES) &&
+            play_buffer(&pcm_fmt, &pcm_buffer, ref, QOA_REGION_FRAMES)){
+        i = compare_frames(out, ref, QOA_REGION_FRAMES);
+        ok(i == QOA_REGION_FRAMES, "QOA play/loop region: frame %u is %.9g, expected %.9g\n",
+                i, out[i % QOA_REGION_FRAMES], ref[i % QOA_REGION_FRAMES]);
+    }
+
+    free(in);
+    free(recon);
+    free(data);
+    free(out);
+    free(ref);
+}
+
+/* Bank writers
+ *
+ * Both bank formats are written in either byte order. Only the numbers are
+ * swapped, strings and the byte-swapped wave data are written by the caller.
+ */
+
+static uint8_t *bank;
+static size_t bank_pos;
+static int bank_swap;
+
+static void w8(uint32_t v)
+{
+    bank[bank_pos++] = v;
+}
+
+static void w16(uint32_t v)
+{
+    bank[bank_pos++] = bank_swap ? v >> 8 : v;
+    bank[bank_pos++] = bank_swap ? v : v >> 8;
+}
+
+static void w32(uint32_t v)
+{
+    int i;
+    for(i = 0; i < 4; ++i)
+        bank[bank_pos++] = v >> ((bank_swap ? 3 - i : i) * 8);
+}
+
+static void wf(float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    w32(v);
+}
+
+static void wstr(const char *s, size_t len)
+{
+    memset(bank + bank_pos, 0, len);
+    strncpy((char*)bank + bank_pos, s, len - 1);
+    bank_pos += len;
+}
+
+/* WaveBanks hold WAVE_COUNT mono PCM16 entries of odd lengths, with names */
+
+#define WAVE_COUNT 37
+#define WAVE_DATA_OFFSET 4096
+#define WAVE_ALIGNMENT 2048
+
+static uint32_t wave_frames(uint32_t i)
+{
+    return 301 + i * 37;
+}
+
+static uint32_t wave_offset(uint32_t i)
+{
+    uint32_t offset = 0, j;
+    for(j = 0; j < i; ++j)
+        offset += (wave_frames(j) * 2 + WAVE_ALIGNMENT - 1) & ~(WAVE_ALIGNMENT - 1);
+    return offset;
+}
+
+static size_t build_wavebank(uint8_t *out, int swap, int streaming)
+{
+    uint32_t i, k, data_len = wave_offset(WAVE_COUNT);
+    char name[64];
+    int16_t v;
+
+    bank = out;
+    bank_pos = 0;
+    bank_swap = swap;
+    memset(out, 0, WAVE_DATA_OFFSET + data_len);
+
+    w32(0x444E4257);
+    w32(46);
+    w32(44);
+    w32(52); w32(96);
+    w32(148); w32(WAVE_COUNT * 24);
+    w32(0); w32(0);
+    w32(148 + WAVE_COUNT * 24); w32(WAVE_COUNT * 64);
+    w32(WAVE_DATA_OFFSET); w32(data_len);
+
+    w32((streaming ? FACT_WAVEBANK_TYPE_STREAMING : 0) | FACT_WAVEBANK_FLAGS_ENTRYNAMES);
+    w32(WAVE_COUNT);
+    wstr("ext_tests", 64);
+    w32(24);
+    w32(64);
+    w32(WAVE_ALIGNMENT);
+    w32(0);
+    w32(0); w32(0);
+
+    for(i = 0; i < WAVE_COUNT; ++i){
+        w32(wave_frames(i) << 4);
+        w32(FACT_WAVEBANKMINIFORMAT_TAG_PCM | (1 << 2) | (RATE << 5) | (2 << 23) | (1u << 31));
+        w32(wave_offset(i));
+        w32(wave_frames(i) * 2);
+        w32(i * 5);
+        w32(i * 3);
+    }
+
+    for(i = 0; i < WAVE_COUNT; ++i){
+        snprintf(name, sizeof(name), "wave_%u_%u", i, i * 7919);
+        wstr(name, 64);
+    }
+
+    /* PCM data is stored in the bank's byte order */
+    for(i = 0; i < WAVE_COUNT; ++i){
+        bank_pos = WAVE_DATA_OFFSET + wave_offset(i);
+        rand_state = 100 + i;
+        for(k = 0; k < wave_frames(i); ++k){
+            v = FAtest_rand();
+            w16((uint16_t)v);
+        }
+    }
+
+    return WAVE_DATA_OFFSET + data_len;
+}
+
+static void check_wave_properties(FACTWaveBank *wb, int streaming, const char *desc)
+{
+    FACTWaveProperties props;
+    uint16_t count = 0, index;
+    uint32_t hr, i;
+    char name[64];
+
+    hr = FACTWaveBank_GetNumWaves(wb, &count);
+    ok(hr == 0 && count == WAVE_COUNT, "%s: %u waves\n", desc, count);
+
+    for(i = 0; i < WAVE_COUNT; ++i){
+        snprintf(name, sizeof(name), "wave_%u_%u", i, i * 7919);
+        memset(&props, 0xCC, sizeof(props));
+        hr = FACTWaveBank_GetWaveProperties(wb, i, &props);
+        ok(hr == 0, "%s: GetWaveProperties(%u) failed: %08x\n", desc, i, hr);
+        ok(strcmp(props.friendlyName, name) == 0, "%s: wave %u is named %s\n", desc, i, props.friendlyName);
+        ok(props.format.wFormatTag == FACT_WAVEBANKMINIFORMAT_TAG_PCM &&
+                props.format.nChannels == 1 &&
+                props.format.nSamplesPerSec == RATE &&
+                props.format.wBlockAlign == 2 &&
+                props.format.wBitsPerSample == 1,
+                "%s: wave %u has format %08x\n", desc, i, props.format.dwValue);
+        ok(props.durationInSamples == wave_frames(i), "%s: wave %u is %u frames long\n",
+                desc, i, props.durationInSamples);
+        ok(props.loopRegion.dwStartSample == i * 5 && props.loopRegion.dwTotalSamples == i * 3,
+                "%s: wave %u loops %u+%u\n", desc, i,
+                props.loopRegion.dwStartSample, props.loopRegion.dwTotalSamples);
+        ok(!props.streaming == !streaming, "%s: wave %u streaming is %d\n", desc, i, props.streaming);
+
+        index = FACTWaveBank_GetWaveIndex(wb, name);
+        ok(index == i, "%s: GetWaveIndex(%s) returned %u\n", desc, name, index);
+    }
+
+    index = FACTWaveBank_GetWaveIndex(wb, "wave_37_0");
+    ok(index == FACTINDEX_INVALID, "%s: missing wave has index %u\n", desc, index);
+    index = FACTWaveBank_GetWaveIndex(wb, "");
+    ok(index == FACTINDEX_INVALID, "%s: empty name has index %u\n", desc, index);
+}
+
+static void test_wavebank_parse(void)
+{
+    FACTRuntimeParameters params;
+    FACTAudioEngine *engine;
+    FACTWaveBank *wb_le = NULL, *wb_be = NULL;
+    uint8_t *le, *be;
+    size_t len;
+    uint32_t hr;
+
+    le = malloc(WAVE_DATA_OFFSET + wave_offset(WAVE_COUNT));
+    be = malloc(WAVE_DATA_OFFSET + wave_offset(WAVE_COUNT));
+    len = build_wavebank(le, 0, 0);
+    build_wavebank(be, 1, 0);
+
+    FACTCreateEngine(0, &engine);
+    memset(&params, 0, sizeof(params));
+    hr = FACTAudioEngine_Initialize(engine, &params);
+    ok(hr == 0, "FACTAudioEngine_Initialize failed: %08x\n", hr);
+    if(hr)
+        goto end;
+
+    hr = FACTAudioEngine_CreateInMemoryWaveBank(engine, le, len, 0, 0, &wb_le);
+    ok(hr == 0, "Little-endian WaveBank failed: %08x\n", hr);
+    hr = FACTAudioEngine_CreateInMemoryWaveBank(engine, be, len, 0, 0, &wb_be);
+    ok(hr == 0, "Big-endian WaveBank failed: %08x\n", hr);
+
+    if(wb_le != NULL){
+        check_wave_properties(wb_le, 0, "LE");
+        FACTWaveBank_Destroy(wb_le);
+    }
+    if(wb_be != NULL){
+        check_wave_properties(wb_be, 0, "BE");
+
+        /* In-memory big-endian PCM is swapped in place when it's loaded */
+        ok(memcmp(le + WAVE_DATA_OFFSET, be + WAVE_DATA_OFFSET, len - WAVE_DATA_OFFSET) == 0,
+                "Big-endian wave data wasn't swapped\n");
+        FACTWaveBank_Destroy(wb_be);
+    }
+
+end:
+    FACTAudioEngine_ShutDown(engine);
+    FACTAudioEngine_Release(engine);
+    free(le);
+    free(be);
+}
+
+/* SoundBanks hold SIMPLE_CUES cues that play a sound directly and
+ * COMPLEX_CUES cues with variation tables, alternating between interactive
+ * and weighted tables, all with names.
+ */
+
+#define SOUND_COUNT 4
+#define SIMPLE_CUES 23
+#define COMPLEX_CUES 14
+
+static uint32_t variation_count(uint32_t i)
+{
+    return 1 + i % 3;
+}
+
+static size_t build_soundbank(uint8_t *out, int swap, int named)
+{
+    uint32_t sounds[SOUND_COUNT], vars[COMPLEX_CUES];
+    uint32_t cue_count = named ? SIMPLE_CUES + COMPLEX_CUES : 0;
+    size_t offsets, cues_simple, cues_complex, name_index, names, wavebanks = 0x200;
+    uint32_t i, j;
+    char name[64];
+
+    bank = out;
+    bank_pos = 0;
+    bank_swap = swap;
+    memset(out, 0, 0x10000);
+
+    memcpy(out, swap ? "KBDS" : "SDBK", 4);
+    bank_pos = 4;
+    w16(FACT_CONTENT_VERSION);
+    w16(43);
+    w16(0);
+    bank_pos += 8;
+    w8(1);
+    w16(named ? SIMPLE_CUES : 0);
+    w16(named ? COMPLEX_CUES : 0);
+    w16(0);
+    w16(0);
+    w8(1);
+    w16(SOUND_COUNT);
+    w16(0);
+    w16(0);
+    offsets = bank_pos;
+    bank_pos += 40;
+    wstr("ext_tests", 64);
+
+    bank_pos = wavebanks;
+    wstr("ext_tests", 64);
+
+    for(i = 0; i < SOUND_COUNT; ++i){
+        sounds[i] = bank_pos;
+        w8(0);
+        w16(1);
+        w8(90 + i);
+        w16(i * 100);
+        w8(i);
+        w16(0);
+        w16(i);
+        w8(0);
+    }
+
+    cues_simple = bank_pos;
+    for(i = 0; i < cue_count && i < SIMPLE_CUES; ++i){
+        w8(0x04);
+        w32(sounds[i % SOUND_COUNT]);
+    }
+
+    /* Variation tables first, then the cues that point at them */
+    for(i = 0; i < cue_count && i < COMPLEX_CUES; ++i){
+        vars[i] = bank_pos;
+        if(i & 1){
+            w32(variation_count(i) | (3 << 19));
+            w16(0);
+            w16(i % 4);
+            for(j = 0; j < variation_count(i); ++j){
+                w32(sounds[(i + j) % SOUND_COUNT]);
+                wf(j * 10.0f);
+                wf(j * 10.0f + 10.0f);
+                w32(0);
+            }
+        }else{
+            w32(variation_count(i) | (1 << 19));
+            w16(0);
+            w16(0xFFFF);
+            for(j = 0; j < variation_count(i); ++j){
+                w32(sounds[(i + j) % SOUND_COUNT]);
+                w8(0);
+                w8(255);
+            }
+        }
+    }
+    cues_complex = bank_pos;
+    for(i = 0; i < cue_count && i < COMPLEX_CUES; ++i){
+        w8(0);
+        w32(vars[i]);
+        w32(0xFFFFFFFF);
+        w8(1 + i);
+        w16(0);
+        w16(0);
+        w8(0);
+    }
+
+    name_index = bank_pos;
+    bank_pos += 6 * cue_count;
+    names = bank_pos;
+    for(i = 0; i < cue_count; ++i){
+        j = bank_pos;
+        bank_pos = name_index + 6 * i;
+        w32(j);
+        w16(0xFFFF);
+        bank_pos = j;
+        snprintf(name, sizeof(name), "cue_%u_%u", i, i * 104729);
+        memcpy(bank + bank_pos, name, strlen(name) + 1);
+        bank_pos += strlen(name) + 1;
+    }
+
+    j = bank_pos;
+    bank_pos = offsets;
+    w32(cue_count ? cues_simple : 0xFFFFFFFF);
+    w32(cue_count ? cues_complex : 0xFFFFFFFF);
+    w32(cue_count ? names : 0xFFFFFFFF);
+    w32(0);
+    w32(cue_count ? vars[0] : 0xFFFFFFFF);
+    w32(0xFFFFFFFF);
+    w32(wavebanks);
+    w32(0xFFFFFFFF);
+    w32(cue_count ? name_index : 0xFFFFFFFF);
+    w32(sounds[0]);
+    return j;
+}
+
+static void check_cue_properties(FACTSoundBank *sb, const char *desc)
+{
+    FACTCueProperties props;
+    uint16_t count = 0, index;
+    uint32_t hr, i, c;
+    char name[64];
+
+    hr = FACTSoundBank_GetNumCues(sb, &count);
+    ok(hr == 0 && count == SIMPLE_CUES + COMPLEX_CUES, "%s: %u cues\n", desc, count);
+
+    for(i = 0; i < SIMPLE_CUES + COMPLEX_CUES; ++i){
+        snprintf(name, sizeof(name), "cue_%u_%u", i, i * 104729);
+        memset(&props, 0xCC, sizeof(props));
+        hr = FACTSoundBank_GetCueProperties(sb, i, &props);
+        ok(hr == 0, "%s: GetCueProperties(%u) failed: %08x\n", desc, i, hr);
+        ok(strcmp(props.friendlyName, name) == 0, "%s: cue %u is named %s\n", desc, i, props.friendlyName);
+        ok(props.currentInstances == 0, "%s: cue %u has %u instances\n", desc, i, props.currentInstances);
+        if(i < SIMPLE_CUES){
+            ok(!props.interactive && props.numVariations == 1,
+                    "%s: simple cue %u: interactive %d, %u variations\n",
+                    desc, i, props.interactive, props.numVariations);
+        }else{
+            c = i - SIMPLE_CUES;
+            ok(props.numVariations == variation_count(c), "%s: cue %u has %u variations\n",
+                    desc, i, props.numVariations);
+            ok(!props.interactive == !(c & 1), "%s: cue %u interactive is %d\n", desc, i, props.interactive);
+            ok(props.iaVariableIndex == ((c & 1) ? c % 4 : FACTINDEX_INVALID),
+                    "%s: cue %u uses variable %u\n", desc, i, props.iaVariableIndex);
+            ok(props.maxInstances == 1 + c, "%s: cue %u allows %u instances\n", desc, i, props.maxInstances);
+        }
+
+        index = FACTSoundBank_GetCueIndex(sb, name);
+        ok(index == i, "%s: GetCueIndex(%s) returned %u\n", desc, name, index);
+    }
+
+    index = FACTSoundBank_GetCueIndex(sb, "cue_37_0");
+    ok(index == FACTINDEX_INVALID, "%s: missing cue has index %u\n", desc, index);
+    index = FACTSoundBank_GetCueIndex(sb, "");
+    ok(index == FACTINDEX_INVALID, "%s: empty name has index %u\n", desc, index);
+}
+
+static void test_soundbank_parse(void)
+{
+    FACTRuntimeParameters params;
+    FACTAudioEngine *engine;
+    FACTSoundBank *sb;
+    uint8_t *data;
+    uint16_t count = 0;
+    size_t len;
+    uint32_t hr, i;
+    int swap;
+
+    data = malloc(0x10000);
+
+    FACTCreateEngine(0, &engine);
+    memset(&params, 0, sizeof(params));
+    hr = FACTAudioEngine_Initialize(engine, &params);
+    ok(hr == 0, "FACTAudioEngine_Initialize failed: %08x\n", hr);
+    if(hr)
+        goto end;
+
+    for(swap = 0; swap <= 1; ++swap){
+        len = build_soundbank(data, swap, 1);
+        hr = FACTAudioEngine_CreateSoundBank(engine, data, len, 0, 0, &sb);
+        ok(hr == 0, "%s SoundBank failed: %08x\n", swap ? "Big-endian" : "Little-endian", hr);
+        if(hr == 0){
+            check_cue_properties(sb, swap ? "BE" : "LE");
+            FACTSoundBank_Destroy(sb);
+        }
+    }
+
+    /* The same bank, parsed on the loader thread */
+    len = build_soundbank(data, 0, 1);
+    hr = FACTAudioEngine_CreateSoundBankAsyncEXT(engine, data, len, 0, 0, &sb);
+    ok(hr == 0, "CreateSoundBankAsyncEXT failed: %08x\n", hr);
+    for(i = 0; hr == 0 && sb == NULL && i < 1000; ++i){
+        FACTAudioEngine_DoWork(engine);
+        FAtest_sleep(5);
+    }
+    ok(sb != NULL, "Async SoundBank never loaded\n");
+    if(sb != NULL){
+        check_cue_properties(sb, "Async");
+        FACTSoundBank_Destroy(sb);
+    }
+
+    /* A bank without any cues or names */
+    len = build_soundbank(data, 0, 0);
+    hr = FACTAudioEngine_CreateSoundBank(engine, data, len, 0, 0, &sb);
+    ok(hr == 0, "Empty SoundBank failed: %08x\n", hr);
+    if(hr == 0){
+        hr = FACTSoundBank_GetNumCues(sb, &count);
+        ok(hr == 0 && count == 0, "Empty SoundBank has %u cues\n", count);
+        ok(FACTSoundBank_GetCueIndex(sb, "cue_0_0") == FACTINDEX_INVALID,
+                "Empty SoundBank found a cue\n");
+        FACTSoundBank_Destroy(sb);
+    }
+
+end:
+    FACTAudioEngine_ShutDown(engine);
+    FACTAudioEngine_Release(engine);
+    free(data);
+}
+
+/* io_uring reads, compared against the file they were read from */
+
+#define URING_FILE "faudio_ext_tests.tmp"
+#define URING_FILE_SIZE (1024 * 1024 + 100)
+#define URING_READS 300
+#define URING_READ_SIZE 4096
+
+static void test_uring(int has_devices)
+{
+    FACTFileIOCallbacks io;
+    FACTOverlapped ovlp[URING_READS];
+    FACTRuntimeParameters params;
+    FACTStreamingParameters stream;
+    FACTAudioEngine *engine;
+    FACTWaveBank *wb;
+    uint8_t *contents, *buffers;
+    uint32_t hr, i, bytes, offset;
+    int32_t sync, result;
+    void *file;
+    FILE *f;
+
+    if(FACTURingGetFileIOCallbacksEXT(&io) != 0){
+        fprintf(stdout, "io_uring not available, tests skipped\n");
+        return;
+    }
+
+    contents = malloc(URING_FILE_SIZE);
+    rand_state = 3;
+    for(i = 0; i < URING_FILE_SIZE; ++i)
+        contents[i] = FAtest_rand();
+    f = fopen(URING_FILE, "wb");
+    ok(f != NULL, "Couldn't create %s\n", URING_FILE);
+    if(!f){
+        free(contents);
+        return;
+    }
+    fwrite(contents, 1, URING_FILE_SIZE, f);
+    fclose(f);
+
+    file = FACTURingOpenEXT(URING_FILE);
+    ok(file != NULL, "FACTURingOpenEXT failed\n");
+    if(file == NULL)
+        goto end;
+
+    /* More reads in flight than the ring holds, most of them aligned */
+    if(posix_memalign((void**)&buffers, 4096, URING_READS * URING_READ_SIZE)){
+        FACTURingCloseEXT(file);
+        goto end;
+    }
+    memset(ovlp, 0, sizeof(ovlp));
+    for(i = 0; i < URING_READS; ++i){
+        offset = (i * 7 % 256) * URING_READ_SIZE;
+        if(i % 10 == 9)
+            offset += i;
+        ovlp[i].Offset = offset;
+        sync = io.readFileCallback(file, buffers + i * URING_READ_SIZE, URING_READ_SIZE, &bytes, &ovlp[i]);
+        ok(sync == 0 || sync == 1, "ReadFile %u returned %d\n", i, sync);
+    }
+    for(i = 0; i < URING_READS; ++i){
+        result = io.getOverlappedResultCallback(file, &ovlp[i], &bytes, 1);
+        ok(result && bytes == URING_READ_SIZE, "Read %u: result %d, %u bytes\n", i, result, bytes);
+        ok(memcmp(buffers + i * URING_READ_SIZE, contents + ovlp[i].Offset, URING_READ_SIZE) == 0,
+                "Read %u at %u doesn't match the file\n", i, ovlp[i].Offset);
+    }
+
+    /* Reads that run into, or start past, the end of the file */
+    memset(ovlp, 0, sizeof(ovlp));
+    ovlp[0].Offset = URING_FILE_SIZE - 100;
+    io.readFileCallback(file, buffers, URING_READ_SIZE, &bytes, &ovlp[0]);
+    result = io.getOverlappedResultCallback(file, &ovlp[0], &bytes, 1);
+    ok(result && bytes == 100, "Read at EOF: result %d, %u bytes\n", result, bytes);
+    ok(memcmp(buffers, contents + URING_FILE_SIZE - 100, 100) == 0, "Read at EOF doesn't match\n");
+    ovlp[1].Offset = URING_FILE_SIZE + URING_READ_SIZE;
+    io.readFileCallback(file, buffers, URING_READ_SIZE, &bytes, &ovlp[1]);
+    io.getOverlappedResultCallback(file, &ovlp[1], &bytes, 1);
+    ok(bytes == 0, "Read past EOF returned %u bytes\n", bytes);
+
+    free(buffers);
+    FACTURingCloseEXT(file);
+
+    /* A streaming WaveBank parsed through the same callbacks */
+    if(!has_devices)
+        goto end;
+    free(contents);
+    contents = malloc(WAVE_DATA_OFFSET + wave_offset(WAVE_COUNT));
+    f = fopen(URING_FILE, "wb");
+    ok(f != NULL, "Couldn't create %s\n", URING_FILE);
+    if(!f)
+        goto end;
+    fwrite(contents, 1, build_wavebank(contents, 0, 1), f);
+    fclose(f);
+
+    file = FACTURingOpenEXT(URING_FILE);
+    ok(file != NULL, "FACTURingOpenEXT failed\n");
+    if(file == NULL)
+        goto end;
+
+    FACTCreateEngine(0, &engine);
+    memset(&params, 0, sizeof(params));
+    params.fileIOCallbacks = io;
+    hr = FACTAudioEngine_Initialize(engine, &params);
+    ok(hr == 0, "FACTAudioEngine_Initialize failed: %08x\n", hr);
+    if(hr == 0){
+        memset(&stream, 0, sizeof(stream));
+        stream.file = file;
+        stream.packetSize = 16;
+        hr = FACTAudioEngine_CreateStreamingWaveBank(engine, &stream, &wb);
+        ok(hr == 0, "Streaming WaveBank failed: %08x\n", hr);
+        if(hr == 0){
+            check_wave_properties(wb, 1, "io_uring");
+            FACTWaveBank_Destroy(wb);
+        }
+    }
+    FACTAudioEngine_ShutDown(engine);
+    FACTAudioEngine_Release(engine);
+    FACTURingCloseEXT(file);
+
+end:
+    unlink(URING_FILE);
+    free(contents);
+}
+
+/* Transcoded MSADPCM entries have to sound exactly like the original */
+
+#define ADPCM_BLOCKS 100
+#define ADPCM_BLOCK_ALIGN 70
+#define ADPCM_FRAMES (ADPCM_BLOCKS * 128 - 50)
+
+static size_t build_adpcm_wavebank(uint8_t *out)
+{
+    uint32_t len = ADPCM_BLOCKS * ADPCM_BLOCK_ALIGN, i, c;
+    uint8_t *p;
+
+    bank = out;
+    bank_pos = 0;
+    bank_swap = 0;
+    memset(out, 0, WAVE_DATA_OFFSET + len);
+
+    w32(0x444E4257);
+    w32(46);
+    w32(44);
+    w32(52); w32(96);
+    w32(148); w32(24);
+    w32(0); w32(0);
+    w32(0); w32(0);
+    w32(WAVE_DATA_OFFSET); w32(len);
+
+    w32(0);
+    w32(1);
+    wstr("ext_adpcm", 64);
+    w32(24);
+    w32(64);
+    w32(WAVE_ALIGNMENT);
+    w32(0);
+    w32(0); w32(0);
+
+    /* The block alignment is stored as (bytes / channels) - 22 */
+    w32(ADPCM_FRAMES << 4);
+    w32(FACT_WAVEBANKMINIFORMAT_TAG_ADPCM | (1 << 2) | (RATE << 5) | (48u << 23));
+    w32(0);
+    w32(len);
+    w32(0);
+    w32(0);
+
+    /* Random nibbles with valid predictors and a sane starting delta */
+    rand_state = 4;
+    for(i = 0; i < ADPCM_BLOCKS; ++i){
+        p = out + WAVE_DATA_OFFSET + i * ADPCM_BLOCK_ALIGN;
+        for(c = 0; c < ADPCM_BLOCK_ALIGN; ++c)
+            p[c] = FAtest_rand();
+        p[0] = FAtest_rand() % 7;
+        p[1] = 64;
+        p[2] = 0;
+    }
+    return WAVE_DATA_OFFSET + len;
+}
+
+static int play_transcoded(uint8_t *data, size_t len, int mode, float *out, uint32_t *sizes)
+{
+    FACTTranscodePolicyEXT policy;
+    FACTRuntimeParameters params;
+    FACTAudioEngine *engine;
+    FACTWaveBank *wb;
+    FACTWave *wave;
+    uint32_t hr;
+    int ret = 0;
+
+    if(!open_device())
+        return 0;
+
+    /* FACT destroys the mastering voice and releases FAudio at shutdown */
+    FAudio_AddRef(audio);
+    FACTCreateEngine(0, &engine);
+    memset(&params, 0, sizeof(params));
+    params.pXAudio2 = audio;
+    params.pMasteringVoice = master;
+    hr = FACTAudioEngine_Initialize(engine, &params);
+    ok(hr == 0, "FACTAudioEngine_Initialize failed: %08x\n", hr);
+    if(hr)
+        goto end;
+
+    policy.target = mode == 2 ? FACT_TRANSCODE_FLOAT_EXT : FACT_TRANSCODE_PCM16_EXT;
+    policy.maxDecodedSize = (mode == 1 || mode == 2) ? 1024 * 1024 : 0;
+    policy.category = FACTCATEGORY_INVALID;
+    hr = FACTAudioEngine_SetTranscodePolicyEXT(engine, &policy);
+    ok(hr == 0, "SetTranscodePolicyEXT failed: %08x\n", hr);
+
+    hr = FACTAudioEngine_CreateInMemoryWaveBank(engine, data, len, 0, 0, &wb);
+    ok(hr == 0, "ADPCM WaveBank failed: %08x\n", hr);
+    if(hr)
+        goto end;
+    if(mode == 3){
+        hr = FACTWaveBank_TranscodeEXT(wb, 0);
+        ok(hr == 0, "TranscodeEXT failed: %08x\n", hr);
+    }
+    FACTAudioEngine_GetTranscodedSizeEXT(engine, &sizes[0]);
+
+    capture_begin();
+    hr = FACTWaveBank_Play(wb, 0, 0, 0, 0, &wave);
+    ok(hr == 0, "FACTWaveBank_Play failed: %08x\n", hr);
+    ret = capture_end(out, ADPCM_FRAMES);
+    ok(ret, "Timed out capturing %u frames\n", ADPCM_FRAMES);
+
+    if(hr == 0)
+        FACTWave_Destroy(wave);
+    FACTWaveBank_Destroy(wb);
+    FACTAudioEngine_GetTranscodedSizeEXT(engine, &sizes[1]);
+
+end:
+    FACTAudioEngine_ShutDown(engine);
+    FACTAudioEngine_Release(engine);
+    FAudio_Release(audio);
+    master = NULL;
+    audio = NULL;
+    return ret;
+}
+
+static void test_transcode(void)
+{
+    static const char *modes[] = { "MSADPCM", "PCM16", "float", "TranscodeEXT" };
+    float *ref, *out;
+    uint32_t ref_sizes[2], sizes[2], i;
+    uint8_t *data;
+    size_t len;
+    int mode;
+
+    data = malloc(WAVE_DATA_OFFSET + ADPCM_BLOCKS * ADPCM_BLOCK_ALIGN);
+    ref = malloc(ADPCM_FRAMES * sizeof(float));
+    out = malloc(ADPCM_FRAMES * sizeof(float));
+    len = build_adpcm_wavebank(data);
+
+    if(!play_transcoded(data, len, 0, ref, ref_sizes))
+        goto end;
+    ok(count_nonzero(ref, ADPCM_FRAMES) > ADPCM_FRAMES / 2, "MSADPCM wave is silent\n");
+    ok(ref_sizes[0] == 0, "Nothing should be transcoded, got %u bytes\n", ref_sizes[0]);
+
+    for(mode = 1; mode < 4; ++mode){
+        if(!play_transcoded(data, len, mode, out, sizes))
+            continue;
+        ok(sizes[0] >= (mode == 2 ? 4 : 2) * (ADPCM_FRAMES - 128) &&
+                sizes[0] <= (mode == 2 ? 4 : 2) * ADPCM_FRAMES,
+                "%s: %u bytes transcoded\n", modes[mode], sizes[0]);
+        ok(sizes[1] == 0, "%s: %u bytes left after destroying the WaveBank\n", modes[mode], sizes[1]);
+        i = compare_frames(out, ref, ADPCM_FRAMES);
+        ok(i == ADPCM_FRAMES, "%s: frame %u is %.9g, expected %.9g\n",
+                modes[mode], i, out[i % ADPCM_FRAMES], ref[i % ADPCM_FRAMES]);
+    }
+
+end:
+    free(data);
+    free(ref);
+    free(out);
+}
+
+int main(int argc, char **argv)
+{
+    int has_devices = open_device();
+
+    if(has_devices){
+        test_pcm_formats();
+        test_vorbis();
+        test_qoa();
+        close_device();
+
+        test_wavebank_parse();
+        test_soundbank_parse();
+        test_transcode();
+    }else
+        fprintf(stdout, "No audio devices available\n");
+
+    test_uring(has_devices);
+
+    fprintf(stdout, "Finished with %u successful tests and %u failed tests.\n",
+            success_count, failure_count);
+
+    return failure_count > 0;
+}
@@ -0,0 +1,139 @@
+/* FAudio - XAudio Reimplementation for FNA
+ *
+ * Copyright (c) 2011-2024 Ethan Lee, Luigi Auriemma, and the MonoGame Team
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Ethan "flibitijibibo" Lee <flibitijibibo@flibitijibibo.com>
+ *
+ */
+
+/* Writes the seek index sidecar that XNA_SetSongPositionEXT looks for next to
+ * an Ogg Vorbis song, so games can ship it instead of building it at runtime.
+ * See src/FAudio_vorbis.c for the layout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static void write32(FILE *out, uint32_t value)
+{
+	uint8_t b[4];
+	b[0] = value & 0xFF;
+	b[1] = (value >> 8) & 0xFF;
+	b[2] = (value >> 16) & 0xFF;
+	b[3] = (value >> 24) & 0xFF;
+	fwrite(b, 1, 4, out);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in, *out;
+	char *path;
+	uint8_t header[27], lacing[255];
+	uint32_t *entries = NULL;
+	uint32_t count = 0, capacity = 0, offset = 0, size, body, sample, i;
+
+	if (argc < 2)
+	{
+		printf("Usage: %s song.ogg [song.ogg.seek]\n", argv[0]);
+		return 0;
+	}
+
+	in = fopen(argv[1], "rb");
+	if (in == NULL)
+	{
+		printf("Can't open %s\n", argv[1]);
+		return 1;
+	}
+	fseek(in, 0, SEEK_END);
+	size = (uint32_t) ftell(in);
+
+	while (offset < size)
+	{
+		fseek(in, offset, SEEK_SET);
+		if (	fread(header, 27, 1, in) != 1 ||
+			memcmp(header, "OggS", 4) != 0 ||
+			fread(lacing, header[26], 1, in) != (header[26] > 0)	)
+		{
+			printf("Bad Ogg page at %u\n", offset);
+			fclose(in);
+			free(entries);
+			return 1;
+		}
+		body = 0;
+		for (i = 0; i < header[26]; i += 1)
+		{
+			body += lacing[i];
+		}
+
+		/* Same truncated granule stb_vorbis reads; ~0 means no packet ends */
+		sample = header[6] | (header[7] << 8) | (header[8] << 16) | ((uint32_t) header[9] << 24);
+		if (sample != 0xFFFFFFFF)
+		{
+			if (count == capacity)
+			{
+				capacity = capacity ? capacity * 2 : 64;
+				entries = (uint32_t*) realloc(entries, sizeof(uint32_t) * 2 * capacity);
+			}
+			entries[count * 2] = offset;
+			entries[count * 2 + 1] = sample;
+			count += 1;
+		}
+		offset += 27 + header[26] + body;
+	}
+	fclose(in);
+
+	if (argc > 2)
+	{
+		path = argv[2];
+	}
+	else
+	{
+		path = (char*) malloc(strlen(argv[1]) + sizeof(".seek"));
+		strcpy(path, argv[1]);
+		strcat(path, ".seek");
+	}
+	out = fopen(path, "wb");
+	if (out == NULL)
+	{
+		printf("Can't write %s\n", path);
+		free(entries);
+		return 1;
+	}
+	fwrite("FSIX", 1, 4, out);
+	write32(out, 1);
+	write32(out, size);
+	write32(out, count);
+	for (i = 0; i < count * 2; i += 1)
+	{
+		write32(out, entries[i]);
+	}
+	fclose(out);
+	printf("%s: %u pages\n", path, count);
+
+	if (path != argv[2])
+	{
+		free(path);
+	}
+	free(entries);
+	return 0;
+}